@@ -0,0 +1,164 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ArrayArithmetic.h"
+
+#if ARRAY_ARITHMETIC_DISPATCH
+#include <immintrin.h>
+
+#define TARGET_SSE
+#define TARGET_AVX __attribute__((target("avx")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+
+/*
+ * Each kernel processes as many whole vectors as possible from startIndex, and finishes the
+ * remaining samples one at a time. Loads and stores are unaligned, such that the kernels may be
+ * applied to any range of a buffer. As the operations are all exactly rounded, every kernel
+ * computes the same result as the scalar tail.
+ */
+
+#define BINARY_KERNEL(_name, _target, _width, _load, _store, _vop, _op) \
+  _target static void _name(float *input0, float *input1, float *output, int startIndex, int endIndex) { \
+    int i = startIndex; \
+    for (; i <= endIndex - _width; i += _width) { \
+      _store(output+i, _vop(_load(input0+i), _load(input1+i))); \
+    } \
+    for (; i < endIndex; i++) { \
+      output[i] = input0[i] _op input1[i]; \
+    } \
+  }
+
+#define CONSTANT_KERNEL(_name, _target, _width, _set1, _load, _store, _vop, _op) \
+  _target static void _name(float *input, float constant, float *output, int startIndex, int endIndex) { \
+    int i = startIndex; \
+    for (; i <= endIndex - _width; i += _width) { \
+      _store(output+i, _vop(_load(input+i), _set1(constant))); \
+    } \
+    for (; i < endIndex; i++) { \
+      output[i] = input[i] _op constant; \
+    } \
+  }
+
+#define FILL_KERNEL(_name, _target, _width, _set1, _store) \
+  _target static void _name(float *input, float constant, int startIndex, int endIndex) { \
+    int i = startIndex; \
+    for (; i <= endIndex - _width; i += _width) { \
+      _store(input+i, _set1(constant)); \
+    } \
+    for (; i < endIndex; i++) { \
+      input[i] = constant; \
+    } \
+  }
+
+#define KERNELS(_suffix, _target, _width, _set1, _load, _store, _add, _sub, _mul, _div) \
+  BINARY_KERNEL(add##_suffix, _target, _width, _load, _store, _add, +) \
+  CONSTANT_KERNEL(addConstant##_suffix, _target, _width, _set1, _load, _store, _add, +) \
+  BINARY_KERNEL(subtract##_suffix, _target, _width, _load, _store, _sub, -) \
+  CONSTANT_KERNEL(subtractConstant##_suffix, _target, _width, _set1, _load, _store, _sub, -) \
+  BINARY_KERNEL(multiply##_suffix, _target, _width, _load, _store, _mul, *) \
+  CONSTANT_KERNEL(multiplyConstant##_suffix, _target, _width, _set1, _load, _store, _mul, *) \
+  BINARY_KERNEL(divide##_suffix, _target, _width, _load, _store, _div, /) \
+  CONSTANT_KERNEL(divideConstant##_suffix, _target, _width, _set1, _load, _store, _div, /) \
+  FILL_KERNEL(fill##_suffix, _target, _width, _set1, _store)
+
+#define KERNEL_TABLE(_suffix) { \
+  &add##_suffix, &addConstant##_suffix, &subtract##_suffix, &subtractConstant##_suffix, \
+  &multiply##_suffix, &multiplyConstant##_suffix, &divide##_suffix, &divideConstant##_suffix, \
+  &fill##_suffix \
+}
+
+#pragma mark - Kernels
+
+KERNELS(Sse, TARGET_SSE, 4, _mm_set1_ps, _mm_loadu_ps, _mm_storeu_ps,
+    _mm_add_ps, _mm_sub_ps, _mm_mul_ps, _mm_div_ps)
+
+KERNELS(Avx, TARGET_AVX, 8, _mm256_set1_ps, _mm256_loadu_ps, _mm256_storeu_ps,
+    _mm256_add_ps, _mm256_sub_ps, _mm256_mul_ps, _mm256_div_ps)
+
+KERNELS(Avx512, TARGET_AVX512, 16, _mm512_set1_ps, _mm512_loadu_ps, _mm512_storeu_ps,
+    _mm512_add_ps, _mm512_sub_ps, _mm512_mul_ps, _mm512_div_ps)
+
+#pragma mark - Dispatch
+
+static bool isSelected = false;
+
+ArrayArithmetic::Kernels ArrayArithmetic::kernels = KERNEL_TABLE(Sse);
+ArrayArithmetic::InstructionSet ArrayArithmetic::instructionSet = ArrayArithmetic::SSE;
+
+bool ArrayArithmetic::isInstructionSetSupported(InstructionSet instructionSet) {
+  // the processor features are read with cpuid, which also reports whether the operating system
+  // saves the wider registers across context switches
+  __builtin_cpu_init();
+  switch (instructionSet) {
+    case SSE: return true;
+    case AVX: return __builtin_cpu_supports("avx");
+    case AVX512: return __builtin_cpu_supports("avx512f");
+    default: return false;
+  }
+}
+
+bool ArrayArithmetic::setInstructionSet(InstructionSet instructionSet) {
+  if (!isInstructionSetSupported(instructionSet)) return false;
+  switch (instructionSet) {
+    case SSE: {
+      Kernels k = KERNEL_TABLE(Sse);
+      kernels = k;
+      break;
+    }
+    case AVX: {
+      Kernels k = KERNEL_TABLE(Avx);
+      kernels = k;
+      break;
+    }
+    case AVX512: {
+      Kernels k = KERNEL_TABLE(Avx512);
+      kernels = k;
+      break;
+    }
+    default: return false;
+  }
+  ArrayArithmetic::instructionSet = instructionSet;
+  isSelected = true;
+  return true;
+}
+
+static bool selectWidestInstructionSet() {
+  // an instruction set which has been chosen explicitly is kept
+  return isSelected || ArrayArithmetic::setInstructionSet(ArrayArithmetic::AVX512) ||
+      ArrayArithmetic::setInstructionSet(ArrayArithmetic::AVX) ||
+      ArrayArithmetic::setInstructionSet(ArrayArithmetic::SSE);
+}
+
+void ArrayArithmetic::selectInstructionSet() {
+  // contexts may be created concurrently, but a function-local static is initialised exactly once.
+  // The kernels are therefore only written before the first context exists.
+  static bool isInitialised = selectWidestInstructionSet();
+  (void) isInitialised;
+}
+
+#else
+
+void ArrayArithmetic::selectInstructionSet() {
+  // the kernels are chosen at compile time
+}
+
+#endif // ARRAY_ARITHMETIC_DISPATCH
@@ -29,6 +29,10 @@
 #endif
 #if __SSE__
 #include <xmmintrin.h>
+#if !__APPLE__
+// on x86, the kernels are chosen at runtime for the widest instruction set of the processor
+#define ARRAY_ARITHMETIC_DISPATCH 1
+#endif
 #elif __ARM_NEON__
 // __ARM_NEON__ is defined by the compiler if the arguments "-mfloat-abi=softfp -mfpu=neon" are passed.
 #include <arm_neon.h>
@@ -37,41 +41,47 @@
 /**
  * This class offers static inline functions for computing basic arithmetic with float arrays.
  * It offers a central place for optimised implementations of common compute-intensive operations.
- * In all SSE cases, input vectors can be (16-byte) unaligned, but output vectors must be aligned.
+ *
+ * On x86 (other than on Apple platforms, which use the Accelerate framework), each operation calls
+ * a kernel for SSE, AVX or AVX-512, which is chosen when the first context is created according to
+ * the instruction sets which the processor and operating system support. The kernels make no
+ * assumptions about the alignment of their buffers, and all compute exactly the same results.
  */
 class ArrayArithmetic {
   
   public:
   
+    /**
+     * Selects the kernels for the widest instruction set which is supported, if this has not
+     * already been done. This is called whenever a <code>PdContext</code> is created, and may be
+     * called from several threads at once. The kernels are selected only once.
+     */
+    static void selectInstructionSet();
+  
+    #if ARRAY_ARITHMETIC_DISPATCH
+    enum InstructionSet {
+      SSE,
+      AVX, // 256-bit kernels, also used with AVX2, which adds no floating point arithmetic
+      AVX512 // 512-bit kernels, requiring AVX-512F
+    };
+  
+    /** Returns <code>true</code> if the processor and operating system support the instruction set. */
+    static bool isInstructionSetSupported(InstructionSet instructionSet);
+  
+    /**
+     * Selects the kernels of the given instruction set, returning <code>false</code> if it is not
+     * supported. This must not be called while any context is processing.
+     */
+    static bool setInstructionSet(InstructionSet instructionSet);
+  
+    static InstructionSet getInstructionSet() { return instructionSet; }
+    #endif
+  
     static inline void add(float *input0, float *input1, float *output, int startIndex, int endIndex) {
       #if __APPLE__
       vDSP_vadd(input0+startIndex, 1, input1+startIndex, 1, output+startIndex, 1, endIndex-startIndex);
-      #elif __SSE__
-      input0 += startIndex;
-      input1 += startIndex;
-      output += startIndex;
-      int n = endIndex - startIndex;
-      
-      // align buffer to 16-byte boundary
-      switch (startIndex & 0x3) {
-        case 0: default: break;
-        case 1: *output++ = *input0++ + *input1++; --n;
-        case 2: *output++ = *input0++ + *input1++; --n;
-        case 3: *output++ = *input0++ + *input1++; --n;
-      }
-      
-      int n4 = n & 0xFFFFFFFC;
-      while (n4) {
-        _mm_store_ps(output, _mm_add_ps(_mm_load_ps(input0), _mm_load_ps(input1)));
-        n4 -= 4; input0 += 4; input1 += 4; output += 4;
-      }
-      
-      switch (n & 0x3) {
-        case 3: *output++ = *input0++ + *input1++;
-        case 2: *output++ = *input0++ + *input1++;
-        case 1: *output++ = *input0++ + *input1++;
-        case 0: default: break;
-      }
+      #elif ARRAY_ARITHMETIC_DISPATCH
+      kernels.add(input0, input1, output, startIndex, endIndex);
       #elif __ARM_NEON__
       input0 += startIndex;
       input1 += startIndex;
@@ -105,32 +115,8 @@ class ArrayArithmetic {
     static inline void add(float *input, float constant, float *output, int startIndex, int endIndex) {
       #if __APPLE__
       vDSP_vsadd(input+startIndex, 1, &constant, output+startIndex, 1, endIndex-startIndex);
-      #elif __SSE__
-      input += startIndex;
-      output += startIndex;
-      int n = endIndex - startIndex;
-      
-      // align buffer to 16-byte boundary
-      switch (startIndex & 0x3) {
-        case 0: default: break;
-        case 1: *output++ += constant; --n;
-        case 2: *output++ += constant; --n;
-        case 3: *output++ += constant; --n;
-      }
-      
-      int n4 = n & 0xFFFFFFFC;
-      const __m128 constVec = _mm_set1_ps(constant);
-      while (n4) {
-        _mm_store_ps(output, _mm_add_ps(_mm_load_ps(input), constVec));
-        n4 -= 4; input += 4; output += 4;
-      }
-      
-      switch (n & 0x3) {
-        case 3: *output++ += constant;
-        case 2: *output++ += constant;
-        case 1: *output++ += constant;
-        case 0: default: break;
-      }
+      #elif ARRAY_ARITHMETIC_DISPATCH
+      kernels.addConstant(input, constant, output, startIndex, endIndex);
       #elif __ARM_NEON__
       input += startIndex;
       output += startIndex;
@@ -162,31 +148,8 @@ class ArrayArithmetic {
     static inline void subtract(float *input0, float *input1, float *output, int startIndex, int endIndex) {
       #if __APPLE__
       vDSP_vsub(input1+startIndex, 1, input0+startIndex, 1, output+startIndex, 1, endIndex-startIndex);
-      #elif __SSE__
-      input0 += startIndex;
-      input1 += startIndex;
-      output += startIndex;
-      int n = endIndex - startIndex;
-      
-      switch (startIndex & 0x3) {
-        case 0: default: break;
-        case 1: *output++ = *input0++ - *input1++; --n;
-        case 2: *output++ = *input0++ - *input1++; --n;
-        case 3: *output++ = *input0++ - *input1++; --n;
-      }
-      
-      int n4 = n & 0xFFFFFFFC;
-      while (n4) {
-        _mm_store_ps(output, _mm_sub_ps(_mm_load_ps(input0), _mm_load_ps(input1)));
-        n4 -= 4; input0 += 4; input1 += 4; output += 4;
-      }
-      
-      switch (n & 0x3) {
-        case 3: *output++ = *input0++ - *input1++;
-        case 2: *output++ = *input0++ - *input1++;
-        case 1: *output++ = *input0++ - *input1++;
-        case 0: default: break;
-      }
+      #elif ARRAY_ARITHMETIC_DISPATCH
+      kernels.subtract(input0, input1, output, startIndex, endIndex);
       #elif __ARM_NEON__
       input0 += startIndex;
       input1 += startIndex;
@@ -221,31 +184,8 @@ class ArrayArithmetic {
       #if __APPLE__
       float negation = -1.0f * constant;
       vDSP_vsadd(input+startIndex, 1, &negation, output+startIndex, 1, endIndex-startIndex);
-      #elif __SSE__
-      input += startIndex;
-      output += startIndex;
-      int n = endIndex - startIndex;
-      
-      switch (startIndex & 0x3) {
-        case 0: default: break;
-        case 1: *output++ -= constant; --n;
-        case 2: *output++ -= constant; --n;
-        case 3: *output++ -= constant; --n;
-      }
-      
-      int n4 = n & 0xFFFFFFFC;
-      const __m128 constVec = _mm_set1_ps(constant);
-      while (n4) {
-        _mm_store_ps(output, _mm_sub_ps(_mm_load_ps(input), constVec));
-        n4 -= 4; input += 4; output += 4;
-      }
-      
-      switch (n & 0x3) {
-        case 3: *output++ -= constant;
-        case 2: *output++ -= constant;
-        case 1: *output++ -= constant;
-        case 0: default: break;
-      }
+      #elif ARRAY_ARITHMETIC_DISPATCH
+      kernels.subtractConstant(input, constant, output, startIndex, endIndex);
       #elif __ARM_NEON__
       input += startIndex;
       output += startIndex;
@@ -276,31 +216,8 @@ class ArrayArithmetic {
     static inline void multiply(float *input0, float *input1, float *output, int startIndex, int endIndex) {
       #if __APPLE__
       vDSP_vmul(input0+startIndex, 1, input1+startIndex, 1, output+startIndex, 1, endIndex-startIndex);
-      #elif __SSE__
-      input0 += startIndex;
-      input1 += startIndex;
-      output += startIndex;
-      int n = endIndex - startIndex;
-      
-      switch (startIndex & 0x3) {
-        case 0: default: break;
-        case 1: *output++ = *input0++ * *input1++; --n;
-        case 2: *output++ = *input0++ * *input1++; --n;
-        case 3: *output++ = *input0++ * *input1++; --n;
-      }
-      
-      int n4 = n & 0xFFFFFFFC;
-      while (n4) {
-        _mm_store_ps(output, _mm_mul_ps(_mm_load_ps(input0), _mm_load_ps(input1)));
-        n4 -= 4; input0 += 4; input1 += 4; output += 4;
-      }
-      
-      switch (n & 0x3) {
-        case 3: *output++ = *input0++ * *input1++;
-        case 2: *output++ = *input0++ * *input1++;
-        case 1: *output++ = *input0++ * *input1++;
-        case 0: default: break;
-      }
+      #elif ARRAY_ARITHMETIC_DISPATCH
+      kernels.multiply(input0, input1, output, startIndex, endIndex);
       #elif __ARM_NEON__
       input0 += startIndex;
       input1 += startIndex;
@@ -334,31 +251,8 @@ class ArrayArithmetic {
     static inline void multiply(float *input, float constant, float *output, int startIndex, int endIndex) {
       #if __APPLE__
       vDSP_vsmul(input+startIndex, 1, &constant, output+startIndex, 1, endIndex-startIndex);
-      #elif __SSE__
-      input += startIndex;
-      output += startIndex;
-      int n = endIndex - startIndex;
-      
-      switch (startIndex & 0x3) {
-        case 0: default: break;
-        case 1: *output++ *= constant; --n;
-        case 2: *output++ *= constant; --n;
-        case 3: *output++ *= constant; --n;
-      }
-      
-      int n4 = n & 0xFFFFFFFC;
-      const __m128 constVec = _mm_set1_ps(constant);
-      while (n4) {
-        _mm_store_ps(output, _mm_mul_ps(_mm_load_ps(input), constVec));
-        n4 -= 4; input += 4; output += 4;
-      }
-      
-      switch (n & 0x3) {
-        case 3: *output++ *= constant;
-        case 2: *output++ *= constant;
-        case 1: *output++ *= constant;
-        case 0: default: break;
-      }
+      #elif ARRAY_ARITHMETIC_DISPATCH
+      kernels.multiplyConstant(input, constant, output, startIndex, endIndex);
       #elif __ARM_NEON__
       input += startIndex;
       output += startIndex;
@@ -390,31 +284,8 @@ class ArrayArithmetic {
     static inline void divide(float *input0, float *input1, float *output, int startIndex, int endIndex) {
       #if __APPLE__
       vDSP_vdiv(input1+startIndex, 1, input0+startIndex, 1, output+startIndex, 1, endIndex-startIndex);
-      #elif __SSE__
-      input0 += startIndex;
-      input1 += startIndex;
-      output += startIndex;
-      int n = endIndex - startIndex;
-      
-      switch (startIndex & 0x3) {
-        case 0: default: break;
-        case 1: *output++ = *input0++ / *input1++; --n;
-        case 2: *output++ = *input0++ / *input1++; --n;
-        case 3: *output++ = *input0++ / *input1++; --n;
-      }
-      
-      int n4 = n & 0xFFFFFFFC;
-      while (n4) {
-        _mm_store_ps(output, _mm_div_ps(_mm_load_ps(input0), _mm_load_ps(input1)));
-        n4 -= 4; input0 += 4; input1 += 4; output += 4;
-      }
-      
-      switch (n & 0x3) {
-        case 3: *output++ = *input0++ / *input1++;
-        case 2: *output++ = *input0++ / *input1++;
-        case 1: *output++ = *input0++ / *input1++;
-        case 0: default: break;
-      }
+      #elif ARRAY_ARITHMETIC_DISPATCH
+      kernels.divide(input0, input1, output, startIndex, endIndex);
       #else
       for (int i = startIndex; i < endIndex; i++) {
         output[i] = input0[i] / input1[i];
@@ -425,31 +296,8 @@ class ArrayArithmetic {
     static inline void divide(float *input, float constant, float *output, int startIndex, int endIndex) {
       #if __APPLE__
       vDSP_vsdiv(input+startIndex, 1, &constant, output+startIndex, 1, endIndex-startIndex);
-      #elif __SSE__
-      input += startIndex;
-      output += startIndex;
-      int n = endIndex - startIndex;
-      
-      switch (startIndex & 0x3) {
-        case 0: default: break;
-        case 1: *output++ /= constant; --n;
-        case 2: *output++ /= constant; --n;
-        case 3: *output++ /= constant; --n;
-      }
-      
-      int n4 = n & 0xFFFFFFFC;
-      const __m128 constVec = _mm_set1_ps(constant);
-      while (n4) {
-        _mm_store_ps(output, _mm_div_ps(_mm_load_ps(input), constVec));
-        n4 -= 4; input += 4; output += 4;
-      }
-      
-      switch (n & 0x3) {
-        case 3: *output++ /= constant;
-        case 2: *output++ /= constant;
-        case 1: *output++ /= constant;
-        case 0: default: break;
-      }
+      #elif ARRAY_ARITHMETIC_DISPATCH
+      kernels.divideConstant(input, constant, output, startIndex, endIndex);
       #else
       for (int i = startIndex; i < endIndex; i++) {
         output[i] = input[i] / constant;
@@ -460,30 +308,8 @@ class ArrayArithmetic {
     static inline void fill(float *input, float constant, int startIndex, int endIndex) {
       #if __APPLE__
       vDSP_vfill(&constant, input+startIndex, 1, endIndex-startIndex);
-      #elif __SSE__
-      input += startIndex;
-      int n = endIndex - startIndex;
-      
-      switch (startIndex & 0x3) {
-        case 0: default: break;
-        case 1: *input++ = constant; --n;
-        case 2: *input++ = constant; --n;
-        case 3: *input++ = constant; --n;
-      }
-      
-      int n4 = n & 0xFFFFFFFC; // force n to be a multiple of 4
-      const __m128 constVec = _mm_set1_ps(constant);
-      while (n4) {
-        _mm_store_ps(input, constVec);
-        n4 -= 4; input += 4;
-      }
-      
-      switch (n & 0x3) {
-        case 3: *input++ = constant;
-        case 2: *input++ = constant;
-        case 1: *input++ = constant;
-        case 0: default: break;
-      }
+      #elif ARRAY_ARITHMETIC_DISPATCH
+      kernels.fill(input, constant, startIndex, endIndex);
       #elif __ARM_NEON__
       input += startIndex;
       int n = endIndex - startIndex;
@@ -510,6 +336,29 @@ class ArrayArithmetic {
   private:
     ArrayArithmetic(); // no instances of this object are allowed
     ~ArrayArithmetic();
+  
+    #if ARRAY_ARITHMETIC_DISPATCH
+    typedef void (*BinaryKernel)(float *input0, float *input1, float *output, int startIndex, int endIndex);
+    typedef void (*ConstantKernel)(float *input, float constant, float *output, int startIndex, int endIndex);
+    typedef void (*FillKernel)(float *input, float constant, int startIndex, int endIndex);
+  
+    /** The kernels of one instruction set. */
+    typedef struct {
+      BinaryKernel add;
+      ConstantKernel addConstant;
+      BinaryKernel subtract;
+      ConstantKernel subtractConstant;
+      BinaryKernel multiply;
+      ConstantKernel multiplyConstant;
+      BinaryKernel divide;
+      ConstantKernel divideConstant;
+      FillKernel fill;
+    } Kernels;
+  
+    /** The kernels of the selected instruction set. The SSE kernels are used until one is selected. */
+    static Kernels kernels;
+    static InstructionSet instructionSet;
+    #endif
 };
 
 #endif // _ARRAY_ARITHMETIC_H_
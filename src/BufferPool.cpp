@@ -23,36 +23,81 @@
 #include "BufferPool.h"
 #include "DspObject.h"
 
-BufferPool::BufferPool(unsigned short size) {
-  bufferSize = size;
- 
-  zeroBuffer = ALLOC_ALIGNED_BUFFER(bufferSize * sizeof(float));
-  memset(zeroBuffer, 0, bufferSize*sizeof(float)); // zero the zero buffer!
+BufferPool::BufferPool(unsigned int size) {
+  // the zero buffer is allocated once at the maximum size, as objects may hold on to it
+  zeroBuffer = ALLOC_ALIGNED_BUFFER(BUFFER_POOL_MAX_BUFFER_SIZE * sizeof(float));
+  memset(zeroBuffer, 0, BUFFER_POOL_MAX_BUFFER_SIZE * sizeof(float)); // zero the zero buffer!
+  bufferSize = 0;
+  resizeBuffers(size);
 }
 
 BufferPool::~BufferPool() {
+  freeBuffers();
+  FREE_ALIGNED_BUFFER(zeroBuffer);
+}
+
+void BufferPool::freeBuffers() {
   // free all buffers, reserved and available
-  for (list<std::pair<float *, unsigned int> >::iterator it = reserved.begin(); it != reserved.end(); ++it) {
-    FREE_ALIGNED_BUFFER((*it).first);
+  for (int i = 0; i < slabs.size(); i++) {
+    FREE_ALIGNED_BUFFER((float *) slabs[i].memory);
   }
-  while (!pool.empty()) {
-    FREE_ALIGNED_BUFFER(pool.top());
-    pool.pop();
+  slabs.clear();
+  pool.clear();
+}
+
+void BufferPool::resizeBuffers(unsigned int newBufferSize) {
+  freeBuffers();
+  
+  bufferSize = newBufferSize;
+  // round the buffer up to a multiple of 16 bytes such that the next header remains aligned
+  stride = sizeof(BufferHeader) + ((bufferSize * sizeof(float) + 15) & ~15);
+  numReservedBuffers = 0;
+  maxNumReservedBuffers = 0;
+  numTotalBuffers = 0;
+}
+
+void BufferPool::addSlab(unsigned int numBuffers) {
+  Slab slab;
+  slab.memory = (char *) ALLOC_ALIGNED_BUFFER(numBuffers * stride);
+  slab.numBuffers = numBuffers;
+  memset(slab.memory, 0, numBuffers * stride);
+  slabs.push_back(slab);
+  
+  // push in reverse such that the buffers are handed out in order of their address
+  for (int i = numBuffers-1; i >= 0; i--) {
+    pool.push_back((float *) (slab.memory + (i * stride) + sizeof(BufferHeader)));
   }
-  FREE_ALIGNED_BUFFER(zeroBuffer);
+  numTotalBuffers += numBuffers;
+}
+
+BufferPool::BufferHeader *BufferPool::getHeader(float *buffer) {
+  char *address = (char *) buffer;
+  for (int i = 0; i < slabs.size(); i++) {
+    Slab *slab = &slabs[i];
+    if (address >= slab->memory && address < slab->memory + (slab->numBuffers * stride)) {
+      unsigned int offset = (address - slab->memory) % stride;
+      return (offset == sizeof(BufferHeader)) ? ((BufferHeader *) buffer) - 1 : NULL;
+    }
+  }
+  return NULL;
+}
+
+bool BufferPool::containsBuffer(float *buffer) {
+  return (getHeader(buffer) != NULL);
 }
 
 float *BufferPool::getBuffer(unsigned int numDependencies) {
-  float *buffer = NULL;
-  if (pool.size() > 0) {
-    buffer = pool.top();
-    pool.pop();
-  } else {
-    buffer = ALLOC_ALIGNED_BUFFER(bufferSize * sizeof(float));
-    memset(buffer, 0, bufferSize * sizeof(float));
+  if (pool.empty()) {
+    // each slab is as large as all previous slabs together
+    addSlab((numTotalBuffers > 0) ? numTotalBuffers : BUFFER_POOL_MIN_SLAB_SIZE);
   }
-  reserved.push_back(std::pair<float *, unsigned int>(buffer, numDependencies));
-//  printf("%i/%i buffer used.\n", getNumReservedBuffers(), getNumTotalBuffers());
+  float *buffer = pool.back();
+  pool.pop_back();
+  BufferHeader *header = ((BufferHeader *) buffer) - 1;
+  header->numDependencies = numDependencies;
+  header->isReserved = true;
+  
+  if (++numReservedBuffers > maxNumReservedBuffers) maxNumReservedBuffers = numReservedBuffers;
   return buffer;
 }
 
@@ -60,46 +105,26 @@ void BufferPool::releaseBuffer(float *buffer) {
   // an object may try to release the zero buffer. This should not be possible.
   if (buffer == zeroBuffer) return;
   
-  for (list<std::pair<float *, unsigned int> >::iterator it = reserved.begin(); it != reserved.end(); ++it) {
-    if ((*it).first == buffer) {
-      --((*it).second);
-      if ((*it).second <= 0) {
-        reserved.erase(it);
-        pool.push(buffer);
-//        printf("%i/%i buffer used.\n", getNumReservedBuffers(), getNumTotalBuffers());
-        break;
-      }
+  // if the buffer is not in the reserved pool, nothing changes. Untracked buffers are left alone.
+  BufferHeader *header = getHeader(buffer);
+  if (header != NULL && header->isReserved && header->numDependencies > 0) {
+    if (--(header->numDependencies) == 0) {
+      header->isReserved = false;
+      pool.push_back(buffer);
+      --numReservedBuffers;
     }
   }
-  // if the buffer is not in the reserved pool, nothing changes. Untracked buffers are left alone.
 }
 
 void BufferPool::reserveBuffer(float *buffer, unsigned int reserveCount) {
   if (buffer == zeroBuffer) return; // no need to reserve the zero buffer
   
-  for (list<std::pair<float *, unsigned int> >::iterator it = reserved.begin(); it != reserved.end(); ++it) {
-    if ((*it).first == buffer) {
-      (*it).second += reserveCount;
-      return;
-    }
+  BufferHeader *header = getHeader(buffer);
+  if (header != NULL && header->isReserved) {
+    header->numDependencies += reserveCount;
+    return;
   }
   
   printf("Attempt to reserve unreserved buffer %p +%i.\n  "
       "This may be ok if the buffer is global such as an adc~ input buffer.\n", buffer, reserveCount);
 }
-
-/*
-void BufferPool::resizeBuffers(unsigned int newBufferSize) {
-  for (list<std::pair<float *, unsigned int> >::iterator it = reserved.begin(); it != reserved.end(); ++it) {
-    float *buffer = (*it).first;
-    float *newBuffer = (float *) realloc(buffer, newBufferSize * sizeof(float));
-    if (newBuffer != buffer) { // buffer should start at same address so that it is still 16-byte aligned
-      free(buffer);
-      free(newBuffer);
-      (*it).first = (float *) valloc(newBufferSize * sizeof(float));
-    }
-  }
-  
-  // TODO(mhroth): resize all buffers in pool
-}
-*/
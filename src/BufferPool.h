@@ -23,13 +23,32 @@
 #ifndef _BUFFER_POOL_
 #define _BUFFER_POOL_
 
-#include <list>
-#include <stack>
+#include <vector>
 using namespace std;
 
+/** The number of buffers in the first slab of a <code>BufferPool</code>. Each following slab is twice as large. */
+#define BUFFER_POOL_MIN_SLAB_SIZE 8
+
+/**
+ * The largest buffer size (in samples) which a <code>BufferPool</code> supports, and therefore the
+ * largest block size of any graph. It is a power of two.
+ */
+#define BUFFER_POOL_MAX_BUFFER_SIZE 32768
+
+/**
+ * The <code>BufferPool</code> provides the signal buffers which connect <code>DspObject</code>s. It
+ * is used while the process order is computed. Each buffer is reserved with a number of
+ * dependencies (i.e. the number of connections reading from it), and is made available again once
+ * all of its dependencies have released it.
+ *
+ * Buffers are allocated in slabs. Each buffer is preceded by a header holding its reference count,
+ * such that reserving and releasing a buffer takes constant time (up to a check of which slab the
+ * buffer belongs to, of which there are logarithmically few). Buffers which do not belong to the
+ * pool (such as the global adc~ buffers) are recognised and left alone.
+ */
 class BufferPool {
   public:
-    BufferPool(unsigned short bufferSize);
+    BufferPool(unsigned int bufferSize);
     ~BufferPool();
   
     /**
@@ -44,25 +63,77 @@ class BufferPool {
     /** Add to the reserve cound of the given buffer. */
     void reserveBuffer(float *buffer, unsigned int reserveCount);
   
-    /** Resizes all buffers in the pool (reserved and available). */
-//    void resizeBuffers(unsigned int newBufferSize);
+    /**
+     * Resizes all buffers in the pool (reserved and available). All buffers are reallocated and all
+     * reservations are cleared. Any buffer pointers previously
+     * acquired from the pool are therefore invalid, and must be acquired again (e.g. by recomputing
+     * the process order).
+     */
+    void resizeBuffers(unsigned int newBufferSize);
   
+    /**
+     * Returns a buffer of <code>BUFFER_POOL_MAX_BUFFER_SIZE</code> zeros. It is never resized or
+     * reallocated, and so may be referenced for the lifetime of the pool.
+     */
     float *getZeroBuffer() { return zeroBuffer; }
   
-    unsigned int getNumReservedBuffers() { return reserved.size(); }
+    /** Returns true if the given buffer belongs to this pool (whether reserved or not). False otherwise. */
+    bool containsBuffer(float *buffer);
+  
+    unsigned int getBufferSize() { return bufferSize; }
+  
+    unsigned int getNumReservedBuffers() { return numReservedBuffers; }
     unsigned int getNumAvailableBuffers() { return pool.size(); }
-    unsigned int getNumTotalBuffers() { return (pool.size() + reserved.size()); }
+    unsigned int getNumTotalBuffers() { return numTotalBuffers; }
+  
+    /** Returns the largest number of buffers which have been reserved at the same time. */
+    unsigned int getMaxNumReservedBuffers() { return maxNumReservedBuffers; }
+  
+    /** Resets the high-water mark to the number of currently reserved buffers. */
+    void resetMaxNumReservedBuffers() { maxNumReservedBuffers = numReservedBuffers; }
   
   private:
-    /** A pool of reserved buffers, paired with the number of outstanding dependencies. */
-    list<std::pair<float *, unsigned int> > reserved;
+    /**
+     * The header preceding each buffer in a slab. It is padded such that the following buffer
+     * remains 16-byte aligned.
+     */
+    typedef union BufferHeader {
+      struct {
+        unsigned int numDependencies;
+        bool isReserved;
+      };
+      char alignment[16];
+    } BufferHeader;
+  
+    typedef struct Slab {
+      char *memory;
+      unsigned int numBuffers;
+    } Slab;
+  
+    /** Returns the header of the given buffer, or <code>NULL</code> if the buffer is not from this pool. */
+    BufferHeader *getHeader(float *buffer);
   
-    /** A pool of available buffers. */
-    stack<float *> pool;
+    /** Allocates a new slab, adding all of its buffers to the available pool. */
+    void addSlab(unsigned int numBuffers);
+  
+    /** Frees all slabs. */
+    void freeBuffers();
+  
+    /** The number of bytes occupied by each header and buffer in a slab. */
+    unsigned int stride;
+  
+    vector<Slab> slabs;
+  
+    /** A stack of available buffers. */
+    vector<float *> pool;
   
     float *zeroBuffer;
   
-    unsigned short bufferSize;
+    unsigned int bufferSize;
+  
+    unsigned int numReservedBuffers;
+    unsigned int maxNumReservedBuffers;
+    unsigned int numTotalBuffers;
 };
 
 #endif // _BUFFER_POOL_
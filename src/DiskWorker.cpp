@@ -0,0 +1,298 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <sys/time.h>
+#include <algorithm>
+#include "DiskWorker.h"
+
+static void deleteTasks(list<DiskTask *> *tasks) {
+  for (list<DiskTask *>::iterator it = tasks->begin(); it != tasks->end(); ++it) {
+    delete *it;
+  }
+  tasks->clear();
+}
+
+#ifndef EMSCRIPTEN
+/** Returns the absolute time the given number of milliseconds from now. */
+static timespec getTimeout(long milliseconds) {
+  timeval now;
+  gettimeofday(&now, NULL);
+  long nanoseconds = (now.tv_usec + 1000L * milliseconds) * 1000L;
+  timespec timeout;
+  timeout.tv_sec = now.tv_sec + nanoseconds / 1000000000L;
+  timeout.tv_nsec = nanoseconds % 1000000000L;
+  return timeout;
+}
+#endif
+
+DiskWorker::DiskWorker() {
+  #ifndef EMSCRIPTEN
+  pthread_mutex_init(&workerLock, NULL);
+  pthread_cond_init(&wakeCondition, NULL);
+  shouldStop = false;
+  pthread_cond_init(&streamWakeCondition, NULL);
+  pthread_cond_init(&serviceCondition, NULL);
+  isStreamThreadStarted = false;
+  servicingStream = NULL;
+  #endif
+  isStreamWakeRequested.store(false, memory_order_relaxed);
+  synchronous = false;
+  runningTask = NULL;
+  isRunningTaskCancelled = false;
+  hasFinishedTasks.store(false, memory_order_relaxed);
+  submittedTasks.store(NULL, memory_order_relaxed);
+  
+  #ifndef EMSCRIPTEN
+  // the thread is started now, such that submitting a task never has to
+  pthread_create(&thread, NULL, &workerThread, this);
+  #endif
+}
+
+DiskWorker::~DiskWorker() {
+  #ifndef EMSCRIPTEN
+  pthread_mutex_lock(&workerLock);
+  shouldStop = true;
+  pthread_cond_signal(&wakeCondition);
+  pthread_cond_signal(&streamWakeCondition);
+  pthread_mutex_unlock(&workerLock);
+  pthread_join(thread, NULL);
+  if (isStreamThreadStarted) pthread_join(streamingThread, NULL);
+  pthread_cond_destroy(&serviceCondition);
+  pthread_cond_destroy(&streamWakeCondition);
+  pthread_cond_destroy(&wakeCondition);
+  pthread_mutex_destroy(&workerLock);
+  #endif
+  
+  for (DiskTask *task = submittedTasks.load(); task != NULL;) {
+    DiskTask *next = task->nextSubmittedTask;
+    delete task;
+    task = next;
+  }
+  deleteTasks(&pendingTasks);
+  deleteTasks(&finishedTasks);
+  deleteTasks(&completedTasks);
+  deleteTasks(&retiredTasks);
+}
+
+void DiskWorker::submit(DiskTask *task) {
+  #ifndef EMSCRIPTEN
+  if (!synchronous) {
+    // the list is emptied in one exchange, so a compare-and-swap suffices
+    DiskTask *head = submittedTasks.load(memory_order_relaxed);
+    do {
+      task->nextSubmittedTask = head;
+    } while (!submittedTasks.compare_exchange_weak(head, task,
+        memory_order_release, memory_order_relaxed));
+    
+    // if the lock is taken, the task is noticed before the worker next waits, or at the latest
+    // once the wait has timed out
+    if (pthread_mutex_trylock(&workerLock) == 0) {
+      pthread_cond_signal(&wakeCondition);
+      pthread_mutex_unlock(&workerLock);
+    }
+    return;
+  }
+  #endif
+  
+  task->run();
+  task->complete();
+  delete task;
+}
+
+void DiskWorker::completeTasks() {
+  #ifndef EMSCRIPTEN
+  if (!hasFinishedTasks.load(memory_order_acquire) && completedTasks.empty()) return;
+  
+  // never wait for the worker. If it holds the lock, the tasks are completed with the next block.
+  if (pthread_mutex_trylock(&workerLock) != 0) return;
+  // the tasks completed with the last block are handed back to be deleted
+  if (!completedTasks.empty()) {
+    retiredTasks.splice(retiredTasks.end(), completedTasks);
+    pthread_cond_signal(&wakeCondition);
+  }
+  completedTasks.splice(completedTasks.end(), finishedTasks);
+  hasFinishedTasks.store(false, memory_order_relaxed);
+  pthread_mutex_unlock(&workerLock);
+  
+  for (list<DiskTask *>::iterator it = completedTasks.begin(); it != completedTasks.end(); ++it) {
+    (*it)->complete();
+  }
+  #endif
+}
+
+void DiskWorker::cancel(DiskTask *task) {
+  #ifndef EMSCRIPTEN
+  pthread_mutex_lock(&workerLock);
+  takeSubmittedTasks();
+  if (task == runningTask) {
+    // the task is retired by the worker once it has been run
+    isRunningTaskCancelled = true;
+  } else {
+    pendingTasks.remove(task);
+    finishedTasks.remove(task);
+    retiredTasks.push_back(task);
+    pthread_cond_signal(&wakeCondition);
+  }
+  pthread_mutex_unlock(&workerLock);
+  #endif
+}
+
+void DiskWorker::addStream(DiskStream *stream) {
+  #ifndef EMSCRIPTEN
+  pthread_mutex_lock(&workerLock);
+  streams.push_back(stream);
+  if (!synchronous) startStreaming();
+  pthread_mutex_unlock(&workerLock);
+  #else
+  streams.push_back(stream);
+  #endif
+}
+
+void DiskWorker::removeStream(DiskStream *stream) {
+  #ifndef EMSCRIPTEN
+  pthread_mutex_lock(&workerLock);
+  streams.erase(std::remove(streams.begin(), streams.end(), stream), streams.end());
+  while (servicingStream == stream) {
+    pthread_cond_wait(&serviceCondition, &workerLock);
+  }
+  pthread_mutex_unlock(&workerLock);
+  #else
+  streams.erase(std::remove(streams.begin(), streams.end(), stream), streams.end());
+  #endif
+}
+
+void DiskWorker::wake(DiskStream *stream) {
+  if (synchronous) {
+    stream->service();
+    return;
+  }
+  #ifndef EMSCRIPTEN
+  isStreamWakeRequested.store(true, memory_order_release);
+  // if the lock is taken, the request is noticed before the stream thread next waits, or at the
+  // latest once the wait has timed out
+  if (pthread_mutex_trylock(&workerLock) == 0) {
+    pthread_cond_signal(&streamWakeCondition);
+    pthread_mutex_unlock(&workerLock);
+  }
+  #else
+  stream->service();
+  #endif
+}
+
+void DiskWorker::setSynchronous(bool synchronous) {
+  #ifndef EMSCRIPTEN
+  pthread_mutex_lock(&workerLock);
+  this->synchronous = synchronous;
+  if (synchronous) {
+    // streams are serviced on the processing thread from now on
+    while (servicingStream != NULL) {
+      pthread_cond_wait(&serviceCondition, &workerLock);
+    }
+  } else if (!streams.empty()) {
+    startStreaming();
+  }
+  pthread_mutex_unlock(&workerLock);
+  #else
+  this->synchronous = synchronous;
+  #endif
+}
+
+#ifndef EMSCRIPTEN
+void DiskWorker::takeSubmittedTasks() {
+  DiskTask *task = submittedTasks.exchange(NULL, memory_order_acquire);
+  // the list is latest first
+  list<DiskTask *>::iterator position = pendingTasks.end();
+  for (; task != NULL; task = task->nextSubmittedTask) {
+    position = pendingTasks.insert(position, task);
+  }
+}
+
+void DiskWorker::startStreaming() {
+  if (!isStreamThreadStarted) {
+    isStreamThreadStarted = true;
+    pthread_create(&streamingThread, NULL, &streamThread, this);
+  }
+}
+
+void *DiskWorker::streamThread(void *userData) {
+  DiskWorker *worker = reinterpret_cast<DiskWorker *>(userData);
+  pthread_mutex_lock(&worker->workerLock);
+  while (!worker->shouldStop) {
+    if (!worker->synchronous) {
+      worker->isStreamWakeRequested.store(false, memory_order_relaxed);
+      // streams may be removed while another is serviced
+      for (int i = 0; i < worker->streams.size(); i++) {
+        DiskStream *stream = worker->streams[i];
+        worker->servicingStream = stream;
+        pthread_mutex_unlock(&worker->workerLock);
+        stream->service();
+        pthread_mutex_lock(&worker->workerLock);
+        worker->servicingStream = NULL;
+        pthread_cond_broadcast(&worker->serviceCondition);
+      }
+    }
+    if (!worker->shouldStop && !worker->isStreamWakeRequested.load(memory_order_acquire)) {
+      timespec timeout = getTimeout(DISK_WORKER_STREAM_INTERVAL_MS);
+      pthread_cond_timedwait(&worker->streamWakeCondition, &worker->workerLock, &timeout);
+    }
+  }
+  pthread_mutex_unlock(&worker->workerLock);
+  return NULL;
+}
+
+void *DiskWorker::workerThread(void *userData) {
+  DiskWorker *worker = reinterpret_cast<DiskWorker *>(userData);
+  pthread_mutex_lock(&worker->workerLock);
+  while (!worker->shouldStop) {
+    worker->takeSubmittedTasks();
+    if (!worker->retiredTasks.empty()) {
+      // delete the retired tasks without holding the lock
+      list<DiskTask *> tasks;
+      tasks.splice(tasks.end(), worker->retiredTasks);
+      pthread_mutex_unlock(&worker->workerLock);
+      deleteTasks(&tasks);
+      pthread_mutex_lock(&worker->workerLock);
+    } else if (!worker->pendingTasks.empty()) {
+      DiskTask *task = worker->pendingTasks.front();
+      worker->pendingTasks.pop_front();
+      worker->runningTask = task;
+      worker->isRunningTaskCancelled = false;
+      pthread_mutex_unlock(&worker->workerLock);
+      task->run();
+      pthread_mutex_lock(&worker->workerLock);
+      worker->runningTask = NULL;
+      if (worker->isRunningTaskCancelled) {
+        worker->retiredTasks.push_back(task);
+      } else {
+        worker->finishedTasks.push_back(task);
+        worker->hasFinishedTasks.store(true, memory_order_release);
+      }
+    } else if (worker->submittedTasks.load(memory_order_acquire) == NULL) {
+      // a task may be submitted without the worker being signalled (see submit())
+      timespec timeout = getTimeout(DISK_WORKER_TASK_INTERVAL_MS);
+      pthread_cond_timedwait(&worker->wakeCondition, &worker->workerLock, &timeout);
+    }
+  }
+  pthread_mutex_unlock(&worker->workerLock);
+  return NULL;
+}
+#endif
@@ -0,0 +1,201 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _DISK_WORKER_H_
+#define _DISK_WORKER_H_
+
+#include <atomic>
+#include <list>
+#include <vector>
+#ifndef EMSCRIPTEN
+#include <pthread.h>
+#endif
+using namespace std;
+
+/**
+ * A <code>DiskTask</code> is a unit of slow work, such as reading a sound file, which an object
+ * hands to the <code>DiskWorker</code> of its context so that it is not done while the context is
+ * processed.
+ */
+class DiskTask {
+  
+  public:
+    virtual ~DiskTask() { /* nothing to do */ }
+  
+    /**
+     * Performs the task on the worker thread. The context is being processed concurrently, so only
+     * data which belongs to the task may be touched.
+     */
+    virtual void run() = 0;
+  
+    /**
+     * Finishes the task on the thread processing the context, at the start of the first block after
+     * <code>run()</code> has returned. This is where the results are handed over, e.g. by swapping
+     * the buffer of a table.
+     */
+    virtual void complete() = 0;
+  
+  private:
+    friend class DiskWorker;
+  
+    /** The next task in the list of submitted tasks of the <code>DiskWorker</code>. */
+    DiskTask *nextSubmittedTask;
+};
+
+/**
+ * A <code>DiskStream</code> continuously moves audio between a file and a ring buffer which is read
+ * or written while the context is processed, such as for [readsf~].
+ */
+class DiskStream {
+  
+  public:
+    virtual ~DiskStream() { /* nothing to do */ }
+  
+    /**
+     * Reads or writes as much of the file as the ring buffer allows. This function is called on the
+     * stream thread of the <code>DiskWorker</code> whenever it is woken, and otherwise at least every
+     * <code>DISK_WORKER_STREAM_INTERVAL_MS</code>.
+     */
+    virtual void service() = 0;
+};
+
+/** The longest interval in milliseconds at which streams are serviced without being woken. */
+#define DISK_WORKER_STREAM_INTERVAL_MS 10
+
+/** The longest time in milliseconds until the worker notices a task submitted without waking it. */
+#define DISK_WORKER_TASK_INTERVAL_MS 10
+
+/**
+ * The <code>DiskWorker</code> runs the <code>DiskTask</code>s of the objects of a context on a
+ * background thread, in the order in which they were submitted. Tasks are completed at the start of
+ * the following block with <code>completeTasks()</code>, and then deleted on the worker thread,
+ * such that any large buffers are also freed there. The thread is started with the worker, i.e.
+ * when the context is created. Submitted tasks are pushed to a lock-free list, which the worker
+ * takes over. Otherwise the worker lock is only ever held while a task is moved between lists. The
+ * processing thread never waits for it, neither when submitting a task nor at the start of a block.
+ *
+ * A synchronous worker instead runs and completes each task as soon as it is submitted, which is
+ * useful when rendering offline.
+ *
+ * <code>DiskStream</code>s are serviced on a second thread, such that a long task, e.g. reading a
+ * large file with [soundfiler], does not hold up streaming. It is started once the first stream is
+ * added. A synchronous worker services a stream when it is woken, on the processing thread.
+ */
+class DiskWorker {
+  
+  public:
+    DiskWorker();
+  
+    /** Stops the thread. Tasks which have not been completed are deleted without being completed. */
+    ~DiskWorker();
+  
+    /**
+     * Hands the task to the worker, which owns it from now on. The task is completed and deleted
+     * later, unless it is cancelled first. This function is called while the context is processed.
+     */
+    void submit(DiskTask *task);
+  
+    /** Completes all tasks which have been run since the last call. Called at the start of each block. */
+    void completeTasks();
+  
+    /**
+     * Ensures that a task which has not yet been completed never will be, e.g. because the object
+     * which submitted it is being deleted. The task is deleted by the worker.
+     */
+    void cancel(DiskTask *task);
+  
+    /** Adds a stream to be serviced until it is removed. */
+    void addStream(DiskStream *stream);
+  
+    /** Removes the stream, waiting until it is no longer being serviced. */
+    void removeStream(DiskStream *stream);
+  
+    /**
+     * Asks for the given stream to be serviced soon, e.g. because its ring buffer is running low.
+     * This function never blocks, and is called while the context is processed.
+     */
+    void wake(DiskStream *stream);
+  
+    /**
+     * Sets whether tasks are run as soon as they are submitted, and streams serviced as soon as they
+     * are woken, on the processing thread.
+     */
+    void setSynchronous(bool synchronous);
+    bool isSynchronous() { return synchronous; }
+  
+  private:
+    #ifndef EMSCRIPTEN
+    static void *workerThread(void *userData);
+    static void *streamThread(void *userData);
+    
+    /**
+     * Moves the submitted tasks to the end of <code>pendingTasks</code>, in the order in which they
+     * were submitted. Called with the worker lock held.
+     */
+    void takeSubmittedTasks();
+  
+    /** Starts the stream thread if it is not yet running. Called with the worker lock held. */
+    void startStreaming();
+  
+    pthread_t thread;
+    pthread_mutex_t workerLock;
+    pthread_cond_t wakeCondition;
+    bool shouldStop;
+  
+    pthread_t streamingThread;
+    pthread_cond_t streamWakeCondition;
+  
+    /** Signalled when a stream has been serviced, for <code>removeStream()</code>. */
+    pthread_cond_t serviceCondition;
+    bool isStreamThreadStarted;
+  
+    /** The stream being serviced. */
+    DiskStream *servicingStream;
+    #endif
+  
+    vector<DiskStream *> streams;
+    atomic<bool> isStreamWakeRequested;
+  
+    bool synchronous;
+  
+    /** Tasks which have been submitted but not yet taken over by the worker, latest first. */
+    atomic<DiskTask *> submittedTasks;
+  
+    /** Tasks waiting to be run. */
+    list<DiskTask *> pendingTasks;
+  
+    /** The task being run, and whether it has been cancelled in the meantime. */
+    DiskTask *runningTask;
+    bool isRunningTaskCancelled;
+  
+    /** Tasks which have been run, and are waiting to be completed. */
+    list<DiskTask *> finishedTasks;
+    atomic<bool> hasFinishedTasks;
+  
+    /** Tasks which have been completed, owned by the processing thread until they are handed back. */
+    list<DiskTask *> completedTasks;
+  
+    /** Tasks waiting to be deleted on the worker thread. */
+    list<DiskTask *> retiredTasks;
+};
+
+#endif // _DISK_WORKER_H_
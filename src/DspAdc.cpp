@@ -20,7 +20,9 @@
  *
  */
 
+#include "BufferPool.h"
 #include "DspAdc.h"
+#include "PdContext.h"
 #include "PdGraph.h"
 
 MessageObject *DspAdc::newObject(PdMessage *initMessage, PdGraph *graph) {
@@ -28,7 +30,12 @@ MessageObject *DspAdc::newObject(PdMessage *initMessage, PdGraph *graph) {
 }
 
 DspAdc::DspAdc(PdGraph *graph) : DspObject(0, 0, 0, graph->getNumInputChannels(), graph) {
-  // nothing to do
+  // the global input buffers hold one block of the context. A reblocked graph cannot read them.
+  isBadVectorSize = (graph->getBlockSize() != graph->getContext()->getBlockSize());
+  if (isBadVectorSize) {
+    graph->printErr("adc~: bad vector size. The input is silent in a graph with a block size of %i.",
+        graph->getBlockSize());
+  }
 }
 
 DspAdc::~DspAdc() {
@@ -36,5 +43,6 @@ DspAdc::~DspAdc() {
 }
 
 float *DspAdc::getDspBufferAtOutlet(int outletIndex) {
-  return graph->getGlobalDspBufferAtInlet(outletIndex);
+  return isBadVectorSize ? graph->getBufferPool()->getZeroBuffer()
+      : graph->getGlobalDspBufferAtInlet(outletIndex);
 }
@@ -41,7 +41,11 @@ class DspAdc : public DspObject {
   
     bool canSetBufferAtOutlet(unsigned int outletIndex) { return false; }
   
+    /** Returns the global input buffer of the channel, or the zero buffer in a reblocked graph. */
     float *getDspBufferAtOutlet(int outletIndex);
+  
+  private:
+    bool isBadVectorSize;
 };
 
 inline const char *DspAdc::getObjectLabel() {
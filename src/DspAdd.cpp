@@ -22,6 +22,7 @@
 
 #include "ArrayArithmetic.h"
 #include "DspAdd.h"
+#include "DspFusedChain.h"
 
 class PdGraph;
 
@@ -31,6 +32,7 @@ MessageObject *DspAdd::newObject(PdMessage *initMessage, PdGraph *graph) {
 
 DspAdd::DspAdd(PdMessage *initMessage, PdGraph *graph) : DspObject(2, 2, 0, 1, graph) {
   constant = initMessage->isFloat(0) ? initMessage->getFloat(0) : 0.0f;
+  processFunction = &processScalar;
   processFunctionNoMessage = &processScalar;
 }
 
@@ -39,8 +41,20 @@ DspAdd::~DspAdd() {
 }
 
 void DspAdd::onInletConnectionUpdate(unsigned int inletIndex) {
-  processFunction = (incomingDspConnections[0].size() > 0 && incomingDspConnections[1].size() > 0)
+  // because onInletConnectionUpdate can only be called at block boundaries, it is guaranteed
+  // that no messages will be in the message queue.
+  processFunctionNoMessage = (incomingDspConnections[0].size() > 0 && incomingDspConnections[1].size() > 0)
       ? &processSignal : &processScalar;
+  processFunction = processFunctionNoMessage;
+}
+
+bool DspAdd::getElementwiseOperation(ElementwiseOperation *operation) {
+  operation->op = ELEMENTWISE_ADD;
+  // as when processed alone, a signal at the right inlet is only used if the left is connected too
+  operation->signalInlet = (processFunctionNoMessage == &processSignal) ? 1 : -1;
+  operation->constants[0] = &constant;
+  operation->constants[1] = NULL;
+  return true;
 }
 
 std::string DspAdd::toString() {
@@ -37,6 +37,7 @@ class DspAdd : public DspObject {
     std::string toString();
   
     void onInletConnectionUpdate(unsigned int inletIndex);
+    bool getElementwiseOperation(ElementwiseOperation *operation);
     
   private:
     static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
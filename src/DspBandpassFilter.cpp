@@ -27,7 +27,7 @@ MessageObject *DspBandpassFilter::newObject(PdMessage *initMessage, PdGraph *gra
   return new DspBandpassFilter(initMessage, graph);
 }
 
-DspBandpassFilter::DspBandpassFilter(PdMessage *initMessage, PdGraph *graph) : DspFilter(3, graph) {
+DspBandpassFilter::DspBandpassFilter(PdMessage *initMessage, PdGraph *graph) : DspFilter(3, 1, graph) {
   fc = initMessage->isFloat(0) ? initMessage->getFloat(0) : graph->getSampleRate()/2.0f;
   q = initMessage->isFloat(1) ? initMessage->getFloat(1) : 1.0f;
   calcFiltCoeff(fc, q);
@@ -46,18 +46,15 @@ void DspBandpassFilter::calcFiltCoeff(float fc, float q) {
   float wc = 2.0f*M_PI*fc/graph->getSampleRate();
   float alpha = sinf(wc)/(2.0f*q);
   
-  b[0] = alpha/(1.0f+alpha);
-  b[1] = 0.0f;
-  b[2] = -alpha/(1.0f+alpha);
-  b[3] = -2.0f*cosf(wc)/(1.0f+alpha);
-  b[4] = (1.0f-alpha)/(1.0f+alpha);
+  setCoefficients(alpha/(1.0f+alpha), 0.0f, -alpha/(1.0f+alpha), -2.0f*cosf(wc)/(1.0f+alpha),
+      (1.0f-alpha)/(1.0f+alpha));
 }
 
 void DspBandpassFilter::processMessage(int inletIndex, PdMessage *message) {
   switch (inletIndex) {
     case 0: {
-      if (message->isSymbol(0, "clear")) {
-        x1 = x2 = dspBufferAtOutlet[0][0] = dspBufferAtOutlet[0][1] = 0.0f;
+      if (message->isSymbol(0, SYMBOL_CLEAR)) {
+        clear();
       }
       break;
     }
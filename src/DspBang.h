@@ -37,6 +37,9 @@ class DspBang : public DspObject {
     std::string toString();
   
     ConnectionType getConnectionType(int outletIndex) { return MESSAGE; }
+  
+    // a bang is scheduled every block, whether or not the outlet is connected
+    bool mustProcessSerially() { return true; }
     
   private:
     static void processDsp(DspObject *dspObject, int fromIndex, int toIndex);
@@ -0,0 +1,374 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include "BufferPool.h"
+#include "DspBufferAllocator.h"
+#include "DspObject.h"
+#include "PdGraph.h"
+
+// marks an inlet or outlet whose buffer is not managed by the allocator
+#define UNMANAGED_BUFFER 0xFFFFFFFF
+
+DspBufferAllocator::DspBufferAllocator(BufferPool *pool) {
+  bufferPool = pool;
+  isArenaEnabled = true;
+  arena = NULL;
+  arenaNumBuffers = 0;
+  arenaStride = 0;
+  numBuffersBefore = 0;
+  numBuffersAfter = 0;
+}
+
+DspBufferAllocator::~DspBufferAllocator() {
+  if (arena != NULL) FREE_ALIGNED_BUFFER(arena);
+}
+
+bool DspBufferAllocator::isManagedBuffer(float *buffer) {
+  if (buffer == NULL) return false;
+  if (arena != NULL && buffer >= arena && buffer < arena + (arenaNumBuffers * arenaStride)) return true;
+  return bufferPool->containsBuffer(buffer);
+}
+
+unsigned int DspBufferAllocator::addWrite(float *buffer, unsigned int position, unsigned int partition) {
+  LiveInterval interval;
+  interval.buffer = buffer;
+  interval.partition = partition;
+  interval.start = position;
+  interval.end = position;
+  interval.isReadAtEnd = false;
+  interval.colour = 0;
+  intervalIndex[buffer] = intervals.size();
+  intervals.push_back(interval);
+  return intervals.size() - 1;
+}
+
+void DspBufferAllocator::addRead(unsigned int index, unsigned int position, bool isReusable) {
+  LiveInterval *interval = &intervals[index];
+  if (position > interval->end) {
+    interval->end = position;
+    interval->isReadAtEnd = isReusable;
+  } else if (position == interval->end && !isReusable) {
+    interval->isReadAtEnd = false;
+  }
+}
+
+// orders intervals by partition, and then by start position
+struct DspBufferAllocator::IntervalStartComparator {
+  IntervalStartComparator(vector<LiveInterval> *i) : intervals(i) {}
+  bool operator()(unsigned int a, unsigned int b) {
+    LiveInterval *x = &(*intervals)[a];
+    LiveInterval *y = &(*intervals)[b];
+    return (x->partition != y->partition) ? (x->partition < y->partition) : (x->start < y->start);
+  }
+  vector<LiveInterval> *intervals;
+};
+
+// orders intervals such that the one which ends first is at the top of the heap. Among intervals
+// ending at the same position, those which are only read at the end come first, as they may be reused.
+struct DspBufferAllocator::IntervalEndComparator {
+  IntervalEndComparator(vector<LiveInterval> *i) : intervals(i) {}
+  bool operator()(unsigned int a, unsigned int b) {
+    LiveInterval *x = &(*intervals)[a];
+    LiveInterval *y = &(*intervals)[b];
+    return (x->end != y->end) ? (x->end > y->end) : (!x->isReadAtEnd && y->isReadAtEnd);
+  }
+  vector<LiveInterval> *intervals;
+};
+
+bool DspBufferAllocator::canShareSignal(DspObject *source, DspObject *reader) {
+  PdGraph *sourceGraph = source->getGraph();
+  PdGraph *readerGraph = reader->getGraph();
+  if (sourceGraph->getBlockSize() != readerGraph->getBlockSize()) return false;
+  
+  // both objects must be processed as part of the same reblocked graph, if any
+  PdGraph *sourceBlock = sourceGraph;
+  while (sourceBlock != NULL && !sourceBlock->isReblocked()) sourceBlock = sourceBlock->getParentGraph();
+  PdGraph *readerBlock = readerGraph;
+  while (readerBlock != NULL && !readerBlock->isReblocked()) readerBlock = readerBlock->getParentGraph();
+  if (sourceBlock != readerBlock) return false;
+  
+  // the source must be processed whenever the reader is, so no graph which may be switched off may
+  // contain the source without also containing the reader
+  for (PdGraph *graph = sourceGraph; graph != NULL; graph = graph->getParentGraph()) {
+    if (!graph->isSwitchable()) continue;
+    PdGraph *parent = readerGraph;
+    while (parent != NULL && parent != graph) parent = parent->getParentGraph();
+    if (parent == NULL) return false;
+  }
+  return true;
+}
+
+bool DspBufferAllocator::isInGraph(DspObject *dspObject, PdGraph *graph) {
+  for (PdGraph *parent = dspObject->getGraph(); parent != NULL; parent = parent->getParentGraph()) {
+    if (parent == graph) return true;
+  }
+  return false;
+}
+
+void DspBufferAllocator::allocateBuffers(vector<PdGraph *> *graphList) {
+  vector<DspObject *> processOrder;
+  for (int i = 0; i < graphList->size(); i++) {
+    (*graphList)[i]->getDeepDspProcessOrder(&processOrder);
+  }
+  allocateBuffers(&processOrder, NULL, NULL);
+}
+
+void DspBufferAllocator::allocateBuffers(vector<DspObject *> *processOrderPtr,
+    vector<unsigned int> *position, vector<unsigned int> *partition) {
+  vector<DspObject *> &processOrder = *processOrderPtr;
+  
+  // compute the live interval of each value written to a buffer, and the interval used by each inlet
+  // and outlet in the process order. Inlets are read before outlets are written.
+  intervals.clear();
+  intervalIndex.clear();
+  vector<unsigned int> uses;
+  vector<pair<float *, unsigned int> > carriedReads; // buffer, index of the use
+  vector<unsigned int> carriedPartitions;
+  unordered_map<DspObject *, pair<unsigned int, unsigned int> > inputIntervals; // interval, partition
+  vector<unsigned int> sourceUses; // the interval read from each signal source, in process order
+  unordered_map<DspObject *, bool> isCopyRequired;
+  
+  // a reblocked graph follows its objects, but reads its inlets whenever it processes a hop, i.e.
+  // throughout its objects. It reads the values which are live when its first object is processed,
+  // even if the BufferPool has handed the same buffer to one of its objects.
+  vector<vector<unsigned int> > graphStarts(processOrder.size()); // the graphs starting at each index
+  for (unsigned int p = 0; p < processOrder.size(); p++) {
+    DspObject *dspObject = processOrder[p];
+    if (dspObject->getObjectType() == OBJECT_PD && reinterpret_cast<PdGraph *>(dspObject)->isReblocked()) {
+      unsigned int q = p;
+      while (q > 0 && isInGraph(processOrder[q-1], reinterpret_cast<PdGraph *>(dspObject))) q--;
+      graphStarts[q].push_back(p);
+    }
+  }
+  unordered_map<DspObject *, vector<unsigned int> > graphInputs; // the value read at each inlet
+  
+  for (unsigned int p = 0; p < processOrder.size(); p++) {
+    for (unsigned int g = 0; g < graphStarts[p].size(); g++) {
+      DspObject *graph = processOrder[graphStarts[p][g]];
+      vector<unsigned int> *inputs = &graphInputs[graph];
+      for (int i = 0; i < graph->getNumDspInlets(); i++) {
+        unordered_map<float *, unsigned int>::iterator it = intervalIndex.find(graph->getDspBufferAtInlet(i));
+        inputs->push_back((it == intervalIndex.end()) ? UNMANAGED_BUFFER : it->second);
+      }
+    }
+    unordered_map<DspObject *, vector<unsigned int> >::iterator inputs = graphInputs.find(processOrder[p]);
+  
+    DspObject *dspObject = processOrder[p];
+    unsigned int objectPosition = (position == NULL) ? p : (*position)[p];
+    unsigned int objectPartition = (partition == NULL) ? 0 : (*partition)[p];
+    for (int i = 0; i < dspObject->getNumDspInlets(); i++) {
+      float *buffer = dspObject->getDspBufferAtInlet(i);
+      if (!isManagedBuffer(buffer)) {
+        uses.push_back(UNMANAGED_BUFFER);
+      } else if (inputs != graphInputs.end() && inputs->second[i] != UNMANAGED_BUFFER) {
+        addRead(inputs->second[i], objectPosition);
+        uses.push_back(inputs->second[i]);
+      } else {
+        unordered_map<float *, unsigned int>::iterator it = intervalIndex.find(buffer);
+        if (it == intervalIndex.end()) {
+          carriedReads.push_back(make_pair(buffer, uses.size()));
+          carriedPartitions.push_back(objectPartition);
+          uses.push_back(0);
+        } else {
+          addRead(it->second, objectPosition);
+          uses.push_back(it->second);
+          if (i == 0) inputIntervals[dspObject] = make_pair(it->second, objectPartition);
+        }
+      }
+    }
+  
+    // a signal received by name is read directly from the inlet of its source if the source is
+    // processed earlier in the same partition, and whenever the reader is processed. Otherwise the
+    // source must make a copy, which is read a block late if the source is processed later. Only the
+    // first source may share its buffer with the outlet of the reader.
+    unsigned int forwardedUse = UNMANAGED_BUFFER;
+    for (int k = 0; k < dspObject->getNumSignalSources(); k++) {
+      DspObject *source = dspObject->getSignalSource(k);
+      unsigned int use = UNMANAGED_BUFFER;
+      if (source != NULL) {
+        unordered_map<DspObject *, pair<unsigned int, unsigned int> >::iterator it =
+            inputIntervals.find(source);
+        if (it != inputIntervals.end() && it->second.second == objectPartition &&
+            canShareSignal(source, dspObject)) {
+          use = it->second.first;
+          addRead(use, objectPosition, k == 0);
+        } else {
+          isCopyRequired[source] = true;
+        }
+      }
+      sourceUses.push_back(use);
+      if (k == 0 && dspObject->forwardsSignalSource()) forwardedUse = use;
+    }
+  
+    for (int i = 0; i < dspObject->getNumDspOutlets(); i++) {
+      if (!dspObject->canSetBufferAtOutlet(i)) continue;
+      float *buffer = dspObject->getDspBufferAtOutlet(i);
+      if (!isManagedBuffer(buffer)) {
+        uses.push_back(UNMANAGED_BUFFER);
+      } else if (i == 0 && forwardedUse != UNMANAGED_BUFFER) {
+        // the outlet carries the value at the inlet of the source, and so shares its buffer
+        intervalIndex[buffer] = forwardedUse;
+        uses.push_back(forwardedUse);
+      } else {
+        uses.push_back(addWrite(buffer, objectPosition, objectPartition));
+      }
+    }
+  }
+  
+  // a buffer which is read before it is written carries the value last written to it from one block
+  // to the next. That value is live throughout.
+  unordered_map<float *, unsigned int> lastWrite(intervalIndex);
+  vector<unsigned int> carriedIntervals;
+  for (unsigned int i = 0; i < carriedReads.size(); i++) {
+    unordered_map<float *, unsigned int>::iterator it = lastWrite.find(carriedReads[i].first);
+    unsigned int index = (it == lastWrite.end())
+        ? addWrite(carriedReads[i].first, 0, carriedPartitions[i]) : it->second;
+    lastWrite[carriedReads[i].first] = index;
+    intervals[index].start = 0;
+    intervals[index].end = processOrder.size();
+    intervals[index].isReadAtEnd = false;
+    uses[carriedReads[i].second] = index;
+    carriedIntervals.push_back(index);
+  }
+  numBuffersBefore = intervalIndex.size();
+  
+  // colour the intervals of each partition in order of their start. Partitions do not share colours.
+  vector<unsigned int> order(intervals.size());
+  for (unsigned int i = 0; i < order.size(); i++) order[i] = i;
+  stable_sort(order.begin(), order.end(), IntervalStartComparator(&intervals));
+  
+  IntervalEndComparator endComparator(&intervals);
+  vector<unsigned int> active; // a heap of the intervals which are currently live
+  vector<unsigned int> freeColours; // a stack of colours which are not currently in use
+  numBuffersAfter = 0;
+  for (int i = 0; i < order.size(); i++) {
+    LiveInterval *interval = &intervals[order[i]];
+    if (i > 0 && interval->partition != intervals[order[i-1]].partition) {
+      active.clear();
+      freeColours.clear();
+    }
+    while (!active.empty()) {
+      LiveInterval *top = &intervals[active.front()];
+      // a buffer which is last read by the object writing this one may be reused (in place)
+      if (top->end < interval->start || (top->end == interval->start && top->isReadAtEnd)) {
+        freeColours.push_back(top->colour);
+        pop_heap(active.begin(), active.end(), endComparator);
+        active.pop_back();
+      } else {
+        break;
+      }
+    }
+    if (freeColours.empty()) {
+      interval->colour = numBuffersAfter++;
+    } else {
+      interval->colour = freeColours.back();
+      freeColours.pop_back();
+    }
+    active.push_back(order[i]);
+    push_heap(active.begin(), active.end(), endComparator);
+  }
+  
+  // determine the buffer for each colour. Existing buffers can only be reused if there are enough.
+  vector<float *> colourBuffers(numBuffersAfter, (float *) NULL);
+  float *previousArena = NULL;
+  if ((isArenaEnabled || numBuffersAfter > numBuffersBefore) && numBuffersAfter > 0) {
+    previousArena = arena;
+    unsigned int previousArenaStride = arenaStride;
+    unsigned int previousArenaSize = arenaNumBuffers * arenaStride;
+    // keep each buffer 16-byte aligned
+    arenaStride = (bufferPool->getBufferSize() + 3) & ~3;
+    arenaNumBuffers = numBuffersAfter;
+    arena = ALLOC_ALIGNED_BUFFER(arenaNumBuffers * arenaStride * sizeof(float));
+    for (unsigned int i = 0; i < numBuffersAfter; i++) {
+      colourBuffers[i] = arena + (i * arenaStride);
+    }
+    
+    // the values carried from one block to the next move to their new buffers, such that recompiling
+    // does not interrupt the signal. Only the other buffers are cleared.
+    vector<char> isCarried(numBuffersAfter, 0);
+    for (unsigned int i = 0; i < carriedIntervals.size(); i++) {
+      LiveInterval *interval = &intervals[carriedIntervals[i]];
+      if (isCarried[interval->colour]) continue;
+      isCarried[interval->colour] = 1;
+      bool isInPreviousArena = previousArena != NULL && interval->buffer >= previousArena &&
+          interval->buffer < previousArena + previousArenaSize;
+      unsigned int numSamples = isInPreviousArena
+          ? min(previousArenaStride, arenaStride) : bufferPool->getBufferSize();
+      memcpy(colourBuffers[interval->colour], interval->buffer, numSamples * sizeof(float));
+    }
+    for (unsigned int i = 0; i < numBuffersAfter; i++) {
+      if (!isCarried[i]) memset(colourBuffers[i], 0, arenaStride * sizeof(float));
+    }
+  } else {
+    // reuse one of the existing buffers of each colour, such that no two colours share a buffer. A
+    // value carried from one block to the next keeps its buffer, and so is not interrupted.
+    unordered_map<float *, bool> isBufferUsed;
+    for (unsigned int i = 0; i < carriedIntervals.size(); i++) {
+      LiveInterval *interval = &intervals[carriedIntervals[i]];
+      if (colourBuffers[interval->colour] == NULL && !isBufferUsed[interval->buffer]) {
+        colourBuffers[interval->colour] = interval->buffer;
+        isBufferUsed[interval->buffer] = true;
+      }
+    }
+    for (int i = 0; i < intervals.size(); i++) {
+      if (colourBuffers[intervals[i].colour] == NULL && !isBufferUsed[intervals[i].buffer]) {
+        colourBuffers[intervals[i].colour] = intervals[i].buffer;
+        isBufferUsed[intervals[i].buffer] = true;
+      }
+    }
+    unordered_map<float *, bool>::iterator it = isBufferUsed.begin();
+    for (unsigned int i = 0; i < numBuffersAfter; i++) {
+      if (colourBuffers[i] != NULL) continue;
+      while (it->second) it++;
+      colourBuffers[i] = it->first;
+      it->second = true;
+    }
+  }
+  
+  // replace the buffers of all objects, and route the signals received by name
+  unsigned int u = 0;
+  unsigned int s = 0;
+  for (unsigned int p = 0; p < processOrder.size(); p++) {
+    DspObject *dspObject = processOrder[p];
+    for (int i = 0; i < dspObject->getNumDspInlets(); i++, u++) {
+      if (uses[u] != UNMANAGED_BUFFER) {
+        dspObject->setDspBufferAtInlet(colourBuffers[intervals[uses[u]].colour], i);
+      }
+    }
+    for (int i = 0; i < dspObject->getNumDspOutlets(); i++) {
+      if (!dspObject->canSetBufferAtOutlet(i)) continue;
+      if (uses[u] != UNMANAGED_BUFFER) {
+        dspObject->setDspBufferAtOutlet(colourBuffers[intervals[uses[u]].colour], i);
+      }
+      u++;
+    }
+    for (int k = 0; k < dspObject->getNumSignalSources(); k++, s++) {
+      dspObject->setSignalSourceBuffer(k, (sourceUses[s] == UNMANAGED_BUFFER)
+          ? NULL : colourBuffers[intervals[sourceUses[s]].colour]);
+    }
+    dspObject->setSignalCopyRequired(isCopyRequired.find(dspObject) != isCopyRequired.end());
+  }
+  
+  // no object refers to the previous arena anymore
+  if (previousArena != NULL) FREE_ALIGNED_BUFFER(previousArena);
+}
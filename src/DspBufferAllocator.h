@@ -0,0 +1,144 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _DSP_BUFFER_ALLOCATOR_H_
+#define _DSP_BUFFER_ALLOCATOR_H_
+
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+class BufferPool;
+class DspObject;
+class PdGraph;
+
+/**
+ * The <code>DspBufferAllocator</code> is a compile step which runs once the process order of all
+ * graphs has been computed. The buffers handed out by the <code>BufferPool</code> while the process
+ * order is computed depend on the order of the traversal, and are generally more than necessary.
+ *
+ * The allocator walks the flattened process order and computes the live interval of each value
+ * written to a buffer, from the object which writes it to the last object which reads it. A buffer
+ * which is read before it is written carries its last value from one block to the next, which is
+ * then live throughout. The intervals are
+ * then coloured greedily in order of their start, which for interval graphs requires the fewest
+ * possible buffers. As with the <code>BufferPool</code>, a buffer whose last reader is an object
+ * may be reused for that object's outlets.
+ *
+ * Signals which are received by name rather than through a connection, such as from a [send~] or a
+ * [throw~], are treated as connections from the inlet of the source wherever the source is always
+ * processed earlier in the same block. The reader then shares the source's input buffer, which
+ * remains live until the reader has been processed, and no copy is made. Only sources with a reader
+ * which is processed first, or which is otherwise processed under different conditions (e.g. in a
+ * graph with a [switch~] or a different block size), copy their input.
+ *
+ * Buffers are either remapped onto a subset of the pool's buffers or, if the arena is enabled, laid
+ * out in one contiguous aligned arena owned by the allocator, such that the working set is compact.
+ */
+class DspBufferAllocator {
+  
+  public:
+    DspBufferAllocator(BufferPool *bufferPool);
+    ~DspBufferAllocator();
+  
+    /**
+     * Reassigns the signal buffers of all objects in the process order of the given graphs, which
+     * are processed in the given order.
+     */
+    void allocateBuffers(vector<PdGraph *> *graphList);
+  
+    /**
+     * Reassigns the signal buffers of all objects in the given process order, which determines the
+     * value read by each inlet. If positions are given, the objects are processed in the order of
+     * their positions instead, e.g. as scheduled over several threads. Each reading object must
+     * nonetheless follow the object writing its input. If a partition is given, it assigns each
+     * object to a partition. The buffers written by the objects of one partition are never shared
+     * with those of another, such that partitions may be processed concurrently. The objects of a
+     * partition may nonetheless read the buffers of another, in which case these remain live until
+     * the last such read.
+     */
+    void allocateBuffers(vector<DspObject *> *processOrder, vector<unsigned int> *position,
+        vector<unsigned int> *partition);
+  
+    /** Enables or disables the contiguous buffer arena. It takes effect with the next allocation. */
+    void setArenaEnabled(bool enabled) { isArenaEnabled = enabled; }
+  
+    /** Returns the number of distinct buffers used by the process order before the last allocation. */
+    unsigned int getNumBuffersBefore() { return numBuffersBefore; }
+  
+    /** Returns the number of distinct buffers used by the process order after the last allocation. */
+    unsigned int getNumBuffersAfter() { return numBuffersAfter; }
+  
+    /** Returns true if the buffer is managed by this allocator, i.e. from the pool or the arena. */
+    bool isManagedBuffer(float *buffer);
+  
+  private:
+    typedef struct LiveInterval {
+      float *buffer;
+      unsigned int partition;
+      unsigned int start;
+      unsigned int end;
+      bool isReadAtEnd; // true if the buffer is only read (not written) by the object at the end
+      unsigned int colour;
+    } LiveInterval;
+  
+    struct IntervalStartComparator;
+    struct IntervalEndComparator;
+  
+    /**
+     * Adds the interval of a value written to the buffer by the object at the given position, which
+     * belongs to the given partition. Returns the index of the interval.
+     */
+    unsigned int addWrite(float *buffer, unsigned int position, unsigned int partition);
+  
+    /**
+     * Extends the interval with the given index to a read by the object at the given position. Unless
+     * the read is reusable, the object may not write any of its outlets to the same buffer.
+     */
+    void addRead(unsigned int index, unsigned int position, bool isReusable = true);
+  
+    /**
+     * Returns true if the reader of a signal received by name may read the buffer at the inlet of its
+     * source, given that the source precedes it. This is the case if the source is processed with the
+     * same block size and whenever the reader is processed.
+     */
+    static bool canShareSignal(DspObject *source, DspObject *reader);
+  
+    /** Returns true if the object belongs to the given graph or to one of its subgraphs. */
+    static bool isInGraph(DspObject *dspObject, PdGraph *graph);
+  
+    BufferPool *bufferPool;
+  
+    /** The live intervals of all values, and the index of the last value written to each buffer. */
+    vector<LiveInterval> intervals;
+    unordered_map<float *, unsigned int> intervalIndex;
+  
+    bool isArenaEnabled;
+    float *arena;
+    unsigned int arenaNumBuffers;
+    unsigned int arenaStride;
+  
+    unsigned int numBuffersBefore;
+    unsigned int numBuffersAfter;
+};
+
+#endif // _DSP_BUFFER_ALLOCATOR_H_
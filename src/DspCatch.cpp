@@ -20,6 +20,7 @@
  *
  */
 
+#include <algorithm>
 #include "ArrayArithmetic.h"
 #include "BufferPool.h"
 #include "DspCatch.h"
@@ -54,29 +55,40 @@ string DspCatch::toString() {
 
 void DspCatch::addThrow(DspThrow *dspThrow) {
   if (!strcmp(dspThrow->getName(), name)) { // make sure that the throw~ really does match this catch~
-    throwList.push_back(dspThrow); // NOTE(mhroth): no dupicate detection
-    
-    // update the process function
-    switch (throwList.size()) {
-      case 0: processFunction = &processNone; break;
-      case 1: processFunction = &processOne; break;
-      default: processFunction = &processMany; break;
-    }
+    throws.push_back(dspThrow); // NOTE(mhroth): no dupicate detection
+    inputBuffers.push_back(dspThrow->getBuffer());
+    updateProcessFunction();
   }
 }
 
 void DspCatch::removeThrow(DspThrow *dspThrow) {
   if (!strcmp(dspThrow->getName(), name)) {
-    throwList.remove(dspThrow);
-    
-    switch (throwList.size()) {
-      case 0: processFunction = &processNone; break;
-      case 1: processFunction = &processOne; break;
-      default: processFunction = &processMany; break;
+    // the input of the remaining throw~s is read from their copies until the buffers are reallocated
+    throws.erase(remove(throws.begin(), throws.end(), dspThrow), throws.end());
+    inputBuffers.clear();
+    for (int i = 0; i < throws.size(); i++) {
+      inputBuffers.push_back(throws[i]->getBuffer());
     }
+    updateProcessFunction();
+  }
+}
+
+void DspCatch::updateProcessFunction() {
+  switch (throws.size()) {
+    case 0: processFunction = &processNone; break;
+    case 1: processFunction = &processOne; break;
+    default: processFunction = &processMany; break;
   }
 }
 
+DspObject *DspCatch::getSignalSource(int index) {
+  return throws[index];
+}
+
+void DspCatch::setSignalSourceBuffer(int index, float *buffer) {
+  inputBuffers[index] = (buffer != NULL) ? buffer : throws[index]->getBuffer();
+}
+
 void DspCatch::processNone(DspObject *dspObject, int fromIndex, int toIndex) {
   DspCatch *d = reinterpret_cast<DspCatch *>(dspObject);
   memset(d->dspBufferAtOutlet[0], 0, toIndex*sizeof(float));
@@ -84,19 +96,22 @@ void DspCatch::processNone(DspObject *dspObject, int fromIndex, int toIndex) {
 
 void DspCatch::processOne(DspObject *dspObject, int fromIndex, int toIndex) {
   DspCatch *d = reinterpret_cast<DspCatch *>(dspObject);
-  DspThrow *dspThrow = d->throwList.front();
-  memcpy(d->dspBufferAtOutlet[0], dspThrow->getBuffer(), toIndex*sizeof(float));
+  // the outlet may share the buffer of the only input
+  if (d->dspBufferAtOutlet[0] != d->inputBuffers[0]) {
+    memcpy(d->dspBufferAtOutlet[0], d->inputBuffers[0], toIndex*sizeof(float));
+  }
 }
 
-// process at least two throw~s
+// process at least two throw~s. The inputs are summed in the order of the throw~s, such that the
+// output does not depend on which buffers are shared. Only the first may share the outlet's buffer.
 void DspCatch::processMany(DspObject *dspObject, int fromIndex, int toIndex) {
   DspCatch *d = reinterpret_cast<DspCatch *>(dspObject);
-  list<DspThrow *>::iterator it = d->throwList.begin();
-  ArrayArithmetic::add((*it++)->getBuffer(), (*it++)->getBuffer(), d->dspBufferAtOutlet[0], 0, toIndex);
-  while (it != d->throwList.end()) {
-    ArrayArithmetic::add(d->dspBufferAtOutlet[0], (*it++)->getBuffer(), d->dspBufferAtOutlet[0],
-        0, toIndex);
-  };
+  float *output = d->dspBufferAtOutlet[0];
+  vector<float *> &inputs = d->inputBuffers;
+  ArrayArithmetic::add(inputs[0], inputs[1], output, 0, toIndex);
+  for (int i = 2; i < inputs.size(); i++) {
+    ArrayArithmetic::add(output, inputs[i], output, 0, toIndex);
+  }
 }
 
 // catch objects should be processed after their corresponding throw object even though
@@ -109,7 +124,7 @@ list<DspObject *> DspCatch::getProcessOrder() {
     isOrdered = true;
     list<DspObject *> processList;
     
-    for (std::list<DspThrow *>::iterator throwIt = throwList.begin(); throwIt != throwList.end(); ++throwIt) {
+    for (vector<DspThrow *>::iterator throwIt = throws.begin(); throwIt != throws.end(); ++throwIt) {
       list<DspObject *> parentProcessList = (*throwIt)->getProcessOrder();
       // combine the process lists
       processList.splice(processList.end(), parentProcessList);
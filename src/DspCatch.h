@@ -29,7 +29,8 @@ class DspThrow;
 
 /**
  * [catch~ symbol]
- * Implements the receiver of a many-to-one audio connection.
+ * Implements the receiver of a many-to-one audio connection. The input of each [throw~] is read from
+ * the buffer set by <code>setSignalSourceBuffer()</code>, or from the copy made by the [throw~].
  */
 class DspCatch : public DspObject {
   
@@ -43,6 +44,10 @@ class DspCatch : public DspObject {
     void addThrow(DspThrow *dspThrow);
     void removeThrow(DspThrow *dspThrow);
   
+    int getNumSignalSources() { return throws.size(); }
+    DspObject *getSignalSource(int index);
+    void setSignalSourceBuffer(int index, float *buffer);
+  
     const char *getName() { return name; }
     static const char *getObjectLabel() { return "catch~"; }
     ObjectType getObjectType() { return DSP_CATCH; }
@@ -52,9 +57,13 @@ class DspCatch : public DspObject {
     static void processNone(DspObject *dspObject, int fromIndex, int toIndex);
     static void processOne(DspObject *dspObject, int fromIndex, int toIndex);
     static void processMany(DspObject *dspObject, int fromIndex, int toIndex);
+  
+    /** Updates the process function according to the number of associated throw~s. */
+    void updateProcessFunction();
     
     char *name;
-    list<DspThrow *> throwList; // list of associated throw~ objects
+    vector<DspThrow *> throws; // associated throw~ objects
+    vector<float *> inputBuffers; // the buffer from which the input of each throw~ is read
 };
 
 #endif // _DSP_CATCH_H_
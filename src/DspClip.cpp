@@ -22,6 +22,7 @@
 
 #include "ArrayArithmetic.h"
 #include "DspClip.h"
+#include "DspFusedChain.h"
 
 class PdGraph;
 
@@ -46,6 +47,14 @@ std::string DspClip::toString() {
   return str;
 }
 
+bool DspClip::getElementwiseOperation(ElementwiseOperation *operation) {
+  operation->op = ELEMENTWISE_CLIP;
+  operation->signalInlet = -1;
+  operation->constants[0] = &lowerBound;
+  operation->constants[1] = &upperBound;
+  return true;
+}
+
 void DspClip::processMessage(int inletIndex, PdMessage *message) {
   switch (inletIndex) {
     case 1: if (message->isFloat(0)) lowerBound = message->getFloat(0); break; // set the lower bound
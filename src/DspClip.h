@@ -34,6 +34,7 @@ class DspClip : public DspObject {
 
     static const char *getObjectLabel();
     std::string toString();
+    bool getElementwiseOperation(ElementwiseOperation *operation);
 
   private:
    static void processScalar(DspObject *dspObject, int fromIndex, int toIndex);
@@ -37,11 +37,7 @@ class DspCosine : public DspObject {
     std::string toString();
 
   private:
-    static void procesSignal(DspObject *dspObject, int fromIndex, int toIndex);
-  
-    float sampleRate;
-    static float *cos_table; // the Cosine lookup table
-    static int refCount; // a reference counter for Cosine table. Now we know when to free it.
+    static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
 };
 
 inline std::string DspCosine::toString() {
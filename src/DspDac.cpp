@@ -22,50 +22,86 @@
 
 #include "ArrayArithmetic.h"
 #include "DspDac.h"
+#include "PdContext.h"
 #include "PdGraph.h"
 
 MessageObject *DspDac::newObject(PdMessage *initMessage, PdGraph *graph) {
-  return new DspDac(graph);
+  return new DspDac(initMessage, graph);
 }
 
-DspDac::DspDac(PdGraph *graph) : DspObject(0, graph->getNumOutputChannels(), 0, 0, graph) {
-  // cache pointers to global output buffers in dspBufferAtOutlet
-  int numInlets = graph->getNumOutputChannels();
-  if (numInlets > 2) dspBufferAtOutlet[2] = (float *) calloc(numInlets-2, sizeof(float *));
+int DspDac::getNumChannelArguments(PdMessage *initMessage) {
+  int numChannels = 0;
+  while (numChannels < initMessage->getNumElements() && initMessage->isFloat(numChannels)) {
+    numChannels++;
+  }
+  return numChannels;
+}
+
+DspDac::DspDac(PdMessage *initMessage, PdGraph *graph) : DspObject(0,
+    (getNumChannelArguments(initMessage) > 0)
+        ? getNumChannelArguments(initMessage) : graph->getNumOutputChannels(), 0, 0, graph) {
+  int numOutputChannels = graph->getNumOutputChannels();
+  int numChannelArguments = getNumChannelArguments(initMessage);
+  if (numChannelArguments == 0) {
+    for (int i = 0; i < numOutputChannels; i++) {
+      channels.push_back(i);
+    }
+  } else {
+    for (int i = 0; i < numChannelArguments; i++) {
+      int channel = ((int) initMessage->getFloat(i)) - 1;
+      if (channel < 0 || channel >= numOutputChannels) {
+        graph->printErr("dac~: output channel %i does not exist and is ignored.", channel + 1);
+        channel = -1;
+      }
+      channels.push_back(channel);
+    }
+  }
+  // the global output buffers hold one block of the context. A reblocked graph cannot write to them.
+  if (graph->getBlockSize() != graph->getContext()->getBlockSize()) {
+    graph->printErr("dac~: bad vector size. The output is ignored in a graph with a block size of %i.",
+        graph->getBlockSize());
+    channels.assign(channels.size(), -1);
+  }
+  isOverwriting.assign(channels.size(), 0);
   
-  for (int i = 0; i < numInlets; i++) {
-    setDspBufferAtOutlet(graph->getGlobalDspBufferAtOutlet(i), i);
+  // cache pointers to the global output buffers
+  for (int i = 0; i < channels.size(); i++) {
+    outputBuffers.push_back((channels[i] >= 0) ? graph->getGlobalDspBufferAtOutlet(channels[i]) : NULL);
   }
   
   processFunction = &processSignal;
 }
 
 DspDac::~DspDac() {
-  free(dspBufferAtOutlet[2]);
+  // nothing to do
+}
+
+int DspDac::getOutputChannel(int inletIndex) {
+  return incomingDspConnections[inletIndex].empty() ? -1 : channels[inletIndex];
+}
+
+void DspDac::setOverwritesOutput(int inletIndex, bool overwrites) {
+  isOverwriting[inletIndex] = overwrites;
+}
+
+void DspDac::onInletConnectionUpdate(unsigned int inletIndex) {
+  // only connected inlets are written to the output
+  outputInlets.clear();
+  for (int i = 0; i < channels.size(); i++) {
+    if (getOutputChannel(i) >= 0) outputInlets.push_back(i);
+  }
 }
 
 void DspDac::processSignal(DspObject *dspObject, int fromIndex, int toIndex) {
   DspDac *d = reinterpret_cast<DspDac *>(dspObject);
-  switch (d->incomingDspConnections.size()) {
-    default: {
-      /* TODO(mhroth): fit this into the new buffer reference architecture
-      for (int i = 2; i < numDspInlets; i++) {
-        float *globalOutputBuffer = graph->getGlobalDspBufferAtOutlet(i);
-        ArrayArithmetic::add(globalOutputBuffer, localDspBufferAtInlet[i], globalOutputBuffer, 0, blockSizeInt);
-      }
-      */
-      // allow fallthrough
-    }
-    case 2: {
-      ArrayArithmetic::add(d->dspBufferAtOutlet[1], d->dspBufferAtInlet[1],
-          d->dspBufferAtOutlet[1], 0, toIndex);
-      // allow fallthrough
-    }
-    case 1: {
-      ArrayArithmetic::add(d->dspBufferAtOutlet[0], d->dspBufferAtInlet[0],
-          d->dspBufferAtOutlet[0], 0, toIndex);
-      // allow fallthrough
+  for (int i = 0; i < d->outputInlets.size(); i++) {
+    int inletIndex = d->outputInlets[i];
+    float *input = d->getDspBufferAtInlet(inletIndex);
+    float *output = d->outputBuffers[inletIndex];
+    if (d->isOverwriting[inletIndex]) {
+      memcpy(output, input, toIndex*sizeof(float));
+    } else {
+      ArrayArithmetic::add(output, input, output, 0, toIndex);
     }
-    case 0: break;
   }
 }
@@ -25,18 +25,52 @@
 
 #include "DspObject.h"
 
+/**
+ * [dac~], [dac~ channel...]
+ * Each inlet is written to the given output channel, counting from 1. Without arguments, there is
+ * one inlet for each output channel of the context. The first [dac~] inlet processed in each block
+ * which writes a channel overwrites it, and any others add to it (see
+ * <code>PdContext::compileDspOutputs()</code>), such that the output need not be cleared.
+ * A [dac~] in a graph whose block size differs from that of the context writes to no channel.
+ */
 class DspDac : public DspObject {
   
   public:
     static MessageObject *newObject(PdMessage *initMessage, PdGraph *graph);
-    DspDac(PdGraph *graph);
+    DspDac(PdMessage *initMessage, PdGraph *graph);
     ~DspDac();
   
     static const char *getObjectLabel();
     std::string toString();
+    ObjectType getObjectType() { return DSP_DAC; }
+  
+    /**
+     * Returns the output channel to which the signal at the given inlet is written, or -1 if it is
+     * not written to any channel, e.g. because the inlet is not connected.
+     */
+    int getOutputChannel(int inletIndex);
+  
+    /**
+     * Sets whether the signal at the given inlet overwrites its output channel, or is added to it.
+     * It is added by default.
+     */
+    void setOverwritesOutput(int inletIndex, bool overwrites);
   
   private:
     static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
+  
+    /** Returns the number of leading float arguments, which are the output channels. */
+    static int getNumChannelArguments(PdMessage *initMessage);
+  
+    void onInletConnectionUpdate(unsigned int inletIndex);
+  
+    /** The output channel of each inlet, or -1 if there is no such channel, and its buffer. */
+    vector<int> channels;
+    vector<float *> outputBuffers;
+  
+    /** The inlets which are written to an output, and whether each overwrites it. */
+    vector<int> outputInlets;
+    vector<char> isOverwriting;
 };
 
 inline std::string DspDac::toString() {
@@ -30,16 +30,16 @@ MessageObject *DspDelayWrite::newObject(PdMessage *initMessage, PdGraph *graph)
 
 DspDelayWrite::DspDelayWrite(PdMessage *initMessage, PdGraph *graph) : DspObject(0, 1, 0, 0, graph) {
   if (initMessage->isSymbol(0) && initMessage->isFloat(1)) {
+    // vd~ reads two samples beyond the delay for its 4-point interpolation
     bufferLength = (int) ceilf(StaticUtils::millisecondsToSamples(initMessage->getFloat(1), 
-        graph->getSampleRate())); 
+        graph->getSampleRate())) + 2; 
     if (bufferLength % blockSizeInt != 0) {
       bufferLength = ((bufferLength/blockSizeInt)+2) * blockSizeInt;
     } else {
       bufferLength += blockSizeInt;
     }
     headIndex = 0;
-    // buffer[bufferLength] == buffer[0], which makes calculation in vd~ easier
-    int numBufferLengthBytes = (bufferLength+1)*sizeof(float);
+    int numBufferLengthBytes = bufferLength*sizeof(float);
     dspBufferAtOutlet[0] = ALLOC_ALIGNED_BUFFER(numBufferLengthBytes);
     memset(dspBufferAtOutlet[0], 0, numBufferLengthBytes); // zero the delay buffer
     name = StaticUtils::copyString(initMessage->getSymbol(0));
@@ -63,7 +63,6 @@ void DspDelayWrite::processSignal(DspObject *dspObject, int fromIndex, int toInd
   
   // copy inlet buffer to delay buffer
   memcpy(d->dspBufferAtOutlet[0] + d->headIndex, d->dspBufferAtInlet[0], toIndex*sizeof(float));
-  if (d->headIndex == 0) d->dspBufferAtOutlet[0][d->bufferLength] = d->dspBufferAtOutlet[0][0];
   d->headIndex += toIndex;
   if (d->headIndex >= d->bufferLength) d->headIndex = 0;
 }
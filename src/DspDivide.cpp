@@ -22,6 +22,7 @@
 
 #include "ArrayArithmetic.h"
 #include "DspDivide.h"
+#include "DspFusedChain.h"
 #include "PdGraph.h"
 
 MessageObject *DspDivide::newObject(PdMessage *initMessage, PdGraph *graph) {
@@ -39,8 +40,20 @@ DspDivide::~DspDivide() {
 }
 
 void DspDivide::onInletConnectionUpdate(unsigned int inletIndex) {
-  processFunction = (incomingDspConnections[0].size() > 0 && incomingDspConnections[1].size() > 0)
+  // because onInletConnectionUpdate can only be called at block boundaries, it is guaranteed
+  // that no messages will be in the message queue.
+  processFunctionNoMessage = (incomingDspConnections[0].size() > 0 && incomingDspConnections[1].size() > 0)
       ? &processSignal : &processScalar;
+  processFunction = processFunctionNoMessage;
+}
+
+bool DspDivide::getElementwiseOperation(ElementwiseOperation *operation) {
+  operation->op = ELEMENTWISE_DIVIDE;
+  // as when processed alone, a signal at the right inlet is only used if the left is connected too
+  operation->signalInlet = (processFunctionNoMessage == &processSignal) ? 1 : -1;
+  operation->constants[0] = &constant;
+  operation->constants[1] = NULL;
+  return true;
 }
 
 string DspDivide::toString() {
@@ -34,14 +34,15 @@ class DspDivide : public DspObject {
 
     static const char *getObjectLabel();
     std::string toString();
+  
+    void onInletConnectionUpdate(unsigned int inletIndex);
+    bool getElementwiseOperation(ElementwiseOperation *operation);
 
   private:
     static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
     static void processScalar(DspObject *dspObject, int fromIndex, int toIndex);
     void processMessage(int inletIndex, PdMessage *message);
   
-    void onInletConnectionUpdate(unsigned int inletIndex);
-  
     float constant;
 };
 
@@ -45,6 +45,9 @@ class DspEnvelope : public DspObject {
 
     ConnectionType getConnectionType(int outletIndex) { return MESSAGE; }
   
+    // the envelope is scheduled whether or not the outlet is connected
+    bool mustProcessSerially() { return true; }
+  
   private:
     static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
   
@@ -0,0 +1,150 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include "DspExecutionPlan.h"
+#include "DspObject.h"
+#include "PdGraph.h"
+
+DspExecutionPlan::DspExecutionPlan() {
+  // nothing to do
+}
+
+DspExecutionPlan::~DspExecutionPlan() {
+  // nothing to do
+}
+
+
+#pragma mark - Compile
+
+void DspExecutionPlan::compile(vector<PdGraph *> *graphList) {
+  steps.clear();
+  for (vector<PdGraph *>::iterator it = graphList->begin(); it != graphList->end(); ++it) {
+    compileGraph(*it, 0, &steps);
+  }
+  invalidGraphs.clear();
+}
+
+void DspExecutionPlan::compileGraph(PdGraph *graph, unsigned int baseIndex,
+    vector<DspExecutionStep> *stepList) {
+  unsigned int guardIndex = stepList->size();
+  DspExecutionStep guard = {graph, 0, 0, 0};
+  stepList->push_back(guard);
+  
+  int blockSize = graph->getBlockSize();
+  list<DspObject *> *dspNodeList = graph->getDspNodeList();
+  for (list<DspObject *>::iterator it = dspNodeList->begin(); it != dspNodeList->end(); ++it) {
+    DspObject *dspObject = *it;
+    if (dspObject->getObjectType() == OBJECT_PD &&
+        !reinterpret_cast<PdGraph *>(dspObject)->isReblocked()) {
+      compileGraph(reinterpret_cast<PdGraph *>(dspObject), baseIndex, stepList);
+    } else {
+      DspExecutionStep step = {dspObject, 0, blockSize, 0};
+      stepList->push_back(step);
+    }
+  }
+  
+  // the guard is never the last step, so graphEnd is never 0 for a guard
+  stepList->at(guardIndex).graphEnd = baseIndex + stepList->size();
+}
+
+
+#pragma mark - Incremental Update
+
+void DspExecutionPlan::invalidateGraph(PdGraph *graph) {
+  // the process order of a subgraph depends on its parent, so the attached graph is recompiled
+  while (graph->getParentGraph() != NULL) {
+    graph = graph->getParentGraph();
+  }
+  if (find(invalidGraphs.begin(), invalidGraphs.end(), graph) == invalidGraphs.end()) {
+    invalidGraphs.push_back(graph);
+  }
+}
+
+void DspExecutionPlan::removeGraph(PdGraph *graph) {
+  invalidGraphs.erase(remove(invalidGraphs.begin(), invalidGraphs.end(), graph), invalidGraphs.end());
+  int guardIndex = findGraph(graph);
+  if (guardIndex >= 0) {
+    vector<DspExecutionStep> emptyList;
+    spliceSteps(guardIndex, steps[guardIndex].graphEnd, &emptyList);
+  }
+}
+
+bool DspExecutionPlan::update() {
+  if (invalidGraphs.empty()) return false;
+  
+  for (vector<PdGraph *>::iterator it = invalidGraphs.begin(); it != invalidGraphs.end(); ++it) {
+    PdGraph *graph = *it;
+    int guardIndex = findGraph(graph);
+    if (guardIndex >= 0) {
+      graph->computeDeepLocalDspProcessOrder();
+      vector<DspExecutionStep> stepList;
+      compileGraph(graph, guardIndex, &stepList);
+      spliceSteps(guardIndex, steps[guardIndex].graphEnd, &stepList);
+    }
+  }
+  invalidGraphs.clear();
+  return true;
+}
+
+int DspExecutionPlan::findGraph(PdGraph *graph) {
+  // only the guards of attached graphs are visited, by jumping from one span to the next
+  unsigned int i = 0;
+  while (i < steps.size()) {
+    if (steps[i].dspObject == graph) return i;
+    i = steps[i].graphEnd;
+  }
+  return -1;
+}
+
+void DspExecutionPlan::spliceSteps(unsigned int fromIndex, unsigned int toIndex,
+    vector<DspExecutionStep> *stepList) {
+  int delta = (int) stepList->size() - (int) (toIndex - fromIndex);
+  steps.erase(steps.begin() + fromIndex, steps.begin() + toIndex);
+  steps.insert(steps.begin() + fromIndex, stepList->begin(), stepList->end());
+  
+  // the spliced span is always that of an attached graph, so only the following guards are moved
+  for (unsigned int i = fromIndex + stepList->size(); i < steps.size(); ++i) {
+    if (steps[i].graphEnd != 0) steps[i].graphEnd += delta;
+  }
+}
+
+
+#pragma mark - Process
+
+void DspExecutionPlan::process() {
+  DspExecutionStep *stepArray = steps.data();
+  unsigned int numSteps = steps.size();
+  unsigned int i = 0;
+  while (i < numSteps) {
+    DspExecutionStep *step = stepArray + i;
+    if (step->graphEnd != 0) {
+      // DSP processing elements are only executed if the graph is switched on
+      i = reinterpret_cast<PdGraph *>(step->dspObject)->isSwitchedOn() ? i+1 : step->graphEnd;
+    } else {
+      // the process function is read at execution time, as it changes when messages are pending
+      DspObject *dspObject = step->dspObject;
+      dspObject->processFunction(dspObject, step->fromIndex, step->toIndex);
+      ++i;
+    }
+  }
+}
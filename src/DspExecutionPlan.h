@@ -0,0 +1,108 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _DSP_EXECUTION_PLAN_H_
+#define _DSP_EXECUTION_PLAN_H_
+
+#include <vector>
+using namespace std;
+
+class DspObject;
+class PdGraph;
+
+/**
+ * The <code>DspExecutionPlan</code> is the compiled form of the process order of all graphs attached
+ * to a context. The nested <code>dspNodeList</code>s of each graph and its subgraphs are flattened
+ * into one contiguous array of steps, such that a block is processed by a single loop rather than
+ * by walking linked lists and recursing into subgraphs.
+ *
+ * Each graph is represented by a guard step, followed by the steps of its contents. If the graph is
+ * switched off then processing jumps past its contents. The steps of each attached graph therefore
+ * occupy a contiguous span of the plan, which is recompiled in place when the graph changes.
+ * A reblocked subgraph (see <code>PdGraph::setBlockSize()</code>) is a single step, as it processes
+ * its contents at its own block size.
+ */
+class DspExecutionPlan {
+  
+  public:
+    typedef struct DspExecutionStep {
+      DspObject *dspObject;
+      int fromIndex;
+      int toIndex;
+      // for graph guards, the index of the step following the graph's contents. 0 for all other steps.
+      unsigned int graphEnd;
+    } DspExecutionStep;
+  
+    DspExecutionPlan();
+    ~DspExecutionPlan();
+  
+    /**
+     * Compiles the plan from the current process order of the given graphs, which are processed in
+     * the given order. Any pending invalidations are discarded.
+     */
+    void compile(vector<PdGraph *> *graphList);
+  
+    /**
+     * Marks the attached graph which contains the given graph as changed. Its process order is
+     * recomputed and its span of the plan recompiled with the next call to <code>update()</code>.
+     */
+    void invalidateGraph(PdGraph *graph);
+  
+    /** Removes the span of the given attached graph from the plan. */
+    void removeGraph(PdGraph *graph);
+  
+    /**
+     * Recomputes the process order of all graphs which have been invalidated since the last update,
+     * and splices their recompiled steps into the plan. Returns <code>true</code> if any graph was
+     * recompiled, in which case the signal buffers of the objects may have changed.
+     */
+    bool update();
+  
+    /** Executes all steps of the plan for one block. */
+    void process();
+  
+    /** Returns the number of steps in the plan, including graph guards. */
+    unsigned int getNumSteps() { return (unsigned int) steps.size(); }
+  
+    /** Returns the steps of the plan. They are valid until the plan is next changed. */
+    DspExecutionStep *getSteps() { return steps.data(); }
+  
+  private:
+    /**
+     * Appends the guard and contents of the given graph to the list of steps, where the first step in
+     * the list has the given index in the plan.
+     */
+    static void compileGraph(PdGraph *graph, unsigned int baseIndex, vector<DspExecutionStep> *stepList);
+  
+    /** Returns the index of the guard of the given attached graph, or -1 if it is not in the plan. */
+    int findGraph(PdGraph *graph);
+  
+    /** Replaces the steps [fromIndex, toIndex) with the given steps and fixes up following guards. */
+    void spliceSteps(unsigned int fromIndex, unsigned int toIndex, vector<DspExecutionStep> *stepList);
+  
+    vector<DspExecutionStep> steps;
+  
+    /** The attached graphs which have changed since the last update. */
+    vector<PdGraph *> invalidGraphs;
+};
+
+#endif // _DSP_EXECUTION_PLAN_H_
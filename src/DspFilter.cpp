@@ -25,48 +25,114 @@
 
 class PdGraph;
 
-DspFilter::DspFilter(int numMessageInlets, PdGraph *graph) : DspObject(numMessageInlets, 1, 0, 1, graph) {
+DspFilter::DspFilter(int numMessageInlets, int numDspInlets, PdGraph *graph) :
+    DspObject(numMessageInlets, numDspInlets, 0, 1, graph) {
+  weights = ALLOC_ALIGNED_BUFFER(32 * sizeof(float));
   x1 = x2 = y1 = y2 = 0.0f;
-
+  setCoefficients(1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+  
   processFunction = &processFilter;
   processFunctionNoMessage = &processFilter;
 }
 
 DspFilter::~DspFilter() {
-  // nothing to do
+  FREE_ALIGNED_BUFFER(weights);
+}
+
+void DspFilter::clear() {
+  x1 = x2 = y1 = y2 = 0.0f;
 }
 
-void DspFilter::onInletConnectionUpdate(unsigned int inletIndex) {
-  // TODO(mhroth)
+void DspFilter::setCoefficients(float b0, float b1, float b2, float a1, float a2) {
+  b[0] = b0; b[1] = b1; b[2] = b2; b[3] = a1; b[4] = a2;
+  
+  // the weights of each variable are the outputs of the recurrence when only that variable is one
+  for (int v = 0; v < 8; v++) {
+    float x[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}; // x[n-2..n+3]
+    float y[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}; // y[n-2..n+3]
+    switch (v) {
+      case 0: case 1: case 2: case 3: x[v+2] = 1.0f; break;
+      case 4: x[1] = 1.0f; break;
+      case 5: x[0] = 1.0f; break;
+      case 6: y[1] = 1.0f; break;
+      case 7: y[0] = 1.0f; break;
+    }
+    for (int j = 2; j < 6; j++) {
+      y[j] = b0*x[j] + b1*x[j-1] + b2*x[j-2] - a1*y[j-1] - a2*y[j-2];
+      weights[4*v + j-2] = y[j];
+    }
+  }
 }
 
 void DspFilter::processFilter(DspObject *dspObject, int fromIndex, int toIndex) {
   DspFilter *d = reinterpret_cast<DspFilter *>(dspObject);
+  float *input = d->dspBufferAtInlet[0];
+  float *output = d->dspBufferAtOutlet[0];
+  float x1 = d->x1, x2 = d->x2, y1 = d->y1, y2 = d->y2;
   
-  int n = toIndex - fromIndex; // number of samples to process
-  float *bufferIn = new float[n + 2]; // new inlet buffer
-  bufferIn[0] = d->x2; bufferIn[1] = d->x1;
-  memcpy(bufferIn+2, d->dspBufferAtInlet[0]+fromIndex, n*sizeof(float));
-  
-  float *bufferOut = new float[n + 2]; // new outlet buffer
-  bufferOut[0] = d->y2; bufferOut[1] = d->y1;
-  
-  #if __APPLE__
-  vDSP_deq22(bufferIn, 1, d->b, bufferOut, 1, n);
-  #else
-  int _toIndex = n + 2;
-  for (int i = 2; i < _toIndex; ++i) {
-    bufferOut[i] = d->b[0]*bufferIn[i] + d->b[1]*bufferIn[i-1] + d->b[2]*bufferIn[i-2] -
-        d->b[3]*bufferOut[i-1] - d->b[4]*bufferOut[i-2];
+  int i = fromIndex;
+  #if __SSE__
+  if (toIndex - i >= 4) {
+    __m128 w0 = _mm_load_ps(d->weights), w1 = _mm_load_ps(d->weights+4);
+    __m128 w2 = _mm_load_ps(d->weights+8), w3 = _mm_load_ps(d->weights+12);
+    __m128 wx1 = _mm_load_ps(d->weights+16), wx2 = _mm_load_ps(d->weights+20);
+    __m128 wy1 = _mm_load_ps(d->weights+24), wy2 = _mm_load_ps(d->weights+28);
+    __m128 vx1 = _mm_set1_ps(x1), vx2 = _mm_set1_ps(x2);
+    __m128 vy1 = _mm_set1_ps(y1), vy2 = _mm_set1_ps(y2);
+    for (; i <= toIndex - 4; i += 4) {
+      __m128 x = _mm_loadu_ps(input+i);
+      __m128 xa = _mm_add_ps(_mm_mul_ps(w0, _mm_shuffle_ps(x, x, 0x00)),
+          _mm_mul_ps(w1, _mm_shuffle_ps(x, x, 0x55)));
+      __m128 xb = _mm_add_ps(_mm_mul_ps(w2, _mm_shuffle_ps(x, x, 0xAA)),
+          _mm_mul_ps(w3, _mm_shuffle_ps(x, x, 0xFF)));
+      __m128 xc = _mm_add_ps(_mm_mul_ps(wx1, vx1), _mm_mul_ps(wx2, vx2));
+      // only the last term depends on the previous outputs
+      __m128 y = _mm_add_ps(_mm_add_ps(xa, xb), xc);
+      y = _mm_add_ps(y, _mm_add_ps(_mm_mul_ps(wy1, vy1), _mm_mul_ps(wy2, vy2)));
+      _mm_storeu_ps(output+i, y);
+      vx1 = _mm_shuffle_ps(x, x, 0xFF); vx2 = _mm_shuffle_ps(x, x, 0xAA);
+      vy1 = _mm_shuffle_ps(y, y, 0xFF); vy2 = _mm_shuffle_ps(y, y, 0xAA);
+    }
+    x1 = _mm_cvtss_f32(vx1); x2 = _mm_cvtss_f32(vx2);
+    y1 = _mm_cvtss_f32(vy1); y2 = _mm_cvtss_f32(vy2);
+  }
+  #elif __ARM_NEON__
+  if (toIndex - i >= 4) {
+    float32x4_t w0 = vld1q_f32(d->weights), w1 = vld1q_f32(d->weights+4);
+    float32x4_t w2 = vld1q_f32(d->weights+8), w3 = vld1q_f32(d->weights+12);
+    float32x4_t wx1 = vld1q_f32(d->weights+16), wx2 = vld1q_f32(d->weights+20);
+    float32x4_t wy1 = vld1q_f32(d->weights+24), wy2 = vld1q_f32(d->weights+28);
+    float32x4_t vx1 = vdupq_n_f32(x1), vx2 = vdupq_n_f32(x2);
+    float32x4_t vy1 = vdupq_n_f32(y1), vy2 = vdupq_n_f32(y2);
+    for (; i <= toIndex - 4; i += 4) {
+      float32x4_t x = vld1q_f32(input+i);
+      float32x2_t xlo = vget_low_f32(x), xhi = vget_high_f32(x);
+      float32x4_t xa = vmlaq_f32(vmulq_f32(w0, vdupq_lane_f32(xlo, 0)), w1, vdupq_lane_f32(xlo, 1));
+      float32x4_t xb = vmlaq_f32(vmulq_f32(w2, vdupq_lane_f32(xhi, 0)), w3, vdupq_lane_f32(xhi, 1));
+      float32x4_t xc = vmlaq_f32(vmulq_f32(wx1, vx1), wx2, vx2);
+      // only the last term depends on the previous outputs
+      float32x4_t y = vaddq_f32(vaddq_f32(xa, xb), xc);
+      y = vaddq_f32(y, vmlaq_f32(vmulq_f32(wy1, vy1), wy2, vy2));
+      vst1q_f32(output+i, y);
+      float32x2_t yhi = vget_high_f32(y);
+      vx1 = vdupq_lane_f32(xhi, 1); vx2 = vdupq_lane_f32(xhi, 0);
+      vy1 = vdupq_lane_f32(yhi, 1); vy2 = vdupq_lane_f32(yhi, 0);
+    }
+    x1 = vgetq_lane_f32(vx1, 0); x2 = vgetq_lane_f32(vx2, 0);
+    y1 = vgetq_lane_f32(vy1, 0); y2 = vgetq_lane_f32(vy2, 0);
   }
   #endif
   
-  memcpy(d->dspBufferAtOutlet[0]+fromIndex, bufferOut+2, n*sizeof(float));
+  float b0 = d->b[0], b1 = d->b[1], b2 = d->b[2], a1 = d->b[3], a2 = d->b[4];
+  for (; i < toIndex; i++) {
+    float x = input[i];
+    float y = b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2;
+    output[i] = y;
+    x2 = x1; x1 = x;
+    y2 = y1; y1 = y;
+  }
   
   // retain state
-  d->x2 = bufferIn[n]; d->x1 = bufferIn[n+1];
-  d->y2 = bufferOut[n]; d->y1 = bufferOut[n+1];
-
-  delete[] bufferIn;
-  delete[] bufferOut;
+  d->x1 = x1; d->x2 = x2;
+  d->y1 = y1; d->y2 = y2;
 }
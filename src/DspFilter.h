@@ -25,20 +25,39 @@
 
 #include "DspObject.h"
 
-/** The superclass of lop~, hip~, bp~, and biquad~ */
+/**
+ * The superclass of lop~, hip~, bp~, and biquad~. The filter is the biquad
+ * <code>y[n] = b0*x[n] + b1*x[n-1] + b2*x[n-2] - a1*y[n-1] - a2*y[n-2]</code>, with persistent
+ * state such that no memory is allocated while processing.
+ *
+ * The recurrence is vectorised by computing four outputs at once. Each of the four outputs is a
+ * linear combination of the four inputs and the two previous inputs and outputs, whose weights are
+ * precomputed when the coefficients change. The four outputs thus depend on the previous four only
+ * through the last two, rather than one after the other.
+ */
 class DspFilter : public DspObject {
   
   public:
-    DspFilter(int numMessageInlets, PdGraph *graph);
+    DspFilter(int numMessageInlets, int numDspInlets, PdGraph *graph);
     ~DspFilter();
-
-    void onInletConnectionUpdate(unsigned int inletIndex);
   
-  protected:  
+  protected:
     static void processFilter(DspObject *dspObject, int fromIndex, int toIndex);
+  
+    /** Sets the filter coefficients, as defined above. */
+    void setCoefficients(float b0, float b1, float b2, float a1, float a2);
+  
+    /** Resets the state of the filter. */
+    void clear();
     
     float x1, x2, y1, y2;
     float b[5]; // filter coefficients
+  
+    /**
+     * The weights of x[n..n+3], x[n-1], x[n-2], y[n-1] and y[n-2], in that order, with which
+     * y[n..n+3] are computed. Each weight is a vector of four.
+     */
+    float *weights;
 };
 
 #endif // _DSP_FILTER_H_
@@ -0,0 +1,363 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <math.h>
+#include <unordered_map>
+#include "DspFusedChain.h"
+#include "PdGraph.h"
+
+/*
+ * Each kernel applies one step of the chain to a range of whole vectors. The steps are applied one
+ * after another to a private buffer, which remains in the cache, such that the operation of each
+ * step is selected once per block rather than for each vector. Loads and stores are unaligned. As in
+ * ArrayArithmetic, the kernel for SSE, AVX or AVX-512 is chosen at runtime on x86. All operations are
+ * exactly rounded, or exactly match their scalar form, so every kernel computes the same result as
+ * the objects of the chain.
+ */
+
+#define STEP_LOOP(_vector, _width, _load, _store, _set1, _expression) \
+  if (operand == NULL) { \
+    _vector y = _set1(*step->constants[0]); \
+    for (int i = fromIndex; i < toIndex; i += _width) { \
+      _vector x = _load(input+i); \
+      _store(output+i, _expression); \
+    } \
+  } else { \
+    for (int i = fromIndex; i < toIndex; i += _width) { \
+      _vector x = _load(input+i); \
+      _vector y = _load(operand+i); \
+      _store(output+i, _expression); \
+    } \
+  }
+
+#define STEP_KERNEL(_name, _target, _vector, _width, _load, _store, _set1, \
+    _add, _sub, _mul, _div, _clip, _wrap) \
+  _target static void _name(DspFusedChain::Step *step, float *input, float *operand, float *output, \
+      int fromIndex, int toIndex) { \
+    switch (step->op) { \
+      case ELEMENTWISE_ADD: STEP_LOOP(_vector, _width, _load, _store, _set1, _add(x, y)); break; \
+      case ELEMENTWISE_SUBTRACT: STEP_LOOP(_vector, _width, _load, _store, _set1, _sub(x, y)); break; \
+      case ELEMENTWISE_MULTIPLY: STEP_LOOP(_vector, _width, _load, _store, _set1, _mul(x, y)); break; \
+      case ELEMENTWISE_DIVIDE: STEP_LOOP(_vector, _width, _load, _store, _set1, _div(x, y)); break; \
+      case ELEMENTWISE_CLIP: { \
+        _vector upper = _set1(*step->constants[1]); \
+        STEP_LOOP(_vector, _width, _load, _store, _set1, _clip(x, y, upper)); \
+        break; \
+      } \
+      case ELEMENTWISE_WRAP: { \
+        for (int i = fromIndex; i < toIndex; i += _width) { \
+          _store(output+i, _wrap(_load(input+i))); \
+        } \
+        break; \
+      } \
+      default: break; \
+    } \
+  }
+
+#if __SSE2__
+#include <immintrin.h>
+
+#pragma mark - SSE
+
+// as [clip~], the lower bound takes precedence, and inputs which are unordered with a bound pass
+static inline __m128 clipSse(__m128 x, __m128 lower, __m128 upper) {
+  __m128 isAbove = _mm_cmpgt_ps(x, upper);
+  __m128 isBelow = _mm_cmplt_ps(x, lower);
+  __m128 y = _mm_or_ps(_mm_and_ps(isAbove, upper), _mm_andnot_ps(isAbove, x));
+  return _mm_or_ps(_mm_and_ps(isBelow, lower), _mm_andnot_ps(isBelow, y));
+}
+
+// x - floorf(x). Values of at least 2^23 in magnitude (and infinities and NaNs) are their own floor.
+static inline __m128 wrapSse(__m128 x) {
+  __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+  t = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+  __m128 isSmall = _mm_cmplt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), x), _mm_set1_ps(8388608.0f));
+  return _mm_sub_ps(x, _mm_or_ps(_mm_and_ps(isSmall, t), _mm_andnot_ps(isSmall, x)));
+}
+
+STEP_KERNEL(processSse, , __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps,
+    _mm_add_ps, _mm_sub_ps, _mm_mul_ps, _mm_div_ps, clipSse, wrapSse)
+
+#if ARRAY_ARITHMETIC_DISPATCH
+#pragma mark - AVX
+
+#define TARGET_AVX __attribute__((target("avx")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+
+TARGET_AVX static inline __m256 clipAvx(__m256 x, __m256 lower, __m256 upper) {
+  __m256 y = _mm256_blendv_ps(x, upper, _mm256_cmp_ps(x, upper, _CMP_GT_OQ));
+  return _mm256_blendv_ps(y, lower, _mm256_cmp_ps(x, lower, _CMP_LT_OQ));
+}
+
+TARGET_AVX static inline __m256 wrapAvx(__m256 x) {
+  return _mm256_sub_ps(x, _mm256_floor_ps(x));
+}
+
+STEP_KERNEL(processAvx, TARGET_AVX, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps,
+    _mm256_add_ps, _mm256_sub_ps, _mm256_mul_ps, _mm256_div_ps, clipAvx, wrapAvx)
+
+#pragma mark - AVX-512
+
+TARGET_AVX512 static inline __m512 clipAvx512(__m512 x, __m512 lower, __m512 upper) {
+  __m512 y = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, upper, _CMP_GT_OQ), x, upper);
+  return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, lower, _CMP_LT_OQ), y, lower);
+}
+
+TARGET_AVX512 static inline __m512 wrapAvx512(__m512 x) {
+  return _mm512_sub_ps(x, _mm512_mask_roundscale_ps(x, 0xFFFF, x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+}
+
+STEP_KERNEL(processAvx512, TARGET_AVX512, __m512, 16, _mm512_loadu_ps, _mm512_storeu_ps,
+    _mm512_set1_ps, _mm512_add_ps, _mm512_sub_ps, _mm512_mul_ps, _mm512_div_ps, clipAvx512, wrapAvx512)
+#endif // ARRAY_ARITHMETIC_DISPATCH
+
+#elif __ARM_NEON__
+#include <arm_neon.h>
+
+#pragma mark - NEON
+
+// NEON has no exact division before ARMv8, and [/~] divides exactly
+static inline float32x4_t divideNeon(float32x4_t a, float32x4_t b) {
+  #if __aarch64__
+  return vdivq_f32(a, b);
+  #else
+  float x[4], y[4];
+  vst1q_f32(x, a);
+  vst1q_f32(y, b);
+  for (int i = 0; i < 4; i++) x[i] /= y[i];
+  return vld1q_f32(x);
+  #endif
+}
+
+static inline float32x4_t clipNeon(float32x4_t x, float32x4_t lower, float32x4_t upper) {
+  float32x4_t y = vbslq_f32(vcgtq_f32(x, upper), upper, x);
+  return vbslq_f32(vcltq_f32(x, lower), lower, y);
+}
+
+static inline float32x4_t wrapNeon(float32x4_t x) {
+  float32x4_t t = vcvtq_f32_s32(vcvtq_s32_f32(x));
+  t = vsubq_f32(t, vreinterpretq_f32_u32(vandq_u32(vcgtq_f32(t, x),
+      vreinterpretq_u32_f32(vdupq_n_f32(1.0f)))));
+  return vsubq_f32(x, vbslq_f32(vcltq_f32(vabsq_f32(x), vdupq_n_f32(8388608.0f)), t, x));
+}
+
+STEP_KERNEL(processNeon, , float32x4_t, 4, vld1q_f32, vst1q_f32, vdupq_n_f32,
+    vaddq_f32, vsubq_f32, vmulq_f32, divideNeon, clipNeon, wrapNeon)
+#endif
+
+#pragma mark - Fuse
+
+// the object to which the given one is fused, or NULL if the chain ends with it
+static DspObject *getNextInChain(DspObject *dspObject,
+    unordered_map<DspObject *, list<DspObject *>::iterator> *unfused) {
+  if (dspObject->getNumDspOutlets() != 1) return NULL;
+  list<ObjectLetPair> connections = dspObject->getOutgoingDspConnections(0);
+  if (connections.size() != 1 || connections.front().second != 0) return NULL;
+  DspObject *nextObject = reinterpret_cast<DspObject *>(connections.front().first);
+  if (unfused->find(nextObject) == unfused->end()) return NULL;
+  ElementwiseOperation operation;
+  if (!nextObject->getElementwiseOperation(&operation)) return NULL;
+  if (nextObject->getIncomingDspConnections(0).size() != 1) return NULL;
+  return nextObject;
+}
+
+void DspFusedChain::fuseChains(list<DspObject *> *processOrder, PdGraph *graph) {
+  // the position of each object which may yet become part of a chain
+  unordered_map<DspObject *, list<DspObject *>::iterator> unfused;
+  for (list<DspObject *>::iterator it = processOrder->begin(); it != processOrder->end(); ++it) {
+    unfused[*it] = it;
+  }
+  
+  // every object follows the objects it reads from, so each chain is found from its first object
+  list<DspObject *>::iterator it = processOrder->begin();
+  while (it != processOrder->end()) {
+    DspObject *dspObject = *it++;
+    ElementwiseOperation operation;
+    if (unfused.find(dspObject) == unfused.end() ||
+        !dspObject->getElementwiseOperation(&operation)) continue;
+    vector<DspObject *> chain(1, dspObject);
+    vector<list<DspObject *>::iterator> positions(1, unfused[dspObject]);
+    unfused.erase(dspObject);
+    DspObject *nextObject;
+    while ((nextObject = getNextInChain(chain.back(), &unfused)) != NULL) {
+      chain.push_back(nextObject);
+      positions.push_back(unfused[nextObject]);
+      unfused.erase(nextObject);
+    }
+    if (chain.size() < 2) continue;
+    
+    processOrder->insert(positions.back(), new DspFusedChain(&chain, graph));
+    for (unsigned int i = 0; i < positions.size(); i++) {
+      if (positions[i] == it) ++it;
+      processOrder->erase(positions[i]);
+    }
+  }
+}
+
+
+#pragma mark - Constructor/Destructor
+
+DspFusedChain::DspFusedChain(vector<DspObject *> *chain, PdGraph *graph) : DspObject(0, 0, 0, 0, graph) {
+  objects = *chain;
+  intermediateBuffer = ALLOC_ALIGNED_BUFFER(blockSizeInt * sizeof(float));
+  memset(intermediateBuffer, 0, blockSizeInt * sizeof(float));
+  
+  inputs.push_back(make_pair(objects.front(), 0));
+  for (unsigned int i = 0; i < objects.size(); i++) {
+    ElementwiseOperation operation;
+    objects[i]->getElementwiseOperation(&operation);
+    Step step = {operation.op, -1, {operation.constants[0], operation.constants[1]}};
+    if (operation.signalInlet >= 0) {
+      step.operandInput = inputs.size();
+      inputs.push_back(make_pair(objects[i], (unsigned int) operation.signalInlet));
+    }
+    steps.push_back(step);
+  }
+  for (unsigned int i = 0; i < inputs.size(); i++) {
+    inputBuffers.push_back(inputs[i].first->getDspBufferAtInlet(inputs[i].second));
+  }
+  outputBuffer = objects.back()->getDspBufferAtOutlet(0);
+  
+  // the buffers between the objects are no longer part of the process order
+  for (unsigned int i = 0; i < objects.size() - 1; i++) {
+    objects[i]->setDspBufferAtOutlet(intermediateBuffer, 0);
+    objects[i+1]->setDspBufferAtInlet(intermediateBuffer, 0);
+  }
+  
+  #if ARRAY_ARITHMETIC_DISPATCH
+  switch (ArrayArithmetic::getInstructionSet()) {
+    case ArrayArithmetic::AVX512: kernel = &processAvx512; kernelWidth = 16; break;
+    case ArrayArithmetic::AVX: kernel = &processAvx; kernelWidth = 8; break;
+    default: kernel = &processSse; kernelWidth = 4; break;
+  }
+  #elif __SSE2__
+  kernel = &processSse;
+  kernelWidth = 4;
+  #elif __ARM_NEON__
+  kernel = &processNeon;
+  kernelWidth = 4;
+  #else
+  kernel = NULL;
+  kernelWidth = 0;
+  #endif
+  
+  processFunction = &processChain;
+  processFunctionNoMessage = &processChain;
+}
+
+DspFusedChain::~DspFusedChain() {
+  FREE_ALIGNED_BUFFER(intermediateBuffer);
+}
+
+string DspFusedChain::toString() {
+  string str = getObjectLabel();
+  for (unsigned int i = 0; i < objects.size(); i++) {
+    str += (i == 0) ? " " : " -> ";
+    str += objects[i]->toString();
+  }
+  return str;
+}
+
+
+#pragma mark - Buffers
+
+void DspFusedChain::setDspBufferAtInlet(float *buffer, unsigned int inletIndex) {
+  inputBuffers[inletIndex] = buffer;
+  inputs[inletIndex].first->setDspBufferAtInlet(buffer, inputs[inletIndex].second);
+}
+
+void DspFusedChain::setDspBufferAtOutlet(float *buffer, unsigned int outletIndex) {
+  outputBuffer = buffer;
+  objects.back()->setDspBufferAtOutlet(buffer, 0);
+}
+
+float *DspFusedChain::getDspBufferAtInlet(int inletIndex) {
+  return inputBuffers[inletIndex];
+}
+
+float *DspFusedChain::getDspBufferAtOutlet(int outletIndex) {
+  return outputBuffer;
+}
+
+
+#pragma mark - Process
+
+void DspFusedChain::processObjects(int fromIndex, int toIndex) {
+  for (unsigned int i = 0; i < objects.size(); i++) {
+    objects[i]->processFunction(objects[i], fromIndex, toIndex);
+  }
+}
+
+void DspFusedChain::processChain(DspObject *dspObject, int fromIndex, int toIndex) {
+  DspFusedChain *d = reinterpret_cast<DspFusedChain *>(dspObject);
+  for (unsigned int i = 0; i < d->objects.size(); i++) {
+    if (d->objects[i]->hasPendingMessages()) {
+      d->processObjects(fromIndex, toIndex);
+      return;
+    }
+  }
+  
+  Step *steps = d->steps.data();
+  int numSteps = d->steps.size();
+  float **inputs = d->inputBuffers.data();
+  float *output = d->outputBuffer;
+  
+  // Only the last step writes the output, which may share the buffer of an input of that step.
+  // As each sample of the output is written after the samples of the inputs are read, this is safe.
+  int i = fromIndex;
+  if (d->kernel != NULL) {
+    i += (toIndex - fromIndex) & ~(d->kernelWidth - 1);
+    float *input = inputs[0];
+    for (int s = 0; s < numSteps; s++) {
+      float *stepOutput = (s == numSteps-1) ? output : d->intermediateBuffer;
+      float *operand = (steps[s].operandInput < 0) ? NULL : inputs[steps[s].operandInput];
+      d->kernel(steps + s, input, operand, stepOutput, fromIndex, i);
+      input = stepOutput;
+    }
+  }
+  
+  // the remaining samples are computed through all steps, one at a time
+  for (; i < toIndex; i++) {
+    float x = inputs[0][i];
+    for (int s = 0; s < numSteps; s++) {
+      Step *step = steps + s;
+      if (step->op == ELEMENTWISE_WRAP) {
+        x = x - floorf(x);
+        continue;
+      }
+      float y = (step->operandInput < 0) ? *step->constants[0] : inputs[step->operandInput][i];
+      switch (step->op) {
+        case ELEMENTWISE_ADD: x = x + y; break;
+        case ELEMENTWISE_SUBTRACT: x = x - y; break;
+        case ELEMENTWISE_MULTIPLY: x = x * y; break;
+        case ELEMENTWISE_DIVIDE: x = x / y; break;
+        case ELEMENTWISE_CLIP: {
+          if (x < y) x = y;
+          else if (x > *step->constants[1]) x = *step->constants[1];
+          break;
+        }
+        default: break;
+      }
+    }
+    output[i] = x;
+  }
+}
@@ -0,0 +1,132 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _DSP_FUSED_CHAIN_H_
+#define _DSP_FUSED_CHAIN_H_
+
+#include "DspObject.h"
+
+/** The operations which may be fused into a <code>DspFusedChain</code>. */
+enum ElementwiseOperator {
+  ELEMENTWISE_ADD,
+  ELEMENTWISE_SUBTRACT,
+  ELEMENTWISE_MULTIPLY,
+  ELEMENTWISE_DIVIDE,
+  ELEMENTWISE_CLIP,
+  ELEMENTWISE_WRAP
+};
+
+/**
+ * Describes the operation of an object whose output at each sample depends only on its inputs at
+ * the same sample (see <code>DspObject::getElementwiseOperation()</code>). The first input is
+ * always the left inlet. The operand is either the signal at <code>signalInlet</code> or the
+ * object's own parameters, which are read through <code>constants</code> whenever a block is
+ * processed.
+ */
+typedef struct ElementwiseOperation {
+  ElementwiseOperator op;
+  int signalInlet; // the dsp inlet of the operand, or -1 if the operand is constant
+  float *constants[2]; // the operand, or the lower and upper bound of ELEMENTWISE_CLIP
+} ElementwiseOperation;
+
+/**
+ * A <code>DspFusedChain</code> replaces a linear chain of elementwise objects in the process order,
+ * such as <code>[*~] -> [+~] -> [clip~] -> [wrap~]</code>, with a single step. Rather than each
+ * object being called in turn and writing a buffer from the <code>BufferPool</code>, the steps of the
+ * chain are applied one after another by vector kernels to a single private buffer. Its inputs are
+ * the left inlet of the first object and the signal operands of all objects, and its only outlet is
+ * that of the last.
+ *
+ * An object is fused with the next one if its only signal connection is to the left inlet of the
+ * next, and that inlet has no other connection. The objects of the chain remain in the graph and
+ * receive messages as usual. Messages are sample accurate, so if any object of the chain has
+ * pending messages then the objects are processed one after another for that block, with a private
+ * buffer between them. Fusing is enabled by default, and may be disabled for each context with
+ * <code>PdContext::setFusionEnabled()</code>.
+ *
+ * Chains are created by <code>PdGraph::computeDeepLocalDspProcessOrder()</code>, and like the
+ * implicit [+~~] objects are owned by the process order and deleted when it is recomputed.
+ */
+class DspFusedChain : public DspObject {
+  
+  public:
+    /**
+     * Replaces every chain of at least two fusible objects in the given process order of the given
+     * graph with a new <code>DspFusedChain</code>, at the position of the last object of the chain.
+     */
+    static void fuseChains(list<DspObject *> *processOrder, PdGraph *graph);
+  
+    DspFusedChain(vector<DspObject *> *chain, PdGraph *graph);
+    ~DspFusedChain();
+  
+    static const char *getObjectLabel();
+    std::string toString();
+    ObjectType getObjectType() { return DSP_FUSED_CHAIN; }
+  
+    unsigned int getNumDspInlets() { return inputs.size(); }
+    unsigned int getNumDspOutlets() { return 1; }
+  
+    /** Buffers are set at the corresponding inlet or outlet of the fused object. */
+    void setDspBufferAtInlet(float *buffer, unsigned int inletIndex);
+    void setDspBufferAtOutlet(float *buffer, unsigned int outletIndex);
+    float *getDspBufferAtInlet(int inletIndex);
+    float *getDspBufferAtOutlet(int outletIndex);
+  
+    /** An object of the chain, as processed by the fused kernel. */
+    typedef struct Step {
+      ElementwiseOperator op;
+      int operandInput; // the index of the operand in inputBuffers, or -1 if it is constant
+      float *constants[2];
+    } Step;
+  
+  private:
+    static void processChain(DspObject *dspObject, int fromIndex, int toIndex);
+  
+    /** Processes the objects of the chain one after another, e.g. when any has pending messages. */
+    void processObjects(int fromIndex, int toIndex);
+  
+    vector<DspObject *> objects;
+    vector<Step> steps;
+  
+    /**
+     * Applies a step to a range of samples with the vector instructions of the processor, or NULL if
+     * there are none. The operand is NULL if it is constant. The range is a multiple of
+     * <code>kernelWidth</code> samples.
+     */
+    void (*kernel)(Step *step, float *input, float *operand, float *output, int fromIndex, int toIndex);
+    int kernelWidth;
+  
+    /** The object and inlet to which each input of the chain belongs, and its current buffer. */
+    vector<pair<DspObject *, unsigned int> > inputs;
+    vector<float *> inputBuffers;
+  
+    float *outputBuffer;
+  
+    /** The buffer between the steps of the chain, and between its objects when processed separately. */
+    float *intermediateBuffer;
+};
+
+inline const char *DspFusedChain::getObjectLabel() {
+  return "~fused~";
+}
+
+#endif // _DSP_FUSED_CHAIN_H_
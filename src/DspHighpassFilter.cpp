@@ -27,7 +27,7 @@ MessageObject *DspHighpassFilter::newObject(PdMessage *initMessage, PdGraph *gra
   return new DspHighpassFilter(initMessage, graph);
 }
 
-DspHighpassFilter::DspHighpassFilter(PdMessage *initMessage, PdGraph *graph) : DspFilter(2, graph) {
+DspHighpassFilter::DspHighpassFilter(PdMessage *initMessage, PdGraph *graph) : DspFilter(2, 2, graph) {
   // by default, the filter is initialised completely open
   calcFiltCoeff(initMessage->isFloat(0) ? initMessage->getFloat(0) : 0.0f);
 }
@@ -42,11 +42,32 @@ void DspHighpassFilter::calcFiltCoeff(float fc) {
   else if (fc < 0.0f) fc = 10.0f;
   
   float alpha = graph->getSampleRate() / ((2.0f*M_PI*fc) + graph->getSampleRate());
-  b[0] = alpha;
-  b[1] = -alpha;
-  b[2] = 0.0f;
-  b[3] = -alpha;
-  b[4] = 0.0f;
+  setCoefficients(alpha, -alpha, 0.0f, -alpha, 0.0f);
+}
+
+void DspHighpassFilter::onInletConnectionUpdate(unsigned int inletIndex) {
+  processFunction = incomingDspConnections[1].empty() ? &processFilter : &processSignalCutoff;
+  processFunctionNoMessage = processFunction;
+}
+
+void DspHighpassFilter::processSignalCutoff(DspObject *dspObject, int fromIndex, int toIndex) {
+  DspHighpassFilter *d = reinterpret_cast<DspHighpassFilter *>(dspObject);
+  float *input = d->dspBufferAtInlet[0];
+  float *cutoff = d->dspBufferAtInlet[1];
+  float *output = d->dspBufferAtOutlet[0];
+  float sampleRate = d->graph->getSampleRate();
+  float x1 = d->x1, y1 = d->y1;
+  for (int i = fromIndex; i < toIndex; i++) {
+    float fc = cutoff[i];
+    if (fc > 0.5f * sampleRate) fc = 0.5f * sampleRate;
+    else if (fc < 0.0f) fc = 10.0f;
+    float alpha = sampleRate / ((2.0f*M_PI*fc) + sampleRate);
+    float x = input[i];
+    y1 = alpha * (x - x1 + y1);
+    x1 = x;
+    output[i] = y1;
+  }
+  d->x1 = x1; d->y1 = y1; // the other state variables are not used by a one-pole filter
 }
 
 void DspHighpassFilter::processMessage(int inletIndex, PdMessage *message) {
@@ -58,9 +79,8 @@ void DspHighpassFilter::processMessage(int inletIndex, PdMessage *message) {
           break;
         }
         case SYMBOL: {
-          if (message->isSymbol(0, "clear")) {
-            x1 = x2 = 0.0f;
-            dspBufferAtOutlet[0][0] = dspBufferAtOutlet[0][1] = 0.0f;
+          if (message->isSymbol(0, SYMBOL_CLEAR)) {
+            clear();
           }
           break;
         }
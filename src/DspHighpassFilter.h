@@ -28,6 +28,7 @@
 /**
  * [hip~], [hip~ float]
  * A one-tap IIR filter: y[i] = a * (y[i-1] + x[i] - x[i-1])
+ * The cutoff frequency may be a signal, in which case a is computed for each sample.
  */
 class DspHighpassFilter : public DspFilter {
   
@@ -41,6 +42,9 @@ class DspHighpassFilter : public DspFilter {
   
   private:
     void processMessage(int inletIndex, PdMessage *message);
+    static void processSignalCutoff(DspObject *dspObject, int fromIndex, int toIndex);
+  
+    void onInletConnectionUpdate(unsigned int inletIndex);
     void calcFiltCoeff(float cutoffFrequency);
 };
 
@@ -30,11 +30,12 @@ MessageObject *DspInlet::newObject(PdMessage *initMessage, PdGraph *graph) {
 }
 
 DspInlet::DspInlet(PdGraph *graph) : DspObject(0, 1, 0, 1, graph) {
-  // nothing to do
+  reblockedBuffer = NULL;
+  resampleFactor = 1.0f;
 }
 
 DspInlet::~DspInlet() {
-  // nothing to do
+  if (reblockedBuffer != NULL) FREE_ALIGNED_BUFFER(reblockedBuffer);
 }
 
 list<DspObject *> DspInlet::getProcessOrder() {
@@ -49,18 +50,51 @@ list<DspObject *> DspInlet::getProcessOrderFromInlet() {
 void DspInlet::setDspBufferAtInlet(float *buffer, unsigned int inletIndex) {
   DspObject::setDspBufferAtInlet(buffer, inletIndex);
   
-  // additionally reserve this buffer in order to account for outgoing connections
-  graph->getBufferPool()->reserveBuffer(buffer, outgoingDspConnections[0].size());
+  // additionally reserve this buffer in order to account for outgoing connections. The buffer of a
+  // reblocked inlet is only read by the graph itself.
+  if (reblockedBuffer == NULL) {
+    graph->getBufferPool()->reserveBuffer(buffer, outgoingDspConnections[0].size());
+  }
   
   // when the dsp buffer updates at a given inlet, inform all receiving objects
   for (list<ObjectLetPair>::iterator it = outgoingDspConnections[0].begin();
       it != outgoingDspConnections[0].end(); ++it) {
     ObjectLetPair letPair = *it;
     DspObject *dspObject = reinterpret_cast<DspObject *>(letPair.first);
-    dspObject->setDspBufferAtInlet(dspBufferAtInlet[0], letPair.second);
+    dspObject->setDspBufferAtInlet((reblockedBuffer != NULL) ? reblockedBuffer : dspBufferAtInlet[0],
+        letPair.second);
   }
 }
 
 float *DspInlet::getDspBufferAtOutlet(int outletIndex) {
+  if (reblockedBuffer != NULL) return reblockedBuffer;
   return (dspBufferAtInlet[0] == NULL) ? graph->getBufferPool()->getZeroBuffer() : dspBufferAtInlet[0];
 }
+
+void DspInlet::setReblocking(bool isReblocked, int blockSize, float resampleFactor) {
+  if (reblockedBuffer != NULL) FREE_ALIGNED_BUFFER(reblockedBuffer);
+  reblockedBuffer = NULL;
+  this->resampleFactor = resampleFactor;
+  blockSizeInt = blockSize;
+  if (isReblocked) {
+    reblockedBuffer = ALLOC_ALIGNED_BUFFER(blockSize * sizeof(float));
+    memset(reblockedBuffer, 0, blockSize * sizeof(float));
+  }
+}
+
+void DspInlet::pushReblockedInput(int index, int n) {
+  // shift the block to make room for the new samples at its end
+  float *output = reblockedBuffer + blockSizeInt - n;
+  memmove(reblockedBuffer, reblockedBuffer + n, (blockSizeInt - n) * sizeof(float));
+  float *input = dspBufferAtInlet[0];
+  if (input == NULL) {
+    memset(output, 0, n * sizeof(float));
+  } else if (resampleFactor == 1.0f) {
+    memcpy(output, input + index, n * sizeof(float));
+  } else {
+    // upsampled input is held, downsampled input is decimated
+    for (int i = 0; i < n; i++) {
+      output[i] = input[(int) ((index + i) / resampleFactor)];
+    }
+  }
+}
@@ -32,6 +32,9 @@ class PdGraph;
  * In this case, the parent-graph's inlet buffer replaces this object's outlet buffer. Thus, when
  * the parent graph fills its inlet buffer, this object's outlet buffer is immediately filled
  * and no further computations must be done.
+ *
+ * If the graph is reblocked, the outlet buffer instead holds the last block of input of the graph,
+ * which the graph appends to with <code>pushReblockedInput()</code>.
  */
 class DspInlet : public DspObject {
   public:
@@ -52,6 +55,23 @@ class DspInlet : public DspObject {
     void setDspBufferAtInlet(float *buffer, unsigned int inletIndex);
     bool canSetBufferAtOutlet(unsigned int outletIndex);
     float *getDspBufferAtOutlet(int outletIndex);
+  
+    /**
+     * Configures this inlet for a reblocked graph, with the given block size and ratio of the
+     * graph's sample rate to that of its parent.
+     */
+    void setReblocking(bool isReblocked, int blockSize, float resampleFactor);
+  
+    /**
+     * Appends <code>n</code> samples to the block, resampled from the input starting at the given
+     * index (in samples of the graph).
+     */
+    void pushReblockedInput(int index, int n);
+  
+  private:
+    /** The last block of input of a reblocked graph, or <code>NULL</code>. */
+    float *reblockedBuffer;
+    float resampleFactor;
 };
 
 inline bool DspInlet::canSetBufferAtOutlet(unsigned int outletIndex) {
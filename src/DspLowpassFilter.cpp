@@ -27,7 +27,7 @@ MessageObject *DspLowpassFilter::newObject(PdMessage *initMessage, PdGraph *grap
   return new DspLowpassFilter(initMessage, graph);
 }
 
-DspLowpassFilter::DspLowpassFilter(PdMessage *initMessage, PdGraph *graph) : DspFilter(2, graph) {
+DspLowpassFilter::DspLowpassFilter(PdMessage *initMessage, PdGraph *graph) : DspFilter(2, 2, graph) {
   calcFiltCoeff(initMessage->isFloat(0) ? initMessage->getFloat(0) : graph->getSampleRate()/2.0f);
 }
 
@@ -42,11 +42,31 @@ void DspLowpassFilter::calcFiltCoeff(float fc) {
   
   float wc = 2.0f*M_PI*fc;
   float alpha = wc / (wc + graph->getSampleRate());
-  b[0] = alpha;
-  b[1] = 0.0f;
-  b[2] = 0.0f;
-  b[3] = -(1.0f-alpha);
-  b[4] = 0.0f;
+  setCoefficients(alpha, 0.0f, 0.0f, -(1.0f-alpha), 0.0f);
+}
+
+void DspLowpassFilter::onInletConnectionUpdate(unsigned int inletIndex) {
+  processFunction = incomingDspConnections[1].empty() ? &processFilter : &processSignalCutoff;
+  processFunctionNoMessage = processFunction;
+}
+
+void DspLowpassFilter::processSignalCutoff(DspObject *dspObject, int fromIndex, int toIndex) {
+  DspLowpassFilter *d = reinterpret_cast<DspLowpassFilter *>(dspObject);
+  float *input = d->dspBufferAtInlet[0];
+  float *cutoff = d->dspBufferAtInlet[1];
+  float *output = d->dspBufferAtOutlet[0];
+  float sampleRate = d->graph->getSampleRate();
+  float y1 = d->y1;
+  for (int i = fromIndex; i < toIndex; i++) {
+    float fc = cutoff[i];
+    if (fc > 0.5f * sampleRate) fc = 0.5f * sampleRate;
+    else if (fc < 0.0f) fc = 0.0f;
+    float wc = 2.0f*M_PI*fc;
+    float alpha = wc / (wc + sampleRate);
+    y1 = alpha * input[i] + (1.0f-alpha) * y1;
+    output[i] = y1;
+  }
+  d->y1 = y1; // the other state variables are not used by a one-pole filter
 }
 
 void DspLowpassFilter::processMessage(int inletIndex, PdMessage *message) {
@@ -58,8 +78,8 @@ void DspLowpassFilter::processMessage(int inletIndex, PdMessage *message) {
           break;
         }
         case SYMBOL: {
-          if (message->isSymbol(0, "clear")) {
-            x1 = x2 = dspBufferAtOutlet[0][0] = dspBufferAtOutlet[0][1] = 0.0f;
+          if (message->isSymbol(0, SYMBOL_CLEAR)) {
+            clear();
           }
           break;
         }
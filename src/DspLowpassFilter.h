@@ -28,6 +28,7 @@
 /**
  * [lop~]
  * Specficially implement a one-tap IIR filter: y = alpha * x_0 + (1-alpha) * y_-1
+ * The cutoff frequency may be a signal, in which case alpha is computed for each sample.
  */
 class DspLowpassFilter : public DspFilter {
   
@@ -42,6 +43,9 @@ class DspLowpassFilter : public DspFilter {
     void processMessage(int inletIndex, PdMessage *message);
   
   private:
+    static void processSignalCutoff(DspObject *dspObject, int fromIndex, int toIndex);
+  
+    void onInletConnectionUpdate(unsigned int inletIndex);
     void calcFiltCoeff(float cutoffFrequency);
 };
 
@@ -22,6 +22,7 @@
 
 #include "ArrayArithmetic.h"
 #include "DspMultiply.h"
+#include "DspFusedChain.h"
 
 class PdGraph;
 
@@ -32,6 +33,7 @@ MessageObject *DspMultiply::newObject(PdMessage *initMessage, PdGraph *graph) {
 DspMultiply::DspMultiply(PdMessage *initMessage, PdGraph *graph) : DspObject(2, 2, 0, 1, graph) {
   constant = initMessage->isFloat(0) ? initMessage->getFloat(0) : 0.0f;
   inputConstant = 0.0f;
+  processFunction = &processScalar;
   processFunctionNoMessage = &processScalar;
 }
 
@@ -47,13 +49,20 @@ string DspMultiply::toString() {
 }
 
 void DspMultiply::onInletConnectionUpdate(unsigned int inletIndex) {
-  if (incomingDspConnections[0].size() > 0 && incomingDspConnections[1].size() > 0) {
-    processFunction = &processSignal;
-  } else {
-    // because onInletConnectionUpdate can only be called at block boundaries, it is guaranteed
-    // that no messages will be in the message queue.
-    processFunction = &processScalar;
-  }
+  // because onInletConnectionUpdate can only be called at block boundaries, it is guaranteed
+  // that no messages will be in the message queue.
+  processFunctionNoMessage = (incomingDspConnections[0].size() > 0 && incomingDspConnections[1].size() > 0)
+      ? &processSignal : &processScalar;
+  processFunction = processFunctionNoMessage;
+}
+
+bool DspMultiply::getElementwiseOperation(ElementwiseOperation *operation) {
+  operation->op = ELEMENTWISE_MULTIPLY;
+  // as when processed alone, a signal at the right inlet is only used if the left is connected too
+  operation->signalInlet = (processFunctionNoMessage == &processSignal) ? 1 : -1;
+  operation->constants[0] = &constant;
+  operation->constants[1] = NULL;
+  return true;
 }
 
 void DspMultiply::processMessage(int inletIndex, PdMessage *message) {
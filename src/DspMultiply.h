@@ -42,6 +42,7 @@ class DspMultiply : public DspObject {
     void processMessage(int inletIndex, PdMessage *message);
   
     void onInletConnectionUpdate(unsigned int inletIndex);
+    bool getElementwiseOperation(ElementwiseOperation *operation);
     
     float inputConstant;
     float constant;
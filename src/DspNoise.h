@@ -24,11 +24,11 @@
 #define _DSP_NOISE_H_
 
 #include "DspObject.h"
+#include "RandomGenerator.h"
 
-class MTRand;
 class PdGraph;
 
-/** [noise~] */
+/** [noise~], white noise in the range [-1,1) */
 class DspNoise : public DspObject {
     
   public:
@@ -42,7 +42,7 @@ class DspNoise : public DspObject {
   private:
     static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
   
-    MTRand *twister;
+    RandomGenerator generator;
 };
 
 inline std::string DspNoise::toString() {
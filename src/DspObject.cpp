@@ -24,6 +24,7 @@
 #include "BufferPool.h"
 #include "DspImplicitAdd.h"
 #include "DspObject.h"
+#include "MessagePool.h"
 #include "PdGraph.h"
 
 
@@ -177,7 +178,7 @@ void DspObject::clearMessageQueue() {
   while (!messageQueue.empty()) {
     MessageLetPair messageLetPair = messageQueue.front();
     PdMessage *message = messageLetPair.first;
-    message->freeMessage();
+    graph->getMessagePool()->freeMessage(message);
     messageQueue.pop();
   }
 }
@@ -186,9 +187,9 @@ void DspObject::receiveMessage(int inletIndex, PdMessage *message) {
   // Queue the message to be processed during the DSP round only if the graph is switched on.
   // Otherwise messages would begin to pile up because the graph is not processed.
   if (graph->isSwitchedOn()) {
-    // Copy the message to the heap so that it is available to process later.
+    // Copy the message to the context's message pool so that it is available to process later.
     // The message is released once it is consumed in processDsp().
-    messageQueue.push(make_pair(message->copyToHeap(), inletIndex));
+    messageQueue.push(make_pair(graph->getMessagePool()->copyMessage(message), inletIndex));
     
     // only process the message if the process function is set to the default no-message function.
     // If it is set to anything else, then it is assumed that messages should not be processed.
@@ -210,11 +211,18 @@ void DspObject::processFunctionMessage(DspObject *dspObject, int fromIndex, int
     PdMessage *message = messageLetPair.first;
     unsigned int inletIndex = messageLetPair.second;
     
+    // in a reblocked graph, a message may belong to a later block of the graph, in which case it
+    // remains in the queue. A message which arrived while the graph was waiting for a complete
+    // block is processed at the start of the block.
     double blockIndexOfCurrentMessage = dspObject->graph->getBlockIndex(message);
+    if (blockIndexOfCurrentMessage >= toIndex) break;
+    blockIndexOfCurrentMessage = max(blockIndexOfCurrentMessage, blockIndexOfLastMessage);
+    
     dspObject->processFunctionNoMessage(dspObject,
         ceil(blockIndexOfLastMessage), ceil(blockIndexOfCurrentMessage));
     dspObject->processMessage(inletIndex, message);
-    message->freeMessage(); // free the message from the head, the message has been consumed.
+    // free the message from the head, the message has been consumed.
+    dspObject->graph->getMessagePool()->freeMessage(message);
     dspObject->messageQueue.pop();
     
     blockIndexOfLastMessage = blockIndexOfCurrentMessage;
@@ -225,7 +233,9 @@ void DspObject::processFunctionMessage(DspObject *dspObject, int fromIndex, int
   // processed in this block, return to the default process function which assumes that no messages
   // are present. This improves performance because the messageQueue must not be checked for
   // any pending messages. It is assumed that there aren't any.
-  dspObject->processFunction = dspObject->processFunctionNoMessage;
+  if (dspObject->messageQueue.empty()) {
+    dspObject->processFunction = dspObject->processFunctionNoMessage;
+  }
 }
 
 void DspObject::processDspWithIndex(double fromIndex, double toIndex) {
@@ -241,6 +251,13 @@ void DspObject::processDspWithIndex(int fromIndex, int toIndex) {
 
 #pragma mark - Process Order
 
+bool DspObject::mustProcessSerially() {
+  for (int i = 0; i < outgoingMessageConnections.size(); i++) {
+    if (!outgoingMessageConnections[i].empty()) return true;
+  }
+  return false;
+}
+
 bool DspObject::isLeafNode() {
   if (!MessageObject::isLeafNode()) return false;
   else {
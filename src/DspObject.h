@@ -47,6 +47,8 @@ inline float* allocAlignedBuffer(size_t numBytes) {
 
 typedef std::pair<PdMessage *, unsigned int> MessageLetPair;
 
+struct ElementwiseOperation;
+
 /**
  * A <code>DspObject</code> is the abstract superclass of any object which processes audio.
  * <code>DspObject</code> is a subclass of <code>MessageObject</code>, such that all of the former
@@ -97,6 +99,13 @@ class DspObject : public MessageObject {
   
     virtual bool doesProcessAudio() { return true; }
   
+    /**
+     * Returns <code>true</code> if processing this object may send or schedule messages, or otherwise
+     * touch state outside of the object and its signal buffers. Such objects are never processed
+     * concurrently with any other object. By default this is the case if any message outlet is connected.
+     */
+    virtual bool mustProcessSerially();
+  
     virtual bool isLeafNode();
 
     virtual list<DspObject *> getProcessOrder();
@@ -128,6 +137,49 @@ class DspObject : public MessageObject {
     /** Returns only outgoing dsp connections from the given outlet. */
     virtual list<ObjectLetPair> getOutgoingDspConnections(unsigned int outletIndex);
   
+    /**
+     * Returns <code>true</code> if the output of this object at each sample depends only on its
+     * inputs at the same sample, such that it may be fused with its neighbours into a
+     * <code>DspFusedChain</code>. The operation is then described in <code>operation</code>.
+     */
+    virtual bool getElementwiseOperation(ElementwiseOperation *operation) { return false; }
+  
+    /**
+     * Returns the number of objects whose signal this object receives by name rather than through a
+     * connection, such as the [send~] of a [receive~] or the [throw~]s of a [catch~].
+     */
+    virtual int getNumSignalSources() { return 0; }
+  
+    /**
+     * Returns the object whose signal is received by name with the given index, or <code>NULL</code>
+     * if no object currently has the name.
+     */
+    virtual DspObject *getSignalSource(int index) { return NULL; }
+  
+    /**
+     * Sets the buffer from which the signal of the given source is read. This is the buffer at the
+     * first inlet of the source if the <code>DspBufferAllocator</code> found that the source is
+     * always processed earlier in the same block, and otherwise <code>NULL</code>, in which case the
+     * copy made by the source is read. Only the buffer of the first source may also be the buffer at
+     * an outlet of this object.
+     */
+    virtual void setSignalSourceBuffer(int index, float *buffer) {}
+  
+    /**
+     * Returns <code>true</code> if the first outlet carries the signal of the only source unchanged,
+     * such that the outlet shares the buffer of the source whenever one is set.
+     */
+    virtual bool forwardsSignalSource() { return false; }
+  
+    /**
+     * Tells a source of named signals whether any object receiving its signal reads the copy of it
+     * made by the source. The copy is otherwise not made.
+     */
+    virtual void setSignalCopyRequired(bool isRequired) {}
+  
+    /** Returns <code>true</code> if messages are waiting to be processed with the next block. */
+    bool hasPendingMessages() { return !messageQueue.empty(); }
+  
     static const char *getObjectLabel() { return "obj~"; }
     
   protected:
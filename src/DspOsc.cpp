@@ -22,13 +22,6 @@
 
 #include "DspOsc.h"
 #include "PdGraph.h"
-#include <cmath>
-
-#define COS_TABLE_SIZE 32768
-
-// initialise the static class variables
-float *DspOsc::cos_table = NULL;
-int DspOsc::refCount = 0;
 
 MessageObject *DspOsc::newObject(PdMessage *initMessage, PdGraph *graph) {
   return new DspOsc(initMessage, graph);
@@ -36,28 +29,19 @@ MessageObject *DspOsc::newObject(PdMessage *initMessage, PdGraph *graph) {
 
 DspOsc::DspOsc(PdMessage *initMessage, PdGraph *graph) : DspObject(2, 2, 0, 1, graph) {
   frequency = initMessage->isFloat(0) ? initMessage->getFloat(0) : 440.0f;
-  phase = 0.0f;
-  refCount++;
-
-  if (cos_table == NULL) {
-    cos_table = ALLOC_ALIGNED_BUFFER(COS_TABLE_SIZE * sizeof(float));
-    for (int i = 0; i < COS_TABLE_SIZE; i++) {
-      cos_table[i] = cosf(2.0f * M_PI * ((float) i) / (COS_TABLE_SIZE - 1));
-    }
-  }
-  
+  increment = PhaseAccumulator::getIncrement(frequency, graph->getSampleRate());
+  phase = 0;
   processFunction = &processScalar;
+  processFunctionNoMessage = &processScalar;
 }
 
 DspOsc::~DspOsc() {
-  if (--refCount == 0) {
-    FREE_ALIGNED_BUFFER(cos_table);
-    cos_table = NULL;
-  }
+  // nothing to do
 }
 
 void DspOsc::onInletConnectionUpdate(unsigned int inletIndex) {
-  processFunction = !incomingDspConnections[0].empty() ? &processSignal : &processScalar;
+  processFunctionNoMessage = !incomingDspConnections[0].empty() ? &processSignal : &processScalar;
+  processFunction = processFunctionNoMessage;
 }
 
 string DspOsc::toString() {
@@ -70,12 +54,15 @@ void DspOsc::processMessage(int inletIndex, PdMessage *message) {
   switch (inletIndex) {
     case 0: { // update the frequency
       if (message->isFloat(0)) {
-        frequency = fabsf(message->getFloat(0));
+        frequency = message->getFloat(0);
+        increment = PhaseAccumulator::getIncrement(frequency, graph->getSampleRate());
       }
       break;
     }
     case 1: { // update the phase
-      // TODO
+      if (message->isFloat(0)) {
+        phase = PhaseAccumulator::getPhase(message->getFloat(0));
+      }
       break;
     }
     default: break;
@@ -84,42 +71,12 @@ void DspOsc::processMessage(int inletIndex, PdMessage *message) {
 
 void DspOsc::processSignal(DspObject *dspObject, int fromIndex, int toIndex) {
   DspOsc *d = reinterpret_cast<DspOsc *>(dspObject);
-  float tableSizeFloat = (float)(COS_TABLE_SIZE - 1);
-  float multiplier = tableSizeFloat / d->graph->getSampleRate();
-  float *input = d->dspBufferAtInlet[0];
-  float *output = d->dspBufferAtOutlet[0];
-  float phase = d->phase;
-
-  for (int i = fromIndex; i < toIndex; i++) {
-    unsigned int lower = (unsigned int)phase;
-    float fraction = phase - lower;
-    float out = fraction * cos_table[lower] + (1.0f - fraction) * cos_table[lower + 1];
-    output[i] = out;
-    phase = fmod(phase + input[i] * multiplier, tableSizeFloat);
-  }
-
-  if (isnan(phase)) {
-    phase = 0.0f;
-  }
-
-  d->phase = phase;
+  d->phase = PhaseAccumulator::cosine(d->phase, d->dspBufferAtInlet[0]+fromIndex,
+      1.0f/d->graph->getSampleRate(), d->dspBufferAtOutlet[0]+fromIndex, toIndex-fromIndex);
 }
 
 void DspOsc::processScalar(DspObject *dspObject, int fromIndex, int toIndex) {
   DspOsc *d = reinterpret_cast<DspOsc *>(dspObject);
-  float tableSizeFloat = (float)(COS_TABLE_SIZE - 1);
-  float multiplier = tableSizeFloat / d->graph->getSampleRate();
-  float phase = d->phase;
-  float addend = multiplier * d->frequency;
-  float *output = d->dspBufferAtOutlet[0];
-
-  for (int i = fromIndex; i < toIndex; i++) {
-    unsigned int lower = (unsigned int)phase;
-    float fraction = phase - lower;
-    float out = fraction * cos_table[lower] + (1.0f - fraction) * cos_table[lower + 1];
-    output[i] = out;
-    phase = fmod(phase + addend, tableSizeFloat);
-  }
-
-  d->phase = phase;
+  d->phase = PhaseAccumulator::cosine(d->phase, d->increment,
+      d->dspBufferAtOutlet[0]+fromIndex, toIndex-fromIndex);
 }
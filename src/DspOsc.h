@@ -24,6 +24,7 @@
 #define _DSP_OSC_H_
 
 #include "DspObject.h"
+#include "PhaseAccumulator.h"
 
 /** [osc~], [osc~ float] */
 class DspOsc : public DspObject {
@@ -44,10 +45,8 @@ class DspOsc : public DspObject {
     void processMessage(int inletIndex, PdMessage *message);
   
     float frequency;
-    float phase;
-  
-    static float *cos_table; // the cosine lookup table
-    static int refCount; // a reference counter for cos_table. Now we know when to free it.
+    uint32_t phase; // the fixed-point phase, as used by PhaseAccumulator
+    uint32_t increment; // the phase increment per sample at the given frequency
 };
 
 inline const char *DspOsc::getObjectLabel() {
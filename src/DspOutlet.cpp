@@ -29,28 +29,92 @@ MessageObject *DspOutlet::newObject(PdMessage *initMessage, PdGraph *graph) {
 }
 
 DspOutlet::DspOutlet(PdGraph *graph) : DspObject(0, 1, 0, 1, graph) {
-  // nothing to do
+  reblockedBuffer = NULL;
+  overlapBuffer = NULL;
+  parentBlockSize = 0;
+  numSamplesPerParentBlock = 0;
+  resampleFactor = 1.0f;
 }
 
 DspOutlet::~DspOutlet() {
-  // nothing to do
+  if (reblockedBuffer != NULL) FREE_ALIGNED_BUFFER(reblockedBuffer);
+  if (overlapBuffer != NULL) FREE_ALIGNED_BUFFER(overlapBuffer);
 }
 
 float *DspOutlet::getDspBufferAtOutlet(int outletIndex) {
+  if (reblockedBuffer != NULL) return reblockedBuffer;
   return (dspBufferAtInlet[0] == NULL) ? graph->getBufferPool()->getZeroBuffer() : dspBufferAtInlet[0];
 }
 
 void DspOutlet::setDspBufferAtInlet(float *buffer, unsigned int inletIndex) {
   DspObject::setDspBufferAtInlet(buffer, inletIndex);
   
-  // additionally reserve buffer to account for outgoing connections
-  graph->getBufferPool()->reserveBuffer(buffer, outgoingDspConnections[0].size());
+  // additionally reserve buffer to account for outgoing connections. The outlet of a reblocked
+  // graph has a buffer of its own.
+  if (reblockedBuffer == NULL) {
+    graph->getBufferPool()->reserveBuffer(buffer, outgoingDspConnections[0].size());
+  }
   
   // when the dsp buffer updates at a given inlet, inform all receiving objects
   list<ObjectLetPair> dspConnections = outgoingDspConnections[0];
   for (list<ObjectLetPair>::iterator it = dspConnections.begin(); it != dspConnections.end(); ++it) {
     ObjectLetPair letPair = *it;
     DspObject *dspObject = reinterpret_cast<DspObject *>(letPair.first);
-    dspObject->setDspBufferAtInlet(dspBufferAtInlet[0], letPair.second);
+    dspObject->setDspBufferAtInlet((reblockedBuffer != NULL) ? reblockedBuffer : dspBufferAtInlet[0],
+        letPair.second);
+  }
+}
+
+
+#pragma mark - Reblocking
+
+void DspOutlet::setReblocking(bool isReblocked, int blockSize, int parentBlockSize,
+    int numSamplesPerParentBlock, float resampleFactor) {
+  if (reblockedBuffer != NULL) FREE_ALIGNED_BUFFER(reblockedBuffer);
+  if (overlapBuffer != NULL) FREE_ALIGNED_BUFFER(overlapBuffer);
+  reblockedBuffer = NULL;
+  overlapBuffer = NULL;
+  blockSizeInt = blockSize;
+  this->parentBlockSize = parentBlockSize;
+  this->numSamplesPerParentBlock = numSamplesPerParentBlock;
+  this->resampleFactor = resampleFactor;
+  if (isReblocked) {
+    reblockedBuffer = ALLOC_ALIGNED_BUFFER(parentBlockSize * sizeof(float));
+    memset(reblockedBuffer, 0, parentBlockSize * sizeof(float));
+    // a block is added at most one block of the parent ahead of the current one
+    int overlapBufferLength = blockSize + numSamplesPerParentBlock;
+    overlapBuffer = ALLOC_ALIGNED_BUFFER(overlapBufferLength * sizeof(float));
+    memset(overlapBuffer, 0, overlapBufferLength * sizeof(float));
+    processFunction = &processReblocked;
+    processFunctionNoMessage = &processReblocked;
+  } else {
+    processFunction = &processFunctionDefaultNoMessage;
+    processFunctionNoMessage = &processFunctionDefaultNoMessage;
+  }
+}
+
+void DspOutlet::processReblocked(DspObject *dspObject, int fromIndex, int toIndex) {
+  DspOutlet *d = reinterpret_cast<DspOutlet *>(dspObject);
+  float *input = d->dspBufferAtInlet[0];
+  float *output = d->overlapBuffer + d->graph->getOverlapIndex();
+  for (int i = fromIndex; i < toIndex; i++) {
+    output[i] += input[i];
   }
 }
+
+void DspOutlet::popReblockedOutput() {
+  if (resampleFactor == 1.0f) {
+    memcpy(reblockedBuffer, overlapBuffer, parentBlockSize * sizeof(float));
+  } else {
+    // upsampled output is decimated, downsampled output is held
+    for (int i = 0; i < parentBlockSize; i++) {
+      reblockedBuffer[i] = overlapBuffer[(int) (i * resampleFactor)];
+    }
+  }
+  memmove(overlapBuffer, overlapBuffer + numSamplesPerParentBlock, blockSizeInt * sizeof(float));
+  memset(overlapBuffer + blockSizeInt, 0, numSamplesPerParentBlock * sizeof(float));
+}
+
+void DspOutlet::clearReblockedOutput() {
+  memset(reblockedBuffer, 0, parentBlockSize * sizeof(float));
+}
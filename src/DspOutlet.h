@@ -34,6 +34,10 @@ class PdGraph;
  * way, when audio streams are implicitly added at the outlet object's inlet, the result
  * automatically appears at the outlet buffer of the parent graph. Superfluous calls to
  * <code>memcpy()</code> are avoided.
+ *
+ * If the graph is reblocked, the outlet is processed along with the graph. Each block of the graph
+ * is added to an overlap buffer, from which the graph emits a block of the parent with
+ * <code>popReblockedOutput()</code>.
  */
 class DspOutlet : public DspObject {
   
@@ -48,13 +52,43 @@ class DspOutlet : public DspObject {
 
     bool isLeafNode();
   
-    // [outlet~] does nothing with audio
+    // [outlet~] does nothing with audio, unless its graph is reblocked
     bool doesProcessAudio();
   
     float *getDspBufferAtOutlet(int outletIndex);
   
     void setDspBufferAtInlet(float *buffer, unsigned int inletIndex);
     bool canSetBufferAtOutlet(unsigned int outletIndex);
+  
+    /**
+     * Configures this outlet for a reblocked graph, with the given block sizes of the graph and its
+     * parent, the number of samples of the graph per block of the parent, and the ratio of the
+     * graph's sample rate to that of its parent.
+     */
+    void setReblocking(bool isReblocked, int blockSize, int parentBlockSize, int numSamplesPerParentBlock,
+        float resampleFactor);
+  
+    /**
+     * Resamples the next block of the parent from the overlap buffer to the outlet buffer, and
+     * advances the overlap buffer by one block of the parent.
+     */
+    void popReblockedOutput();
+  
+    /** Silences the outlet buffer of a reblocked graph. */
+    void clearReblockedOutput();
+  
+  private:
+    static void processReblocked(DspObject *dspObject, int fromIndex, int toIndex);
+  
+    /** The outlet buffer of a reblocked graph, read by the parent, or <code>NULL</code>. */
+    float *reblockedBuffer;
+  
+    /** The sum of the overlapping blocks of a reblocked graph, starting at the current block of the parent. */
+    float *overlapBuffer;
+  
+    int parentBlockSize;
+    int numSamplesPerParentBlock;
+    float resampleFactor;
 };
 
 inline const char *DspOutlet::getObjectLabel() {
@@ -70,7 +104,7 @@ inline bool DspOutlet::isLeafNode() {
 }
   
 inline bool DspOutlet::doesProcessAudio() {
-  return false;
+  return (reblockedBuffer != NULL);
 }
 
 inline std::string DspOutlet::toString() {
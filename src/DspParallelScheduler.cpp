@@ -0,0 +1,647 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <unordered_map>
+#ifndef EMSCRIPTEN
+#include <sched.h>
+#endif
+#include "DspBufferAllocator.h"
+#include "DspCatch.h"
+#include "DspDelayWrite.h"
+#include "DspImplicitAdd.h"
+#include "DelayReceiver.h"
+#include "DspParallelScheduler.h"
+#include "DspReceive.h"
+#include "DspSend.h"
+#include "DspTablePlay.h"
+#include "DspTableRead.h"
+#include "DspTableRead4.h"
+#include "DspTableWrite.h"
+#include "DspThrow.h"
+#include "OutboundMessageQueue.h"
+#include "PdGraph.h"
+
+#if __SSE__
+#include <xmmintrin.h>
+#define DSP_SCHEDULER_PAUSE() _mm_pause()
+#else
+#define DSP_SCHEDULER_PAUSE()
+#endif
+
+#ifndef EMSCRIPTEN
+thread_local DspParallelScheduler::Worker *DspParallelScheduler::currentWorker = NULL;
+#endif
+
+DspParallelScheduler::DspParallelScheduler(unsigned int numThreads, DspBufferAllocator *bufferAllocator,
+    void *(*outputFunction)(ZGCallbackFunction, void *, void *), void *outputUserData) {
+#ifdef EMSCRIPTEN
+  this->numThreads = 1; // there are no threads to use
+#else
+  this->numThreads = (numThreads > 0) ? numThreads : 1;
+#endif
+  this->bufferAllocator = bufferAllocator;
+  this->outputFunction = outputFunction;
+  this->outputUserData = outputUserData;
+  numClusters = 0;
+  numRemainingTasks.store(0);
+  
+  vector<TaskQueue> taskQueues(this->numThreads);
+  queues.swap(taskQueues);
+  for (unsigned int i = 0; i < queues.size(); i++) {
+    queues[i].lock.clear();
+    queues[i].front = 0;
+    queues[i].back = 0;
+  }
+  
+#ifndef EMSCRIPTEN
+  generation.store(0);
+  numPendingWorkers.store(0);
+  numSleepingWorkers.store(0);
+  isShuttingDown.store(false);
+  pthread_mutex_init(&sleepMutex, NULL);
+  pthread_cond_init(&wakeCondition, NULL);
+  
+  // the calling thread is the first thread
+  workers.resize(this->numThreads - 1);
+  for (unsigned int i = 0; i < workers.size(); i++) {
+    workers[i].scheduler = this;
+    workers[i].queueIndex = i + 1;
+    workers[i].output = new OutboundMessageQueue();
+    pthread_create(&workers[i].thread, NULL, &workerThread, &workers[i]);
+    
+    // request real-time priority. This fails without the necessary privileges, in which case the
+    // worker keeps the default policy.
+    struct sched_param param;
+    param.sched_priority = (sched_get_priority_min(SCHED_FIFO) + sched_get_priority_max(SCHED_FIFO)) / 2;
+    pthread_setschedparam(workers[i].thread, SCHED_FIFO, &param);
+  }
+#endif
+}
+
+DspParallelScheduler::~DspParallelScheduler() {
+#ifndef EMSCRIPTEN
+  isShuttingDown.store(true);
+  generation.fetch_add(1);
+  pthread_mutex_lock(&sleepMutex);
+  pthread_cond_broadcast(&wakeCondition);
+  pthread_mutex_unlock(&sleepMutex);
+  for (unsigned int i = 0; i < workers.size(); i++) {
+    pthread_join(workers[i].thread, NULL);
+    delete workers[i].output;
+  }
+  pthread_mutex_destroy(&sleepMutex);
+  pthread_cond_destroy(&wakeCondition);
+#endif
+}
+
+
+#pragma mark - Schedule
+
+static unsigned int findRoot(vector<unsigned int> *parent, unsigned int i) {
+  while ((*parent)[i] != i) {
+    (*parent)[i] = (*parent)[(*parent)[i]];
+    i = (*parent)[i];
+  }
+  return i;
+}
+
+// the root of a cluster is always its first object in the plan
+static void uniteClusters(vector<unsigned int> *parent, unsigned int a, unsigned int b) {
+  a = findRoot(parent, a);
+  b = findRoot(parent, b);
+  if (a != b) (*parent)[max(a, b)] = min(a, b);
+}
+
+/**
+ * Returns the name of the resource through which the object exchanges signal data with objects other
+ * than those it is connected to, or an empty string if there is none.
+ */
+static string getResourceName(DspObject *dspObject, bool *isWriter) {
+  const char *name = NULL;
+  const char *kind = NULL;
+  *isWriter = false;
+  switch (dspObject->getObjectType()) {
+    case DSP_SEND: {
+      name = reinterpret_cast<DspSend *>(dspObject)->getName();
+      kind = "send~ ";
+      *isWriter = true;
+      break;
+    }
+    case DSP_RECEIVE: {
+      name = reinterpret_cast<DspReceive *>(dspObject)->getName();
+      kind = "send~ ";
+      break;
+    }
+    case DSP_THROW: {
+      name = reinterpret_cast<DspThrow *>(dspObject)->getName();
+      kind = "catch~ ";
+      *isWriter = true;
+      break;
+    }
+    case DSP_CATCH: {
+      name = reinterpret_cast<DspCatch *>(dspObject)->getName();
+      kind = "catch~ ";
+      break;
+    }
+    case DSP_DELAY_WRITE: {
+      name = reinterpret_cast<DspDelayWrite *>(dspObject)->getName();
+      kind = "delwrite~ ";
+      *isWriter = true;
+      break;
+    }
+    case DSP_DELAY_READ:
+    case DSP_VARIABLE_DELAY: {
+      name = reinterpret_cast<DelayReceiver *>(dspObject)->getName();
+      kind = "delwrite~ ";
+      break;
+    }
+    case DSP_TABLE_WRITE: {
+      name = static_cast<DspTableWrite *>(dspObject)->getName();
+      kind = "table ";
+      *isWriter = true;
+      break;
+    }
+    case DSP_TABLE_READ: name = static_cast<DspTableRead *>(dspObject)->getName(); kind = "table "; break;
+    case DSP_TABLE_READ4: name = static_cast<DspTableRead4 *>(dspObject)->getName(); kind = "table "; break;
+    case DSP_TABLE_PLAY: name = static_cast<DspTablePlay *>(dspObject)->getName(); kind = "table "; break;
+    default: break;
+  }
+  return (name == NULL) ? string() : string(kind) + name;
+}
+
+void DspParallelScheduler::schedule(DspExecutionPlan *plan) {
+  DspExecutionPlan::DspExecutionStep *planSteps = plan->getSteps();
+  unsigned int numPlanSteps = plan->getNumSteps();
+  
+  // collect the object steps of the plan, and the graph which contains each of them
+  steps.clear();
+  guards.clear();
+  vector<pair<unsigned int, unsigned int> > guardStack; // guard index, and end of the graph in the plan
+  for (unsigned int i = 0; i < numPlanSteps; i++) {
+    while (!guardStack.empty() && i >= guardStack.back().second) guardStack.pop_back();
+    DspExecutionPlan::DspExecutionStep *planStep = planSteps + i;
+    if (planStep->graphEnd != 0) {
+      Guard guard = {reinterpret_cast<PdGraph *>(planStep->dspObject),
+          guardStack.empty() ? -1 : (int) guardStack.back().first};
+      guardStack.push_back(make_pair((unsigned int) guards.size(), planStep->graphEnd));
+      guards.push_back(guard);
+    } else {
+      Step step = {planStep->dspObject, planStep->fromIndex, planStep->toIndex, guardStack.back().first, 0};
+      steps.push_back(step);
+    }
+  }
+  guardActive.assign(guards.size(), 1);
+  
+  // find the object which writes each buffer read by an object. This is the last object before it
+  // which wrote the buffer, or the last one in the plan if the buffer is carried over from the
+  // previous block.
+  unsigned int numSteps = steps.size();
+  vector<char> isBarrier(numSteps, 0);
+  vector<char> isCarried(numSteps, 0);
+  vector<pair<unsigned int, unsigned int> > reads; // reading object, writing object
+  vector<vector<unsigned int> > readers(numSteps);
+  unordered_map<float *, unsigned int> lastWriter;
+  vector<pair<unsigned int, float *> > carriedReads;
+  for (unsigned int k = 0; k < numSteps; k++) {
+    DspObject *dspObject = steps[k].dspObject;
+    isBarrier[k] = dspObject->mustProcessSerially();
+    for (int i = 0; i < dspObject->getNumDspInlets(); i++) {
+      float *buffer = dspObject->getDspBufferAtInlet(i);
+      if (!bufferAllocator->isManagedBuffer(buffer)) continue;
+      unordered_map<float *, unsigned int>::iterator it = lastWriter.find(buffer);
+      if (it == lastWriter.end()) {
+        carriedReads.push_back(make_pair(k, buffer));
+        isCarried[k] = 1;
+      } else {
+        reads.push_back(make_pair(k, it->second));
+        readers[it->second].push_back(k);
+      }
+    }
+    for (int i = 0; i < dspObject->getNumDspOutlets(); i++) {
+      if (!dspObject->canSetBufferAtOutlet(i)) continue;
+      float *buffer = dspObject->getDspBufferAtOutlet(i);
+      if (bufferAllocator->isManagedBuffer(buffer)) lastWriter[buffer] = k;
+    }
+  }
+  for (unsigned int i = 0; i < carriedReads.size(); i++) {
+    unordered_map<float *, unsigned int>::iterator it = lastWriter.find(carriedReads[i].second);
+    if (it != lastWriter.end()) reads.push_back(make_pair(carriedReads[i].first, it->second));
+  }
+  
+  // [dac~]s are deferred, along with the implicit [+~~]s which only sum their input. An object is
+  // only deferred if all of its input is computed earlier in the block. A [dac~] which is not is
+  // processed as a barrier instead.
+  vector<char> isDeferred(numSteps, 0);
+  for (int k = numSteps - 1; k >= 0; k--) {
+    if (isBarrier[k]) continue;
+    DspObject *dspObject = steps[k].dspObject;
+    if (dspObject->getObjectType() == DSP_DAC) {
+      isDeferred[k] = !isCarried[k];
+      isBarrier[k] = isCarried[k];
+    } else if (!isCarried[k] && !readers[k].empty() &&
+        !strcmp(dspObject->toString().c_str(), DspImplicitAdd::getObjectLabel())) {
+      isDeferred[k] = 1;
+      for (unsigned int i = 0; i < readers[k].size(); i++) {
+        if (!isDeferred[readers[k][i]]) isDeferred[k] = 0;
+      }
+    }
+  }
+  
+  // cluster the remaining objects by signal dataflow
+  vector<unsigned int> parent(numSteps);
+  for (unsigned int k = 0; k < numSteps; k++) {
+    parent[k] = k;
+  }
+  for (unsigned int i = 0; i < reads.size(); i++) {
+    if (!isDeferred[reads[i].first]) uniteClusters(&parent, reads[i].first, reads[i].second);
+  }
+  numClusters = 0;
+  for (unsigned int k = 0; k < numSteps; k++) {
+    unsigned int root = findRoot(&parent, k);
+    steps[k].cluster = (root == k) ? numClusters++ : steps[root].cluster;
+  }
+  
+  // split the plan into segments at each barrier. Within a segment, each cluster is a task. Objects
+  // writing and reading the same resource are ordered as they are in the plan.
+  segments.clear();
+  tasks.clear();
+  taskSteps.clear();
+  serialSteps.clear();
+  vector<vector<unsigned int> > localTasks;
+  unordered_map<unsigned int, unsigned int> localTaskOfCluster;
+  vector<pair<unsigned int, unsigned int> > edges;
+  vector<unsigned int> deferred;
+  map<string, pair<unsigned int, vector<unsigned int> > > resources; // last writing task + 1, reading tasks
+  for (unsigned int k = 0; k < numSteps; k++) {
+    if (isBarrier[k]) {
+      addSegment(&localTasks, &edges, &deferred, k);
+      localTasks.clear();
+      localTaskOfCluster.clear();
+      edges.clear();
+      deferred.clear();
+      resources.clear();
+    } else if (isDeferred[k]) {
+      deferred.push_back(k);
+    } else {
+      unordered_map<unsigned int, unsigned int>::iterator it = localTaskOfCluster.find(steps[k].cluster);
+      unsigned int task = 0;
+      if (it == localTaskOfCluster.end()) {
+        task = localTasks.size();
+        localTaskOfCluster[steps[k].cluster] = task;
+        localTasks.push_back(vector<unsigned int>());
+      } else {
+        task = it->second;
+      }
+      localTasks[task].push_back(k);
+      
+      bool isWriter = false;
+      string resourceName = getResourceName(steps[k].dspObject, &isWriter);
+      if (!resourceName.empty()) {
+        pair<unsigned int, vector<unsigned int> > *resource = &resources[resourceName];
+        if (resource->first > 0) edges.push_back(make_pair(resource->first - 1, task));
+        if (isWriter) {
+          for (unsigned int i = 0; i < resource->second.size(); i++) {
+            edges.push_back(make_pair(resource->second[i], task));
+          }
+          resource->first = task + 1;
+          resource->second.clear();
+        } else {
+          resource->second.push_back(task);
+        }
+      }
+    }
+  }
+  if (!localTasks.empty() || !deferred.empty()) {
+    addSegment(&localTasks, &edges, &deferred, -1);
+  }
+  
+  vector<atomic<int> > pending(tasks.size());
+  pendingPredecessors.swap(pending);
+  unsigned int maxNumTasks = 0;
+  for (unsigned int i = 0; i < segments.size(); i++) {
+    maxNumTasks = max(maxNumTasks, segments[i].numTasks);
+  }
+  for (unsigned int i = 0; i < queues.size(); i++) {
+    queues[i].tasks.resize(maxNumTasks);
+  }
+}
+
+void DspParallelScheduler::addSegment(vector<vector<unsigned int> > *localTasks,
+    vector<pair<unsigned int, unsigned int> > *edges, vector<unsigned int> *deferred, int barrier) {
+  // order the tasks topologically
+  unsigned int numLocalTasks = localTasks->size();
+  vector<vector<unsigned int> > successors(numLocalTasks);
+  vector<unsigned int> numPredecessors(numLocalTasks, 0);
+  sort(edges->begin(), edges->end());
+  edges->erase(unique(edges->begin(), edges->end()), edges->end());
+  for (unsigned int i = 0; i < edges->size(); i++) {
+    pair<unsigned int, unsigned int> edge = (*edges)[i];
+    if (edge.first != edge.second) {
+      successors[edge.first].push_back(edge.second);
+      numPredecessors[edge.second]++;
+    }
+  }
+  vector<unsigned int> order;
+  for (unsigned int i = 0; i < numLocalTasks; i++) {
+    if (numPredecessors[i] == 0) order.push_back(i);
+  }
+  for (unsigned int i = 0; i < order.size(); i++) {
+    for (unsigned int j = 0; j < successors[order[i]].size(); j++) {
+      if (--numPredecessors[successors[order[i]][j]] == 0) order.push_back(successors[order[i]][j]);
+    }
+  }
+  
+  // tasks which are part of a cycle, or follow one, are merged into a single task which comes last
+  vector<unsigned int> taskIndex(numLocalTasks, order.size());
+  for (unsigned int i = 0; i < order.size(); i++) {
+    taskIndex[order[i]] = i;
+  }
+  unsigned int numTasks = (order.size() < numLocalTasks) ? order.size() + 1 : order.size();
+  vector<vector<unsigned int> > taskStepLists(numTasks);
+  for (unsigned int i = 0; i < numLocalTasks; i++) {
+    vector<unsigned int> *taskStepList = &taskStepLists[taskIndex[i]];
+    taskStepList->insert(taskStepList->end(), (*localTasks)[i].begin(), (*localTasks)[i].end());
+  }
+  if (numTasks > order.size()) sort(taskStepLists.back().begin(), taskStepLists.back().end());
+  
+  Segment segment;
+  segment.firstTask = tasks.size();
+  segment.numTasks = numTasks;
+  for (unsigned int i = 0; i < numTasks; i++) {
+    Task task;
+    task.firstStep = taskSteps.size();
+    task.numSteps = taskStepLists[i].size();
+    task.numPredecessors = 0;
+    taskSteps.insert(taskSteps.end(), taskStepLists[i].begin(), taskStepLists[i].end());
+    tasks.push_back(task);
+  }
+  set<pair<unsigned int, unsigned int> > taskEdges;
+  for (unsigned int i = 0; i < edges->size(); i++) {
+    unsigned int from = taskIndex[(*edges)[i].first];
+    unsigned int to = taskIndex[(*edges)[i].second];
+    if (from != to && taskEdges.insert(make_pair(from, to)).second) {
+      tasks[segment.firstTask + from].successors.push_back(segment.firstTask + to);
+      tasks[segment.firstTask + to].numPredecessors++;
+    }
+  }
+  for (unsigned int i = 0; i < numTasks; i++) {
+    if (tasks[segment.firstTask + i].numPredecessors == 0) segment.readyTasks.push_back(segment.firstTask + i);
+  }
+  
+  segment.firstDeferredStep = serialSteps.size();
+  segment.numDeferredSteps = deferred->size();
+  serialSteps.insert(serialSteps.end(), deferred->begin(), deferred->end());
+  segment.barrierStep = -1;
+  if (barrier >= 0) {
+    segment.barrierStep = serialSteps.size();
+    serialSteps.push_back(barrier);
+  }
+  segments.push_back(segment);
+}
+
+void DspParallelScheduler::getAllocationOrder(vector<DspObject *> *processOrder,
+    vector<unsigned int> *position, vector<unsigned int> *partition) {
+  // the rank of each step in the order in which the steps are processed
+  vector<unsigned int> rank(steps.size());
+  unsigned int r = 0;
+  for (unsigned int s = 0; s < segments.size(); s++) {
+    Segment *segment = &segments[s];
+    for (unsigned int t = segment->firstTask; t < segment->firstTask + segment->numTasks; t++) {
+      for (unsigned int i = tasks[t].firstStep; i < tasks[t].firstStep + tasks[t].numSteps; i++) {
+        rank[taskSteps[i]] = r++;
+      }
+    }
+    for (unsigned int i = 0; i < segment->numDeferredSteps; i++) {
+      rank[serialSteps[segment->firstDeferredStep + i]] = r++;
+    }
+    if (segment->barrierStep >= 0) rank[serialSteps[segment->barrierStep]] = r++;
+  }
+  
+  // a reblocked graph is a single step, which processes all of its objects before the graph itself
+  vector<vector<DspObject *> > stepObjects(steps.size());
+  vector<unsigned int> firstPosition(steps.size() + 1, 0);
+  for (unsigned int k = 0; k < steps.size(); k++) {
+    DspObject *dspObject = steps[k].dspObject;
+    if (dspObject->getObjectType() == OBJECT_PD && reinterpret_cast<PdGraph *>(dspObject)->isReblocked()) {
+      reinterpret_cast<PdGraph *>(dspObject)->getDeepDspProcessOrder(&stepObjects[k]);
+    }
+    stepObjects[k].push_back(dspObject);
+    firstPosition[rank[k] + 1] = stepObjects[k].size();
+  }
+  for (unsigned int i = 1; i <= steps.size(); i++) {
+    firstPosition[i] += firstPosition[i-1];
+  }
+  
+  processOrder->clear();
+  position->clear();
+  partition->clear();
+  for (unsigned int k = 0; k < steps.size(); k++) {
+    for (unsigned int j = 0; j < stepObjects[k].size(); j++) {
+      processOrder->push_back(stepObjects[k][j]);
+      position->push_back(firstPosition[rank[k]] + j);
+      partition->push_back(steps[k].cluster);
+    }
+  }
+}
+
+
+#pragma mark - Process
+
+void DspParallelScheduler::process() {
+  // DSP processing elements are only executed if their graph, and all graphs containing it, are switched on
+  for (unsigned int i = 0; i < guards.size(); i++) {
+    guardActive[i] = guards[i].graph->isSwitchedOn() && (guards[i].parent < 0 || guardActive[guards[i].parent]);
+  }
+  
+  for (unsigned int i = 0; i < segments.size(); i++) {
+    runSegment(&segments[i]);
+  }
+}
+
+bool DspParallelScheduler::pushLine(ZGCallbackFunction function, const char *line) {
+#ifndef EMSCRIPTEN
+  if (currentWorker != NULL && currentWorker->scheduler == this) {
+    currentWorker->output->pushLine(function, line);
+    return true;
+  }
+#endif
+  return false;
+}
+
+void DspParallelScheduler::runSegment(Segment *segment) {
+  if (numThreads > 1 && segment->numTasks > 1) {
+    for (unsigned int i = segment->firstTask; i < segment->firstTask + segment->numTasks; i++) {
+      pendingPredecessors[i].store(tasks[i].numPredecessors, memory_order_relaxed);
+    }
+    for (unsigned int i = 0; i < queues.size(); i++) {
+      queues[i].front = 0;
+      queues[i].back = 0;
+    }
+    for (unsigned int i = 0; i < segment->readyTasks.size(); i++) {
+      TaskQueue *queue = &queues[i % numThreads];
+      queue->tasks[queue->back++] = segment->readyTasks[i];
+    }
+    numRemainingTasks.store(segment->numTasks, memory_order_relaxed);
+    
+#ifndef EMSCRIPTEN
+    // wake the workers. The new generation publishes the state of the segment.
+    numPendingWorkers.store(numThreads - 1, memory_order_relaxed);
+    generation.fetch_add(1);
+    if (numSleepingWorkers.load() > 0) {
+      pthread_mutex_lock(&sleepMutex);
+      pthread_cond_broadcast(&wakeCondition);
+      pthread_mutex_unlock(&sleepMutex);
+    }
+#endif
+    
+    runTasks(0);
+    
+#ifndef EMSCRIPTEN
+    // the queues may only be reset once all workers have left the segment
+    unsigned int spins = 0;
+    while (numPendingWorkers.load(memory_order_acquire) > 0) {
+      if (++spins < DSP_SCHEDULER_SPIN_COUNT) DSP_SCHEDULER_PAUSE();
+      else sched_yield();
+    }
+    
+    // pass on what the workers printed, before anything printed by the following serial objects
+    for (unsigned int i = 0; i < workers.size(); i++) {
+      workers[i].output->poll(outputFunction, outputUserData);
+    }
+#endif
+  } else {
+    // the tasks are in topological order
+    for (unsigned int i = segment->firstTask; i < segment->firstTask + segment->numTasks; i++) {
+      for (unsigned int j = tasks[i].firstStep; j < tasks[i].firstStep + tasks[i].numSteps; j++) {
+        executeStep(&steps[taskSteps[j]]);
+      }
+    }
+  }
+  
+  // [dac~]s, in plan order, and finally the barrier
+  for (unsigned int i = 0; i < segment->numDeferredSteps; i++) {
+    executeStep(&steps[serialSteps[segment->firstDeferredStep + i]]);
+  }
+  if (segment->barrierStep >= 0) {
+    executeStep(&steps[serialSteps[segment->barrierStep]]);
+  }
+}
+
+void DspParallelScheduler::runTasks(unsigned int queueIndex) {
+  unsigned int spins = 0;
+  while (numRemainingTasks.load(memory_order_acquire) > 0) {
+    unsigned int taskIndex = 0;
+    if (popTask(queueIndex, &taskIndex) || stealTask(queueIndex, &taskIndex)) {
+      Task *task = &tasks[taskIndex];
+      for (unsigned int i = task->firstStep; i < task->firstStep + task->numSteps; i++) {
+        executeStep(&steps[taskSteps[i]]);
+      }
+      for (unsigned int i = 0; i < task->successors.size(); i++) {
+        if (pendingPredecessors[task->successors[i]].fetch_sub(1, memory_order_acq_rel) == 1) {
+          pushTask(queueIndex, task->successors[i]);
+        }
+      }
+      numRemainingTasks.fetch_sub(1, memory_order_acq_rel);
+      spins = 0;
+    } else {
+#ifndef EMSCRIPTEN
+      if (++spins < DSP_SCHEDULER_SPIN_COUNT) DSP_SCHEDULER_PAUSE();
+      else sched_yield();
+#endif
+    }
+  }
+}
+
+
+#pragma mark - Task Queues
+
+void DspParallelScheduler::pushTask(unsigned int queueIndex, unsigned int task) {
+  TaskQueue *queue = &queues[queueIndex];
+  while (queue->lock.test_and_set(memory_order_acquire)) DSP_SCHEDULER_PAUSE();
+  queue->tasks[queue->back++] = task;
+  queue->lock.clear(memory_order_release);
+}
+
+bool DspParallelScheduler::popTask(unsigned int queueIndex, unsigned int *task) {
+  TaskQueue *queue = &queues[queueIndex];
+  bool hasTask = false;
+  while (queue->lock.test_and_set(memory_order_acquire)) DSP_SCHEDULER_PAUSE();
+  if (queue->back > queue->front) {
+    *task = queue->tasks[--queue->back];
+    hasTask = true;
+  }
+  queue->lock.clear(memory_order_release);
+  return hasTask;
+}
+
+bool DspParallelScheduler::stealTask(unsigned int queueIndex, unsigned int *task) {
+  for (unsigned int i = 1; i < numThreads; i++) {
+    TaskQueue *queue = &queues[(queueIndex + i) % numThreads];
+    bool hasTask = false;
+    while (queue->lock.test_and_set(memory_order_acquire)) DSP_SCHEDULER_PAUSE();
+    if (queue->back > queue->front) {
+      *task = queue->tasks[queue->front++];
+      hasTask = true;
+    }
+    queue->lock.clear(memory_order_release);
+    if (hasTask) return true;
+  }
+  return false;
+}
+
+
+#pragma mark - Worker Threads
+
+#ifndef EMSCRIPTEN
+void *DspParallelScheduler::workerThread(void *arg) {
+  Worker *worker = reinterpret_cast<Worker *>(arg);
+  DspParallelScheduler *scheduler = worker->scheduler;
+  currentWorker = worker;
+  unsigned int lastGeneration = 0;
+  while (true) {
+    // wait for the next segment. Spin for a while before going to sleep.
+    unsigned int spins = 0;
+    while (scheduler->generation.load(memory_order_acquire) == lastGeneration) {
+      if (++spins < DSP_SCHEDULER_SPIN_COUNT) {
+        DSP_SCHEDULER_PAUSE();
+      } else {
+        pthread_mutex_lock(&scheduler->sleepMutex);
+        scheduler->numSleepingWorkers.fetch_add(1);
+        while (scheduler->generation.load() == lastGeneration) {
+          pthread_cond_wait(&scheduler->wakeCondition, &scheduler->sleepMutex);
+        }
+        scheduler->numSleepingWorkers.fetch_sub(1);
+        pthread_mutex_unlock(&scheduler->sleepMutex);
+      }
+    }
+    lastGeneration = scheduler->generation.load(memory_order_acquire);
+    if (scheduler->isShuttingDown.load()) break;
+    
+    scheduler->runTasks(worker->queueIndex);
+    scheduler->numPendingWorkers.fetch_sub(1, memory_order_release);
+  }
+  return NULL;
+}
+#endif
@@ -0,0 +1,211 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _DSP_PARALLEL_SCHEDULER_H_
+#define _DSP_PARALLEL_SCHEDULER_H_
+
+#include <atomic>
+#include <string>
+#include <vector>
+#ifndef EMSCRIPTEN
+#include <pthread.h>
+#endif
+#include "DspExecutionPlan.h"
+#include "DspObject.h"
+#include "ZGCallbackFunction.h"
+using namespace std;
+
+class DspBufferAllocator;
+class OutboundMessageQueue;
+class PdGraph;
+
+/** The number of times that an idle worker polls for work before it goes to sleep. */
+#define DSP_SCHEDULER_SPIN_COUNT 16384
+
+/**
+ * The <code>DspParallelScheduler</code> executes a <code>DspExecutionPlan</code> on a fixed pool of
+ * worker threads, together with the thread calling <code>process()</code>.
+ *
+ * The objects of the plan are partitioned into clusters, which are the connected components of the
+ * signal dataflow. Clusters exchange data only through named objects, such as [send~]/[receive~],
+ * [throw~]/[catch~], [delwrite~]/[delread~] and tables. Where they do, the writing and reading
+ * objects are processed in the order of the plan, and a [receive~] or [catch~] in another cluster
+ * than its source reads the copy made by the source (see <code>DspBufferAllocator</code>). All
+ * [dac~]s accumulate into the same output buffers, and are deferred until the clusters have been
+ * processed, as are the implicit [+~~]s which only sum their input. Objects which may send or
+ * schedule messages (see <code>DspObject::mustProcessSerially()</code>) split the plan into
+ * segments. Such an object is processed alone, once everything before it in the plan is complete.
+ *
+ * Within a segment, each cluster is a task. Ready tasks are pushed to the queue of the thread which
+ * made them ready, and idle threads steal from the queues of others. The result is identical to that
+ * of processing the plan serially.
+ *
+ * The schedule must be recomputed whenever the plan changes. The signal buffers must then be
+ * reallocated with the positions and partition given by <code>getAllocationOrder()</code>, such that
+ * concurrently processed clusters never share a buffer.
+ */
+class DspParallelScheduler {
+  
+  public:
+    /**
+     * Creates a scheduler with the given total number of threads, including the calling thread.
+     * The worker threads are requested to run with real-time priority, if permitted.
+     */
+    DspParallelScheduler(unsigned int numThreads, DspBufferAllocator *bufferAllocator,
+        void *(*outputFunction)(ZGCallbackFunction, void *, void *), void *outputUserData);
+    ~DspParallelScheduler();
+  
+    /** Computes the clusters, segments and tasks of the given plan. */
+    void schedule(DspExecutionPlan *plan);
+  
+    /**
+     * Returns all objects in the order of the plan, together with the position of each object in the
+     * order in which they are processed, and the cluster of each object. Deferred objects read their
+     * buffers after all clusters of their segment are processed.
+     */
+    void getAllocationOrder(vector<DspObject *> *processOrder, vector<unsigned int> *position,
+        vector<unsigned int> *partition);
+  
+    /** Processes one block. */
+    void process();
+  
+    /**
+     * If the calling thread is a worker of this scheduler, queues a copy of the printed line in the
+     * worker's own <code>OutboundMessageQueue</code> and returns <code>true</code>. The lines of all
+     * workers are passed to the output function on the thread calling <code>process()</code> once
+     * the segment which is being processed is complete. Returns <code>false</code> otherwise.
+     */
+    bool pushLine(ZGCallbackFunction function, const char *line);
+  
+    unsigned int getNumThreads() { return numThreads; }
+  
+    /** Returns the number of clusters in the current schedule. */
+    unsigned int getNumClusters() { return numClusters; }
+  
+    /** Returns the number of segments in the current schedule. */
+    unsigned int getNumSegments() { return (unsigned int) segments.size(); }
+  
+  private:
+    typedef struct Step {
+      DspObject *dspObject;
+      int fromIndex;
+      int toIndex;
+      unsigned int guard; // the index of the innermost graph containing the object
+      unsigned int cluster;
+    } Step;
+  
+    typedef struct Guard {
+      PdGraph *graph;
+      int parent; // the index of the guard of the parent graph, or -1
+    } Guard;
+  
+    typedef struct Task {
+      unsigned int firstStep; // into taskSteps
+      unsigned int numSteps;
+      vector<unsigned int> successors; // global task indices
+      unsigned int numPredecessors;
+    } Task;
+  
+    typedef struct Segment {
+      unsigned int firstTask;
+      unsigned int numTasks;
+      vector<unsigned int> readyTasks; // tasks without predecessors
+      unsigned int firstDeferredStep; // into serialSteps
+      unsigned int numDeferredSteps;
+      int barrierStep; // into serialSteps, or -1
+    } Segment;
+  
+    /** A queue of ready tasks. The owner pushes and pops at the back, others steal from the front. */
+    typedef struct TaskQueue {
+      atomic_flag lock;
+      vector<unsigned int> tasks;
+      unsigned int front;
+      unsigned int back;
+    } TaskQueue;
+  
+    /**
+     * Adds the tasks of a segment. The given steps of each task are in plan order, and edges are
+     * pairs of local task indices. Cycles are merged into a single task.
+     */
+    void addSegment(vector<vector<unsigned int> > *localTasks, vector<pair<unsigned int, unsigned int> > *edges,
+        vector<unsigned int> *deferred, int barrier);
+  
+    void runSegment(Segment *segment);
+  
+    /** Executes ready tasks until all tasks of the current segment are complete. */
+    void runTasks(unsigned int queueIndex);
+  
+    void pushTask(unsigned int queueIndex, unsigned int task);
+    bool popTask(unsigned int queueIndex, unsigned int *task);
+    bool stealTask(unsigned int queueIndex, unsigned int *task);
+  
+    inline void executeStep(Step *step) {
+      if (guardActive[step->guard]) {
+        DspObject *dspObject = step->dspObject;
+        dspObject->processFunction(dspObject, step->fromIndex, step->toIndex);
+      }
+    }
+  
+    unsigned int numThreads;
+    DspBufferAllocator *bufferAllocator;
+    void *(*outputFunction)(ZGCallbackFunction, void *, void *);
+    void *outputUserData;
+  
+    /** All object steps of the plan, in plan order. */
+    vector<Step> steps;
+    vector<Guard> guards;
+    vector<char> guardActive;
+    unsigned int numClusters;
+  
+    vector<Segment> segments;
+    vector<Task> tasks;
+    vector<unsigned int> taskSteps; // into steps
+    vector<unsigned int> serialSteps; // into steps
+  
+    vector<atomic<int> > pendingPredecessors;
+    atomic<int> numRemainingTasks;
+    vector<TaskQueue> queues;
+  
+#ifndef EMSCRIPTEN
+    typedef struct Worker {
+      DspParallelScheduler *scheduler;
+      unsigned int queueIndex;
+      OutboundMessageQueue *output; // the lines printed by objects processed on this worker
+      pthread_t thread;
+    } Worker;
+  
+    static void *workerThread(void *arg);
+  
+    /** The worker running on the calling thread, or <code>NULL</code>. */
+    static thread_local Worker *currentWorker;
+  
+    vector<Worker> workers;
+    atomic<unsigned int> generation;
+    atomic<int> numPendingWorkers;
+    atomic<int> numSleepingWorkers;
+    atomic<bool> isShuttingDown;
+    pthread_mutex_t sleepMutex;
+    pthread_cond_t wakeCondition;
+#endif
+};
+
+#endif // _DSP_PARALLEL_SCHEDULER_H_
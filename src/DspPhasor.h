@@ -24,6 +24,7 @@
 #define _DSP_PHASOR_H_
 
 #include "DspObject.h"
+#include "PhaseAccumulator.h"
 
 /** [phasor~], [phasor~ float] */
 class DspPhasor : public DspObject {
@@ -43,14 +44,8 @@ class DspPhasor : public DspObject {
     void processMessage(int inletIndex, PdMessage *message);
   
     float frequency;
-  
-    #if __SSE3__
-    __m64 inc; // the amount by which to increment indicies every step
-    __m64 indicies; // the table lookup indicies
-    #else
-    float inc;
-    float offset;
-    #endif
+    uint32_t phase; // the fixed-point phase, as used by PhaseAccumulator
+    uint32_t increment; // the phase increment per sample at the given frequency
 };
 
 inline const char *DspPhasor::getObjectLabel() {
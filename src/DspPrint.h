@@ -35,6 +35,9 @@ class DspPrint : public DspObject {
 
     static const char *getObjectLabel();
     std::string toString();
+  
+    // printing calls back into the host
+    bool mustProcessSerially() { return true; }
     
   private:
     void processMessage(int inletIndex, PdMessage *message);
@@ -0,0 +1,310 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string.h>
+#include "DspReadSoundfile.h"
+#include "PdContext.h"
+#include "PdGraph.h"
+
+#include <sndfile.h>
+
+/** The number of frames which are read from the file at once, before they are copied to the ring. */
+#define STREAM_CHUNK_FRAMES 4096
+
+#define DEFAULT_RING_LENGTH 65536
+#define MIN_RING_LENGTH 1024
+#define MAX_NUM_CHANNELS 64
+
+/** The state of the file, as seen by the stream thread. */
+enum StreamState {
+  STREAM_CLOSED,
+  STREAM_OPEN,
+  STREAM_END, // the whole file has been written to the ring buffer
+  STREAM_FAILED
+};
+
+struct ReadSoundfileRequest {
+  char *path;
+  int onset;
+  unsigned int serial;
+  
+  ~ReadSoundfileRequest() { free(path); }
+};
+
+MessageObject *DspReadSoundfile::newObject(PdMessage *initMessage, PdGraph *graph) {
+  return new DspReadSoundfile(initMessage, graph);
+}
+
+DspReadSoundfile::DspReadSoundfile(PdMessage *initMessage, PdGraph *graph) :
+    DspObject(1, 0, getNumChannels(initMessage)+1, getNumChannels(initMessage), graph) {
+  numChannels = getNumChannels(initMessage);
+  
+  // the buffer size is given in bytes per channel, as in Pd
+  ringLength = DEFAULT_RING_LENGTH;
+  if (initMessage->isFloat(1) && initMessage->getFloat(1) > 0.0f) {
+    unsigned int numFrames = (unsigned int) initMessage->getFloat(1) / sizeof(float);
+    ringLength = MIN_RING_LENGTH;
+    while (ringLength < numFrames && ringLength < (1 << 24)) ringLength <<= 1;
+  }
+  ring = (float *) calloc(ringLength * numChannels, sizeof(float));
+  ringHead.store(0, std::memory_order_relaxed);
+  ringTail.store(0, std::memory_order_relaxed);
+  
+  pendingRequest.store(NULL, std::memory_order_relaxed);
+  serial = 0;
+  streamSerial.store(0, std::memory_order_relaxed);
+  streamState.store(STREAM_CLOSED, std::memory_order_relaxed);
+  isOpen = false;
+  isPlaying = false;
+  endMessage = NULL;
+  numUnderruns = 0;
+  numUnderrunFrames = 0;
+  file = NULL;
+  numFileChannels = 0;
+  
+  diskWorker = graph->getContext()->getDiskWorker();
+  diskWorker->addStream(this);
+}
+
+DspReadSoundfile::~DspReadSoundfile() {
+  // the stream thread is done with this object once it has been removed
+  diskWorker->removeStream(this);
+  if (file != NULL) sf_close(file);
+  delete pendingRequest.load(std::memory_order_relaxed);
+  free(ring);
+}
+
+int DspReadSoundfile::getNumChannels(PdMessage *initMessage) {
+  return initMessage->isFloat(0)
+      ? max(1, min(MAX_NUM_CHANNELS, (int) initMessage->getFloat(0))) : 1;
+}
+
+ConnectionType DspReadSoundfile::getConnectionType(int outletIndex) {
+  // the rightmost outlet bangs at the end of the file
+  return (outletIndex == numChannels) ? MESSAGE : DSP;
+}
+
+void DspReadSoundfile::sendMessage(int outletIndex, PdMessage *message) {
+  MessageObject::sendMessage(outletIndex, message);
+  endMessage = NULL;
+}
+
+void DspReadSoundfile::stop() {
+  isPlaying = false;
+  if (endMessage != NULL) {
+    graph->cancelMessage(this, numChannels, endMessage);
+    endMessage = NULL;
+  }
+}
+
+void DspReadSoundfile::requestFile(char *path, int onset) {
+  ReadSoundfileRequest *request = new ReadSoundfileRequest();
+  request->path = path;
+  request->onset = onset;
+  request->serial = ++serial;
+  // a request which the stream thread has not yet taken will never be answered
+  delete pendingRequest.exchange(request, std::memory_order_acq_rel);
+  diskWorker->wake(this);
+}
+
+void DspReadSoundfile::start() {
+  if (isOpen) {
+    isPlaying = true;
+  } else {
+    graph->printErr("[readsf~]: start requested with no prior open.");
+  }
+}
+
+void DspReadSoundfile::close() {
+  stop();
+  if (isOpen) {
+    isOpen = false;
+    requestFile(NULL, 0);
+  }
+}
+
+void DspReadSoundfile::processMessage(int inletIndex, PdMessage *message) {
+  switch (message->getType(0)) {
+    case FLOAT: {
+      if (message->getFloat(0) != 0.0f) start();
+      else close();
+      break;
+    }
+    case SYMBOL: {
+      if (message->isSymbol(0, SYMBOL_OPEN) && message->isSymbol(1)) {
+        char *fullPath = graph->resolveFullPath(message->getSymbol(1));
+        if (fullPath == NULL) {
+          graph->printErr("[readsf~]: file '%s' cannot be found.", message->getSymbol(1));
+          break;
+        }
+        // the file is not played until it is started
+        stop();
+        isOpen = true;
+        numUnderruns = 0;
+        numUnderrunFrames = 0;
+        requestFile(fullPath, message->isFloat(2) ? max(0, (int) message->getFloat(2)) : 0);
+      } else if (message->isSymbol(0, SYMBOL_START)) {
+        start();
+      } else if (message->isSymbol(0, SYMBOL_STOP)) {
+        close();
+      } else if (message->isSymbol(0, SYMBOL_PRINT)) {
+        graph->printStd("[readsf~]: %s, %d underruns (%d frames), buffer of %u frames.",
+            isPlaying ? "playing" : (isOpen ? "open" : "closed"),
+            numUnderruns, numUnderrunFrames, ringLength);
+      }
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+}
+
+void DspReadSoundfile::processDspWithIndex(int fromIndex, int toIndex) {
+  int n = toIndex - fromIndex;
+  int numFrames = 0;
+  // nothing is played until the stream thread has taken the latest request
+  if (isPlaying && streamSerial.load(std::memory_order_acquire) == serial) {
+    int state = streamState.load(std::memory_order_acquire);
+    unsigned int tail = ringTail.load(std::memory_order_relaxed);
+    if (state == STREAM_OPEN && ringHead.load(std::memory_order_acquire) - tail < ringLength/2) {
+      // a synchronous worker fills the ring buffer now
+      diskWorker->wake(this);
+    }
+    unsigned int numAvailable = ringHead.load(std::memory_order_acquire) - tail;
+    numFrames = min(n, (int) numAvailable);
+    unsigned int mask = ringLength - 1;
+    for (int i = 0; i < numChannels; i++) {
+      float *buffer = getDspBufferAtOutlet(i) + fromIndex;
+      for (int j = 0; j < numFrames; j++) {
+        buffer[j] = ring[((tail + j) & mask) * numChannels + i];
+      }
+    }
+    ringTail.store(tail + numFrames, std::memory_order_release);
+    
+    if (numFrames < n) {
+      switch (state) {
+        case STREAM_END: {
+          isPlaying = false;
+          isOpen = false;
+          endMessage = PD_MESSAGE_ON_STACK(1);
+          endMessage->initWithTimestampAndBang(graph->getContext()->getBlockStartTimestamp() +
+              1000.0 * (fromIndex + numFrames) / graph->getSampleRate());
+          endMessage = graph->scheduleMessage(this, numChannels, endMessage);
+          break;
+        }
+        case STREAM_FAILED: {
+          isPlaying = false;
+          isOpen = false;
+          graph->printErr("[readsf~]: file cannot be opened.");
+          break;
+        }
+        case STREAM_OPEN: {
+          // the disk has fallen behind. Only the first underrun is reported, the rest are counted.
+          if (numUnderruns++ == 0) {
+            graph->printErr("[readsf~]: the disk is too slow, %d frames of silence were output. "
+                "Consider a larger buffer.", n - numFrames);
+          }
+          numUnderrunFrames += n - numFrames;
+          break;
+        }
+        default: break;
+      }
+    }
+  }
+  
+  for (int i = 0; i < numChannels; i++) {
+    memset(getDspBufferAtOutlet(i) + fromIndex + numFrames, 0, (n - numFrames) * sizeof(float));
+  }
+}
+
+void DspReadSoundfile::service() {
+  ReadSoundfileRequest *request = pendingRequest.exchange(NULL, std::memory_order_acq_rel);
+  unsigned int primedSerial = 0; // the serial of a request which is answered once the ring is primed
+  if (request != NULL) {
+    if (file != NULL) {
+      sf_close(file);
+      file = NULL;
+    }
+    int state = STREAM_CLOSED;
+    if (request->path != NULL) {
+      SF_INFO sfInfo;
+      memset(&sfInfo, 0, sizeof(SF_INFO));
+      file = sf_open(request->path, SFM_READ, &sfInfo);
+      if (file == NULL || sfInfo.channels <= 0) {
+        if (file != NULL) sf_close(file);
+        file = NULL;
+        state = STREAM_FAILED;
+      } else if (request->onset > 0 && sf_seek(file, request->onset, SEEK_SET) < 0) {
+        // the onset is beyond the end of the file
+        sf_close(file);
+        file = NULL;
+        state = STREAM_END;
+      } else {
+        numFileChannels = sfInfo.channels;
+        chunk.resize(STREAM_CHUNK_FRAMES * numFileChannels);
+        state = STREAM_OPEN;
+      }
+    }
+    // the ring buffer is not read until the request has been answered, so it may be emptied here
+    ringHead.store(ringTail.load(std::memory_order_acquire), std::memory_order_relaxed);
+    streamState.store(state, std::memory_order_relaxed);
+    if (state == STREAM_OPEN) {
+      // the request of an open file is only answered once the first frames are in the ring buffer,
+      // such that playback does not begin with an underrun
+      primedSerial = request->serial;
+    } else {
+      streamSerial.store(request->serial, std::memory_order_release);
+    }
+    delete request;
+  }
+  if (file == NULL) return;
+  
+  unsigned int head = ringHead.load(std::memory_order_relaxed);
+  unsigned int numFree = ringLength - (head - ringTail.load(std::memory_order_acquire));
+  unsigned int mask = ringLength - 1;
+  int numCopiedChannels = min(numFileChannels, numChannels);
+  while (numFree > 0) {
+    int numChunkFrames = (int) sf_readf_float(file, &chunk[0], min(numFree, (unsigned int) STREAM_CHUNK_FRAMES));
+    if (numChunkFrames <= 0) {
+      sf_close(file);
+      file = NULL;
+      streamState.store(STREAM_END, std::memory_order_release);
+      if (primedSerial != 0) streamSerial.store(primedSerial, std::memory_order_release);
+      return;
+    }
+    // channels which are not in the file are silent
+    for (int i = 0; i < numChunkFrames; i++) {
+      float *frame = ring + ((head + i) & mask) * numChannels;
+      float *fileFrame = &chunk[i * numFileChannels];
+      for (int j = 0; j < numCopiedChannels; j++) frame[j] = fileFrame[j];
+      for (int j = numCopiedChannels; j < numChannels; j++) frame[j] = 0.0f;
+    }
+    head += numChunkFrames;
+    ringHead.store(head, std::memory_order_release);
+    numFree -= numChunkFrames;
+    if (primedSerial != 0) {
+      streamSerial.store(primedSerial, std::memory_order_release);
+      primedSerial = 0;
+    }
+  }
+}
@@ -0,0 +1,127 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _DSP_READ_SOUNDFILE_H_
+#define _DSP_READ_SOUNDFILE_H_
+
+#include <atomic>
+#include <vector>
+#include "DiskWorker.h"
+#include "DspObject.h"
+
+struct SNDFILE_tag;
+struct ReadSoundfileRequest;
+
+/**
+ * [readsf~ nchannels bufsize]
+ * Plays a sound file from disk without reading it into memory. The file is read ahead into a ring
+ * buffer by the stream thread of the <code>DiskWorker</code>, and the ring buffer is read while the
+ * context is processed without ever waiting for the disk. If the disk falls behind, silence is
+ * output and the underrun is reported. The size of the ring buffer is given in bytes per channel.
+ */
+class DspReadSoundfile : public DspObject, public DiskStream {
+  
+  public:
+    static MessageObject *newObject(PdMessage *initMessage, PdGraph *graph);
+    DspReadSoundfile(PdMessage *initMessage, PdGraph *graph);
+    ~DspReadSoundfile();
+  
+    static const char *getObjectLabel();
+    std::string toString();
+  
+    ConnectionType getConnectionType(int outletIndex);
+  
+    void sendMessage(int outletIndex, PdMessage *message);
+  
+    // the bang at the end of the file is scheduled whether or not the outlet is connected
+    bool mustProcessSerially() { return true; }
+  
+    void service();
+    
+  private:
+    void processMessage(int inletIndex, PdMessage *message);
+    void processDspWithIndex(int fromIndex, int toIndex);
+  
+    /**
+     * Hands a request to the stream thread to open the given file (owned by the request) at the
+     * given frame, or to close the file if <code>path</code> is <code>NULL</code>. A request which
+     * has not yet been taken is replaced.
+     */
+    void requestFile(char *path, int onset);
+  
+    /** Plays the open file. */
+    void start();
+  
+    /** Stops playback, cancelling the bang at the end of the file. The file remains open. */
+    void stop();
+  
+    /** Stops playback and closes the file. */
+    void close();
+  
+    /** Returns the number of channels given in the init message. */
+    static int getNumChannels(PdMessage *initMessage);
+  
+    int numChannels;
+    DiskWorker *diskWorker;
+  
+    /** Interleaved frames of <code>numChannels</code> channels, written by the stream thread. */
+    float *ring;
+    unsigned int ringLength; // in frames, a power of two
+    std::atomic<unsigned int> ringHead; // the number of frames written
+    std::atomic<unsigned int> ringTail; // the number of frames read
+  
+    /** The request which has not yet been taken by the stream thread. */
+    std::atomic<ReadSoundfileRequest *> pendingRequest;
+  
+    /** The serial number of the latest request, and of the one which the stream thread has taken. */
+    unsigned int serial;
+    std::atomic<unsigned int> streamSerial;
+  
+    /** The state of the file of the request which the stream thread has taken. */
+    std::atomic<int> streamState;
+  
+    /** Whether a file has been opened and has not since been closed or played to its end. */
+    bool isOpen;
+    bool isPlaying;
+  
+    /** The bang scheduled at the end of the file. */
+    PdMessage *endMessage;
+  
+    /** The number of blocks in which the ring buffer ran out while playing, and the frames lost. */
+    int numUnderruns;
+    int numUnderrunFrames;
+  
+    // only touched by the stream thread
+    SNDFILE_tag *file;
+    int numFileChannels;
+    std::vector<float> chunk;
+};
+
+inline std::string DspReadSoundfile::toString() {
+  return DspReadSoundfile::getObjectLabel();
+}
+
+inline const char *DspReadSoundfile::getObjectLabel() {
+  return "readsf~";
+}
+
+#endif // _DSP_READ_SOUNDFILE_H_
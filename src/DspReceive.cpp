@@ -22,6 +22,8 @@
 
 #include "BufferPool.h"
 #include "DspReceive.h"
+#include "DspSend.h"
+#include "PdContext.h"
 #include "PdGraph.h"
 
 MessageObject *DspReceive::newObject(PdMessage *initMessage, PdGraph *graph) {
@@ -31,29 +33,52 @@ MessageObject *DspReceive::newObject(PdMessage *initMessage, PdGraph *graph) {
 DspReceive::DspReceive(PdMessage *initMessage, PdGraph *graph) : DspObject(1, 0, 0, 1, graph) {
   if (initMessage->isSymbol(0)) {
     name = StaticUtils::copyString(initMessage->getSymbol(0));
-    dspBufferAtOutlet[0] = ALLOC_ALIGNED_BUFFER(graph->getBlockSize() * sizeof(float));
   } else {
     name = NULL;
     graph->printErr("receive~ not initialised with a name.");
   }
-  processFunction = &processSignal;
+  processFunctionNoMessage = &processSignal;
+  processFunction = processFunctionNoMessage;
   
-  // this pointer contains the send buffer
+  // this pointer contains the copy made by the send~
   // default to zero buffer
   dspBufferAtInlet[0] = graph->getBufferPool()->getZeroBuffer();
 }
 
 DspReceive::~DspReceive() {
   free(name);
-  FREE_ALIGNED_BUFFER(dspBufferAtOutlet[0]);
 }
 
 void DspReceive::processMessage(int inletIndex, PdMessage *message) {
-  if (message->hasFormat("ss") && message->isSymbol(0, "set")) {
+  if (message->hasFormat("ss") && message->isSymbol(0, SYMBOL_SET)) {
     graph->printErr("[receive~ %s]: message \"set %s\" is not supported.", name, message->getSymbol(1));
   }
 }
 
+int DspReceive::getNumSignalSources() {
+  return (name != NULL) ? 1 : 0;
+}
+
+DspObject *DspReceive::getSignalSource(int index) {
+  return graph->getContext()->getDspSend(name);
+}
+
+void DspReceive::setSignalSourceBuffer(int index, float *buffer) {
+  // the outlet already shares the input buffer of the send~ if it can. Otherwise read the copy made
+  // by the send~, or zeros if there is none.
+  if (buffer == NULL) {
+    DspObject *dspSend = getSignalSource(0);
+    dspBufferAtInlet[0] = (dspSend != NULL)
+        ? dspSend->getDspBufferAtOutlet(0) : graph->getBufferPool()->getZeroBuffer();
+  }
+  processFunctionNoMessage = (buffer != NULL) ? &processNone : &processSignal;
+  if (!hasPendingMessages()) processFunction = processFunctionNoMessage;
+}
+
+void DspReceive::processNone(DspObject *dspObject, int fromIndex, int toIndex) {
+  // nothing to do
+}
+
 void DspReceive::processSignal(DspObject *dspObject, int fromIndex, int toIndex) {
   DspReceive *d = reinterpret_cast<DspReceive *>(dspObject);
   memcpy(d->dspBufferAtOutlet[0], d->dspBufferAtInlet[0], toIndex*sizeof(float));
@@ -25,7 +25,11 @@
 
 #include "DspObject.h"
 
-/** [receive~ symbol], [r~ symbol] */
+/**
+ * [receive~ symbol], [r~ symbol]
+ * If the [send~] is processed earlier in the same block, the outlet shares the buffer at the inlet of
+ * the [send~] and nothing is copied. Otherwise the copy made by the [send~] is copied to the outlet.
+ */
 class DspReceive : public DspObject {
   
   public:
@@ -41,9 +45,13 @@ class DspReceive : public DspObject {
   
     void processMessage(int inletIndex, PdMessage *message);
   
-    bool canSetBufferAtOutlet(unsigned int outletIndex);
+    int getNumSignalSources();
+    DspObject *getSignalSource(int index);
+    void setSignalSourceBuffer(int index, float *buffer);
+    bool forwardsSignalSource() { return true; }
   
   private:
+    static void processNone(DspObject *dspObject, int fromIndex, int toIndex);
     static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
   
     char *name;
@@ -61,10 +69,6 @@ inline ObjectType DspReceive::getObjectType() {
   return DSP_RECEIVE;
 }
   
-inline bool DspReceive::canSetBufferAtOutlet(unsigned int outletIndex) {
-  return false;
-}
-
 inline std::string DspReceive::toString() {
   return string(DspReceive::getObjectLabel()) + " " + string(name);
 }
@@ -20,52 +20,39 @@
  *
  */
 
-#include "ArrayArithmetic.h"
-#include "BufferPool.h"
 #include "DspRfft.h"
 #include "PdGraph.h"
+#include "RealFft.h"
 
 MessageObject *DspRfft::newObject(PdMessage *initMessage, PdGraph *graph) {
   return new DspRfft(initMessage, graph);
 }
 
 DspRfft::DspRfft(PdMessage *initMessage, PdGraph *graph) : DspObject(0, 1, 0, 2, graph) {
-  #if __APPLE__
-  log2n = lrintf(log2f((float) blockSizeInt));
-  fftSetup = vDSP_create_fftsetup(log2n, kFFTRadix2);
-  zeroBuffer = graph->getBufferPool()->getZeroBuffer(); // cache the local zero buffer
-  #else
-  graph->printErr("[rfft~] is not supported on this platform. It is only supported on Apple OS X and iOS platforms.");
-  #endif // __APPLE__
+  fft = RealFft::getPlan(blockSizeInt);
+  workBuffer = NULL;
+  if (fft != NULL) {
+    workBuffer = ALLOC_ALIGNED_BUFFER(fft->getWorkBufferLength() * sizeof(float));
+  } else {
+    graph->printErr("[rfft~] requires a block size which is a power of two, not %i.", blockSizeInt);
+  }
   
   processFunction = &processSignal;
+  processFunctionNoMessage = &processSignal;
 }
 
 DspRfft::~DspRfft() {
-  #if __APPLE__
-  vDSP_destroy_fftsetup(fftSetup);
-  #endif // __APPLE__
+  RealFft::releasePlan(fft);
+  if (workBuffer != NULL) FREE_ALIGNED_BUFFER(workBuffer);
 }
 
 void DspRfft::processSignal(DspObject *dspObject, int fromIndex, int toIndex) {
   DspRfft *d = reinterpret_cast<DspRfft *>(dspObject);
-  
-  #if __APPLE__
-  DSPSplitComplex inputVector;
-  inputVector.realp = d->dspBufferAtInlet[0];
-  inputVector.imagp = d->zeroBuffer;
-  DSPSplitComplex outputVector;
-  outputVector.realp = d->dspBufferAtOutlet[0];
-  outputVector.imagp = d->dspBufferAtOutlet[1];
-  vDSP_fft_zop(d->fftSetup, &inputVector, 1, &outputVector, 1, d->log2n, kFFTDirection_Forward);
-  
-  // NOTE(mhroth): vDSP_fft_zop outputs the entire series of symmetric coefficients.
-  // Pd only returns the unique values. The below code makes this object output values in the same
-  // way that Pd does. But since the Apple fft and ifft functions require the symmetric values,
-  // we leave it like this for now.
-  
-  //int halfBlockSize = blockSizeInt >> 1;
-  //memset(dspBufferAtOutlet0+halfBlockSize+1, 0, (halfBlockSize-1) * sizeof(float));
-  //memset(dspBufferAtOutlet[1]+halfBlockSize, 0, halfBlockSize * sizeof(float));
-  #endif // __APPLE__
+  if (d->fft != NULL) {
+    d->fft->forward(d->dspBufferAtInlet[0], d->dspBufferAtOutlet[0], d->dspBufferAtOutlet[1],
+        d->workBuffer);
+  } else {
+    memset(d->dspBufferAtOutlet[0], 0, d->blockSizeInt * sizeof(float));
+    memset(d->dspBufferAtOutlet[1], 0, d->blockSizeInt * sizeof(float));
+  }
 }
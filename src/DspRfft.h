@@ -23,10 +23,14 @@
 #ifndef _DSP_RFFT_H_
 #define _DSP_RFFT_H_
 
-#include "ArrayArithmetic.h"
 #include "DspObject.h"
 
-/** [rfft~] */
+class RealFft;
+
+/**
+ * [rfft~]
+ * The Fourier transform of each block. Only the unique bins are output, as in Pd.
+ */
 class DspRfft : public DspObject {
   
   public:
@@ -40,12 +44,9 @@ class DspRfft : public DspObject {
   private:
     static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
   
-    #if __APPLE__
-    vDSP_Length log2n;
-    FFTSetup fftSetup;
-    float *zeroBuffer;
-    #endif // __APPLE__
-  
+    /** The plan of the block size, or <code>NULL</code> if the block size is not a power of two. */
+    RealFft *fft;
+    float *workBuffer;
 };
 
 inline const char *DspRfft::getObjectLabel() {
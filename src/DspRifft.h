@@ -23,10 +23,15 @@
 #ifndef _DSP_RIFFT_H_
 #define _DSP_RIFFT_H_
 
-#include "ArrayArithmetic.h"
 #include "DspObject.h"
 
-/** [rifft~] */
+class RealFft;
+
+/**
+ * [rifft~]
+ * The inverse Fourier transform of each block. Only the unique bins are read, and the output is
+ * not normalised, as in Pd.
+ */
 class DspRifft : public DspObject {
   
   public:
@@ -38,13 +43,11 @@ class DspRifft : public DspObject {
     std::string toString();
     
   private:
-    void processDspWithIndex(int fromIndex, int toIndex);
-    
-    #if __APPLE__
-    vDSP_Length log2n;
-    FFTSetup fftSetup;
-    #endif // __APPLE__
+    static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
   
+    /** The plan of the block size, or <code>NULL</code> if the block size is not a power of two. */
+    RealFft *fft;
+    float *workBuffer;
 };
 
 inline std::string DspRifft::toString() {
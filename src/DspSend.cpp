@@ -31,11 +31,14 @@ DspSend::DspSend(PdMessage *initMessage, PdGraph *graph) : DspObject(0, 1, 0, 0,
   if (initMessage->isSymbol(0)) {
     name = StaticUtils::copyString(initMessage->getSymbol(0));
     dspBufferAtOutlet[0] = ALLOC_ALIGNED_BUFFER(graph->getBlockSize()*sizeof(float));
+    // a receive~ processed before this object reads silence in the first block
+    memset(dspBufferAtOutlet[0], 0, graph->getBlockSize()*sizeof(float));
   } else {
     name = NULL;
     graph->printErr("send~ not initialised with a name.");
   }
-  processFunction = &processSignal;
+  processFunctionNoMessage = &processSignal;
+  processFunction = processFunctionNoMessage;
 }
 
 DspSend::~DspSend() {
@@ -43,18 +46,18 @@ DspSend::~DspSend() {
   FREE_ALIGNED_BUFFER(dspBufferAtOutlet[0]);
 }
 
-/*
- * It would be very nice to not have to use memcpys with send~ and receive~, but unfortunately
- * things become very complicated very quickly. If s~ is already in an attached graph, then
- * everything works out fine. If s~ does not yet exist, then it is also easy for r~ to use the
- * zero buffer as its output. Ideally, we'd like to remove s~ and r~ entirely from the dsp graph
- * and all objects receiving from r~ to simply refer to the buffer at s~. But for that we'd need
- * to make sure that the s~ buffer is accordingly retained and not reused before all r~ receivers
- * have had a chance to use it.
- */
+void DspSend::setSignalCopyRequired(bool isRequired) {
+  processFunctionNoMessage = isRequired ? &processSignal : &processNone;
+  if (!hasPendingMessages()) processFunction = processFunctionNoMessage;
+}
+
+void DspSend::processNone(DspObject *dspObject, int fromIndex, int toIndex) {
+  // every receive~ reads the input buffer directly
+}
+
 void DspSend::processSignal(DspObject *dspObject, int fromIndex, int toIndex) {
-  // make a defensive copy of the input in case the buffer is reused before all receives
-  // have had the chance to refer to it
+  // copy the input for the receive~s which are processed before this object, or which otherwise
+  // cannot read the input buffer directly
   DspSend *d = reinterpret_cast<DspSend *>(dspObject);
   memcpy(d->dspBufferAtOutlet[0], d->dspBufferAtInlet[0], toIndex*sizeof(float));
 }
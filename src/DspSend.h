@@ -25,7 +25,12 @@
 
 #include "DspObject.h"
 
-/** [send~ symbol], [s~ symbol] */
+/**
+ * [send~ symbol], [s~ symbol]
+ * A [receive~] which is processed after its [send~] in the same block reads the buffer at the inlet
+ * of the [send~] directly (see <code>DspBufferAllocator</code>). Otherwise it reads a copy of the
+ * input made by the [send~], which is only made if there is such a [receive~].
+ */
 class DspSend : public DspObject {
   
   public:
@@ -38,8 +43,11 @@ class DspSend : public DspObject {
     std::string toString();
   
     ObjectType getObjectType();
+  
+    void setSignalCopyRequired(bool isRequired);
     
   private:
+    static void processNone(DspObject *dspObject, int fromIndex, int toIndex);
     static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
   
     char *name;
@@ -22,6 +22,7 @@
 
 #include "ArrayArithmetic.h"
 #include "DspSubtract.h"
+#include "DspFusedChain.h"
 
 class PdGraph;
 
@@ -31,6 +32,7 @@ MessageObject *DspSubtract::newObject(PdMessage *initMessage, PdGraph *graph) {
 
 DspSubtract::DspSubtract(PdMessage *initMessage, PdGraph *graph) : DspObject(2, 2, 0, 1, graph) {
   constant = initMessage->isFloat(0) ? initMessage->getFloat(0) : 0.0f;
+  processFunction = &processScalar;
   processFunctionNoMessage = &processScalar;
 }
 
@@ -46,8 +48,20 @@ string DspSubtract::toString() {
 }
 
 void DspSubtract::onInletConnectionUpdate(unsigned int inletIndex) {
-  processFunction = (incomingDspConnections[0].size() > 0 && incomingDspConnections[1].size() > 0)
-      ? &processSignal : processScalar;
+  // because onInletConnectionUpdate can only be called at block boundaries, it is guaranteed
+  // that no messages will be in the message queue.
+  processFunctionNoMessage = (incomingDspConnections[0].size() > 0 && incomingDspConnections[1].size() > 0)
+      ? &processSignal : &processScalar;
+  processFunction = processFunctionNoMessage;
+}
+
+bool DspSubtract::getElementwiseOperation(ElementwiseOperation *operation) {
+  operation->op = ELEMENTWISE_SUBTRACT;
+  // as when processed alone, a signal at the right inlet is only used if the left is connected too
+  operation->signalInlet = (processFunctionNoMessage == &processSignal) ? 1 : -1;
+  operation->constants[0] = &constant;
+  operation->constants[1] = NULL;
+  return true;
 }
 
 void DspSubtract::processMessage(int inletIndex, PdMessage *message) {
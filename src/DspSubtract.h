@@ -36,6 +36,7 @@ class DspSubtract : public DspObject {
     std::string toString();
   
     void onInletConnectionUpdate(unsigned int inletIndex);
+    bool getElementwiseOperation(ElementwiseOperation *operation);
 
   private:
     static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
@@ -22,6 +22,7 @@
 
 #include "DspTablePlay.h"
 #include "MessageTable.h"
+#include "PdContext.h"
 #include "PdGraph.h"
 
 MessageObject *DspTablePlay::newObject(PdMessage *initMessage, PdGraph *graph) {
@@ -63,8 +64,12 @@ void DspTablePlay::processMessage(int inletIndex, PdMessage *message) {
       break;
     }
     case SYMBOL: {
-      if (message->isSymbol(0, "set") && message->isSymbol(1)) {
-        table = graph->getTable(message->getSymbol(1));
+      if (message->isSymbol(0, SYMBOL_SET) && message->isSymbol(1)) {
+        free(name);
+        name = StaticUtils::copyString(message->getSymbol(1));
+        // file this object under its new name, such that a table created later with that name
+        // is found, and look up the table
+        graph->getContext()->registerTableReceiver(this);
       }
       break;
     }
@@ -42,6 +42,10 @@ class DspTablePlay : public DspObject, public TableReceiverInterface {
   
     void sendMessage(int outletIndex, PdMessage *message);
   
+    // the bang at the end of the table is scheduled whether or not the outlet is connected, and
+    // "set" registers this object with the context
+    bool mustProcessSerially() { return true; }
+  
     char *getName();
     void setTable(MessageTable *table);
     
@@ -22,6 +22,7 @@
 
 #include "ArrayArithmetic.h"
 #include "DspTableRead.h"
+#include "PdContext.h"
 #include "PdGraph.h"
 
 MessageObject *DspTableRead::newObject(PdMessage *initMessage, PdGraph *graph) {
@@ -42,14 +43,20 @@ void DspTableRead::setTable(MessageTable *aTable) {
   table = aTable;
 }
 
+bool DspTableRead::mustProcessSerially() {
+  return DspObject::mustProcessSerially() || !incomingMessageConnections[0].empty();
+}
+
 void DspTableRead::processMessage(int inletIndex, PdMessage *message) {
   switch (inletIndex) {
     case 0: {
-      if (message->isSymbol(0, "set") && message->isSymbol(1)) {
+      if (message->isSymbol(0, SYMBOL_SET) && message->isSymbol(1)) {
         // change the table from which this object reads
         free(name);
         name = StaticUtils::copyString(message->getSymbol(1));
-        table = graph->getTable(name);
+        // file this object under its new name, such that a table created later with that name
+        // is found, and look up the table
+        graph->getContext()->registerTableReceiver(this);
       }
       break;
     }
@@ -43,6 +43,9 @@ class DspTableRead : public DspObject, public TableReceiverInterface {
   
     char *getName();
     void setTable(MessageTable *table);
+  
+    // "set" registers this object with the context, which is only done on the processing thread
+    bool mustProcessSerially();
     
   private:
     void processMessage(int inletIndex, PdMessage *message);
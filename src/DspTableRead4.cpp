@@ -20,8 +20,9 @@
  *
  */
 
-#include "ArrayArithmetic.h"
 #include "DspTableRead4.h"
+#include "Interpolator.h"
+#include "PdContext.h"
 #include "PdGraph.h"
 
 MessageObject *DspTableRead4::newObject(PdMessage *initMessage, PdGraph *graph) {
@@ -42,14 +43,20 @@ void DspTableRead4::setTable(MessageTable *aTable) {
   table = aTable;
 }
 
+bool DspTableRead4::mustProcessSerially() {
+  return DspObject::mustProcessSerially() || !incomingMessageConnections[0].empty();
+}
+
 void DspTableRead4::processMessage(int inletIndex, PdMessage *message) {
   switch (inletIndex) {
     case 0: {
-      if (message->isSymbol(0, "set") && message->isSymbol(1)) {
+      if (message->isSymbol(0, SYMBOL_SET) && message->isSymbol(1)) {
         // change the table from which this object reads
         free(name);
         name = StaticUtils::copyString(message->getSymbol(1));
-        table = graph->getTable(name);
+        // file this object under its new name, such that a table created later with that name
+        // is found, and look up the table
+        graph->getContext()->registerTableReceiver(this);
       }
       break;
     }
@@ -66,39 +73,9 @@ void DspTableRead4::processMessage(int inletIndex, PdMessage *message) {
 }
 
 void DspTableRead4::processDspWithIndex(int fromIndex, int toIndex) {
-  if (table != NULL) { // ensure that there is a table to read from!
-    int bufferLength = 0;
-    float *buffer = table->getBuffer(&bufferLength);
-    #if __APPLE__
-    //float zero = 0.0f;
-    //float bufferLengthFloat = (float) (bufferLength-2);
-    //vDSP_vclip(inputBuffer+startSampleIndex, 1, &zero, &bufferLengthFloat,
-    //    inputBuffer+startSampleIndex, 1, endSampleIndex-startSampleIndex);
-    // NOTE(mhroth): is isn't clear what the clipping behaviour of vDSP_vlint is, but I
-    // *think* that it is doing the right thing (i.e., clipping OOB indicies)
-    int duration = toIndex - fromIndex;
-    vDSP_vsadd(dspBufferAtInlet[0]+fromIndex, 1, &offset, dspBufferAtOutlet[0]+fromIndex, 1, duration);
-    vDSP_vlint(buffer, dspBufferAtOutlet[0]+fromIndex, 1, dspBufferAtOutlet[0]+fromIndex, 1,
-        duration, bufferLength);
-    #else
-    float *inputBuffer = dspBufferAtInlet[0];
-    int maxIndex = bufferLength-1;
-    for (int i = fromIndex; i < toIndex; i++) {
-      float xf = inputBuffer[i] + offset;
-      int xi = (int) xf;
-      if (xi <= 0) {
-        dspBufferAtOutlet[0][i] = buffer[0];
-      } else if (xi >= maxIndex) {
-        dspBufferAtOutlet[0][i] = buffer[maxIndex];
-      } else {
-        // 2-point linear interpolation (basic and fast)
-        float dx = xf - ((float) xi);
-        float y0 = buffer[xi];
-        float y1 = buffer[xi+1];
-        float slope = (y1 - y0);
-        dspBufferAtOutlet[0][i] = (slope * dx) + y0;
-      }
-    }
-    #endif
-  }
+  // without a table, the output is zero
+  int bufferLength = 0;
+  float *buffer = (table != NULL) ? table->getBuffer(&bufferLength) : NULL;
+  Interpolator::readClipped(buffer, bufferLength, dspBufferAtInlet[0]+fromIndex, offset,
+      dspBufferAtOutlet[0]+fromIndex, toIndex-fromIndex);
 }
@@ -28,7 +28,7 @@
 
 /**
  * [tabread4~ name]
- * This is a linear-interpolating table reader.
+ * This is a 4-point interpolating table reader. Indices are clipped to [1, length-2], as in Pd.
  */
 class DspTableRead4 : public DspObject, public TableReceiverInterface {
   
@@ -44,6 +44,9 @@ class DspTableRead4 : public DspObject, public TableReceiverInterface {
     char *getName();
     void setTable(MessageTable *table);
   
+    // "set" registers this object with the context, which is only done on the processing thread
+    bool mustProcessSerially();
+  
   private:
     void processMessage(int inletIndex, PdMessage *message);
     void processDspWithIndex(int fromIndex, int toIndex);
@@ -32,6 +32,7 @@ DspThrow::DspThrow(PdMessage *initMessage, PdGraph *graph) : DspObject(0, 1, 0,
   if (initMessage->isSymbol(0)) {
     name = StaticUtils::copyString(initMessage->getSymbol(0));
     buffer = ALLOC_ALIGNED_BUFFER(graph->getBlockSize() * sizeof(float));
+    memset(buffer, 0, graph->getBlockSize() * sizeof(float));
   } else {
     name = NULL;
     buffer = NULL;
@@ -47,11 +48,20 @@ DspThrow::~DspThrow() {
 }
 
 void DspThrow::processMessage(int inletIndex, PdMessage *message) {
-  if (inletIndex == 0 && message->isSymbol(0, "set") && message->isSymbol(1)) {
+  if (inletIndex == 0 && message->isSymbol(0, SYMBOL_SET) && message->isSymbol(1)) {
     graph->printErr("throw~ does not support the \"set\" message.");
   }
 }
 
+void DspThrow::setSignalCopyRequired(bool isRequired) {
+  processFunctionNoMessage = isRequired ? &processSignal : &processNone;
+  if (!hasPendingMessages()) processFunction = processFunctionNoMessage;
+}
+
+void DspThrow::processNone(DspObject *dspObject, int fromIndex, int toIndex) {
+  // the catch~ reads the input buffer directly
+}
+
 void DspThrow::processSignal(DspObject *dspObject, int fromIndex, int toIndex) {
   DspThrow *d = reinterpret_cast<DspThrow *>(dspObject);
   memcpy(d->buffer, d->dspBufferAtInlet[0], toIndex * sizeof(float));
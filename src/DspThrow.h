@@ -29,7 +29,9 @@ class DspCatch;
 
 /**
  * [throw~ symbol]
- * Implements the sending end of a many-to-one audio connection.
+ * Implements the sending end of a many-to-one audio connection. If the [catch~] is processed later
+ * in the same block, it reads the buffer at the inlet directly (see <code>DspBufferAllocator</code>).
+ * Otherwise the input is copied to the buffer returned by <code>getBuffer()</code>.
  */
 class DspThrow : public DspObject {
   
@@ -48,8 +50,11 @@ class DspThrow : public DspObject {
     void processMessage(int inletIndex, PdMessage *message);
   
     bool isLeafNode();
+  
+    void setSignalCopyRequired(bool isRequired);
     
   private:
+    static void processNone(DspObject *dspObject, int fromIndex, int toIndex);
     static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
   
     char *name;
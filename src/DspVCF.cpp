@@ -24,14 +24,31 @@
 #include "DspVCF.h"
 #include "PdGraph.h"
 
+// the coefficients of the Taylor series of cos and sin, to the tenth and eleventh order
+#define COS_C1 (-1.0f/2.0f)
+#define COS_C2 (1.0f/24.0f)
+#define COS_C3 (-1.0f/720.0f)
+#define COS_C4 (1.0f/40320.0f)
+#define COS_C5 (-1.0f/3628800.0f)
+#define SIN_C1 (-1.0f/6.0f)
+#define SIN_C2 (1.0f/120.0f)
+#define SIN_C3 (-1.0f/5040.0f)
+#define SIN_C4 (1.0f/362880.0f)
+#define SIN_C5 (-1.0f/39916800.0f)
+#define HALF_PI_F ((float) (0.5 * M_PI))
+#define PI_F ((float) M_PI)
+
 MessageObject *DspVCF::newObject(PdMessage *initMessage, PdGraph *graph) {
   return new DspVCF(initMessage, graph);
 }
 
-DspVCF::DspVCF(PdMessage *initMessage, PdGraph *graph) : DspObject(3, 3, 0, 2, graph) {
-  sampleRate = graph->getSampleRate();
-  calculateFilterCoefficients(this->sampleRate/2.0f, 1.0f); // initialise the filter completely open
-  tap_0 = tap_1 = 0.0f;
+DspVCF::DspVCF(PdMessage *initMessage, PdGraph *graph) : DspObject(3, 2, 0, 2, graph) {
+  q = initMessage->isFloat(0) ? initMessage->getFloat(0) : 1.0f;
+  if (q < 0.0f) q = 0.0f;
+  centerFrequency = 0.0f;
+  tapReal = tapImag = 0.0f;
+  processFunction = &processScalar;
+  processFunctionNoMessage = &processScalar;
 }
 
 DspVCF::~DspVCF() {
@@ -42,51 +59,179 @@ const char *DspVCF::getObjectLabel() {
   return "vcf~";
 }
 
-void DspVCF::calculateFilterCoefficients(float f, float q) {
-  float r, oneminusr, omega;
-  if (f < 0.001f) f = 10.0f;
-  if (q < 0.0f) q = 0.0f;
-  this->centerFrequency = f;
-  this->q = q;
-  omega = f * (2.0f * M_PI) / sampleRate;
-  if (q < 0.001) oneminusr = 1.0f;
-  else oneminusr = omega/q;
-  if (oneminusr > 1.0f) oneminusr = 1.0f;
-  r = 1.0f - oneminusr;
-  coef1 = 2.0f * sigbp_qcos(omega) * r;
-  coef2 = - r * r;
-  gain = 2 * oneminusr * (oneminusr + r * omega);
+void DspVCF::onInletConnectionUpdate(unsigned int inletIndex) {
+  processFunction = incomingDspConnections[1].empty() ? &processScalar : &processSignal;
+  processFunctionNoMessage = processFunction;
 }
 
-float DspVCF::sigbp_qcos(float f) {
-  if (f >= -(0.5f * M_PI) && f <= (0.5f * M_PI)) {
-    float g = f*f;
-    return (((g*g*g * (-1.0f/720.0f) + g*g*(1.0f/24.0f)) - g*0.5) + 1);
-  } else {
-    return 0.0f;
+void DspVCF::processMessage(int inletIndex, PdMessage *message) {
+  switch (inletIndex) {
+    case 0: {
+      if (message->isSymbol(0, SYMBOL_CLEAR)) {
+        tapReal = tapImag = 0.0f;
+      }
+      break;
+    }
+    case 1: {
+      // the centre frequency is only used if the inlet is not connected to a signal
+      if (message->isFloat(0)) centerFrequency = message->getFloat(0);
+      break;
+    }
+    case 2: {
+      if (message->isFloat(0)) {
+        q = message->getFloat(0); // update the resonance (q)
+        if (q < 0.0f) q = 0.0f;
+      }
+      break;
+    }
+    default: break;
   }
 }
 
-void DspVCF::processMessage(int inletIndex, PdMessage *message) {
-  // not sure what the other inlets do wrt messages
-  if (inletIndex == 2) {
-    if (message->isFloat(0)) {
-      q = message->getFloat(0); // update the resonance (q)
-    }
+
+#pragma mark - Coefficients
+
+inline float DspVCF::sigbp_qcos(float f) {
+  float g = f*f;
+  return 1.0f + g*(COS_C1 + g*(COS_C2 + g*(COS_C3 + g*(COS_C4 + g*COS_C5))));
+}
+
+inline float DspVCF::sigbp_qsin(float f) {
+  float g = f*f;
+  return f * (1.0f + g*(SIN_C1 + g*(SIN_C2 + g*(SIN_C3 + g*(SIN_C4 + g*SIN_C5)))));
+}
+
+inline void DspVCF::calculateFilterCoefficients(float omega, float qinv, float ampCorrection,
+    float *coefReal, float *coefImag, float *gain) {
+  // the pole angle is limited to the Nyquist frequency
+  if (omega < 0.0f) omega = 0.0f;
+  else if (omega > PI_F) omega = PI_F;
+  float r = 0.0f;
+  if (qinv > 0.0f) {
+    r = 1.0f - omega * qinv;
+    if (r < 0.0f) r = 0.0f;
+  }
+  // cos(omega) = -sin(omega - pi/2) and sin(omega) = cos(omega - pi/2), with the argument in [-pi/2, pi/2]
+  float a = omega - HALF_PI_F;
+  *coefReal = r * -sigbp_qsin(a);
+  *coefImag = r * sigbp_qcos(a);
+  *gain = ampCorrection * (1.0f - r);
+}
+
+
+#pragma mark - Process
+
+void DspVCF::filter(float *input, float *coefReal, float *coefImag, float *gain,
+    float *outputReal, float *outputImag, int n) {
+  float re = tapReal, im = tapImag;
+  for (int i = 0; i < n; i++) {
+    float x = input[i];
+    float re2 = re;
+    re = gain[i] * x + coefReal[i] * re2 - coefImag[i] * im;
+    im = coefImag[i] * re2 + coefReal[i] * im;
+    outputReal[i] = re;
+    outputImag[i] = im;
+  }
+  tapReal = re;
+  tapImag = im;
+}
+
+void DspVCF::processSignal(DspObject *dspObject, int fromIndex, int toIndex) {
+  DspVCF *d = reinterpret_cast<DspVCF *>(dspObject);
+  float *input = d->dspBufferAtInlet[0];
+  float *frequency = d->dspBufferAtInlet[1];
+  float *outputReal = d->dspBufferAtOutlet[0];
+  float *outputImag = d->dspBufferAtOutlet[1];
+  float radiansPerHz = 2.0f * PI_F / d->graph->getSampleRate();
+  float qinv = (d->q > 0.0f) ? 1.0f / d->q : 0.0f;
+  float ampCorrection = 2.0f - 2.0f / (d->q + 2.0f);
+  float coefReal[4], coefImag[4], gain[4];
+  
+  int i = fromIndex;
+  #if __SSE__
+  __m128 vRadiansPerHz = _mm_set1_ps(radiansPerHz);
+  __m128 vQinv = _mm_set1_ps(qinv);
+  __m128 vAmpCorrection = _mm_set1_ps(ampCorrection);
+  __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+  for (; i <= toIndex - 4; i += 4) {
+    __m128 omega = _mm_mul_ps(_mm_loadu_ps(frequency+i), vRadiansPerHz);
+    omega = _mm_min_ps(_mm_max_ps(omega, zero), _mm_set1_ps(PI_F));
+    __m128 r = (qinv > 0.0f) ? _mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(omega, vQinv)), zero) : zero;
+    __m128 a = _mm_sub_ps(omega, _mm_set1_ps(HALF_PI_F));
+    __m128 g = _mm_mul_ps(a, a);
+    __m128 c = _mm_add_ps(_mm_set1_ps(COS_C4), _mm_mul_ps(g, _mm_set1_ps(COS_C5)));
+    c = _mm_add_ps(_mm_set1_ps(COS_C3), _mm_mul_ps(g, c));
+    c = _mm_add_ps(_mm_set1_ps(COS_C2), _mm_mul_ps(g, c));
+    c = _mm_add_ps(_mm_set1_ps(COS_C1), _mm_mul_ps(g, c));
+    c = _mm_add_ps(one, _mm_mul_ps(g, c));
+    __m128 s = _mm_add_ps(_mm_set1_ps(SIN_C4), _mm_mul_ps(g, _mm_set1_ps(SIN_C5)));
+    s = _mm_add_ps(_mm_set1_ps(SIN_C3), _mm_mul_ps(g, s));
+    s = _mm_add_ps(_mm_set1_ps(SIN_C2), _mm_mul_ps(g, s));
+    s = _mm_add_ps(_mm_set1_ps(SIN_C1), _mm_mul_ps(g, s));
+    s = _mm_mul_ps(a, _mm_add_ps(one, _mm_mul_ps(g, s)));
+    _mm_storeu_ps(coefReal, _mm_mul_ps(r, _mm_sub_ps(zero, s)));
+    _mm_storeu_ps(coefImag, _mm_mul_ps(r, c));
+    _mm_storeu_ps(gain, _mm_mul_ps(vAmpCorrection, _mm_sub_ps(one, r)));
+    d->filter(input+i, coefReal, coefImag, gain, outputReal+i, outputImag+i, 4);
+  }
+  #elif __ARM_NEON__
+  float32x4_t vRadiansPerHz = vdupq_n_f32(radiansPerHz);
+  float32x4_t vQinv = vdupq_n_f32(qinv);
+  float32x4_t vAmpCorrection = vdupq_n_f32(ampCorrection);
+  float32x4_t zero = vdupq_n_f32(0.0f), one = vdupq_n_f32(1.0f);
+  for (; i <= toIndex - 4; i += 4) {
+    float32x4_t omega = vmulq_f32(vld1q_f32(frequency+i), vRadiansPerHz);
+    omega = vminq_f32(vmaxq_f32(omega, zero), vdupq_n_f32(PI_F));
+    float32x4_t r = (qinv > 0.0f) ? vmaxq_f32(vsubq_f32(one, vmulq_f32(omega, vQinv)), zero) : zero;
+    float32x4_t a = vsubq_f32(omega, vdupq_n_f32(HALF_PI_F));
+    float32x4_t g = vmulq_f32(a, a);
+    float32x4_t c = vaddq_f32(vdupq_n_f32(COS_C4), vmulq_f32(g, vdupq_n_f32(COS_C5)));
+    c = vaddq_f32(vdupq_n_f32(COS_C3), vmulq_f32(g, c));
+    c = vaddq_f32(vdupq_n_f32(COS_C2), vmulq_f32(g, c));
+    c = vaddq_f32(vdupq_n_f32(COS_C1), vmulq_f32(g, c));
+    c = vaddq_f32(one, vmulq_f32(g, c));
+    float32x4_t s = vaddq_f32(vdupq_n_f32(SIN_C4), vmulq_f32(g, vdupq_n_f32(SIN_C5)));
+    s = vaddq_f32(vdupq_n_f32(SIN_C3), vmulq_f32(g, s));
+    s = vaddq_f32(vdupq_n_f32(SIN_C2), vmulq_f32(g, s));
+    s = vaddq_f32(vdupq_n_f32(SIN_C1), vmulq_f32(g, s));
+    s = vmulq_f32(a, vaddq_f32(one, vmulq_f32(g, s)));
+    vst1q_f32(coefReal, vmulq_f32(r, vnegq_f32(s)));
+    vst1q_f32(coefImag, vmulq_f32(r, c));
+    vst1q_f32(gain, vmulq_f32(vAmpCorrection, vsubq_f32(one, r)));
+    d->filter(input+i, coefReal, coefImag, gain, outputReal+i, outputImag+i, 4);
+  }
+  #endif
+  for (; i < toIndex; i++) {
+    calculateFilterCoefficients(frequency[i] * radiansPerHz, qinv, ampCorrection,
+        coefReal, coefImag, gain);
+    d->filter(input+i, coefReal, coefImag, gain, outputReal+i, outputImag+i, 1);
   }
+  
+  // flush the state if it becomes denormal
+  if (fabsf(d->tapReal) < 1e-30f) d->tapReal = 0.0f;
+  if (fabsf(d->tapImag) < 1e-30f) d->tapImag = 0.0f;
 }
 
-void DspVCF::processDspWithIndex(int fromIndex, int toIndex) {
-  /*
+void DspVCF::processScalar(DspObject *dspObject, int fromIndex, int toIndex) {
+  DspVCF *d = reinterpret_cast<DspVCF *>(dspObject);
+  float *input = d->dspBufferAtInlet[0];
+  float *outputReal = d->dspBufferAtOutlet[0];
+  float *outputImag = d->dspBufferAtOutlet[1];
+  float qinv = (d->q > 0.0f) ? 1.0f / d->q : 0.0f;
+  float ampCorrection = 2.0f - 2.0f / (d->q + 2.0f);
+  float coefReal, coefImag, gain;
+  calculateFilterCoefficients(d->centerFrequency * 2.0f * PI_F / d->graph->getSampleRate(), qinv,
+      ampCorrection, &coefReal, &coefImag, &gain);
+  
+  float re = d->tapReal, im = d->tapImag;
   for (int i = fromIndex; i < toIndex; i++) {
-    calculateFilterCoefficients(dspBufferAtInlet1[i], q);
-    dspBufferAtOutlet0[i] = dspBufferAtInlet0[i] + (coef1 * tap_0) + (coef2 * tap_1);
-    tap_1 = tap_0;
-    tap_0 = dspBufferAtOutlet0[i];
+    float x = input[i];
+    float re2 = re;
+    re = gain * x + coefReal * re2 - coefImag * im;
+    im = coefImag * re2 + coefReal * im;
+    outputReal[i] = re;
+    outputImag[i] = im;
   }
-  // dspBufferAtOutlet0[i] *= gain;
-  ArrayArithmetic::multiply(dspBufferAtOutlet0, gain, dspBufferAtOutlet0, fromIndex, toIndex);
-  */
-  // NOTE(mhroth): This object is definitely not working properly. It outputs only zero.
-  ArrayArithmetic::fill(dspBufferAtOutlet[0], 0, fromIndex, toIndex);
+  d->tapReal = (fabsf(re) < 1e-30f) ? 0.0f : re;
+  d->tapImag = (fabsf(im) < 1e-30f) ? 0.0f : im;
 }
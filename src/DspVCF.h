@@ -25,7 +25,17 @@
 
 #include "DspObject.h"
 
-/** [vcf~], a voltage controlled bandpass filter */
+/**
+ * [vcf~], a voltage controlled bandpass filter. As in Pd, the filter is a complex one-pole
+ * resonator whose pole is recomputed at every sample from the centre frequency at the right
+ * signal inlet. The left outlet is the real part (bandpass), the right outlet the imaginary part
+ * (lowpass).
+ *
+ * The cosine and sine of the pole angle are computed with <code>sigbp_qcos()</code> and
+ * <code>sigbp_qsin()</code>, polynomials which are evaluated for four samples at once with SSE or
+ * NEON. The scalar and vector versions perform the same operations, such that the output does not
+ * depend on the alignment of the block.
+ */
 class DspVCF : public DspObject {
   
   public:
@@ -35,22 +45,34 @@ class DspVCF : public DspObject {
   
     static const char *getObjectLabel();
     std::string toString();
+  
+    void onInletConnectionUpdate(unsigned int inletIndex);
     
   private:
+    static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
+    static void processScalar(DspObject *dspObject, int fromIndex, int toIndex);
+  
     void processMessage(int inletIndex, PdMessage *message);
-    void processDspWithIndex(int fromIndex, int toIndex);
   
-    void calculateFilterCoefficients(float f, float q);
-    float sigbp_qcos(float f); // not entirely sure what this is doing. From Pd.
+    /**
+     * Computes the pole <code>(coefReal, coefImag)</code> and input gain for the centre frequency
+     * given in radians per sample.
+     */
+    static inline void calculateFilterCoefficients(float omega, float qinv, float ampCorrection,
+        float *coefReal, float *coefImag, float *gain);
+  
+    /** Approximations of cos(f) and sin(f) for f in <code>[-pi/2, pi/2]</code>. */
+    static inline float sigbp_qcos(float f);
+    static inline float sigbp_qsin(float f);
+  
+    /** Runs the resonator over the given samples, with one pole and gain per sample. */
+    void filter(float *input, float *coefReal, float *coefImag, float *gain, float *outputReal,
+        float *outputImag, int n);
     
-    float sampleRate;
-    float centerFrequency;
+    float centerFrequency; // the centre frequency if the right inlet is not a signal
     float q;
-    float coef1;
-    float coef2;
-    float gain;
-    float tap_0;
-    float tap_1;
+    float tapReal; // the state of the resonator
+    float tapImag;
 };
 
 inline std::string DspVCF::toString() {
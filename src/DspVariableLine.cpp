@@ -67,7 +67,7 @@ void DspVariableLine::processMessage(int inletIndex, PdMessage *message) {
           messageList.push_back(heapMessage);
         }
         
-      } else if (message->isSymbol(0, "stop")) {
+      } else if (message->isSymbol(0, SYMBOL_STOP)) {
         // clear all pending messages
         clearAllMessagesFrom(messageList.begin());
         
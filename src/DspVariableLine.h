@@ -41,6 +41,9 @@ class DspVariableLine : public DspObject {
   
     // override sendMessage in order to update path
     void sendMessage(int outletIndex, PdMessage *message);
+  
+    // segments are scheduled as messages to this object
+    bool mustProcessSerially() { return true; }
     
   private:
     static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
@@ -35,6 +35,7 @@ class DspWrap : public DspObject {
 
     static const char *getObjectLabel();
     std::string toString();
+    bool getElementwiseOperation(ElementwiseOperation *operation);
   
   private:
     static void processSignal(DspObject *dspObject, int fromIndex, int toIndex);
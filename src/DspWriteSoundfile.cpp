@@ -0,0 +1,272 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string.h>
+#include "DspWriteSoundfile.h"
+#include "PdContext.h"
+#include "PdGraph.h"
+
+#include <sndfile.h>
+
+#define DEFAULT_RING_LENGTH 65536
+#define MIN_RING_LENGTH 1024
+#define MAX_NUM_CHANNELS 64
+
+/** The state of the file, as seen by the stream thread. */
+enum WriterState {
+  WRITER_CLOSED,
+  WRITER_OPEN,
+  WRITER_FAILED // the file could not be opened or written
+};
+
+struct WriteSoundfileRequest {
+  char *path;
+  int format;
+  int sampleRate;
+  
+  /** The frames before <code>finishPosition</code> are written to the current file. */
+  unsigned int finishPosition;
+  
+  /** The frames from <code>startPosition</code> on are written to the new file. */
+  unsigned int startPosition;
+  
+  unsigned int serial;
+  
+  ~WriteSoundfileRequest() { free(path); }
+};
+
+MessageObject *DspWriteSoundfile::newObject(PdMessage *initMessage, PdGraph *graph) {
+  return new DspWriteSoundfile(initMessage, graph);
+}
+
+DspWriteSoundfile::DspWriteSoundfile(PdMessage *initMessage, PdGraph *graph) :
+    DspObject(1, getNumChannels(initMessage), 0, 0, graph) {
+  numChannels = getNumChannels(initMessage);
+  
+  // the buffer size is given in bytes per channel, as in Pd
+  ringLength = DEFAULT_RING_LENGTH;
+  if (initMessage->isFloat(1) && initMessage->getFloat(1) > 0.0f) {
+    unsigned int numFrames = (unsigned int) initMessage->getFloat(1) / sizeof(float);
+    ringLength = MIN_RING_LENGTH;
+    while (ringLength < numFrames && ringLength < (1 << 24)) ringLength <<= 1;
+  }
+  ring = (float *) calloc(ringLength * numChannels, sizeof(float));
+  ringHead.store(0, std::memory_order_relaxed);
+  ringTail.store(0, std::memory_order_relaxed);
+  
+  pendingRequest.store(NULL, std::memory_order_relaxed);
+  pendingFinishPosition = 0;
+  serial = 0;
+  streamSerial.store(0, std::memory_order_relaxed);
+  streamState.store(WRITER_CLOSED, std::memory_order_relaxed);
+  isOpen = false;
+  isRecording = false;
+  numOverruns = 0;
+  numOverrunFrames = 0;
+  file = NULL;
+  
+  diskWorker = graph->getContext()->getDiskWorker();
+  diskWorker->addStream(this);
+}
+
+DspWriteSoundfile::~DspWriteSoundfile() {
+  // the stream thread is done with this object once it has been removed, so the rest of the
+  // recording is written here
+  diskWorker->removeStream(this);
+  if (isOpen) {
+    isOpen = false;
+    requestFile(NULL, 0, 0);
+  }
+  service();
+  free(ring);
+}
+
+int DspWriteSoundfile::getNumChannels(PdMessage *initMessage) {
+  return initMessage->isFloat(0)
+      ? max(1, min(MAX_NUM_CHANNELS, (int) initMessage->getFloat(0))) : 1;
+}
+
+void DspWriteSoundfile::requestFile(char *path, int format, int sampleRate) {
+  WriteSoundfileRequest *request = new WriteSoundfileRequest();
+  request->path = path;
+  request->format = format;
+  request->sampleRate = sampleRate;
+  request->startPosition = ringHead.load(std::memory_order_relaxed);
+  request->serial = ++serial;
+  WriteSoundfileRequest *previousRequest = pendingRequest.load(std::memory_order_acquire);
+  do {
+    // if the previous request has not been taken, its file is never opened, and the current file is
+    // still finished where that request said. The request itself may already have been taken and
+    // deleted by the stream thread, so its finish position is read from the copy.
+    request->finishPosition = (previousRequest != NULL)
+        ? pendingFinishPosition : request->startPosition;
+  } while (!pendingRequest.compare_exchange_weak(previousRequest, request,
+      std::memory_order_acq_rel, std::memory_order_acquire));
+  pendingFinishPosition = request->finishPosition;
+  delete previousRequest;
+  diskWorker->wake(this);
+}
+
+void DspWriteSoundfile::close() {
+  isRecording = false;
+  if (isOpen) {
+    isOpen = false;
+    requestFile(NULL, 0, 0);
+  }
+}
+
+void DspWriteSoundfile::processMessage(int inletIndex, PdMessage *message) {
+  if (message->isSymbol(0, SYMBOL_OPEN)) {
+    // open [flags] filename, where the flags are -wave, -aiff, -bytes <2, 3 or 4> and -rate <rate>
+    int majorFormat = 0;
+    int numBytes = 2;
+    int sampleRate = (int) graph->getSampleRate();
+    int i = 1;
+    for (; i < message->getNumElements() && message->isSymbol(i); i++) {
+      if (message->isSymbol(i, SYMBOL_FLAG_WAVE)) {
+        majorFormat = SF_FORMAT_WAV;
+      } else if (message->isSymbol(i, SYMBOL_FLAG_AIFF)) {
+        majorFormat = SF_FORMAT_AIFF;
+      } else if (message->isSymbol(i, SYMBOL_FLAG_BYTES) && message->isFloat(i+1)) {
+        numBytes = (int) message->getFloat(++i);
+      } else if (message->isSymbol(i, SYMBOL_FLAG_RATE) && message->isFloat(i+1)) {
+        sampleRate = (int) message->getFloat(++i);
+      } else {
+        break;
+      }
+    }
+    if (!message->isSymbol(i) || numBytes < 2 || numBytes > 4 || sampleRate <= 0) {
+      graph->printErr("[writesf~]: parameters are incorrect");
+      return;
+    }
+    char *filename = message->getSymbol(i);
+    if (majorFormat == 0) {
+      // the format follows from the extension of the file, and is otherwise WAVE
+      const char *extension = strrchr(filename, '.');
+      majorFormat = (extension != NULL && (!strcmp(extension, ".aif") || !strcmp(extension, ".aiff")))
+          ? SF_FORMAT_AIFF : SF_FORMAT_WAV;
+    }
+    int subFormat = (numBytes == 2) ? SF_FORMAT_PCM_16
+        : (numBytes == 3) ? SF_FORMAT_PCM_24 : SF_FORMAT_FLOAT;
+    
+    // the file is not recorded until it is started
+    isRecording = false;
+    isOpen = true;
+    numOverruns = 0;
+    numOverrunFrames = 0;
+    requestFile(graph->resolveWritePath(filename), majorFormat | subFormat, sampleRate);
+  } else if (message->isSymbol(0, SYMBOL_START)) {
+    if (isOpen) {
+      isRecording = true;
+    } else {
+      graph->printErr("[writesf~]: start requested with no prior open.");
+    }
+  } else if (message->isSymbol(0, SYMBOL_STOP)) {
+    close();
+  } else if (message->isSymbol(0, SYMBOL_PRINT)) {
+    graph->printStd("[writesf~]: %s, %d overruns (%d frames), buffer of %u frames.",
+        isRecording ? "recording" : (isOpen ? "open" : "closed"),
+        numOverruns, numOverrunFrames, ringLength);
+  }
+}
+
+void DspWriteSoundfile::processDspWithIndex(int fromIndex, int toIndex) {
+  if (isOpen && streamSerial.load(std::memory_order_acquire) == serial &&
+      streamState.load(std::memory_order_relaxed) == WRITER_FAILED) {
+    graph->printErr("[writesf~]: file cannot be written.");
+    close();
+  }
+  if (!isRecording) return;
+  
+  int n = toIndex - fromIndex;
+  unsigned int head = ringHead.load(std::memory_order_relaxed);
+  unsigned int numQueued = head - ringTail.load(std::memory_order_acquire);
+  int numFrames = min(n, (int) (ringLength - numQueued));
+  unsigned int mask = ringLength - 1;
+  for (int i = 0; i < numChannels; i++) {
+    float *buffer = getDspBufferAtInlet(i) + fromIndex;
+    for (int j = 0; j < numFrames; j++) {
+      ring[((head + j) & mask) * numChannels + i] = buffer[j];
+    }
+  }
+  ringHead.store(head + numFrames, std::memory_order_release);
+  
+  if (numFrames < n) {
+    // the disk has fallen behind. Only the first overrun is reported, the rest are counted.
+    if (numOverruns++ == 0) {
+      graph->printErr("[writesf~]: the disk is too slow, %d frames were dropped. "
+          "Consider a larger buffer.", n - numFrames);
+    }
+    numOverrunFrames += n - numFrames;
+  }
+  if (numQueued + numFrames >= ringLength/2) {
+    // a synchronous worker empties the ring buffer now
+    diskWorker->wake(this);
+  }
+}
+
+void DspWriteSoundfile::service() {
+  while (true) {
+    WriteSoundfileRequest *request = pendingRequest.exchange(NULL, std::memory_order_acq_rel);
+    
+    // write all frames to the current file, or only those which belong to it if it is to be closed.
+    // Frames are discarded if no file is open.
+    unsigned int tail = ringTail.load(std::memory_order_relaxed);
+    unsigned int end = (request != NULL)
+        ? request->finishPosition : ringHead.load(std::memory_order_acquire);
+    unsigned int mask = ringLength - 1;
+    while (tail != end) {
+      // the frames up to the end of the ring buffer are contiguous
+      unsigned int index = tail & mask;
+      int numFrames = (int) min(end - tail, ringLength - index);
+      if (file != NULL && sf_writef_float(file, ring + index * numChannels, numFrames) < numFrames) {
+        // e.g. the disk is full
+        sf_close(file);
+        file = NULL;
+        streamState.store(WRITER_FAILED, std::memory_order_relaxed);
+      }
+      tail += numFrames;
+      ringTail.store(tail, std::memory_order_release);
+    }
+    if (request == NULL) return;
+    
+    // closing the file completes its header
+    if (file != NULL) {
+      sf_close(file);
+      file = NULL;
+    }
+    ringTail.store(request->startPosition, std::memory_order_release);
+    int state = WRITER_CLOSED;
+    if (request->path != NULL) {
+      SF_INFO sfInfo;
+      memset(&sfInfo, 0, sizeof(SF_INFO));
+      sfInfo.samplerate = request->sampleRate;
+      sfInfo.channels = numChannels;
+      sfInfo.format = request->format;
+      file = sf_open(request->path, SFM_WRITE, &sfInfo);
+      state = (file != NULL) ? WRITER_OPEN : WRITER_FAILED;
+    }
+    streamState.store(state, std::memory_order_relaxed);
+    streamSerial.store(request->serial, std::memory_order_release);
+    delete request;
+  }
+}
@@ -0,0 +1,115 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _DSP_WRITE_SOUNDFILE_H_
+#define _DSP_WRITE_SOUNDFILE_H_
+
+#include <atomic>
+#include "DiskWorker.h"
+#include "DspObject.h"
+
+struct SNDFILE_tag;
+struct WriteSoundfileRequest;
+
+/**
+ * [writesf~ nchannels bufsize]
+ * Records its inlets to a sound file. While the context is processed, blocks are only copied into a
+ * ring buffer, which the stream thread of the <code>DiskWorker</code> writes to the file. If the disk
+ * falls behind and the ring buffer is full, frames are dropped and the overrun is reported. The size
+ * of the ring buffer is given in bytes per channel. Any frames which have not yet been written when
+ * the object is deleted are written before the file is closed.
+ */
+class DspWriteSoundfile : public DspObject, public DiskStream {
+  
+  public:
+    static MessageObject *newObject(PdMessage *initMessage, PdGraph *graph);
+    DspWriteSoundfile(PdMessage *initMessage, PdGraph *graph);
+    ~DspWriteSoundfile();
+  
+    static const char *getObjectLabel();
+    std::string toString();
+  
+    // overruns and errors are reported while processing
+    bool mustProcessSerially() { return true; }
+  
+    void service();
+    
+  private:
+    void processMessage(int inletIndex, PdMessage *message);
+    void processDspWithIndex(int fromIndex, int toIndex);
+  
+    /**
+     * Hands a request to the stream thread to finish the current file with the frames recorded so
+     * far, and then to open the given file (owned by the request) with the given format, unless
+     * <code>path</code> is <code>NULL</code>.
+     */
+    void requestFile(char *path, int format, int sampleRate);
+  
+    /** Stops recording and closes the file. */
+    void close();
+  
+    /** Returns the number of channels given in the init message. */
+    static int getNumChannels(PdMessage *initMessage);
+  
+    int numChannels;
+    DiskWorker *diskWorker;
+  
+    /** Interleaved frames of <code>numChannels</code> channels, read by the stream thread. */
+    float *ring;
+    unsigned int ringLength; // in frames, a power of two
+    std::atomic<unsigned int> ringHead; // the number of frames written
+    std::atomic<unsigned int> ringTail; // the number of frames read
+  
+    /** The request which has not yet been taken by the stream thread. */
+    std::atomic<WriteSoundfileRequest *> pendingRequest;
+  
+    /** The finish position of the latest request. Only touched by the processing thread. */
+    unsigned int pendingFinishPosition;
+  
+    /** The serial number of the latest request, and of the one which the stream thread has taken. */
+    unsigned int serial;
+    std::atomic<unsigned int> streamSerial;
+  
+    /** The state of the file of the request which the stream thread has taken. */
+    std::atomic<int> streamState;
+  
+    /** Whether a file has been opened and has not since been closed or failed. */
+    bool isOpen;
+    bool isRecording;
+  
+    /** The number of blocks in which the ring buffer was full while recording, and the frames lost. */
+    int numOverruns;
+    int numOverrunFrames;
+  
+    // only touched by the stream thread
+    SNDFILE_tag *file;
+};
+
+inline std::string DspWriteSoundfile::toString() {
+  return DspWriteSoundfile::getObjectLabel();
+}
+
+inline const char *DspWriteSoundfile::getObjectLabel() {
+  return "writesf~";
+}
+
+#endif // _DSP_WRITE_SOUNDFILE_H_
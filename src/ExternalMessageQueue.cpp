@@ -0,0 +1,140 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "ExternalMessageQueue.h"
+
+// keeps the storage of each message 8-byte aligned
+#define ALIGN_MESSAGE_BYTES(_x) (((_x) + 7) & ~7)
+
+static void discardMessage(void *userData, const char *receiverName, PdMessage *message) {
+  // nothing to do
+}
+
+// copies the string to the buffer, and returns the position following it
+static char *appendString(char *buffer, const char *string) {
+  size_t length = strlen(string) + 1;
+  memcpy(buffer, string, length);
+  return buffer + length;
+}
+
+ExternalMessageQueue::ExternalMessageQueue() {
+  numBytesPerSlot = ALIGN_MESSAGE_BYTES(PdMessage::numBytes(EXTERNAL_MESSAGE_QUEUE_MAX_ELEMENTS)) +
+      EXTERNAL_MESSAGE_QUEUE_STRING_BYTES;
+  slotStorage = (char *) malloc(EXTERNAL_MESSAGE_QUEUE_CAPACITY * numBytesPerSlot);
+  slots = new Slot[EXTERNAL_MESSAGE_QUEUE_CAPACITY];
+  for (unsigned int i = 0; i < EXTERNAL_MESSAGE_QUEUE_CAPACITY; i++) {
+    slots[i].sequence.store(i, memory_order_relaxed);
+    slots[i].receiverName = NULL;
+    slots[i].message = NULL;
+    slots[i].isOnHeap = false;
+  }
+  tail.store(0, memory_order_relaxed);
+  head = 0;
+  numPushed.store(0, memory_order_relaxed);
+  numDropped.store(0, memory_order_relaxed);
+  maxNumQueued.store(0, memory_order_relaxed);
+}
+
+ExternalMessageQueue::~ExternalMessageQueue() {
+  // free any large messages which were never delivered
+  drain(&discardMessage, NULL);
+  delete[] slots;
+  free(slotStorage);
+}
+
+bool ExternalMessageQueue::push(const char *receiverName, PdMessage *message) {
+  // the message is followed by copies of the receiver name and of the symbols of the message
+  unsigned int numMessageBytes = ALIGN_MESSAGE_BYTES(message->numBytes());
+  unsigned int numBytes = numMessageBytes + strlen(receiverName) + 1;
+  for (int i = 0; i < message->getNumElements(); i++) {
+    if (message->isSymbol(i)) numBytes += strlen(message->getSymbol(i)) + 1;
+  }
+  
+  // claim the slot at the tail. It is free once the consumer has advanced its sequence to the position.
+  unsigned int position = tail.load(memory_order_relaxed);
+  Slot *slot = NULL;
+  while (true) {
+    slot = &slots[position & (EXTERNAL_MESSAGE_QUEUE_CAPACITY - 1)];
+    int difference = (int) (slot->sequence.load(memory_order_acquire) - position);
+    if (difference == 0) {
+      if (tail.compare_exchange_weak(position, position + 1, memory_order_relaxed)) break;
+    } else if (difference < 0) {
+      numDropped.fetch_add(1, memory_order_relaxed);
+      return false; // the queue is full
+    } else {
+      position = tail.load(memory_order_relaxed); // another producer claimed the slot first
+    }
+  }
+  
+  // the symbols are interned by the consumer, such that the producer never locks the symbol table
+  slot->isOnHeap = (message->getNumElements() > EXTERNAL_MESSAGE_QUEUE_MAX_ELEMENTS) ||
+      (numBytes - numMessageBytes > EXTERNAL_MESSAGE_QUEUE_STRING_BYTES);
+  char *storage = slot->isOnHeap ? (char *) malloc(numBytes)
+      : slotStorage + (position & (EXTERNAL_MESSAGE_QUEUE_CAPACITY - 1)) * numBytesPerSlot;
+  slot->message = message->copyTo(storage);
+  char *strings = storage + numMessageBytes;
+  slot->receiverName = strings;
+  strings = appendString(strings, receiverName);
+  for (int i = 0; i < message->getNumElements(); i++) {
+    if (message->isSymbol(i)) {
+      slot->message->setUninternedSymbol(i, strings);
+      strings = appendString(strings, message->getSymbol(i));
+    }
+  }
+  
+  // publish the slot to the consumer
+  slot->sequence.store(position + 1, memory_order_release);
+  numPushed.fetch_add(1, memory_order_relaxed);
+  return true;
+}
+
+unsigned int ExternalMessageQueue::drain(
+    void (*receive)(void *userData, const char *receiverName, PdMessage *message), void *userData) {
+  // only the messages queued before the drain began are delivered
+  unsigned int end = tail.load(memory_order_acquire);
+  if (end - head > maxNumQueued.load(memory_order_relaxed)) {
+    maxNumQueued.store(end - head, memory_order_relaxed);
+  }
+  unsigned int numMessages = 0;
+  while (head != end) {
+    unsigned int index = head & (EXTERNAL_MESSAGE_QUEUE_CAPACITY - 1);
+    Slot *slot = &slots[index];
+    // a producer may not yet have finished writing its message. It is delivered with the next drain.
+    if (slot->sequence.load(memory_order_acquire) != head + 1) break;
+    
+    // symbols which are already known are interned without taking the lock of the symbol table
+    PdMessage *message = slot->message;
+    for (int i = 0; i < message->getNumElements(); i++) {
+      if (message->isSymbol(i)) message->setSymbol(i, message->getSymbol(i));
+    }
+    receive(userData, slot->receiverName, message);
+    if (slot->isOnHeap) message->freeMessage();
+    
+    // release the slot to the producers for the next time around the ring
+    slot->sequence.store(head + EXTERNAL_MESSAGE_QUEUE_CAPACITY, memory_order_release);
+    head++;
+    numMessages++;
+  }
+  return numMessages;
+}
@@ -0,0 +1,119 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _EXTERNAL_MESSAGE_QUEUE_H_
+#define _EXTERNAL_MESSAGE_QUEUE_H_
+
+#include <atomic>
+#include "PdMessage.h"
+using namespace std;
+
+/** The number of messages which an <code>ExternalMessageQueue</code> can hold. A power of two. */
+#define EXTERNAL_MESSAGE_QUEUE_CAPACITY 1024
+
+/** The largest number of elements of a message which is stored in the queue without allocation. */
+#define EXTERNAL_MESSAGE_QUEUE_MAX_ELEMENTS 16
+
+/**
+ * The number of bytes in each slot for the receiver name and the symbols of the message, including
+ * their terminating null characters.
+ */
+#define EXTERNAL_MESSAGE_QUEUE_STRING_BYTES 256
+
+/**
+ * The <code>ExternalMessageQueue</code> carries messages sent to named receivers from any thread
+ * (e.g. with <code>zg_context_send_message()</code>) to the thread processing the context, without
+ * taking the context lock. It is a bounded ring of pre-allocated slots, each with a sequence number
+ * which tells producers and the consumer whose turn it is. Producers claim a slot with a
+ * compare-and-swap, which is lock-free but not wait-free: a producer may retry while others claim
+ * slots, but no producer waits for another to finish. If the ring is full, the message is dropped and
+ * counted.
+ *
+ * The receiver name and the symbols of the message are copied into the slot as strings, and the
+ * symbols are interned by the consumer before the message is delivered. A producer therefore never
+ * takes the lock of the <code>SymbolTable</code>. The consumer finds known symbols without a lock,
+ * and only takes it for a symbol which has never been seen. A message whose elements or strings do
+ * not fit into a slot is copied to the heap, and the producer may then block in the allocator.
+ *
+ * The context drains the queue at the start of each block. A drain delivers the messages which were
+ * pushed before it began, in order, and no others, such that its duration is bounded by the capacity
+ * of the queue. A message is therefore delivered in the first block which starts after it has been
+ * pushed, unless a push which began earlier is still in progress.
+ */
+class ExternalMessageQueue {
+  
+  public:
+    ExternalMessageQueue();
+    ~ExternalMessageQueue();
+  
+    /**
+     * Queues a copy of the message for the named receiver. Returns <code>false</code> if the queue is
+     * full, in which case the message is dropped. This function may be called from any thread. The
+     * symbols of the message need not be interned (see <code>PdMessage::setUninternedSymbol()</code>).
+     */
+    bool push(const char *receiverName, PdMessage *message);
+  
+    /**
+     * Passes each message which was queued before this call to the given function, in order, and
+     * removes it from the queue. The symbols of the message are interned, but the receiver name is
+     * not. Both are only valid for the duration of the call. Returns the number of messages. Only one
+     * thread may drain the queue.
+     */
+    unsigned int drain(void (*receive)(void *userData, const char *receiverName, PdMessage *message),
+        void *userData);
+  
+    /** Returns the number of messages which have been queued. */
+    unsigned int getNumPushed() { return numPushed.load(memory_order_relaxed); }
+  
+    /** Returns the number of messages which were dropped because the queue was full. */
+    unsigned int getNumDropped() { return numDropped.load(memory_order_relaxed); }
+  
+    /** Returns the largest number of messages which were waiting at the start of a drain. */
+    unsigned int getMaxNumQueued() { return maxNumQueued.load(memory_order_relaxed); }
+  
+  private:
+    typedef struct Slot {
+      atomic<unsigned int> sequence;
+      const char *receiverName; // a copy, following the message
+      PdMessage *message; // in the slot's own storage, or on the heap if the message is large
+      bool isOnHeap;
+    } Slot;
+  
+    Slot *slots;
+  
+    /** The storage of each slot, holding the message followed by its strings. */
+    char *slotStorage;
+    unsigned int numBytesPerSlot;
+  
+    // the positions of the producers and the consumer are kept on separate cache lines
+    char padding0[64];
+    atomic<unsigned int> tail;
+    char padding1[64];
+    unsigned int head;
+    char padding2[64];
+  
+    atomic<unsigned int> numPushed;
+    atomic<unsigned int> numDropped;
+    atomic<unsigned int> maxNumQueued; // written only by the consumer, but read from any thread
+};
+
+#endif // _EXTERNAL_MESSAGE_QUEUE_H_
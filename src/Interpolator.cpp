@@ -0,0 +1,325 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string.h>
+#include "ArrayArithmetic.h"
+#include "Interpolator.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#define INTERPOLATOR_SIMD 1
+typedef __m128 v4sf;
+typedef __m128i v4si;
+#elif __ARM_NEON__
+#include <arm_neon.h>
+#define INTERPOLATOR_SIMD 1
+typedef float32x4_t v4sf;
+typedef int32x4_t v4si;
+#endif
+
+#if ARRAY_ARITHMETIC_DISPATCH
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// the shortest delay of [vd~], in samples. The newest sample read for any delay is then in the past.
+#define MIN_DELAY 1.0f
+
+#pragma mark - Scalar Operations
+
+/*
+ * Pd's 4-point interpolation at the given fraction of the way from b to c, where a precedes b and d
+ * follows c. The operations are evaluated in the same order by all vector paths.
+ */
+static inline float interpolate(float a, float b, float c, float d, float frac) {
+  float cminusb = c - b;
+  return b + frac * (cminusb - 0.1666667f * (1.0f - frac) *
+      ((d - a - 3.0f * cminusb) * frac + (d + 2.0f * a - 3.0f * b)));
+}
+
+// an index of a circular buffer, which may lie at most one length outside of it
+static inline int wrap(int index, int length) {
+  return index + ((index < 0) ? length : 0) - ((index >= length) ? length : 0);
+}
+
+#pragma mark - Vector Operations
+
+#if INTERPOLATOR_SIMD
+#if __SSE2__
+static inline v4sf vloadu(const float *p) { return _mm_loadu_ps(p); }
+static inline void vstoreu(float *p, v4sf a) { _mm_storeu_ps(p, a); }
+static inline v4sf vset1(float f) { return _mm_set1_ps(f); }
+static inline v4sf vadd(v4sf a, v4sf b) { return _mm_add_ps(a, b); }
+static inline v4sf vsub(v4sf a, v4sf b) { return _mm_sub_ps(a, b); }
+static inline v4sf vmul(v4sf a, v4sf b) { return _mm_mul_ps(a, b); }
+static inline v4sf vmax(v4sf a, v4sf b) { return _mm_max_ps(a, b); } // a > b ? a : b
+static inline v4sf vmin(v4sf a, v4sf b) { return _mm_min_ps(a, b); } // a < b ? a : b
+static inline v4si vtruncate(v4sf a) { return _mm_cvttps_epi32(a); }
+static inline v4sf vfloat(v4si a) { return _mm_cvtepi32_ps(a); }
+static inline v4si vset1i(int a) { return _mm_set1_epi32(a); }
+static inline v4si vrampi(int a) { return _mm_setr_epi32(a, a+1, a+2, a+3); }
+static inline v4si vaddi(v4si a, v4si b) { return _mm_add_epi32(a, b); }
+static inline v4si vsubi(v4si a, v4si b) { return _mm_sub_epi32(a, b); }
+static inline v4si vandi(v4si a, v4si b) { return _mm_and_si128(a, b); }
+static inline v4si vgreateri(v4si a, v4si b) { return _mm_cmpgt_epi32(a, b); }
+
+static inline v4si vori(v4si a, v4si b) { return _mm_or_si128(a, b); }
+static inline bool vanyi(v4si mask) { return _mm_movemask_epi8(mask) != 0; }
+static inline void vstoreui(int *p, v4si a) { _mm_storeu_si128((__m128i *) p, a); }
+
+// SSE2 has no gather instruction, so each lane is loaded separately
+static inline v4sf vgather(const float *table, v4si index) {
+  int i[4];
+  vstoreui(i, index);
+  return _mm_setr_ps(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+}
+
+// loads four consecutive samples at each of four addresses, such that v0 holds the first of each
+static inline void vloadtransposed(const float *p0, const float *p1, const float *p2, const float *p3,
+    v4sf *v0, v4sf *v1, v4sf *v2, v4sf *v3) {
+  v4sf r0 = _mm_loadu_ps(p0), r1 = _mm_loadu_ps(p1), r2 = _mm_loadu_ps(p2), r3 = _mm_loadu_ps(p3);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+  *v0 = r0; *v1 = r1; *v2 = r2; *v3 = r3;
+}
+#elif __ARM_NEON__
+static inline v4sf vloadu(const float *p) { return vld1q_f32(p); }
+static inline void vstoreu(float *p, v4sf a) { vst1q_f32(p, a); }
+static inline v4sf vset1(float f) { return vdupq_n_f32(f); }
+static inline v4sf vadd(v4sf a, v4sf b) { return vaddq_f32(a, b); }
+static inline v4sf vsub(v4sf a, v4sf b) { return vsubq_f32(a, b); }
+static inline v4sf vmul(v4sf a, v4sf b) { return vmulq_f32(a, b); }
+// as on x86 and in the scalar path, b is returned if either operand is NaN
+static inline v4sf vmax(v4sf a, v4sf b) { return vbslq_f32(vcgtq_f32(a, b), a, b); }
+static inline v4sf vmin(v4sf a, v4sf b) { return vbslq_f32(vcltq_f32(a, b), a, b); }
+static inline v4si vtruncate(v4sf a) { return vcvtq_s32_f32(a); }
+static inline v4sf vfloat(v4si a) { return vcvtq_f32_s32(a); }
+static inline v4si vset1i(int a) { return vdupq_n_s32(a); }
+static inline v4si vrampi(int a) {
+  int32_t r[4] = {a, a+1, a+2, a+3};
+  return vld1q_s32(r);
+}
+static inline v4si vaddi(v4si a, v4si b) { return vaddq_s32(a, b); }
+static inline v4si vsubi(v4si a, v4si b) { return vsubq_s32(a, b); }
+static inline v4si vandi(v4si a, v4si b) { return vandq_s32(a, b); }
+static inline v4si vgreateri(v4si a, v4si b) { return vreinterpretq_s32_u32(vcgtq_s32(a, b)); }
+
+static inline v4si vori(v4si a, v4si b) { return vorrq_s32(a, b); }
+static inline bool vanyi(v4si mask) {
+  int32x2_t m = vorr_s32(vget_low_s32(mask), vget_high_s32(mask));
+  return (vget_lane_s32(m, 0) | vget_lane_s32(m, 1)) != 0;
+}
+static inline void vstoreui(int *p, v4si a) { vst1q_s32(p, a); }
+
+// NEON has no gather instruction, so each lane is loaded separately
+static inline v4sf vgather(const float *table, v4si index) {
+  v4sf v = vld1q_dup_f32(table + vgetq_lane_s32(index, 0));
+  v = vld1q_lane_f32(table + vgetq_lane_s32(index, 1), v, 1);
+  v = vld1q_lane_f32(table + vgetq_lane_s32(index, 2), v, 2);
+  return vld1q_lane_f32(table + vgetq_lane_s32(index, 3), v, 3);
+}
+
+// loads four consecutive samples at each of four addresses, such that v0 holds the first of each
+static inline void vloadtransposed(const float *p0, const float *p1, const float *p2, const float *p3,
+    v4sf *v0, v4sf *v1, v4sf *v2, v4sf *v3) {
+  float32x4x2_t t01 = vtrnq_f32(vld1q_f32(p0), vld1q_f32(p1));
+  float32x4x2_t t23 = vtrnq_f32(vld1q_f32(p2), vld1q_f32(p3));
+  *v0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+  *v1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+  *v2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+  *v3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+#endif
+
+static inline v4sf vinterpolate(v4sf a, v4sf b, v4sf c, v4sf d, v4sf frac) {
+  v4sf cminusb = vsub(c, b);
+  v4sf t = vadd(vmul(vsub(vsub(d, a), vmul(vset1(3.0f), cminusb)), frac),
+      vsub(vadd(d, vmul(vset1(2.0f), a)), vmul(vset1(3.0f), b)));
+  t = vmul(vmul(vset1(0.1666667f), vsub(vset1(1.0f), frac)), t);
+  return vadd(b, vmul(frac, vsub(cminusb, t)));
+}
+
+static inline v4si vwrap(v4si index, v4si length, v4si lastIndex) {
+  index = vaddi(index, vandi(vgreateri(vset1i(0), index), length));
+  return vsubi(index, vandi(vgreateri(index, lastIndex), length));
+}
+#endif // INTERPOLATOR_SIMD
+
+#pragma mark - AVX2
+
+#if ARRAY_ARITHMETIC_DISPATCH
+// AVX2 adds the gather instruction. It is only used if the AVX kernels of ArrayArithmetic are.
+static bool isGatherSupported() {
+  return ArrayArithmetic::getInstructionSet() != ArrayArithmetic::SSE && __builtin_cpu_supports("avx2");
+}
+
+TARGET_AVX2 static inline __m256 interpolateAvx2(__m256 a, __m256 b, __m256 c, __m256 d, __m256 frac) {
+  __m256 three = _mm256_set1_ps(3.0f);
+  __m256 cminusb = _mm256_sub_ps(c, b);
+  __m256 t = _mm256_add_ps(
+      _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(d, a), _mm256_mul_ps(three, cminusb)), frac),
+      _mm256_sub_ps(_mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(2.0f), a)), _mm256_mul_ps(three, b)));
+  t = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.1666667f), _mm256_sub_ps(_mm256_set1_ps(1.0f), frac)), t);
+  return _mm256_add_ps(b, _mm256_mul_ps(frac, _mm256_sub_ps(cminusb, t)));
+}
+
+TARGET_AVX2 static inline __m256i wrapAvx2(__m256i index, __m256i length, __m256i lastIndex) {
+  index = _mm256_add_epi32(index, _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), index), length));
+  return _mm256_sub_epi32(index, _mm256_and_si256(_mm256_cmpgt_epi32(index, lastIndex), length));
+}
+
+TARGET_AVX2 static int readClippedAvx2(float *table, int length, float *index, float offset,
+    float *output, int i, int n) {
+  __m256 minPosition = _mm256_set1_ps(1.0f);
+  __m256 maxPosition = _mm256_set1_ps((float) (length - 2));
+  __m256i maxIndex = _mm256_set1_epi32(length - 3);
+  __m256i one = _mm256_set1_epi32(1);
+  for (; i <= n - 8; i += 8) {
+    __m256 f = _mm256_add_ps(_mm256_loadu_ps(index + i), _mm256_set1_ps(offset));
+    f = _mm256_min_ps(_mm256_max_ps(f, minPosition), maxPosition);
+    __m256i x = _mm256_cvttps_epi32(f);
+    x = _mm256_sub_epi32(x, _mm256_and_si256(_mm256_cmpgt_epi32(x, maxIndex), one));
+    __m256 frac = _mm256_sub_ps(f, _mm256_cvtepi32_ps(x));
+    __m256 a = _mm256_i32gather_ps(table - 1, x, 4);
+    __m256 b = _mm256_i32gather_ps(table, x, 4);
+    __m256 c = _mm256_i32gather_ps(table + 1, x, 4);
+    __m256 d = _mm256_i32gather_ps(table + 2, x, 4);
+    _mm256_storeu_ps(output + i, interpolateAvx2(a, b, c, d, frac));
+  }
+  return i;
+}
+
+TARGET_AVX2 static int readDelayedAvx2(float *buffer, int length, int position, float *delay,
+    float delayScale, float maxDelay, float *output, int i, int n) {
+  __m256i lengths = _mm256_set1_epi32(length);
+  __m256i lastIndex = _mm256_set1_epi32(length - 1);
+  __m256i one = _mm256_set1_epi32(1);
+  __m256i two = _mm256_set1_epi32(2);
+  __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  for (; i <= n - 8; i += 8) {
+    __m256 samples = _mm256_mul_ps(_mm256_loadu_ps(delay + i), _mm256_set1_ps(delayScale));
+    samples = _mm256_max_ps(_mm256_min_ps(samples, _mm256_set1_ps(maxDelay)), _mm256_set1_ps(MIN_DELAY));
+    __m256i wholeSamples = _mm256_cvttps_epi32(samples);
+    __m256 frac = _mm256_sub_ps(samples, _mm256_cvtepi32_ps(wholeSamples));
+    __m256i x = _mm256_sub_epi32(_mm256_add_epi32(_mm256_set1_epi32(position + i), lanes), wholeSamples);
+    x = wrapAvx2(x, lengths, lastIndex);
+    __m256 a = _mm256_i32gather_ps(buffer, wrapAvx2(_mm256_add_epi32(x, one), lengths, lastIndex), 4);
+    __m256 b = _mm256_i32gather_ps(buffer, x, 4);
+    __m256 c = _mm256_i32gather_ps(buffer, wrapAvx2(_mm256_sub_epi32(x, one), lengths, lastIndex), 4);
+    __m256 d = _mm256_i32gather_ps(buffer, wrapAvx2(_mm256_sub_epi32(x, two), lengths, lastIndex), 4);
+    _mm256_storeu_ps(output + i, interpolateAvx2(a, b, c, d, frac));
+  }
+  return i;
+}
+#endif // ARRAY_ARITHMETIC_DISPATCH
+
+#pragma mark - Read
+
+void Interpolator::readClipped(float *table, int length, float *index, float offset, float *output, int n) {
+  if (table == NULL || length < 4) {
+    memset(output, 0, n * sizeof(float));
+    return;
+  }
+  
+  // the position is clipped in float, such that large and invalid values are clipped as well
+  float minPosition = 1.0f;
+  float maxPosition = (float) (length - 2);
+  int maxIndex = length - 3; // the last index at which all four samples are in the table
+  int i = 0;
+  #if ARRAY_ARITHMETIC_DISPATCH
+  if (isGatherSupported()) i = readClippedAvx2(table, length, index, offset, output, i, n);
+  #endif
+  #if INTERPOLATOR_SIMD
+  for (; i <= n - 4; i += 4) {
+    v4sf f = vmin(vmax(vadd(vloadu(index + i), vset1(offset)), vset1(minPosition)), vset1(maxPosition));
+    v4si x = vtruncate(f);
+    x = vsubi(x, vandi(vgreateri(x, vset1i(maxIndex)), vset1i(1)));
+    v4sf frac = vsub(f, vfloat(x));
+    // without a gather instruction, the four samples around each index are loaded together
+    int j[4];
+    vstoreui(j, x);
+    v4sf a, b, c, d;
+    vloadtransposed(table + j[0] - 1, table + j[1] - 1, table + j[2] - 1, table + j[3] - 1, &a, &b, &c, &d);
+    vstoreu(output + i, vinterpolate(a, b, c, d, frac));
+  }
+  #endif
+  for (; i < n; i++) {
+    float f = index[i] + offset;
+    f = (f > minPosition) ? f : minPosition;
+    f = (f < maxPosition) ? f : maxPosition;
+    int x = (int) f;
+    x -= (x > maxIndex) ? 1 : 0; // at maxPosition, the fraction is 1
+    float frac = f - (float) x;
+    output[i] = interpolate(table[x-1], table[x], table[x+1], table[x+2], frac);
+  }
+}
+
+void Interpolator::readDelayed(float *buffer, int length, int position, float *delay, float delayScale,
+    float maxDelay, float *output, int n) {
+  if (buffer == NULL || length < 4) {
+    memset(output, 0, n * sizeof(float));
+    return;
+  }
+  
+  // The delay is clipped in float, such that large and invalid values are clipped as well. Sample b
+  // lies the whole number of samples of the delay behind the position, and a is the sample after it.
+  int i = 0;
+  #if ARRAY_ARITHMETIC_DISPATCH
+  if (isGatherSupported()) {
+    i = readDelayedAvx2(buffer, length, position, delay, delayScale, maxDelay, output, i, n);
+  }
+  #endif
+  #if INTERPOLATOR_SIMD
+  v4si lengths = vset1i(length);
+  v4si lastIndex = vset1i(length - 1);
+  for (; i <= n - 4; i += 4) {
+    v4sf samples = vmul(vloadu(delay + i), vset1(delayScale));
+    samples = vmax(vmin(samples, vset1(maxDelay)), vset1(MIN_DELAY));
+    v4si wholeSamples = vtruncate(samples);
+    v4sf frac = vsub(samples, vfloat(wholeSamples));
+    v4si x = vwrap(vsubi(vrampi(position + i), wholeSamples), lengths, lastIndex);
+    v4sf a, b, c, d;
+    if (!vanyi(vori(vgreateri(vset1i(2), x), vgreateri(x, vset1i(length - 2))))) {
+      // none of the four samples around any index wrap, so they are loaded together
+      int j[4];
+      vstoreui(j, x);
+      vloadtransposed(buffer + j[0] - 2, buffer + j[1] - 2, buffer + j[2] - 2, buffer + j[3] - 2,
+          &d, &c, &b, &a);
+    } else {
+      a = vgather(buffer, vwrap(vaddi(x, vset1i(1)), lengths, lastIndex));
+      b = vgather(buffer, x);
+      c = vgather(buffer, vwrap(vsubi(x, vset1i(1)), lengths, lastIndex));
+      d = vgather(buffer, vwrap(vsubi(x, vset1i(2)), lengths, lastIndex));
+    }
+    vstoreu(output + i, vinterpolate(a, b, c, d, frac));
+  }
+  #endif
+  for (; i < n; i++) {
+    float samples = delay[i] * delayScale;
+    samples = (samples < maxDelay) ? samples : maxDelay;
+    samples = (samples > MIN_DELAY) ? samples : MIN_DELAY;
+    int wholeSamples = (int) samples;
+    float frac = samples - (float) wholeSamples;
+    int x = wrap(position + i - wholeSamples, length);
+    output[i] = interpolate(buffer[wrap(x+1, length)], buffer[x], buffer[wrap(x-1, length)],
+        buffer[wrap(x-2, length)], frac);
+  }
+}
@@ -0,0 +1,59 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _INTERPOLATOR_H_
+#define _INTERPOLATOR_H_
+
+/**
+ * The 4-point interpolating reads shared by [tabread4~] and [vd~]. Both use the interpolation of
+ * Pd, which is cubic and passes through the two samples on either side of the position.
+ *
+ * Indices are clipped or wrapped with vector masks, such that there are no branches per sample.
+ * Four samples are processed at a time with SSE2 or NEON, which have no gather instruction. The
+ * four samples around each index are then loaded together and transposed, except where they wrap
+ * around the delay line. On x86 processors with AVX2, eight samples are processed at a time, and
+ * the table is read with gather instructions. All paths finish with a scalar tail, and all compute
+ * exactly the same values. Buffers need not be aligned, and the input buffer may be the same as
+ * the output buffer.
+ */
+class Interpolator {
+
+  public:
+    /**
+     * Reads the table at each index plus the offset, as Pd's [tabread4~]. Indices are clipped to
+     * <code>[1, length-2]</code>, such that the four samples around each index are in the table.
+     * Tables of fewer than four samples read as zero.
+     */
+    static void readClipped(float *table, int length, float *index, float offset, float *output, int n);
+
+    /**
+     * Reads the circular buffer of a delay line, as Pd's [vd~]. Sample <code>i</code> is read at
+     * <code>position + i</code> less its delay, which is <code>delay[i] * delayScale</code> samples
+     * clipped to <code>[1, maxDelay]</code>. The position must lie in <code>[-length, length)</code>
+     * and <code>maxDelay</code> must be less than <code>length - 2</code>, such that every sample
+     * which is read lies at most one buffer length outside of the buffer.
+     */
+    static void readDelayed(float *buffer, int length, int position, float *delay, float delayScale,
+        float maxDelay, float *output, int n);
+};
+
+#endif // _INTERPOLATOR_H_
@@ -0,0 +1,50 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MessageBlock.h"
+#include "PdGraph.h"
+
+MessageObject *MessageBlock::newObject(PdMessage *initMessage, PdGraph *graph) {
+  return new MessageBlock(initMessage, graph);
+}
+
+MessageBlock::MessageBlock(PdMessage *initMessage, PdGraph *graph) : MessageObject(1, 0, graph) {
+  if (initMessage->isFloat(0)) setBlockSizeWithMessage(graph, initMessage, 0);
+}
+
+MessageBlock::~MessageBlock() {
+  // nothing to do
+}
+
+void MessageBlock::setBlockSizeWithMessage(PdGraph *graph, PdMessage *message, int offset) {
+  // missing parameters default to the block size of the parent, no overlap and no resampling
+  int blockSize = message->isFloat(offset) ? (int) message->getFloat(offset) : 0;
+  int overlap = message->isFloat(offset+1) ? (int) message->getFloat(offset+1) : 1;
+  float resampleFactor = message->isFloat(offset+2) ? message->getFloat(offset+2) : 1.0f;
+  graph->setBlockSize(blockSize, overlap, resampleFactor);
+}
+
+void MessageBlock::processMessage(int inletIndex, PdMessage *message) {
+  if (message->isSymbol(0, SYMBOL_SET)) {
+    setBlockSizeWithMessage(graph, message, 1);
+  }
+}
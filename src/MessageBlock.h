@@ -0,0 +1,61 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _MESSAGE_BLOCK_H_
+#define _MESSAGE_BLOCK_H_
+
+#include "MessageObject.h"
+
+/**
+ * [block~]
+ * Sets the block size, overlap and up/down sampling factor of its graph, such as
+ * <code>[block~ 1024 4 1]</code>. The arguments of the object are already applied by the
+ * <code>PdFileParser</code> when the graph is created, such that the objects of the graph are
+ * created with the correct block size. A <code>set</code> message can change the overlap, but not
+ * the block size or resampling factor of a graph which contains signal objects.
+ */
+class MessageBlock : public MessageObject {
+  
+  public:
+    static MessageObject *newObject(PdMessage *initMessage, PdGraph *graph);
+    MessageBlock(PdMessage *initMessage, PdGraph *graph);
+    virtual ~MessageBlock();
+  
+    static const char *getObjectLabel();
+    std::string toString();
+  
+    /** Reblocks the graph with the block size, overlap and resampling factor in the given message. */
+    static void setBlockSizeWithMessage(PdGraph *graph, PdMessage *message, int offset);
+  
+  protected:
+    void processMessage(int inletIndex, PdMessage *message);
+};
+
+inline const char *MessageBlock::getObjectLabel() {
+  return "block~";
+}
+
+inline std::string MessageBlock::toString() {
+  return MessageBlock::getObjectLabel();
+}
+
+#endif // _MESSAGE_BLOCK_H_
@@ -55,7 +55,7 @@ void MessageChange::processMessage(int inletIndex, PdMessage *message) {
       break;
     }
     case SYMBOL: {
-      if (message->isSymbol(0, "set") && message->isFloat(1)) {
+      if (message->isSymbol(0, SYMBOL_SET) && message->isFloat(1)) {
         prevValue = message->getFloat(1);
       }
       break;
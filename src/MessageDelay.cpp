@@ -48,7 +48,7 @@ void MessageDelay::processMessage(int inletIndex, PdMessage *message) {
     case 0: {
       switch (message->getType(0)) {
         case SYMBOL: {
-          if (message->isSymbol(0, "stop")) {
+          if (message->isSymbol(0, SYMBOL_STOP)) {
             cancelScheduledMessageIfExists();
             break;
           }
@@ -58,7 +58,7 @@ void MessageLine::processMessage(int inletIndex, PdMessage *message) {
             PdMessage *outgoingMessage = PD_MESSAGE_ON_STACK(1);
             outgoingMessage->initWithTimestampAndFloat(message->getTimestamp(), currentValue);
             sendMessage(0, outgoingMessage);
-          } else if (message->isSymbol(0, "stop")) {
+          } else if (message->isSymbol(0, SYMBOL_STOP)) {
             cancelPendingMessage();
           }
           break;
@@ -86,7 +86,7 @@ void MessageLine::processMessage(int inletIndex, PdMessage *message) {
               outgoingMessage->initWithTimestampAndFloat(message->getTimestamp(), currentValue);
               sendMessage(0, outgoingMessage);
             }
-          } else if (message->isSymbol(0, "set") && message->isFloat(1)) {
+          } else if (message->isSymbol(0, SYMBOL_SET) && message->isFloat(1)) {
             cancelPendingMessage();
             
             // set the current value to the given input, without outputting any message
@@ -29,26 +29,26 @@
 // MessageListAppend is the default factor for all list objects
 MessageObject *MessageListAppend::newObject(PdMessage *initMessage, PdGraph *graph) {
   if (initMessage->isSymbol(0)) {
-    if (initMessage->isSymbol(0, "append") ||
-        initMessage->isSymbol(0, "prepend") ||
-        initMessage->isSymbol(0, "split")) {
+    if (initMessage->isSymbol(0, SYMBOL_APPEND) ||
+        initMessage->isSymbol(0, SYMBOL_PREPEND) ||
+        initMessage->isSymbol(0, SYMBOL_SPLIT)) {
       int numElements = initMessage->getNumElements()-1;
       PdMessage *message = PD_MESSAGE_ON_STACK(numElements);
       message->initWithTimestampAndNumElements(0.0, numElements);
       memcpy(message->getElement(0), initMessage->getElement(1), numElements*sizeof(MessageAtom));
       MessageObject *messageObject = NULL;
-      if (initMessage->isSymbol(0, "append")) {
+      if (initMessage->isSymbol(0, SYMBOL_APPEND)) {
         messageObject = new MessageListAppend(message, graph);
-      } else if (initMessage->isSymbol(0, "prepend")) {
+      } else if (initMessage->isSymbol(0, SYMBOL_PREPEND)) {
         messageObject = new MessageListPrepend(message, graph);
-      } else if (initMessage->isSymbol(0, "split")) {
+      } else if (initMessage->isSymbol(0, SYMBOL_SPLIT)) {
         messageObject = new MessageListSplit(message, graph);
       }
       return messageObject;
-    } else if (initMessage->isSymbol(0, "trim")) {
+    } else if (initMessage->isSymbol(0, SYMBOL_TRIM)) {
       // trim and length do not act on the initMessage
       return new MessageListTrim(initMessage, graph);
-    } else if (initMessage->isSymbol(0, "length")) {
+    } else if (initMessage->isSymbol(0, SYMBOL_LENGTH)) {
       return new MessageListLength(initMessage, graph);
     } else {
       return new MessageListAppend(initMessage, graph);
@@ -46,7 +46,7 @@ void MessageMakefilename::processMessage(int inletIndex, PdMessage *message) {
         break;
       }
       case SYMBOL: {
-        if (message->isSymbol(0, "set") && message->isSymbol(1)) {
+        if (message->isSymbol(0, SYMBOL_SET) && message->isSymbol(1)) {
           free(format);
           format = StaticUtils::copyString(message->getSymbol(1));
         } else {
@@ -109,7 +109,8 @@ void MessageMessageBox::processMessage(int inletIndex, PdMessage *message) {
     outgoingMessage->initWithTimestampAndNumElements(message->getTimestamp(), numElements);
     memcpy(outgoingMessage->getElement(0), messageTemplate->getElement(0), numElements*sizeof(MessageAtom));
     for (int i = 0; i < numElements; i++) {
-      if (messageTemplate->isSymbol(i)) {
+      // only symbols with arguments need to be resolved. All others are already interned in the template.
+      if (messageTemplate->isSymbol(i) && strstr(messageTemplate->getSymbol(i), "\\$") != NULL) {
         char *buffer = (char *) alloca(RES_BUFFER_LENGTH * sizeof(char));
         // TODO(mhroth): resolve string, but may be in stack buffer
         PdMessage::resolveString(messageTemplate->getSymbol(i), message, 1, buffer, RES_BUFFER_LENGTH);
@@ -130,7 +131,8 @@ void MessageMessageBox::processMessage(int inletIndex, PdMessage *message) {
     outgoingMessage->initWithTimestampAndNumElements(message->getTimestamp(), numElements);
     memcpy(outgoingMessage->getElement(0), messageTemplate->getElement(0), numElements*sizeof(MessageAtom));
     for (int i = 0; i < numElements; i++) {
-      if (messageTemplate->isSymbol(i)) {
+      // only symbols with arguments need to be resolved. All others are already interned in the template.
+      if (messageTemplate->isSymbol(i) && strstr(messageTemplate->getSymbol(i), "\\$") != NULL) {
         char *buffer = (char *) alloca(RES_BUFFER_LENGTH * sizeof(char));
         // TODO(mhroth): resolve string, but may be in stack buffer
         PdMessage::resolveString(messageTemplate->getSymbol(i), message, 1, buffer, RES_BUFFER_LENGTH);
@@ -53,7 +53,7 @@ void MessageMetro::processMessage(int inletIndex, PdMessage *message) {
           break;
         }
         case SYMBOL: {
-          if (message->isSymbol(0, "stop")) {
+          if (message->isSymbol(0, SYMBOL_STOP)) {
             stopMetro();
           }
           break;
@@ -66,7 +66,7 @@ void MessageObject::receiveMessage(int inletIndex, PdMessage *message) {
           break;
         }
         case SYMBOL: {
-          distributedMessage->initWithTimestampAndSymbol(message->getTimestamp(), message->getSymbol(i));
+          distributedMessage->initWithTimestampAndAtom(message->getTimestamp(), message->getElement(i));
           break;
         }
         case BANG: {
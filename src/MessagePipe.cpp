@@ -50,19 +50,26 @@ void MessagePipe::processMessage(int inletIndex, PdMessage *message) {
     case 0: {
       switch (message->getType(0)) {
         case SYMBOL: {
-          if (message->isSymbol(0, "flush")) {
+          if (message->isSymbol(0, SYMBOL_FLUSH)) {
             // cancel all scheduled messages and send them immediately
             for(list<PdMessage *>::iterator it = scheduledMessagesList.begin();
                 it != scheduledMessagesList.end(); it++) {
               // send the message using the super class's sendMessage because otherwise the
               // list will be changed while iterating over it. Leads to badness.
-              (*it)->setTimestamp(message->getTimestamp());
-              MessageObject::sendMessage(0, *it);
+              // The scheduled message is sent as a retimed copy, as changing the timestamp of a
+              // message which is still in the message queue would corrupt the queue's ordering.
+              PdMessage *scheduledMessage = *it;
+              int numElements = scheduledMessage->getNumElements();
+              PdMessage *outgoingMessage = PD_MESSAGE_ON_STACK(numElements);
+              outgoingMessage->initWithTimestampAndNumElements(message->getTimestamp(), numElements);
+              memcpy(outgoingMessage->getElement(0), scheduledMessage->getElement(0),
+                  numElements * sizeof(MessageAtom));
+              MessageObject::sendMessage(0, outgoingMessage);
               graph->cancelMessage(this, 0, *it); // cancel the scheduled message and free it from memory
             }
             scheduledMessagesList.clear();
             break;
-          } else if (message->isSymbol(0, "clear")) {
+          } else if (message->isSymbol(0, SYMBOL_CLEAR)) {
             // cancel all scheduled messages
             for(list<PdMessage *>::iterator it = scheduledMessagesList.begin();
                 it != scheduledMessagesList.end(); it++) {
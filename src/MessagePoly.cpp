@@ -133,9 +133,9 @@ void MessagePoly::processMessage(int inletIndex, PdMessage *message) {
     case 1:
       if (message->isFloat(0)) {
         velocity = message->getFloat(0);
-      } else if (message->isSymbol(0, "stop")) {
+      } else if (message->isSymbol(0, SYMBOL_STOP)) {
         // TODO: implement stop
-      } else if (message->isSymbol(0, "clear")) {
+      } else if (message->isSymbol(0, SYMBOL_CLEAR)) {
         // TODO: implement clear
       }
       break;
@@ -0,0 +1,121 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MessagePool.h"
+
+/**
+ * The number of blocks reserved for each size class when the pool is created. Across the test
+ * patches, at most eight messages are pooled at once, nearly all of them in the smallest class.
+ */
+static const unsigned int RESERVED_BLOCKS[MESSAGE_POOL_NUM_SIZE_CLASSES] = {256, 32, 8, 4, 4};
+
+MessagePool::MessagePool() {
+  numHits.store(0, memory_order_relaxed);
+  numMisses.store(0, memory_order_relaxed);
+  numBlocksInUse.store(0, memory_order_relaxed);
+  releasedList.store(NULL);
+  
+  // pre-reserve all size classes
+  for (unsigned int i = 0; i < MESSAGE_POOL_NUM_SIZE_CLASSES; i++) {
+    freeLists[i] = NULL;
+    numBlocks[i] = 0;
+    growSizeClass(i, RESERVED_BLOCKS[i]);
+  }
+}
+
+MessagePool::~MessagePool() {
+  for (vector<void *>::iterator it = allocations.begin(); it != allocations.end(); ++it) {
+    free(*it);
+  }
+}
+
+unsigned int MessagePool::getSizeClass(unsigned int numBytes) {
+  numBytes += sizeof(BlockHeader);
+  unsigned int sizeClass = 0;
+  while (sizeClass < MESSAGE_POOL_NUM_SIZE_CLASSES && numBytes > getBlockSize(sizeClass)) {
+    sizeClass++;
+  }
+  return sizeClass; // == MESSAGE_POOL_NUM_SIZE_CLASSES if the block is too large for the pool
+}
+
+void MessagePool::growSizeClass(unsigned int sizeClass, unsigned int numNewBlocks) {
+  unsigned int blockSize = getBlockSize(sizeClass);
+  char *slab = (char *) malloc(numNewBlocks * blockSize);
+  allocations.push_back(slab);
+  for (unsigned int i = 0; i < numNewBlocks; i++) {
+    BlockHeader *header = (BlockHeader *) (slab + i*blockSize);
+    header->sizeClass = sizeClass;
+    pushBlock(&freeLists[sizeClass], header);
+  }
+  numBlocks[sizeClass] += numNewBlocks;
+}
+
+void MessagePool::reclaimReleasedBlocks() {
+  BlockHeader *header = releasedList.exchange(NULL, memory_order_acquire);
+  while (header != NULL) {
+    BlockHeader *next = *((BlockHeader **) (header + 1));
+    pushBlock(&freeLists[header->sizeClass], header);
+    header = next;
+  }
+}
+
+void *MessagePool::allocate(unsigned int numBytes) {
+  BlockHeader *header = NULL;
+  unsigned int sizeClass = getSizeClass(numBytes);
+  if (sizeClass == MESSAGE_POOL_NUM_SIZE_CLASSES) {
+    // the block is too large to be pooled
+    header = (BlockHeader *) malloc(sizeof(BlockHeader) + numBytes);
+    numMisses.store(numMisses.load(memory_order_relaxed) + 1, memory_order_relaxed);
+  } else {
+    // released blocks are only taken over once the size class' own free list is exhausted
+    if (freeLists[sizeClass] == NULL) reclaimReleasedBlocks();
+    if (freeLists[sizeClass] == NULL) {
+      // the size class is exhausted and is doubled
+      growSizeClass(sizeClass, numBlocks[sizeClass]);
+      numMisses.store(numMisses.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    } else {
+      numHits.store(numHits.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    }
+    header = (BlockHeader *) freeLists[sizeClass];
+    freeLists[sizeClass] = *((void **) (header + 1));
+  }
+  header->sizeClass = sizeClass;
+  numBlocksInUse.fetch_add(1, memory_order_relaxed);
+  return header + 1;
+}
+
+void MessagePool::release(void *block) {
+  BlockHeader *header = ((BlockHeader *) block) - 1;
+  numBlocksInUse.fetch_sub(1, memory_order_relaxed);
+  if (header->sizeClass == MESSAGE_POOL_NUM_SIZE_CLASSES) {
+    free(header);
+    return;
+  }
+  
+  // the list is only ever pushed to concurrently, and is emptied in one exchange, so a
+  // compare-and-swap suffices
+  BlockHeader *head = releasedList.load(memory_order_relaxed);
+  do {
+    *((void **) (header + 1)) = head;
+  } while (!releasedList.compare_exchange_weak(head, header,
+      memory_order_release, memory_order_relaxed));
+}
@@ -0,0 +1,132 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _MESSAGE_POOL_H_
+#define _MESSAGE_POOL_H_
+
+#include <atomic>
+#include <vector>
+#include "PdMessage.h"
+using namespace std;
+
+/** The number of block size classes in a <code>MessagePool</code>. */
+#define MESSAGE_POOL_NUM_SIZE_CLASSES 5
+
+/** The size in bytes of the smallest block size class. Each following class is twice as large. */
+#define MESSAGE_POOL_MIN_BLOCK_SIZE 64
+
+/**
+ * The <code>MessagePool</code> is a size-class allocator for messages which are copied while the
+ * context is processed, such as scheduled messages or those queued at the inlets of
+ * <code>DspObject</code>s. Each <code>PdContext</code> owns one pool.
+ *
+ * Blocks are only allocated by the thread which processes the context (or otherwise holds the
+ * context lock), but they may be released from any thread, e.g. by <code>DspObject</code>s which
+ * consume their messages on the worker threads of parallel DSP. Neither path takes a lock. Released
+ * blocks are pushed to a lock-free list, which the allocating thread takes over in one exchange once
+ * a size class' own free list is exhausted.
+ *
+ * Every size class is pre-reserved when the pool is created, so that no memory need be allocated
+ * from the system in the audio callback in the nominal case. The reserve is weighted towards the
+ * smallest class, which holds nearly all messages in practice. If a size class is exhausted, it is
+ * grown by as many blocks as it already holds, such that the pool reaches the high-water mark of its
+ * use with a logarithmic number of allocations from the system. Each such allocation is counted as a
+ * miss. Requests larger than the largest size class are always served (and released) directly by
+ * the system, and are also counted as misses.
+ */
+class MessagePool {
+  
+  public:
+    MessagePool();
+    ~MessagePool();
+  
+    /** Returns a block of memory of at least the given size. */
+    void *allocate(unsigned int numBytes);
+  
+    /** Returns a block previously acquired with <code>allocate()</code> to the pool. */
+    void release(void *block);
+  
+    /** Copies the message into a new block from the pool. */
+    PdMessage *copyMessage(PdMessage *message) {
+      return message->copyTo(allocate(message->numBytes()));
+    }
+  
+    /** Releases a message copied with <code>copyMessage()</code>. */
+    void freeMessage(PdMessage *message) { release(message); }
+  
+    /** Returns the number of allocations which were served from a pre-existing block. */
+    unsigned int getNumHits() { return numHits.load(memory_order_relaxed); }
+  
+    /** Returns the number of allocations for which memory had to be requested from the system. */
+    unsigned int getNumMisses() { return numMisses.load(memory_order_relaxed); }
+  
+    /** Returns the number of blocks which are currently allocated. */
+    unsigned int getNumBlocksInUse() { return numBlocksInUse.load(memory_order_relaxed); }
+  
+  private:
+    /**
+     * The header preceding each block. It records the size class from which the block was taken,
+     * and is padded such that the remainder of the block remains 8-byte aligned.
+     */
+    typedef union BlockHeader {
+      unsigned int sizeClass;
+      double alignment;
+    } BlockHeader;
+  
+    /** Returns the index of the smallest size class which can hold the given number of bytes. */
+    static unsigned int getSizeClass(unsigned int numBytes);
+  
+    static inline unsigned int getBlockSize(unsigned int sizeClass) {
+      return MESSAGE_POOL_MIN_BLOCK_SIZE << sizeClass;
+    }
+  
+    /** Returns all blocks released since the last call to the free lists of their size classes. */
+    void reclaimReleasedBlocks();
+  
+    /** Adds the given number of new blocks to a size class. */
+    void growSizeClass(unsigned int sizeClass, unsigned int numBlocks);
+  
+    /** Adds a block to the given size class' free list. */
+    static inline void pushBlock(void **freeList, BlockHeader *header) {
+      *((void **) (header + 1)) = *freeList;
+      *freeList = header;
+    }
+  
+    /** The heads of the free lists of each size class. Links are stored in the free blocks. */
+    void *freeLists[MESSAGE_POOL_NUM_SIZE_CLASSES];
+  
+    /** The number of blocks held by each size class, whether free or in use. */
+    unsigned int numBlocks[MESSAGE_POOL_NUM_SIZE_CLASSES];
+  
+    /** The head of the list of released blocks, pushed to from any thread. */
+    atomic<BlockHeader *> releasedList;
+  
+    /** All memory acquired by the pool for size-classed blocks, to be freed on destruction. */
+    vector<void *> allocations;
+  
+    // read from any thread. The hits and misses are only written by the allocating thread.
+    atomic<unsigned int> numHits;
+    atomic<unsigned int> numMisses;
+    atomic<unsigned int> numBlocksInUse;
+};
+
+#endif // _MESSAGE_POOL_H_
@@ -29,7 +29,7 @@ MessageObject *MessagePrint::newObject(PdMessage *initMessage, PdGraph *graph) {
 
 MessagePrint::MessagePrint(PdMessage *initMessage, PdGraph *graph) : MessageObject(1, 0, graph) {
   if (initMessage->isSymbol(0)) {
-    name = initMessage->isSymbol(0, "-n") ? NULL : StaticUtils::copyString(initMessage->getSymbol(0));
+    name = initMessage->isSymbol(0, SYMBOL_FLAG_N) ? NULL : StaticUtils::copyString(initMessage->getSymbol(0));
   } else {
     name = StaticUtils::copyString((char *) "print");
   }
@@ -21,6 +21,8 @@
  */
 
 #include "MessageRandom.h"
+#include "PdContext.h"
+#include "PdGraph.h"
 
 MessageObject *MessageRandom::newObject(PdMessage *initMessage, PdGraph *graph) {
   return new MessageRandom(initMessage, graph);
@@ -28,7 +30,7 @@ MessageObject *MessageRandom::newObject(PdMessage *initMessage, PdGraph *graph)
 
 MessageRandom::MessageRandom(PdMessage *initMessage, PdGraph *graph) : MessageObject(2, 1, graph) {
   max_inc = initMessage->isFloat(0) ? ((int) initMessage->getFloat(0))-1 : 1;
-  twister = new MTRand();
+  twister = new MTRand(graph->getContext()->getNextRandomSeed());
 }
 
 MessageRandom::~MessageRandom() {
@@ -40,7 +42,7 @@ void MessageRandom::processMessage(int inletIndex, PdMessage *message) {
     case 0: {
       switch (message->getType(0)) {
         case SYMBOL: {
-          if (message->isSymbol(0, "seed") && message->isFloat(1)) {
+          if (message->isSymbol(0, SYMBOL_SEED) && message->isFloat(1)) {
             twister->seed((int) message->getFloat(1)); // reset the seed
           }
           break;
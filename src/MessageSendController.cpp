@@ -20,17 +20,16 @@
  *
  */
 
+#include <algorithm>
 #include "MessageSendController.h"
 #include "PdContext.h"
+#include "SymbolTable.h"
 
 // a special index for referencing the system "pd" receiver
 #define SYSTEM_NAME_INDEX 0x7FFFFFFF
 
-// it might nice if this class were implemented using a hashtable with receiver name as the key
-// and Lists as the value.
 MessageSendController::MessageSendController(PdContext *aContext) : MessageObject(0, 0, NULL) {
   context = aContext;
-  sendStack = vector<std::pair<string, set<RemoteMessageReceiver *> > >();
 }
 
 MessageSendController::~MessageSendController() {
@@ -46,23 +45,27 @@ int MessageSendController::getNameIndex(const char *receiverName) {
     return SYSTEM_NAME_INDEX; // a special case for sending messages to the system
   }
   
-  for (int i = 0; i < sendStack.size(); i++) {
-    string str = sendStack[i].first;
-    if (!str.compare(receiverName)) return i;
-  }  
-  return -1;
+  // a name which has never been interned has never been registered
+  return getSymbolIndex(SymbolTable::find(receiverName));
+}
+
+int MessageSendController::getSymbolIndex(const char *symbol) {
+  if (symbol == NULL) return -1;
+  unordered_map<const char *, int>::iterator it = nameIndexMap.find(symbol);
+  return (it == nameIndexMap.end()) ? -1 : it->second;
 }
 
 void MessageSendController::receiveMessage(const char *name, PdMessage *message) {
-  int index = getNameIndex(name);
+  // a name which has never been interned has neither internal nor external receivers
+  const char *symbol = SymbolTable::find(name);
+  int index = !strcmp("pd", name) ? SYSTEM_NAME_INDEX : getSymbolIndex(symbol);
   
   // if the receiver name is not registered, nothing to do
   if (index >= 0) sendMessage(index, message);
   
   // check to see if the receiver name has been registered as an external receiver
-  if (externalReceiverSet.find(string(name)) != externalReceiverSet.end()) {
-    std::pair<const char *, PdMessage *> pair = make_pair(name, message);
-    context->callbackFunction(ZG_RECEIVER_MESSAGE, context->callbackUserData, &pair);
+  if (symbol != NULL && externalReceiverSet.find(symbol) != externalReceiverSet.end()) {
+    context->sendMessageToExternalReceiver(name, message);
   }
 }
 
@@ -70,11 +73,17 @@ void MessageSendController::sendMessage(int outletIndex, PdMessage *message) {
   if (outletIndex == SYSTEM_NAME_INDEX) {
     context->receiveSystemMessage(message);
   } else {
-    set<RemoteMessageReceiver *> receiverSet = sendStack[outletIndex].second;
-    for (set<RemoteMessageReceiver *>::iterator it = receiverSet.begin(); it != receiverSet.end(); ++it) {
-      RemoteMessageReceiver *receiver = *it;
-      receiver->receiveMessage(0, message);
+    // the receiver list is indexed anew on each iteration, as a receiver may register or unregister
+    // receivers in response to the message, possibly reallocating the list
+    Delivery delivery;
+    delivery.nameIndex = outletIndex;
+    delivery.numReceivers = sendStack[outletIndex].size();
+    deliveries.push_back(&delivery);
+    for (delivery.receiverIndex = 0; delivery.receiverIndex < delivery.numReceivers;
+        delivery.receiverIndex++) {
+      sendStack[outletIndex][delivery.receiverIndex]->receiveMessage(0, message);
     }
+    deliveries.pop_back();
   }
 }
 
@@ -86,37 +95,51 @@ void MessageSendController::addReceiver(RemoteMessageReceiver *receiver) {
   }
 
   if (nameIndex == -1) {
-    set<RemoteMessageReceiver *> remoteSet = set<RemoteMessageReceiver *>();
-    remoteSet.insert(receiver);
-    std::pair<string, set<RemoteMessageReceiver *> > nameSetPair =
-        make_pair(string(receiver->getName()), remoteSet);
-    sendStack.push_back(nameSetPair);
-    nameIndex = sendStack.size()-1;
+    nameIndex = sendStack.size();
+    nameIndexMap[SymbolTable::intern(receiver->getName())] = nameIndex;
+    sendStack.push_back(vector<RemoteMessageReceiver *>());
   }
   
-  set<RemoteMessageReceiver *> *receiverSet = &(sendStack[nameIndex].second);
-  receiverSet->insert(receiver);
+  // a receiver is only registered once
+  vector<RemoteMessageReceiver *> *receiverList = &(sendStack[nameIndex]);
+  if (find(receiverList->begin(), receiverList->end(), receiver) == receiverList->end()) {
+    receiverList->push_back(receiver);
+  }
 }
 
 void MessageSendController::removeReceiver(RemoteMessageReceiver *receiver) {
   int nameIndex = getNameIndex(receiver->getName());
-  if (nameIndex != -1) {
-    set<RemoteMessageReceiver *> *receiverSet = &(sendStack[nameIndex].second);
-    receiverSet->erase(receiver);
+  if (nameIndex != -1 && nameIndex != SYSTEM_NAME_INDEX) {
+    vector<RemoteMessageReceiver *> *receiverList = &(sendStack[nameIndex]);
+    vector<RemoteMessageReceiver *>::iterator it = find(receiverList->begin(), receiverList->end(), receiver);
+    if (it != receiverList->end()) {
+      // move the messages being sent to this name along with the remaining receivers, such that
+      // none is skipped
+      int position = it - receiverList->begin();
+      for (int i = 0; i < deliveries.size(); i++) {
+        Delivery *delivery = deliveries[i];
+        if (delivery->nameIndex == nameIndex && position < delivery->numReceivers) {
+          if (position <= delivery->receiverIndex) delivery->receiverIndex--;
+          delivery->numReceivers--;
+        }
+      }
+      receiverList->erase(it); // preserve the order of the remaining receivers
+    }
     // NOTE(mhroth):
-    // once the receiver set has been created, it should not be erased anymore from the sendStack.
+    // once the receiver list has been created, it should not be erased anymore from the sendStack.
     // PdContext depends on the nameIndex to be constant for all receiver names once they are
     // defined, as a message destined for that receiver may already be in the message queue
     // with the given index. If the indicies change, then message will be sent to the wrong
-    // receiver set. This is a stupid constraint. Fix it.
+    // receiver list.
   }
 }
 
 void MessageSendController::registerExternalReceiver(const char *receiverName) {
   // sets only contain unique items
-  externalReceiverSet.insert(string(receiverName));
+  externalReceiverSet.insert(SymbolTable::intern(receiverName));
 }
 
 void MessageSendController::unregisterExternalReceiver(const char *receiverName) {
-  externalReceiverSet.erase(string(receiverName));
+  const char *symbol = SymbolTable::find(receiverName);
+  if (symbol != NULL) externalReceiverSet.erase(symbol);
 }
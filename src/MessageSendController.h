@@ -23,8 +23,10 @@
 #ifndef _MESSAGE_SEND_CONTROLLER_H_
 #define _MESSAGE_SEND_CONTROLLER_H_
 
-#include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "MessageObject.h"
 #include "RemoteMessageReceiver.h"
 
@@ -45,6 +47,10 @@ class PdContext;
  * Alternatively, a message can be sent to receivers using <code>receiveMessage()</code> with
  * name and message arguments (instead of inlet index and message). Messages sent using this
  * alternative will be sent right away (avoiding the message queue).
+ *
+ * Receiver names are resolved to indices with a hash map keyed on the interned name (see
+ * <code>SymbolTable</code>), such that a name is looked up without copying it. Once a name has been
+ * assigned an index, the index never changes, even if all receivers by that name are removed.
  */
 class MessageSendController : public MessageObject {
   
@@ -64,8 +70,8 @@ class MessageSendController : public MessageObject {
     bool receiverExists(const char *receiverName);
   
     /**
-     * Returns the index to which the given receiver name is referenced.
-     * Used with <code>receiveMessage(int, PdMessage *)</code>.
+     * Returns the index to which the given receiver name is referenced, or -1 if no receiver by that
+     * name has ever been registered. Used with <code>receiveMessage(int, PdMessage *)</code>.
      */
     int getNameIndex(const char *name);
   
@@ -80,9 +86,35 @@ class MessageSendController : public MessageObject {
   
     PdContext *context;
   
-    vector<std::pair<string, set<RemoteMessageReceiver *> > > sendStack;
+    /** Returns the index of the given interned receiver name, or -1 if it has none. */
+    int getSymbolIndex(const char *symbol);
+  
+    /** Maps each interned receiver name to its index in the <code>sendStack</code>. */
+    unordered_map<const char *, int> nameIndexMap;
+  
+    /**
+     * The receivers registered for each name, in the order in which they were added. Receivers are
+     * kept in a flat list such that they can be iterated without copying when a message is sent.
+     */
+    vector<vector<RemoteMessageReceiver *> > sendStack;
+  
+    /**
+     * The position of a message being sent in a receiver list. Receivers are removed from the list
+     * while the message is sent, e.g. by an object which is deleted in response, so the position is
+     * moved along with the remaining receivers. Receivers added while the message is sent do not
+     * receive it.
+     */
+    struct Delivery {
+      int nameIndex;
+      int receiverIndex; // the receiver receiving the message
+      int numReceivers; // the end of the receivers when the message was sent
+    };
+  
+    /** The messages being sent, innermost last. A receiver may send a message to another name. */
+    vector<Delivery *> deliveries;
   
-    set<string> externalReceiverSet;
+    /** The interned names of the external receivers. */
+    unordered_set<const char *> externalReceiverSet;
 };
 
 inline const char *MessageSendController::getObjectLabel() {
@@ -19,128 +19,196 @@
  *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
  *
  */
-
+#include <string.h>
+#include <vector>
+#include "DiskWorker.h"
 #include "MessageSoundfiler.h"
 #include "MessageTable.h"
+#include "PdContext.h"
 #include "PdGraph.h"
 
 #include <sndfile.h>
 
+/** The number of frames which are read from the file at once, before they are deinterleaved. */
+#define READ_CHUNK_FRAMES 4096
+
+/**
+ * Reads a sound file into new buffers for each table on the worker thread, which are swapped with
+ * the buffers of the tables when the task is completed.
+ */
+class SoundfileReadTask : public DiskTask {
+  
+  public:
+    SoundfileReadTask(MessageSoundfiler *soundfiler, char *path, bool shouldResizeTables,
+        double timestamp) {
+      this->soundfiler = soundfiler;
+      this->path = path;
+      this->shouldResizeTables = shouldResizeTables;
+      this->timestamp = timestamp;
+      numFrames = 0;
+      isOpened = false;
+    }
+  
+    ~SoundfileReadTask() {
+      free(path);
+      for (int i = 0; i < buffers.size(); i++) {
+        free(buffers[i]);
+      }
+    }
+  
+    /** Adds a table to be filled with the next channel of the file. */
+    void addTable(char *tableName, int tableLength) {
+      tableNames.push_back(tableName);
+      tableLengths.push_back(tableLength);
+    }
+  
+    void run() {
+      SF_INFO sfInfo;
+      memset(&sfInfo, 0, sizeof(SF_INFO));
+      SNDFILE *sndFile = sf_open(path, SFM_READ, &sfInfo);
+      if (sndFile == NULL || sfInfo.channels <= 0) {
+        if (sndFile != NULL) sf_close(sndFile);
+        return; // there was an error reading the file. Move on with life.
+      }
+      isOpened = true;
+      numFrames = static_cast<int>(sfInfo.frames);
+      
+      // each table receives one channel, and is zeroed beyond the end of the file
+      int numChannels = sfInfo.channels;
+      int numTables = min((int) tableNames.size(), numChannels);
+      vector<int> bufferLengths(numTables);
+      for (int i = 0; i < numTables; i++) {
+        bufferLengths[i] = shouldResizeTables ? numFrames : tableLengths[i];
+        buffers.push_back((float *) calloc(max(bufferLengths[i], 1), sizeof(float)));
+      }
+      
+      // read the file in chunks, such that the whole interleaved file is never held in memory
+      float *chunk = (float *) malloc(READ_CHUNK_FRAMES * numChannels * sizeof(float));
+      int frameIndex = 0;
+      while (frameIndex < numFrames) {
+        int numChunkFrames = (int) sf_readf_float(sndFile, chunk, READ_CHUNK_FRAMES);
+        if (numChunkFrames <= 0) break;
+        for (int i = 0; i < numTables; i++) {
+          float *buffer = buffers[i];
+          int n = min(numChunkFrames, bufferLengths[i] - frameIndex);
+          for (int j = 0; j < n; j++) {
+            buffer[frameIndex+j] = chunk[j*numChannels + i];
+          }
+        }
+        frameIndex += numChunkFrames;
+      }
+      free(chunk);
+      sf_close(sndFile); // release the handle to the file
+    }
+  
+    void complete() {
+      soundfiler->tasks.remove(this);
+      PdGraph *graph = soundfiler->graph;
+      if (!isOpened) {
+        graph->printErr("[soundfiler]: file %s cannot be opened.", path);
+        return;
+      }
+      
+      for (int i = 0; i < buffers.size(); i++) {
+        // the table is looked up again, as it may have been deleted in the meantime
+        MessageTable *table = graph->getTable(tableNames[i]);
+        if (table == NULL) continue;
+        int tableLength = 0;
+        float *tableBuffer = table->getBuffer(&tableLength);
+        if (shouldResizeTables) {
+          // tables are not resized to zero length
+          if (numFrames > 0) buffers[i] = table->setBuffer(buffers[i], numFrames);
+        } else if (tableLength == tableLengths[i]) {
+          buffers[i] = table->setBuffer(buffers[i], tableLength);
+        } else {
+          // the table has been resized since the file was requested. Fill as much of it as possible.
+          memcpy(tableBuffer, buffers[i], min(tableLength, tableLengths[i]) * sizeof(float));
+        }
+      }
+      // the previous buffers of the tables are freed along with the task, on the worker thread
+      
+      // send message with sample length when all tables have been filled
+      PdMessage *outgoingMessage = PD_MESSAGE_ON_STACK(1);
+      outgoingMessage->initWithTimestampAndFloat(
+          max(timestamp, graph->getContext()->getBlockStartTimestamp()), (float) numFrames);
+      soundfiler->sendMessage(0, outgoingMessage);
+    }
+  
+  private:
+    MessageSoundfiler *soundfiler;
+    char *path;
+    bool shouldResizeTables;
+    double timestamp;
+  
+    /** The names (interned) and lengths of the tables when the file was requested. */
+    vector<char *> tableNames;
+    vector<int> tableLengths;
+  
+    /** The channels read for each table. */
+    vector<float *> buffers;
+    int numFrames;
+    bool isOpened;
+};
+
 MessageObject *MessageSoundfiler::newObject(PdMessage *initMessage, PdGraph *graph) {
   return new MessageSoundfiler(initMessage, graph);
 }
 
 MessageSoundfiler::MessageSoundfiler(PdMessage *initMessage, PdGraph *graph) : MessageObject(1, 1, graph) {
-  // TODO(mhroth)
+  diskWorker = graph->getContext()->getDiskWorker();
 }
 
 MessageSoundfiler::~MessageSoundfiler() {
-  // nothing to do
+  // the tables will not be filled after all
+  for (list<DiskTask *>::iterator it = tasks.begin(); it != tasks.end(); ++it) {
+    diskWorker->cancel(*it);
+  }
 }
 
-void MessageSoundfiler::processMessage(int inletIndex, PdMessage *message)
-{
-  if (message->isSymbol(0, "read"))
-  {
+void MessageSoundfiler::processMessage(int inletIndex, PdMessage *message) {
+  if (message->isSymbol(0, SYMBOL_READ)) {
     int currentElementIndex;
     bool shouldResizeTable = false;
-    char *tabName;
-    char *soundfilePath;
-    MessageTable *table;
-    
-    for (currentElementIndex = 1;
-         currentElementIndex < message->getNumElements();
-         ++currentElementIndex)
-    {
-      if (message->isSymbol(currentElementIndex, "-resize"))
+    for (currentElementIndex = 1; currentElementIndex < message->getNumElements(); ++currentElementIndex) {
+      if (message->isSymbol(currentElementIndex, SYMBOL_FLAG_RESIZE)) {
         shouldResizeTable = true;
-      /* else if other flags... */
-      else
+      } else { // else if other flags...
         break;
+      }
     }
-    if (message->getNumElements() - currentElementIndex - 2 < 0)
-    {
+    if (message->getNumElements() - currentElementIndex - 2 < 0 ||
+        !message->isSymbol(currentElementIndex) || !message->isSymbol(currentElementIndex+1)) {
       graph->printErr("[soundfiler]: parameters are incorrect");
       return;
     }
-    soundfilePath = message->getSymbol(currentElementIndex++);
-    tabName = message->getSymbol(currentElementIndex++);
-    if ((table = graph->getTable(tabName)) == NULL)
-    {
+    char *soundfilePath = message->getSymbol(currentElementIndex++);
+    char *tabName = message->getSymbol(currentElementIndex);
+    if (graph->getTable(tabName) == NULL) {
       graph->printErr("[soundfiler]: table '%s' cannot be found", tabName);
       return;
     }
-    SF_INFO sfInfo;
     char *fullPath = graph->resolveFullPath(soundfilePath);
-    if (fullPath == NULL)
-    {
+    if (fullPath == NULL) {
       graph->printErr("[soundfiler]: file '%s' cannot be found.", soundfilePath);
       return;
     }
     
-    SNDFILE *sndFile = sf_open(fullPath, SFM_READ, &sfInfo);
-    if (sndFile == NULL)
-    {
-      graph->printErr("[soundfiler]: file %s cannot be opened.", fullPath);
-      free(fullPath);
-      return; // there was an error reading the file. Move on with life.
-    }
-    delete fullPath;
-    
-    // It is assumed that the channels are interleaved.
-    int samplesPerChannel = static_cast<int>(sfInfo.frames);
-    int bufferLength = samplesPerChannel * sfInfo.channels;
-    // create a buffer in memory for the file data
-    float *buffer = (float *) malloc(bufferLength * sizeof(float));
-    sf_read_float(sndFile, buffer, bufferLength); // read the whole file into memory
-    sf_close(sndFile); // release the handle to the file
-    
-    if (sfInfo.channels > 0) // sanity check
-    {
-      // get the table's buffer. Resize the buffer if necessary.
-      int tableLength = samplesPerChannel;
-      float *tableBuffer = shouldResizeTable ? table->resizeBuffer(samplesPerChannel) :
+    // each following table receives the next channel of the file
+    SoundfileReadTask *task = new SoundfileReadTask(this, fullPath, shouldResizeTable,
+        message->getTimestamp());
+    for (; currentElementIndex < message->getNumElements() && message->isSymbol(currentElementIndex);
+        currentElementIndex++) {
+      tabName = message->getSymbol(currentElementIndex);
+      MessageTable *table = graph->getTable(tabName);
+      if (table == NULL) break;
+      int tableLength = 0;
       table->getBuffer(&tableLength);
-      if (tableLength > samplesPerChannel)
-      {
-        // avoid trying to read more into the table buffer than is available
-        tableLength = samplesPerChannel;
-      }
-      
-      // extract the first channel
-      for (int i = 0, j = 0; i < bufferLength; i+=sfInfo.channels, j++)
-      {
-        tableBuffer[j] = buffer[i];
-      }
-      
-      // extract the second channel (if it exists and if there is a table to write it to)
-      if (sfInfo.channels > 1 &&
-          (tabName = message->getSymbol(currentElementIndex++)) != NULL &&
-          (table = graph->getTable(tabName)) != NULL)
-      {
-        tableLength = samplesPerChannel;
-        tableBuffer = shouldResizeTable ? table->resizeBuffer(samplesPerChannel) :
-        table->getBuffer(&tableLength);
-        if (tableLength > samplesPerChannel)
-        {
-          // avoid trying to read more into the table buffer than is available
-          tableLength = samplesPerChannel;
-        }
-        for (int i = 1, j = 0; i < bufferLength; i+=sfInfo.channels, j++)
-          tableBuffer[j] = buffer[i];
-      }
+      task->addTable(tabName, tableLength);
     }
-    delete buffer;
-    
-    // send message with sample length when all tables have been filled
-    PdMessage *outgoingMessage = PD_MESSAGE_ON_STACK(1);
-    outgoingMessage->initWithTimestampAndFloat(message->getTimestamp(), samplesPerChannel);
-    sendMessage(0, outgoingMessage);
-  }
-  else if (message->isSymbol(0, "write"))
-  {
+    tasks.push_back(task);
+    diskWorker->submit(task);
+  } else if (message->isSymbol(0, SYMBOL_WRITE)) {
     //Not implemented yet
     graph->printErr("[soundfiler]: The 'write' command is not supported yet.");
   }
 }
-
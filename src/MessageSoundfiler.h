@@ -23,9 +23,18 @@
 #ifndef _MESSAGE_SOUNDFILER_H_
 #define _MESSAGE_SOUNDFILER_H_
 
+#include <list>
 #include "MessageObject.h"
 
-/** [soundfiler~] */
+class DiskTask;
+class DiskWorker;
+
+/**
+ * [soundfiler]
+ * Files are read by the <code>DiskWorker</code> of the context. The tables are filled and the number
+ * of frames read is sent at the start of the first block after the file has been read, or
+ * immediately if disk I/O is synchronous.
+ */
 class MessageSoundfiler : public MessageObject {
   
   public:
@@ -37,7 +46,14 @@ class MessageSoundfiler : public MessageObject {
     std::string toString();
     
   private:
+    friend class SoundfileReadTask;
+  
     void processMessage(int inletIndex, PdMessage *message);
+  
+    DiskWorker *diskWorker;
+  
+    /** The read tasks which have been submitted but not yet completed. */
+    std::list<DiskTask *> tasks;
 };
 
 inline const char *MessageSoundfiler::getObjectLabel() {
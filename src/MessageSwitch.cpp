@@ -27,8 +27,8 @@ MessageObject *MessageSwitch::newObject(PdMessage *initMessage, PdGraph *graph)
   return new MessageSwitch(initMessage, graph);
 }
 
-MessageSwitch::MessageSwitch(PdMessage *initMessage, PdGraph *graph) : MessageObject(1, 0, graph) {
-  // TODO(mhroth): parse object arguments 
+MessageSwitch::MessageSwitch(PdMessage *initMessage, PdGraph *graph) : MessageBlock(initMessage, graph) {
+  graph->setSwitchable();
 }
 
 MessageSwitch::~MessageSwitch() {
@@ -38,5 +38,7 @@ MessageSwitch::~MessageSwitch() {
 void MessageSwitch::processMessage(int inletIndex, PdMessage *message) {
   if (message->isFloat(0)) {
     graph->setSwitch(message->getFloat(0) != 0.0f);
+  } else {
+    MessageBlock::processMessage(inletIndex, message);
   }
 }
@@ -23,15 +23,15 @@
 #ifndef _MESSAGE_SWITCH_H_
 #define _MESSAGE_SWITCH_H_
 
-#include "MessageObject.h"
+#include "MessageBlock.h"
 
 /* 
  * Even though switch~ acts on the DSP domain, it only processes messages. Thus it is represented
- * internally as a message object.
- * TODO(mhroth): This object currently only turns DSP processing on and off.
+ * internally as a message object. In addition to reblocking its graph like [block~], it turns DSP
+ * processing of the graph on and off.
  */
 /** [switch~] */
-class MessageSwitch : public MessageObject {
+class MessageSwitch : public MessageBlock {
   
   public:
     static MessageObject *newObject(PdMessage *initMessage, PdGraph *graph);
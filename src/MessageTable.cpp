@@ -70,15 +70,22 @@ float *MessageTable::resizeBuffer(int newBufferLength) {
   return buffer;
 }
 
+float *MessageTable::setBuffer(float *newBuffer, int newBufferLength) {
+  float *previousBuffer = buffer;
+  buffer = newBuffer;
+  bufferLength = newBufferLength;
+  return previousBuffer;
+}
+
 void MessageTable::processMessage(int inletIndex, PdMessage *message) {
   // TODO(mhroth): process all of the commands which can be sent to tables
-  if (message->isSymbol(0, "read")) {
+  if (message->isSymbol(0, SYMBOL_READ)) {
     if (message->isSymbol(1))  {
       // read the file and fill the table
     }
-  } else if (message->isSymbol(0, "write")) {
+  } else if (message->isSymbol(0, SYMBOL_WRITE)) {
     // write the contents of the table to file
-  } else if (message->isSymbol(0, "normalize")) {
+  } else if (message->isSymbol(0, SYMBOL_NORMALIZE)) {
     // normalise the contents of the table to the given value. Default to 1.
     #if __APPLE__
     float sum = 0.0f;
@@ -100,7 +107,7 @@ void MessageTable::processMessage(int inletIndex, PdMessage *message) {
       }
     }
     #endif
-  } else if (message->isSymbol(0, "resize")) {
+  } else if (message->isSymbol(0, SYMBOL_RESIZE)) {
     if (message->isFloat(1)) {
       int newBufferLength = (int) message->getFloat(1);
       resizeBuffer(newBufferLength);
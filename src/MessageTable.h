@@ -47,6 +47,13 @@ class MessageTable : public RemoteMessageReceiver {
      */
     float *resizeBuffer(int bufferLength);
   
+    /**
+     * Replaces the table's buffer with the given one, which must have been allocated with
+     * <code>malloc()</code> and is owned by the table from now on. The previous buffer is returned,
+     * and must be freed by the caller.
+     */
+    float *setBuffer(float *buffer, int bufferLength);
+  
   private:
     // tables can receive sent messages
     void processMessage(int inletIndex, PdMessage *message);
@@ -21,6 +21,7 @@
  */
 
 #include "MessageTableRead.h"
+#include "PdContext.h"
 #include "PdGraph.h"
 
 MessageObject *MessageTableRead::newObject(PdMessage *initMessage, PdGraph *graph) {
@@ -60,10 +61,12 @@ void MessageTableRead::processMessage(int inletIndex, PdMessage *message) {
       break;
     }
     case SYMBOL: {
-      if (message->isSymbol(0, "set") && message->isSymbol(1)) {
+      if (message->isSymbol(0, SYMBOL_SET) && message->isSymbol(1)) {
         free(name);
         name = StaticUtils::copyString(message->getSymbol(1));
-        table = graph->getTable(name);
+        // file this object under its new name, such that a table created later with that name
+        // is found, and look up the table
+        graph->getContext()->registerTableReceiver(this);
       }
       break;
     }
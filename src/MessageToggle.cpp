@@ -57,7 +57,7 @@ void MessageToggle::processMessage(int inletIndex, PdMessage *message) {
       break;
     }
     case SYMBOL: {
-      if (message->isSymbol(0, "set")) {
+      if (message->isSymbol(0, SYMBOL_SET)) {
         if (message->isFloat(1)) {
           isOn = (message->getFloat(1) != 0.0f);
           if (isOn) onOutput = message->getFloat(1);
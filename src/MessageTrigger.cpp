@@ -97,7 +97,7 @@ void MessageTrigger::processMessage(int inletIndex, PdMessage *message) {
             break;
           }
           case ANYTHING: {
-            outgoingMessage->initWithTimestampAndSymbol(message->getTimestamp(), message->getSymbol(0));
+            outgoingMessage->initWithTimestampAndAtom(message->getTimestamp(), message->getElement(0));
             sendMessage(i, outgoingMessage);
             break;
           }
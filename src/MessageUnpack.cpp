@@ -77,7 +77,7 @@ void MessageUnpack::processMessage(int inletIndex, PdMessage *message) {
           break;
         }
         case SYMBOL: {
-          outgoingMessage->initWithTimestampAndSymbol(message->getTimestamp(), message->getSymbol(i));
+          outgoingMessage->initWithTimestampAndAtom(message->getTimestamp(), message->getElement(i));
           sendMessage(i, outgoingMessage);
           break;
         }
@@ -88,7 +88,7 @@ void MessageUnpack::processMessage(int inletIndex, PdMessage *message) {
               break;
             }
             case SYMBOL: {
-              outgoingMessage->initWithTimestampAndSymbol(message->getTimestamp(), message->getSymbol(i));
+              outgoingMessage->initWithTimestampAndAtom(message->getTimestamp(), message->getElement(i));
               break;
             }
             default: {
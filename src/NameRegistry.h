@@ -0,0 +1,120 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _NAME_REGISTRY_H_
+#define _NAME_REGISTRY_H_
+
+#include <list>
+#include <string>
+#include <unordered_map>
+using namespace std;
+
+/**
+ * A <code>NameRegistry</code> associates named senders with the receivers of the same name, such as
+ * [send~] and [receive~], [delwrite~] and [delread~], [catch~] and [throw~], or [table] and
+ * [tabread]. There is at most one sender per name, but any number of receivers. Both types must
+ * implement <code>getName()</code>.
+ *
+ * Senders and receivers are kept in per-name buckets in a hash map, such that registering or
+ * unregistering an object only touches the bucket of that object's name.
+ */
+template <class S, class R>
+class NameRegistry {
+  
+  public:
+    /** Returns the sender registered under the given name, or <code>NULL</code> if there is none. */
+    S *getSender(const char *name) {
+      typename unordered_map<string, Bucket>::iterator it = buckets.find(string(name));
+      return (it == buckets.end()) ? NULL : it->second.sender;
+    }
+  
+    /**
+     * Registers a sender under its name. Returns false if a sender is already registered under
+     * that name, in which case the registry is not changed.
+     */
+    bool addSender(S *sender) {
+      Bucket *bucket = &buckets[string(sender->getName())];
+      if (bucket->sender != NULL) return false;
+      bucket->sender = sender;
+      return true;
+    }
+  
+    void removeSender(S *sender) {
+      typename unordered_map<string, Bucket>::iterator it = buckets.find(string(sender->getName()));
+      if (it != buckets.end() && it->second.sender == sender) {
+        it->second.sender = NULL;
+        removeBucketIfEmpty(it);
+      }
+    }
+  
+    /**
+     * Returns the receivers registered under the given name, or <code>NULL</code> if there are none.
+     * The list is owned by the registry.
+     */
+    list<R *> *getReceivers(const char *name) {
+      typename unordered_map<string, Bucket>::iterator it = buckets.find(string(name));
+      return (it == buckets.end()) ? NULL : &(it->second.receivers);
+    }
+  
+    /**
+     * Registers a receiver under its current name. A receiver without a name is kept under the
+     * empty name. If the receiver is already registered, it is moved to the bucket of its current name.
+     */
+    void addReceiver(R *receiver) {
+      removeReceiver(receiver);
+      string name = (receiver->getName() != NULL) ? string(receiver->getName()) : string();
+      buckets[name].receivers.push_back(receiver);
+      receiverNames[receiver] = name;
+    }
+  
+    /**
+     * Unregisters a receiver. The receiver is looked up under the name with which it was
+     * registered, as the names of some receivers (e.g. [tabread]) may change in the meantime.
+     */
+    void removeReceiver(R *receiver) {
+      typename unordered_map<R *, string>::iterator nameIt = receiverNames.find(receiver);
+      if (nameIt != receiverNames.end()) {
+        typename unordered_map<string, Bucket>::iterator it = buckets.find(nameIt->second);
+        it->second.receivers.remove(receiver);
+        removeBucketIfEmpty(it);
+        receiverNames.erase(nameIt);
+      }
+    }
+  
+  private:
+    typedef struct Bucket {
+      Bucket() : sender(NULL) {}
+      S *sender;
+      list<R *> receivers;
+    } Bucket;
+  
+    void removeBucketIfEmpty(typename unordered_map<string, Bucket>::iterator it) {
+      if (it->second.sender == NULL && it->second.receivers.empty()) buckets.erase(it);
+    }
+  
+    unordered_map<string, Bucket> buckets;
+  
+    /** The name under which each receiver was registered. */
+    unordered_map<R *, string> receiverNames;
+};
+
+#endif // _NAME_REGISTRY_H_
@@ -28,6 +28,7 @@
 #include "MessageArcTangent.h"
 #include "MessageArcTangent2.h"
 #include "MessageBang.h"
+#include "MessageBlock.h"
 #include "MessageCosine.h"
 #include "MessageCputime.h"
 #include "MessageChange.h"
@@ -135,6 +136,9 @@
 #include "DspOutlet.h"
 #include "DspPhasor.h"
 #include "DspPrint.h"
+#ifndef EMSCRIPTEN
+#include "DspReadSoundfile.h"
+#endif
 #include "DspReceive.h"
 #include "DspReciprocalSqrt.h"
 #include "DspRfft.h"
@@ -154,6 +158,9 @@
 #include "DspVariableLine.h"
 #include "DspVCF.h"
 #include "DspWrap.h"
+#ifndef EMSCRIPTEN
+#include "DspWriteSoundfile.h"
+#endif
 
 ObjectFactoryMap::ObjectFactoryMap() {
   // these objects represent the core set of supported objects
@@ -164,6 +171,7 @@ ObjectFactoryMap::ObjectFactoryMap() {
   objectFactoryMap[string(MessageArcTangent::getObjectLabel())] = &MessageArcTangent::newObject;
   objectFactoryMap[string(MessageArcTangent2::getObjectLabel())] = &MessageArcTangent2::newObject;
   objectFactoryMap[string(MessageBang::getObjectLabel())] = &MessageBang::newObject;
+  objectFactoryMap[string(MessageBlock::getObjectLabel())] = &MessageBlock::newObject;
   objectFactoryMap[string("bng")] = &MessageBang::newObject;
   objectFactoryMap[string("b")] = &MessageBang::newObject;
   objectFactoryMap[string(MessageChange::getObjectLabel())] = &MessageChange::newObject;
@@ -280,6 +288,9 @@ ObjectFactoryMap::ObjectFactoryMap() {
   objectFactoryMap[string(DspOutlet::getObjectLabel())] = &DspOutlet::newObject;
   objectFactoryMap[string(DspPhasor::getObjectLabel())] = &DspPhasor::newObject;
   objectFactoryMap[string(DspPrint::getObjectLabel())] = &DspPrint::newObject;
+  #ifndef EMSCRIPTEN
+  objectFactoryMap[string(DspReadSoundfile::getObjectLabel())] = &DspReadSoundfile::newObject;
+  #endif
   objectFactoryMap[string(DspReceive::getObjectLabel())] = &DspReceive::newObject;
   objectFactoryMap[string("r~")] = &DspReceive::newObject;
   objectFactoryMap[string(DspReciprocalSqrt::getObjectLabel())] = &DspReciprocalSqrt::newObject;
@@ -301,7 +312,11 @@ ObjectFactoryMap::ObjectFactoryMap() {
   objectFactoryMap[string(DspThrow::getObjectLabel())] = &DspThrow::newObject;
   objectFactoryMap[string(DspVariableDelay::getObjectLabel())] = &DspVariableDelay::newObject;
   objectFactoryMap[string(DspVariableLine::getObjectLabel())] = &DspVariableLine::newObject;
+  objectFactoryMap[string(DspVCF::getObjectLabel())] = &DspVCF::newObject;
   objectFactoryMap[string(DspWrap::getObjectLabel())] = &DspWrap::newObject;
+  #ifndef EMSCRIPTEN
+  objectFactoryMap[string(DspWriteSoundfile::getObjectLabel())] = &DspWriteSoundfile::newObject;
+  #endif
 }
 
 ObjectFactoryMap::~ObjectFactoryMap() {
@@ -35,6 +35,7 @@ enum ObjectType {
   DSP_TABLE_PLAY,
   DSP_DELAY_READ,
   DSP_DELAY_WRITE,
+  DSP_FUSED_CHAIN,
   DSP_INLET,
   DSP_OUTLET,
   DSP_RECEIVE,
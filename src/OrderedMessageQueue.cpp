@@ -20,54 +20,108 @@
  *
  */
 
+#include "MessagePool.h"
 #include "OrderedMessageQueue.h"
 
-OrderedMessageQueue::OrderedMessageQueue() {
-  orderedMessageQueue = list<ObjectMessageLetPair>();
+OrderedMessageQueue::OrderedMessageQueue(MessagePool *messagePool) {
+  this->messagePool = messagePool;
+  numInsertions = 0;
 }
 
 OrderedMessageQueue::~OrderedMessageQueue() {
   // destroy all remaining inserted messages
-  for (list<ObjectMessageLetPair>::iterator it = orderedMessageQueue.begin();
-       it != orderedMessageQueue.end(); ++it) {
-    ObjectMessageLetPair omlPair = *it;
-    omlPair.second.first->freeMessage();
+  for (vector<MessageNode *>::iterator it = heap.begin(); it != heap.end(); ++it) {
+    freeMessage(getMessage(*it));
   }
 }
 
-void OrderedMessageQueue::insertMessage(MessageObject *messageObject, int outletIndex, PdMessage *message) {
-  ObjectMessageLetPair omlPair = make_pair(messageObject, make_pair(message, outletIndex));
-  for (list<ObjectMessageLetPair>::iterator it = orderedMessageQueue.begin();
-       it != orderedMessageQueue.end(); ++it) {
-    if (message->getTimestamp() < it->second.first->getTimestamp()) {
-      orderedMessageQueue.insert(it, omlPair);
-      return;
-    }
-  }
-  orderedMessageQueue.push_back(omlPair); // insert at end
+PdMessage *OrderedMessageQueue::insertMessage(MessageObject *messageObject, int outletIndex, PdMessage *message) {
+  MessageNode *node = (MessageNode *) messagePool->allocate(sizeof(MessageNode) + message->numBytes());
+  node->object = messageObject;
+  node->outletIndex = outletIndex;
+  node->insertionIndex = numInsertions++;
+  message->copyTo(getMessage(node));
+  
+  heap.push_back(node);
+  siftUp(heap.size()-1);
+  return getMessage(node);
 }
 
 void OrderedMessageQueue::removeMessage(MessageObject *messageObject, int outletIndex, PdMessage *message) {
-  for (list<ObjectMessageLetPair>::iterator it = orderedMessageQueue.begin();
-       it != orderedMessageQueue.end(); ++it) {
-    ObjectMessageLetPair omlPair = *it;
-    if (omlPair.first == messageObject &&
-        omlPair.second.first == message &&
-        omlPair.second.second == outletIndex) {
-      orderedMessageQueue.erase(it);
-      return;
-    }
+  MessageNode *node = getNode(message);
+  // make sure that the handle really refers to a message which is still in the queue
+  if (node->heapIndex < heap.size() && heap[node->heapIndex] == node &&
+      node->object == messageObject && node->outletIndex == outletIndex) {
+    removeNodeAtIndex(node->heapIndex);
+    freeMessage(message);
   }
 }
 
 ObjectMessageLetPair OrderedMessageQueue::peek() {
-  return orderedMessageQueue.front();
+  MessageNode *node = heap.front();
+  return make_pair(node->object, make_pair(getMessage(node), node->outletIndex));
 }
 
 void OrderedMessageQueue::pop() {
-  orderedMessageQueue.pop_front();
+  removeNodeAtIndex(0);
+}
+
+void OrderedMessageQueue::freeMessage(PdMessage *message) {
+  messagePool->release(getNode(message));
 }
 
 bool OrderedMessageQueue::empty() {
-  return orderedMessageQueue.empty();
+  return heap.empty();
+}
+
+unsigned int OrderedMessageQueue::size() {
+  return heap.size();
+}
+
+
+#pragma mark - Heap
+
+void OrderedMessageQueue::removeNodeAtIndex(unsigned int index) {
+  MessageNode *node = heap[index];
+  MessageNode *last = heap.back();
+  heap.pop_back();
+  node->heapIndex = (unsigned int) -1; // the node is no longer in the heap
+  
+  if (node != last) {
+    // move the last node into the hole and restore the heap in whichever direction is necessary
+    setNodeAtIndex(last, index);
+    if (index > 0 && isBefore(last, heap[(index-1)/2])) {
+      siftUp(index);
+    } else {
+      siftDown(index);
+    }
+  }
+}
+
+void OrderedMessageQueue::siftUp(unsigned int index) {
+  MessageNode *node = heap[index];
+  while (index > 0) {
+    unsigned int parentIndex = (index-1)/2;
+    MessageNode *parent = heap[parentIndex];
+    if (!isBefore(node, parent)) break;
+    setNodeAtIndex(parent, index);
+    index = parentIndex;
+  }
+  setNodeAtIndex(node, index);
+}
+
+void OrderedMessageQueue::siftDown(unsigned int index) {
+  MessageNode *node = heap[index];
+  unsigned int numNodes = heap.size();
+  while (true) {
+    unsigned int childIndex = 2*index + 1;
+    if (childIndex >= numNodes) break;
+    if (childIndex+1 < numNodes && isBefore(heap[childIndex+1], heap[childIndex])) {
+      childIndex++; // choose the earlier of the two children
+    }
+    if (!isBefore(heap[childIndex], node)) break;
+    setNodeAtIndex(heap[childIndex], index);
+    index = childIndex;
+  }
+  setNodeAtIndex(node, index);
 }
@@ -25,28 +25,99 @@
 
 #include "MessageObject.h"
 
+class MessagePool;
+
 typedef std::pair<MessageObject *, std::pair<PdMessage *, unsigned int> > ObjectMessageLetPair;
 
+/**
+ * The <code>OrderedMessageQueue</code> keeps track of all scheduled messages in a context. It is
+ * implemented as a binary min-heap ordered by timestamp. Messages with the same timestamp are
+ * delivered in the order in which they were inserted.
+ *
+ * The queue owns a copy of each inserted message, allocated from the context's
+ * <code>MessagePool</code>. The copy is stored directly behind a small header
+ * which records the position of the message in the heap. The message pointer returned by
+ * <code>insertMessage()</code> is thus a handle with which the message can be found again in
+ * constant time, and removed in logarithmic time.
+ */
 class OrderedMessageQueue {
   
   public:
-    OrderedMessageQueue();
+    OrderedMessageQueue(MessagePool *messagePool);
     ~OrderedMessageQueue();
     
-    /** Inserts the message into the ordered queue based on its scheduled time. */
-    void insertMessage(MessageObject *messageObject, int outletIndex, PdMessage *message);
+    /**
+     * Copies the message into the queue and inserts it based on its scheduled time. The returned
+     * queued copy is owned by the queue.
+     */
+    PdMessage *insertMessage(MessageObject *messageObject, int outletIndex, PdMessage *message);
   
-    /** Removes the given message addressed to the given <code>MessageObject</code> from the queue. */
+    /**
+     * Removes the given message addressed to the given <code>MessageObject</code> from the queue.
+     * The message must have been returned by <code>insertMessage()</code>. Its memory is freed.
+     */
     void removeMessage(MessageObject *messageObject, int outletIndex, PdMessage *message);
   
     ObjectMessageLetPair peek();
   
+    /**
+     * Removes the next message from the queue. The message memory remains valid until it is
+     * released with <code>freeMessage()</code>.
+     */
     void pop();
   
+    /** Frees a message which has been <code>pop()</code>ed from the queue. */
+    void freeMessage(PdMessage *message);
+  
     bool empty();
   
+    /** Returns the number of messages currently in the queue. */
+    unsigned int size();
+  
   private:
-    list<ObjectMessageLetPair> orderedMessageQueue;
+    /** The header preceding every queued message. */
+    typedef struct MessageNode {
+      MessageObject *object;
+      unsigned int outletIndex;
+      unsigned int heapIndex;
+      unsigned long long insertionIndex; // breaks ties between equal timestamps (FIFO)
+    } MessageNode;
+  
+    static inline PdMessage *getMessage(MessageNode *node) {
+      return (PdMessage *) (node + 1);
+    }
+  
+    static inline MessageNode *getNode(PdMessage *message) {
+      return ((MessageNode *) message) - 1;
+    }
+  
+    /** Returns <code>true</code> if the node <code>a</code> must be delivered before <code>b</code>. */
+    static inline bool isBefore(MessageNode *a, MessageNode *b) {
+      double timestampA = getMessage(a)->getTimestamp();
+      double timestampB = getMessage(b)->getTimestamp();
+      return (timestampA < timestampB) ||
+          ((timestampA == timestampB) && (a->insertionIndex < b->insertionIndex));
+    }
+  
+    /** Removes the node at the given heap index from the heap, restoring the heap property. */
+    void removeNodeAtIndex(unsigned int index);
+  
+    void siftUp(unsigned int index);
+    void siftDown(unsigned int index);
+  
+    /** Places the node at the given index in the heap and updates its recorded position. */
+    inline void setNodeAtIndex(MessageNode *node, unsigned int index) {
+      heap[index] = node;
+      node->heapIndex = index;
+    }
+  
+    vector<MessageNode *> heap;
+  
+    /** The pool from which all queued messages are allocated. */
+    MessagePool *messagePool;
+  
+    /** The total number of messages which have been inserted into the queue. */
+    unsigned long long numInsertions;
 };
 
 #endif // _ORDERED_MESSAGE_QUEUE_H_
@@ -0,0 +1,145 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "OutboundMessageQueue.h"
+#include "ZenGarden.h"
+
+/** Marks the unused end of the ring, after which the next entry starts at the beginning. */
+#define ENTRY_WRAP -1
+
+/** Every entry begins with this header. Entries are 8-byte aligned. */
+typedef struct EntryHeader {
+  unsigned int numBytes; // including the header
+  int function; // a ZGCallbackFunction, or ENTRY_WRAP
+} EntryHeader;
+
+static inline unsigned int alignEntry(unsigned int numBytes) {
+  return (numBytes + 7) & ~7;
+}
+
+OutboundMessageQueue::OutboundMessageQueue() {
+  buffer = (char *) malloc(OUTBOUND_MESSAGE_QUEUE_CAPACITY);
+  reservedTail = 0;
+  tail.store(0, memory_order_relaxed);
+  head.store(0, memory_order_relaxed);
+  numDropped.store(0, memory_order_relaxed);
+}
+
+OutboundMessageQueue::~OutboundMessageQueue() {
+  free(buffer);
+}
+
+char *OutboundMessageQueue::reserve(ZGCallbackFunction function, unsigned int numBytes) {
+  unsigned int numEntryBytes = alignEntry(sizeof(EntryHeader) + numBytes);
+  unsigned int position = tail.load(memory_order_relaxed);
+  unsigned int offset = position & (OUTBOUND_MESSAGE_QUEUE_CAPACITY - 1);
+  unsigned int numBytesToEnd = OUTBOUND_MESSAGE_QUEUE_CAPACITY - offset;
+  // an entry which does not fit before the end of the ring starts again at the beginning
+  unsigned int numBytesNeeded = (numEntryBytes > numBytesToEnd)
+      ? numBytesToEnd + numEntryBytes : numEntryBytes;
+  unsigned int numBytesFree =
+      OUTBOUND_MESSAGE_QUEUE_CAPACITY - (position - head.load(memory_order_acquire));
+  if (numEntryBytes > OUTBOUND_MESSAGE_QUEUE_CAPACITY || numBytesNeeded > numBytesFree) {
+    numDropped.fetch_add(1, memory_order_relaxed);
+    return NULL;
+  }
+  
+  if (numEntryBytes > numBytesToEnd) {
+    EntryHeader *wrap = (EntryHeader *) (buffer + offset);
+    wrap->numBytes = numBytesToEnd;
+    wrap->function = ENTRY_WRAP;
+    position += numBytesToEnd;
+    offset = 0;
+  }
+  EntryHeader *header = (EntryHeader *) (buffer + offset);
+  header->numBytes = numEntryBytes;
+  header->function = function;
+  reservedTail = position + numEntryBytes;
+  return buffer + offset + sizeof(EntryHeader);
+}
+
+void OutboundMessageQueue::commit() {
+  // publish the entry to the consumer
+  tail.store(reservedTail, memory_order_release);
+}
+
+bool OutboundMessageQueue::pushMessage(const char *receiverName, PdMessage *message) {
+  // the symbols of a message are interned, such that the message can be copied as it is
+  unsigned int numMessageBytes = alignEntry(message->numBytes());
+  char *payload = reserve(ZG_RECEIVER_MESSAGE, numMessageBytes + strlen(receiverName) + 1);
+  if (payload == NULL) return false;
+  message->copyTo(payload);
+  strcpy(payload + numMessageBytes, receiverName);
+  commit();
+  return true;
+}
+
+bool OutboundMessageQueue::pushLine(ZGCallbackFunction function, const char *line) {
+  char *payload = reserve(function, strlen(line) + 1);
+  if (payload == NULL) return false;
+  strcpy(payload, line);
+  commit();
+  return true;
+}
+
+bool OutboundMessageQueue::pushDsp(int isOn) {
+  char *payload = reserve(ZG_PD_DSP, sizeof(int));
+  if (payload == NULL) return false;
+  *((int *) payload) = isOn;
+  commit();
+  return true;
+}
+
+unsigned int OutboundMessageQueue::poll(
+    void *(*callbackFunction)(ZGCallbackFunction, void *, void *), void *userData) {
+  // only the entries queued before polling began are delivered
+  unsigned int end = tail.load(memory_order_acquire);
+  unsigned int position = head.load(memory_order_relaxed);
+  unsigned int numEntries = 0;
+  while (position != end) {
+    EntryHeader *header = (EntryHeader *) (buffer + (position & (OUTBOUND_MESSAGE_QUEUE_CAPACITY - 1)));
+    char *payload = (char *) header + sizeof(EntryHeader);
+    switch (header->function) {
+      case ENTRY_WRAP: break;
+      case ZG_RECEIVER_MESSAGE: {
+        PdMessage *message = (PdMessage *) payload;
+        ZGReceiverMessagePair pair;
+        pair.receiverName = payload + alignEntry(message->numBytes());
+        pair.message = message;
+        callbackFunction(ZG_RECEIVER_MESSAGE, userData, &pair);
+        numEntries++;
+        break;
+      }
+      default: {
+        callbackFunction((ZGCallbackFunction) header->function, userData, payload);
+        numEntries++;
+        break;
+      }
+    }
+    // release the space of the entry to the producer
+    position += header->numBytes;
+    head.store(position, memory_order_release);
+  }
+  return numEntries;
+}
@@ -0,0 +1,90 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _OUTBOUND_MESSAGE_QUEUE_H_
+#define _OUTBOUND_MESSAGE_QUEUE_H_
+
+#include <atomic>
+#include "PdMessage.h"
+#include "ZGCallbackFunction.h"
+using namespace std;
+
+/** The number of bytes which an <code>OutboundMessageQueue</code> can hold. A power of two. */
+#define OUTBOUND_MESSAGE_QUEUE_CAPACITY 65536
+
+/**
+ * The <code>OutboundMessageQueue</code> carries the output of a context meant for the host, such as
+ * messages to external receivers and printed lines, from the thread processing the context to a
+ * thread of the host's choosing. It is the counterpart of <code>ExternalMessageQueue</code>. Each
+ * entry is serialised into a ring of bytes, together with the <code>ZGCallbackFunction</code> with
+ * which it is later passed to the host. There is one producer and one consumer, neither of which
+ * ever blocks. If the ring is full, the entry is dropped and counted.
+ */
+class OutboundMessageQueue {
+  
+  public:
+    OutboundMessageQueue();
+    ~OutboundMessageQueue();
+  
+    /** Queues a copy of a message sent to the named external receiver. */
+    bool pushMessage(const char *receiverName, PdMessage *message);
+  
+    /** Queues a copy of a line printed to standard (<code>ZG_PRINT_STD</code>) or error output. */
+    bool pushLine(ZGCallbackFunction function, const char *line);
+  
+    /** Queues a suggestion to turn signal processing on (1) or off (0). */
+    bool pushDsp(int isOn);
+  
+    /**
+     * Passes each entry which was queued before this call to the given callback function, in order,
+     * with the same arguments as the context would have, and removes it from the queue. Returns the
+     * number of entries.
+     */
+    unsigned int poll(void *(*callbackFunction)(ZGCallbackFunction, void *, void *), void *userData);
+  
+    /** Returns the number of entries which were dropped because the queue was full. */
+    unsigned int getNumDropped() { return numDropped.load(memory_order_relaxed); }
+  
+  private:
+    /**
+     * Reserves space for an entry with a payload of the given number of bytes, or returns
+     * <code>NULL</code> if the queue is full. The entry is queued with <code>commit()</code>.
+     */
+    char *reserve(ZGCallbackFunction function, unsigned int numBytes);
+    void commit();
+  
+    char *buffer;
+  
+    /** The position at which the reserved entry ends. */
+    unsigned int reservedTail;
+  
+    // the positions of the producer and the consumer are kept on separate cache lines
+    char padding0[64];
+    atomic<unsigned int> tail;
+    char padding1[64];
+    atomic<unsigned int> head;
+    char padding2[64];
+  
+    atomic<unsigned int> numDropped;
+};
+
+#endif // _OUTBOUND_MESSAGE_QUEUE_H_
@@ -20,15 +20,27 @@
  *
  */
 
+#include <time.h>
+#include "ArrayArithmetic.h"
 #include "BufferPool.h"
+#include "DiskWorker.h"
+#include "DspBufferAllocator.h"
+#include "DspExecutionPlan.h"
+#include "DspParallelScheduler.h"
+#include "ExternalMessageQueue.h"
+#include "MessagePool.h"
 #include "MessageSendController.h"
 #include "ObjectFactoryMap.h"
+#include "OutboundMessageQueue.h"
 #include "PdAbstractionDataBase.h"
 #include "PdContext.h"
 #include "PdFileParser.h"
+#include "RandomGenerator.h"
+#include "ZenGarden.h"
 
 #include "DelayReceiver.h"
 #include "DspCatch.h"
+#include "DspDac.h"
 #include "DspDelayWrite.h"
 #include "DspReceive.h"
 #include "DspSend.h"
@@ -42,10 +54,15 @@
 // Include here to avoid conflict with remove(const char*)
 #include <algorithm>
 
+/** The context which is being processed by the current thread, if any. */
+static thread_local PdContext *processingContext = NULL;
+
 #pragma mark Constructor/Deconstructor
 
 PdContext::PdContext(int numInputChannels, int numOutputChannels, int blockSize, float sampleRate,
     void *(*function)(ZGCallbackFunction, void *, void *), void *userData) {
+  ArrayArithmetic::selectInstructionSet();
+  
   this->numInputChannels = numInputChannels;
   this->numOutputChannels = numOutputChannels;
   this->blockSize = blockSize;
@@ -54,10 +71,22 @@ PdContext::PdContext(int numInputChannels, int numOutputChannels, int blockSize,
   callbackUserData = userData;
   blockStartTimestamp = 0.0;
   blockDurationMs = ((double) blockSize / (double) sampleRate) * 1000.0;
-  messageCallbackQueue = new OrderedMessageQueue();
+  messagePool = new MessagePool();
+  messageCallbackQueue = new OrderedMessageQueue(messagePool);
+  externalMessageQueue = new ExternalMessageQueue();
   objectFactoryMap = new ObjectFactoryMap();
   globalGraphId = 0;
   bufferPool = new BufferPool(blockSize);
+  bufferAllocator = new DspBufferAllocator(bufferPool);
+  executionPlan = new DspExecutionPlan();
+  parallelScheduler = NULL;
+  lockDepth = 0;
+  fusionEnabled = true;
+  outboundMessageQueue = new OutboundMessageQueue();
+  diskWorker = new DiskWorker();
+  messagePollingEnabled = false;
+  numOutboundDroppedReported = 0;
+  setRandomSeed(RandomGenerator::mix((uint32_t) time(NULL)) ^ (uint32_t) (uintptr_t) this);
   
   numBytesInInputBuffers = blockSize * numInputChannels * sizeof(float);
   numBytesInOutputBuffers = blockSize * numOutputChannels * sizeof(float);
@@ -84,8 +113,14 @@ PdContext::~PdContext() {
   FREE_ALIGNED_BUFFER(globalDspOutputBuffers);
   
   delete messageCallbackQueue;
+  delete externalMessageQueue;
+  delete outboundMessageQueue;
   delete sendController;
   delete objectFactoryMap;
+  delete parallelScheduler;
+  delete executionPlan;
+  executionPlan = NULL; // graphs are no longer compiled while they are deleted
+  delete bufferAllocator;
   delete bufferPool;
   
   // delete all of the PdGraphs in the graph list
@@ -94,6 +129,12 @@ PdContext::~PdContext() {
   }
 
   delete abstractionDatabase;
+  
+  // objects cancel their disk tasks when they are deleted, so the worker is stopped afterwards
+  delete diskWorker;
+  
+  // the message pool is deleted last, as it may be used by any object when it is deleted
+  delete messagePool;
 
 #ifndef EMSCRIPTEN
   pthread_mutex_destroy(&contextLock);
@@ -156,12 +197,22 @@ int PdContext::getNextGraphId() {
 
 void PdContext::process(float *inputBuffers, float *outputBuffers) {
   lock(); // lock the context
+  PdContext *previousProcessingContext = processingContext;
+  processingContext = this;
   
   // set up adc~ buffers
   memcpy(globalDspInputBuffers, inputBuffers, numBytesInInputBuffers);
   
-  // clear the global output audio buffers so that dac~ nodes can write to it
-  memset(globalDspOutputBuffers, 0, numBytesInOutputBuffers);
+  // schedule the messages sent from outside of the context since the last block
+  externalMessageQueue->drain(&receiveExternalMessage, this);
+  
+  // hand over the results of the disk tasks which have finished since the last block
+  diskWorker->completeTasks();
+  
+  // clear the output channels which are not overwritten by a dac~ in every block
+  for (int i = 0; i < clearedOutputChannels.size(); i++) {
+    memset(globalDspOutputBuffers + (clearedOutputChannels[i] * blockSize), 0, blockSize * sizeof(float));
+  }
 
   // // Send all messages for this block
   ObjectMessageLetPair omlPair;
@@ -183,19 +234,16 @@ void PdContext::process(float *inputBuffers, float *outputBuffers) {
     }
     
     object->sendMessage(outletIndex, message);
-    message->freeMessage(); // free the message now that it has been sent and processed
+    messageCallbackQueue->freeMessage(message); // free the message now that it has been sent and processed
   }
   
-  switch (graphList.size()) {
-    case 0: break;
-    case 1: graphList.front()->processFunction(graphList.front(), 0, 0); break;
-    default: {
-      int numGraphs = graphList.size();
-      PdGraph **graph = &graphList.front();
-      for (int i = 0; i < numGraphs; ++i) {
-        graph[i]->processFunction(graph[i], 0, 0);
-      }
-    }
+  // graphs changed from outside of process() were compiled when the context was unlocked. Only those
+  // changed by the messages of this block are compiled here, before the plan is executed.
+  updateDsp();
+  if (parallelScheduler == NULL) {
+    executionPlan->process();
+  } else {
+    parallelScheduler->process();
   }
   
   blockStartTimestamp = nextBlockStartTimestamp;
@@ -203,6 +251,7 @@ void PdContext::process(float *inputBuffers, float *outputBuffers) {
   // copy the output audio to the given buffer
   memcpy(outputBuffers, globalDspOutputBuffers, numBytesInOutputBuffers);
   
+  processingContext = previousProcessingContext;
   unlock(); // unlock the context
 }
 
@@ -216,6 +265,9 @@ void PdContext::attachGraph(PdGraph *graph) {
   for (auto graph : graphList) {
     graph->computeDeepLocalDspProcessOrder();
   }
+  // reassign the signal buffers now that the process order of all graphs is known
+  executionPlan->compile(&graphList);
+  compileDsp();
   unlock();
 }
 
@@ -224,9 +276,143 @@ void PdContext::unattachGraph(PdGraph *graph) {
   graphList.erase(std::remove(graphList.begin(), graphList.end(), graph),
     graphList.end());
   graph->attachToContext(false);
+  executionPlan->removeGraph(graph);
+  // objects in other graphs may read signals by name directly from the buffers of this one
+  compileDsp();
+  unlock();
+}
+
+void PdContext::reserveBlockSize(int blockSize) {
+  if (blockSize <= (int) bufferPool->getBufferSize()) return;
+  
+  lock();
+  // all buffers acquired from the pool become invalid, so every attached graph must reacquire them
+  bufferPool->resizeBuffers(blockSize);
+  for (vector<PdGraph *>::iterator it = graphList.begin(); it != graphList.end(); ++it) {
+    executionPlan->invalidateGraph(*it);
+  }
+  unlock();
+}
+
+void PdContext::compileDsp() {
+  if (parallelScheduler == NULL) {
+    bufferAllocator->allocateBuffers(&graphList);
+  } else {
+    parallelScheduler->schedule(executionPlan);
+    vector<DspObject *> processOrder;
+    vector<unsigned int> position;
+    vector<unsigned int> partition;
+    parallelScheduler->getAllocationOrder(&processOrder, &position, &partition);
+    bufferAllocator->allocateBuffers(&processOrder, &position, &partition);
+  }
+  compileDspOutputs();
+}
+
+void PdContext::updateDsp() {
+  if (executionPlan != NULL && executionPlan->update()) {
+    compileDsp();
+  }
+}
+
+void PdContext::compileDspOutputs() {
+  // [dac~]s are processed in the order of the plan, whether DSP is parallel or not
+  vector<DspObject *> processOrder;
+  for (vector<PdGraph *>::iterator it = graphList.begin(); it != graphList.end(); ++it) {
+    (*it)->getDeepDspProcessOrder(&processOrder);
+  }
+  
+  vector<bool> isWritten(numOutputChannels, false);
+  clearedOutputChannels.clear();
+  for (vector<DspObject *>::iterator it = processOrder.begin(); it != processOrder.end(); ++it) {
+    if ((*it)->getObjectType() != DSP_DAC) continue;
+    DspDac *dspDac = reinterpret_cast<DspDac *>(*it);
+    
+    // a dac~ in a graph which may be switched off or reblocked is not processed once every block
+    bool isConditional = false;
+    for (PdGraph *graph = dspDac->getGraph(); graph != NULL; graph = graph->getParentGraph()) {
+      if (graph->isSwitchable() || graph->isReblocked()) isConditional = true;
+    }
+    
+    for (int i = 0; i < dspDac->getNumDspInlets(); i++) {
+      int channel = dspDac->getOutputChannel(i);
+      if (channel < 0) continue;
+      dspDac->setOverwritesOutput(i, !isWritten[channel] && !isConditional);
+      if (!isWritten[channel] && isConditional) clearedOutputChannels.push_back(channel);
+      isWritten[channel] = true;
+    }
+  }
+  
+  // channels which are not written are cleared once, and remain silent
+  memset(globalDspOutputBuffers, 0, numBytesInOutputBuffers);
+}
+
+void PdContext::setNumDspThreads(unsigned int numThreads) {
+  lock();
+  delete parallelScheduler;
+  parallelScheduler = (numThreads > 1)
+      ? new DspParallelScheduler(numThreads, bufferAllocator, &printWorkerOutput, this) : NULL;
+  compileDsp();
+  unlock();
+}
+
+unsigned int PdContext::getNumDspThreads() {
+  return (parallelScheduler == NULL) ? 1 : parallelScheduler->getNumThreads();
+}
+
+void PdContext::setFusionEnabled(bool enabled) {
+  lock();
+  if (fusionEnabled != enabled) {
+    fusionEnabled = enabled;
+    // the process order of every graph is recomputed when the context is unlocked
+    for (vector<PdGraph *>::iterator it = graphList.begin(); it != graphList.end(); ++it) {
+      executionPlan->invalidateGraph(*it);
+    }
+  }
   unlock();
 }
 
+void PdContext::setMessagePollingEnabled(bool enabled) {
+  lock();
+  messagePollingEnabled = enabled;
+  unlock();
+}
+
+void PdContext::setDiskIoSynchronous(bool synchronous) {
+  lock();
+  diskWorker->setSynchronous(synchronous);
+  unlock();
+}
+
+bool PdContext::isOutputPolled() {
+  return messagePollingEnabled && processingContext == this;
+}
+
+unsigned int PdContext::pollMessages() {
+  if (callbackFunction == NULL) return 0;
+  unsigned int numCalls = outboundMessageQueue->poll(callbackFunction, callbackUserData);
+  
+  // let the host know that it is not polling often enough
+  unsigned int numDropped = outboundMessageQueue->getNumDropped();
+  if (numDropped != numOutboundDroppedReported) {
+    char str[128];
+    snprintf(str, sizeof(str), "%u messages were dropped because they were not polled in time.",
+        numDropped - numOutboundDroppedReported);
+    numOutboundDroppedReported = numDropped;
+    callbackFunction(ZG_PRINT_ERR, callbackUserData, str);
+    numCalls++;
+  }
+  return numCalls;
+}
+
+void PdContext::setRandomSeed(uint32_t seed) {
+  randomSeed = seed;
+  numRandomSeeds = 0;
+}
+
+uint32_t PdContext::getNextRandomSeed() {
+  return RandomGenerator::mix(randomSeed ^ RandomGenerator::mix(numRandomSeeds++));
+}
+
 
 #pragma mark - New Object
 
@@ -247,8 +433,19 @@ MessageObject *PdContext::newObject(const char *objectLabel, PdMessage *initMess
 
 #pragma mark - PrintStd/PrintErr
 
+void *PdContext::printWorkerOutput(ZGCallbackFunction function, void *userData, void *ptr) {
+  PdContext *context = reinterpret_cast<PdContext *>(userData);
+  if (function == ZG_PRINT_ERR) context->printErr((char *) ptr);
+  else context->printStd((char *) ptr);
+  return NULL;
+}
+
 void PdContext::printErr(char *msg) {
-  if (callbackFunction != NULL) {
+  // the processing thread passes on the lines printed on the workers of the parallel scheduler
+  if (parallelScheduler != NULL && parallelScheduler->pushLine(ZG_PRINT_ERR, msg)) return;
+  if (isOutputPolled()) {
+    outboundMessageQueue->pushLine(ZG_PRINT_ERR, msg);
+  } else if (callbackFunction != NULL) {
     callbackFunction(ZG_PRINT_ERR, callbackUserData, msg);
   }
 }
@@ -264,7 +461,10 @@ void PdContext::printErr(const char *msg, ...) {
 }
 
 void PdContext::printStd(char *msg) {
-  if (callbackFunction != NULL) {
+  if (parallelScheduler != NULL && parallelScheduler->pushLine(ZG_PRINT_STD, msg)) return;
+  if (isOutputPolled()) {
+    outboundMessageQueue->pushLine(ZG_PRINT_STD, msg);
+  } else if (callbackFunction != NULL) {
     callbackFunction(ZG_PRINT_STD, callbackUserData, msg);
   }
 }
@@ -283,9 +483,7 @@ void PdContext::printStd(const char *msg, ...) {
 #pragma mark - Register/Unregister DspSend/Receive
 
 void PdContext::registerDspReceive(DspReceive *dspReceive) {
-  // NOTE(mhroth): no duplicate check is made for dspReceive
-  list<DspReceive *> *receiveList = &(dspReceiveMap[string(dspReceive->getName())]);
-  receiveList->push_back(dspReceive);
+  dspSendRegistry.addReceiver(dspReceive);
   
   // connect receive~ to associated send~
   DspSend *dspSend = getDspSend(dspReceive->getName());
@@ -295,42 +493,38 @@ void PdContext::registerDspReceive(DspReceive *dspReceive) {
 }
 
 void PdContext::unregisterDspReceive(DspReceive *dspReceive) {
-  list<DspReceive *> *receiveList = &(dspReceiveMap[string(dspReceive->getName())]);
-  receiveList->remove(dspReceive);
+  dspSendRegistry.removeReceiver(dspReceive);
   dspReceive->setDspBufferAtInlet(dspReceive->getGraph()->getBufferPool()->getZeroBuffer(), 0);
 }
 
 void PdContext::registerDspSend(DspSend *dspSend) {
-  DspSend *sendObject = getDspSend(dspSend->getName());
-  if (sendObject != NULL) {
+  if (!dspSendRegistry.addSender(dspSend)) {
     printErr("Duplicate send~ object found with name \"%s\".", dspSend->getName());
     return;
   }
-  dspSendList.push_back(dspSend);
   
   // connect associated receive~s to send~.
   updateDspReceiveForSendWithBuffer(dspSend->getName(), dspSend->getDspBufferAtOutlet(0));
 }
 
 void PdContext::unregisterDspSend(DspSend *dspSend) {
-  dspSendList.remove(dspSend);
+  if (getDspSend(dspSend->getName()) != dspSend) return; // a duplicate send~ was never registered
+  dspSendRegistry.removeSender(dspSend);
   
   // inform all previously connected receive~s that the send~ buffer does not exist anymore.
   updateDspReceiveForSendWithBuffer(dspSend->getName(), dspSend->getGraph()->getBufferPool()->getZeroBuffer());
 }
 
 DspSend *PdContext::getDspSend(const char *name) {
-  for (list<DspSend *>::iterator it = dspSendList.begin(); it != dspSendList.end(); ++it) {
-    if (!strcmp((*it)->getName(), name)) return *it;
-  }
-  return NULL;
+  return dspSendRegistry.getSender(name);
 }
 
 void PdContext::updateDspReceiveForSendWithBuffer(const char *name, float *buffer) {
-  list<DspReceive *> receiveList = dspReceiveMap[string(name)];
-  for (list<DspReceive *>::iterator it = receiveList.begin(); it != receiveList.end(); ++it) {
-    DspReceive *dspReceive = *it;
-    dspReceive->setDspBufferAtInlet(buffer, 0);
+  list<DspReceive *> *receiveList = dspSendRegistry.getReceivers(name);
+  if (receiveList != NULL) {
+    for (list<DspReceive *>::iterator it = receiveList->begin(); it != receiveList->end(); ++it) {
+      (*it)->setDspBufferAtInlet(buffer, 0);
+    }
   }
 }
 
@@ -346,20 +540,22 @@ void PdContext::unregisterRemoteMessageReceiver(RemoteMessageReceiver *receiver)
 }
 
 void PdContext::registerDelayline(DspDelayWrite *delayline) {
-  if (getDelayline(delayline->getName()) != NULL) {
+  if (!delaylineRegistry.addSender(delayline)) {
     printErr("delwrite~ with duplicate name \"%s\" registered.", delayline->getName());
     return;
   }
-  delaylineList.push_back(delayline);
   
   // connect this delayline to all same-named delay receivers
-  for (list<DelayReceiver *>::iterator it = delayReceiverList.begin(); it != delayReceiverList.end(); it++) {
-    if (!strcmp((*it)->getName(), delayline->getName())) (*it)->setDelayline(delayline);
+  list<DelayReceiver *> *receiverList = delaylineRegistry.getReceivers(delayline->getName());
+  if (receiverList != NULL) {
+    for (list<DelayReceiver *>::iterator it = receiverList->begin(); it != receiverList->end(); it++) {
+      (*it)->setDelayline(delayline);
+    }
   }
 }
 
 void PdContext::registerDelayReceiver(DelayReceiver *delayReceiver) {
-  delayReceiverList.push_back(delayReceiver);
+  delaylineRegistry.addReceiver(delayReceiver);
   
   // connect the delay receiver to the named delayline
   DspDelayWrite *delayline = getDelayline(delayReceiver->getName());
@@ -367,15 +563,11 @@ void PdContext::registerDelayReceiver(DelayReceiver *delayReceiver) {
 }
 
 DspDelayWrite *PdContext::getDelayline(const char *name) {
-  for (list<DspDelayWrite *>::iterator it = delaylineList.begin(); it != delaylineList.end(); ++it) {
-    if (!strcmp((*it)->getName(), name)) return *it;
-  }
-  return NULL;
+  return delaylineRegistry.getSender(name);
 }
 
 void PdContext::registerDspThrow(DspThrow *dspThrow) {
-  // NOTE(mhroth): no duplicate testing for the same object more than once
-  throwList.push_back(dspThrow);
+  dspCatchRegistry.addReceiver(dspThrow);
   
   DspCatch *dspCatch = getDspCatch(dspThrow->getName());
   if (dspCatch != NULL) {
@@ -384,51 +576,45 @@ void PdContext::registerDspThrow(DspThrow *dspThrow) {
 }
 
 void PdContext::registerDspCatch(DspCatch *dspCatch) {
-  DspCatch *catchObject = getDspCatch(dspCatch->getName());
-  if (catchObject != NULL) {
+  if (!dspCatchRegistry.addSender(dspCatch)) {
     printErr("catch~ with duplicate name \"%s\" already exists.", dspCatch->getName());
     return;
   }
-  catchList.push_back(dspCatch);
   
   // connect catch~ to all associated throw~s
-  for (list<DspThrow *>::iterator it = throwList.begin(); it != throwList.end(); it++) {
-    if (!strcmp((*it)->getName(), dspCatch->getName())) dspCatch->addThrow((*it));
+  list<DspThrow *> *throwList = dspCatchRegistry.getReceivers(dspCatch->getName());
+  if (throwList != NULL) {
+    for (list<DspThrow *>::iterator it = throwList->begin(); it != throwList->end(); it++) {
+      dspCatch->addThrow(*it);
+    }
   }
 }
 
 DspCatch *PdContext::getDspCatch(const char *name) {
-  for (list<DspCatch *>::iterator it = catchList.begin(); it != catchList.end(); it++) {
-    if (!strcmp((*it)->getName(), name)) return (*it);
-  }
-  return NULL;
+  return dspCatchRegistry.getSender(name);
 }
 
 void PdContext::registerTable(MessageTable *table) {  
-  if (getTable(table->getName()) != NULL) {
+  if (!tableRegistry.addSender(table)) {
     printErr("Table with name \"%s\" already exists.", table->getName());
     return;
   }
-  tableList.push_back(table);
   
-  for (list<TableReceiverInterface *>::iterator it = tableReceiverList.begin();
-      it != tableReceiverList.end(); it++) {
-    // in case the table receiver doesn't have the table name yet
-    if ((*it)->getName() == NULL)
-      continue;
-    if (!strcmp((*it)->getName(), table->getName())) (*it)->setTable(table);
+  list<TableReceiverInterface *> *receiverList = tableRegistry.getReceivers(table->getName());
+  if (receiverList != NULL) {
+    for (list<TableReceiverInterface *>::iterator it = receiverList->begin();
+        it != receiverList->end(); it++) {
+      (*it)->setTable(table);
+    }
   }
 }
 
 MessageTable *PdContext::getTable(const char *name) {
-  for (list<MessageTable *>::iterator it = tableList.begin(); it != tableList.end(); it++) {
-    if (!strcmp((*it)->getName(), name)) return (*it);
-  }
-  return NULL;
+  return tableRegistry.getSender(name);
 }
 
 void PdContext::registerTableReceiver(TableReceiverInterface *tableReceiver) {
-  tableReceiverList.push_back(tableReceiver); // add the new receiver
+  tableRegistry.addReceiver(tableReceiver); // add the new receiver
   
   // in case the tableread doesnt have the name of the table yet
   if (tableReceiver->getName()) {
@@ -438,7 +624,7 @@ void PdContext::registerTableReceiver(TableReceiverInterface *tableReceiver) {
 }
 
 void PdContext::unregisterTableReceiver(TableReceiverInterface *tableReceiver) {
-  tableReceiverList.remove(tableReceiver); // remove the receiver
+  tableRegistry.removeReceiver(tableReceiver); // remove the receiver
   tableReceiver->setTable(NULL);
 }
 
@@ -462,6 +648,17 @@ void PdContext::unregisterExternalReceiver(const char *receiverName) {
   unlock();
 }
 
+void PdContext::sendMessageToExternalReceiver(const char *receiverName, PdMessage *message) {
+  if (isOutputPolled()) {
+    outboundMessageQueue->pushMessage(receiverName, message);
+  } else if (callbackFunction != NULL) {
+    ZGReceiverMessagePair pair;
+    pair.receiverName = receiverName;
+    pair.message = message;
+    callbackFunction(ZG_RECEIVER_MESSAGE, callbackUserData, &pair);
+  }
+}
+
 
 #pragma mark - Manage Messages
 
@@ -477,7 +674,7 @@ void PdContext::scheduleExternalMessageV(const char *receiverName, double timest
   for (int i = 0; i < numElements; i++) { // format message
     switch (messageFormat[i]) {
       case 'f': message->setFloat(i, (float) va_arg(ap, double)); break;
-      case 's': message->setSymbol(i, (char *) va_arg(ap, char *)); break;
+      case 's': message->setUninternedSymbol(i, (char *) va_arg(ap, char *)); break;
       case 'b': message->setBang(i); break;
       default: break;
     }
@@ -487,36 +684,32 @@ void PdContext::scheduleExternalMessageV(const char *receiverName, double timest
 }
 
 void PdContext::scheduleExternalMessage(const char *receiverName, PdMessage *message) {
-  lock();
-  int receiverNameIndex = sendController->getNameIndex(receiverName);
-  if (receiverNameIndex >= 0) { // if the receiver exists
-    scheduleMessage(sendController, receiverNameIndex, message);
-  }
-  unlock();
+  // the receiver is resolved once the message is taken from the queue, at the start of the next block
+  externalMessageQueue->push(receiverName, message);
 }
 
 void PdContext::scheduleExternalMessage(const char *receiverName, double timestamp, const char *initString) {
-  // do the heavy lifting of string parsing before the lock (minimise the critical section)
   int maxElements = (strlen(initString)/2)+1;
   PdMessage *message = PD_MESSAGE_ON_STACK(maxElements);
   char str[strlen(initString)+1]; strcpy(str, initString);
-  message->initWithString(timestamp, maxElements, str);
+  message->initWithString(timestamp, maxElements, str, false);
   
-  lock(); // lock and load
-  int receiverNameIndex = sendController->getNameIndex(receiverName);
+  externalMessageQueue->push(receiverName, message);
+}
+
+void PdContext::receiveExternalMessage(void *context, const char *receiverName, PdMessage *message) {
+  PdContext *d = reinterpret_cast<PdContext *>(context);
+  int receiverNameIndex = d->sendController->getNameIndex(receiverName);
   if (receiverNameIndex >= 0) { // if the receiver exists
-    scheduleMessage(sendController, receiverNameIndex, message);
+    d->scheduleMessage(d->sendController, receiverNameIndex, message);
   }
-  unlock();
 }
 
 PdMessage *PdContext::scheduleMessage(MessageObject *messageObject, unsigned int outletIndex, PdMessage *message) {
   // basic argument checking. It may happen that the message is NULL in case a cancel message
   // is sent multiple times to a particular object, when no message is pending
   if (message != NULL && messageObject != NULL) {
-    message = message->copyToHeap();
-    messageCallbackQueue->insertMessage(messageObject, outletIndex, message);
-    return message;
+    return messageCallbackQueue->insertMessage(messageObject, outletIndex, message);
   }
   return NULL;
 }
@@ -524,18 +717,21 @@ PdMessage *PdContext::scheduleMessage(MessageObject *messageObject, unsigned int
 void PdContext::cancelMessage(MessageObject *messageObject, int outletIndex, PdMessage *message) {
   if (message != NULL && outletIndex >= 0 && messageObject != NULL) {
     messageCallbackQueue->removeMessage(messageObject, outletIndex, message);
-    message->freeMessage();
   }
 }
 
 void PdContext::receiveSystemMessage(PdMessage *message) {
   // TODO(mhroth): What are all of the possible system messages?
-  if (message->isSymbol(0, "obj")) {
+  if (message->isSymbol(0, SYMBOL_OBJ)) {
     // TODO(mhroth): dynamic patching
   } else if (callbackFunction != NULL) {
-    if (message->isSymbol(0, "dsp") && message->isFloat(1)) {
+    if (message->isSymbol(0, SYMBOL_DSP) && message->isFloat(1)) {
       int result = (message->getFloat(1) != 0.0f) ? 1 : 0;
-      callbackFunction(ZG_PD_DSP, callbackUserData, &result);
+      if (isOutputPolled()) {
+        outboundMessageQueue->pushDsp(result);
+      } else {
+        callbackFunction(ZG_PD_DSP, callbackUserData, &result);
+      }
     }
   } else {
     char *messageString = message->toString();
@@ -24,22 +24,31 @@
 #define _PD_CONTEXT_H_
 
 #include <map>
+#include <stdint.h>
 #ifndef EMSCRIPTEN
 #include <pthread.h>
 #endif
+#include "NameRegistry.h"
 #include "OrderedMessageQueue.h"
 #include "PdGraph.h"
 #include "ZGCallbackFunction.h"
 
 class BufferPool;
+class DiskWorker;
+class DspBufferAllocator;
+class DspExecutionPlan;
+class DspParallelScheduler;
 class DspCatch;
 class DelayReceiver;
 class DspDelayWrite;
 class DspReceive;
 class DspSend;
 class DspThrow;
+class ExternalMessageQueue;
+class MessagePool;
 class MessageSendController;
 class MessageTable;
+class OutboundMessageQueue;
 class PdFileParser;
 class RemoteMessageReceiver;
 class TableReceiverInterface;
@@ -72,12 +81,70 @@ class PdContext {
     
     void process(float *inputBuffers, float *outputBuffers);
   
+    /**
+     * Sets the number of threads on which DSP is processed, including the thread calling
+     * <code>process()</code>. With one thread (the default) the execution plan is processed serially.
+     */
+    void setNumDspThreads(unsigned int numThreads);
+    unsigned int getNumDspThreads();
+  
+    /**
+     * Enables or disables the fusing of chains of elementwise signal objects into a single step of the
+     * process order (see <code>DspFusedChain</code>). Fusing is enabled by default. The output is
+     * identical in either case.
+     */
+    void setFusionEnabled(bool enabled);
+    bool isFusionEnabled() { return fusionEnabled; }
+  
+    /**
+     * Enables or disables the polling of output meant for the host. When enabled, messages to
+     * external receivers, printed lines and <code>ZG_PD_DSP</code> suggestions produced while the
+     * context is processed are queued in an <code>OutboundMessageQueue</code> instead of being passed
+     * to the callback function on the processing thread. They are passed to it when
+     * <code>pollMessages()</code> is called. Polling is disabled by default.
+     */
+    void setMessagePollingEnabled(bool enabled);
+  
+    /**
+     * Passes the output queued since the last call to the callback function, on the calling thread,
+     * and returns the number of calls. Only one thread may poll the context at a time.
+     */
+    unsigned int pollMessages();
+  
+    /**
+     * Sets whether the tasks which objects hand to the <code>DiskWorker</code>, such as reading a
+     * sound file with [soundfiler], are performed immediately on the processing thread rather than in
+     * the background. This is useful when rendering offline, where the result of the task should be
+     * available at the logical time at which it was requested. Disk I/O is asynchronous by default.
+     */
+    void setDiskIoSynchronous(bool synchronous);
+  
+    /**
+     * Sets the seed from which the random generators of [noise~] and [random] objects are seeded.
+     * Objects created afterwards take seeds derived from it in the order in which they are created,
+     * such that a graph created after the seed is set produces the same output every time. The
+     * default seed differs for each context.
+     */
+    void setRandomSeed(uint32_t seed);
+  
+    /** Returns the seed of the next random generator. See <code>setRandomSeed()</code>. */
+    uint32_t getNextRandomSeed();
+  
     void lock() {
 #ifndef EMSCRIPTEN
         pthread_mutex_lock(&contextLock);
 #endif
+        lockDepth++;
     }
+  
+    /**
+     * Unlocks the context. The graphs which have changed while it was locked are recompiled before
+     * it is released by the thread which locked it, such that <code>process()</code> only executes
+     * the compiled plan.
+     */
     void unlock() {
+        if (lockDepth == 1) updateDsp();
+        lockDepth--;
 #ifndef EMSCRIPTEN
         pthread_mutex_unlock(&contextLock);
 #endif
@@ -146,12 +213,16 @@ class PdContext {
     void scheduleExternalMessageV(const char *receiverName, double timestamp,
         const char *messageFormat, va_list ap);
   
-    /** Schedules a message to be sent to all receivers at the start of the next block. */
+    /**
+     * Schedules a message to be sent to all receivers at the start of the next block. The context is
+     * not locked, so this function may be called from any thread without waiting for the current
+     * block to be processed. See <code>ExternalMessageQueue</code>.
+     */
     void scheduleExternalMessage(const char *receiverName, PdMessage *message);
   
     /**
      * Schedules a message described by the given string to be sent to named receivers at the
-     * given timestamp.
+     * given timestamp. The context is not locked.
      */
     void scheduleExternalMessage(const char *receiverName, double timestamp,
         const char *initString);
@@ -160,13 +231,14 @@ class PdContext {
      * Schedules a <code>PdMessage</code> to be sent by the <code>MessageObject</code> from the
      * <code>outletIndex</code> at the specified <code>time</code>. The message will be copied
      * to the heap and the context will thereafter take over ownership and be responsible for
-     * freeing it. The pointer to the heap-message is returned.
+     * freeing it. The pointer to the heap-message is returned. It serves as the handle with which
+     * the message may be cancelled in constant time.
      */
     PdMessage *scheduleMessage(MessageObject *messageObject, unsigned int outletIndex, PdMessage *message);
   
     /**
-     * Cancel a scheduled <code>PdMessage</code> according to its id. The message memory will
-     * be freed.
+     * Cancel a scheduled <code>PdMessage</code> according to the handle returned by
+     * <code>scheduleMessage()</code>. The message memory will be freed.
      */
     void cancelMessage(MessageObject *messageObject, int outletIndex, PdMessage *message);
   
@@ -206,6 +278,9 @@ class PdContext {
     void registerExternalReceiver(const char *receiverName);
     void unregisterExternalReceiver(const char *receiverName);
   
+    /** Passes a message sent to a registered external receiver to the host. */
+    void sendMessageToExternalReceiver(const char *receiverName, PdMessage *message);
+  
     /** User-provided data associated with the callback function. */
     void *callbackUserData;
   
@@ -220,6 +295,30 @@ class PdContext {
     void unregisterExternalObject(const char *objectLabel);
   
     BufferPool *getBufferPool() { return bufferPool; }
+  
+    /**
+     * Ensures that the signal buffers of the pool can hold a block of the given size, as required by
+     * a reblocked graph. If the buffers are resized, all attached graphs are recompiled.
+     */
+    void reserveBlockSize(int blockSize);
+  
+    /** Returns the allocator which assigns the signal buffers once the process order is computed. */
+    DspBufferAllocator *getBufferAllocator() { return bufferAllocator; }
+  
+    /** Returns the compiled process order of all attached graphs. */
+    DspExecutionPlan *getExecutionPlan() { return executionPlan; }
+  
+    /** Returns the scheduler which processes the execution plan in parallel, or NULL if DSP is serial. */
+    DspParallelScheduler *getParallelScheduler() { return parallelScheduler; }
+  
+    /** Returns the pool from which messages are allocated while the context is processed. */
+    MessagePool *getMessagePool() { return messagePool; }
+  
+    /** Returns the queue of messages sent to named receivers from outside of the context. */
+    ExternalMessageQueue *getExternalMessageQueue() { return externalMessageQueue; }
+  
+    /** Returns the worker which performs disk I/O for the objects of this context. */
+    DiskWorker *getDiskWorker() { return diskWorker; }
 
     PdAbstractionDataBase *getAbstractionDataBase();
   
@@ -228,6 +327,35 @@ class PdContext {
     bool configureEmptyGraphWithParser(PdGraph *graph, PdFileParser *fileParser);
   
     void initObjectInitMap();
+  
+    /**
+     * Assigns the signal buffers once the execution plan has changed. If DSP is parallel, the plan
+     * is rescheduled first.
+     */
+    void compileDsp();
+  
+    /** Recompiles the graphs which have been invalidated in the execution plan, if any. */
+    void updateDsp();
+  
+    /**
+     * Determines which [dac~] inlet overwrites each output channel, being the first to write it in
+     * every block. Any other inlet writing the channel adds to it. A channel which is first written
+     * by a [dac~] which may not be processed in every block, e.g. in a graph with [switch~], is
+     * cleared before each block. Channels which are not written at all remain silent.
+     */
+    void compileDspOutputs();
+  
+    /**
+     * Returns <code>true</code> if output meant for the host should be queued rather than passed to
+     * the callback function, i.e. if polling is enabled and the calling thread is processing the context.
+     */
+    bool isOutputPolled();
+  
+    /** Prints a line printed on a worker of the parallel scheduler, on the processing thread. */
+    static void *printWorkerOutput(ZGCallbackFunction function, void *userData, void *ptr);
+  
+    /** Schedules a message taken from the external message queue for its named receivers. */
+    static void receiveExternalMessage(void *context, const char *receiverName, PdMessage *message);
 
     int numInputChannels;
     int numOutputChannels;
@@ -244,6 +372,9 @@ class PdContext {
     /** A thread lock used to access critical sections of this context. */
     pthread_mutex_t contextLock;
 #endif
+  
+    /** The number of times that the context lock is held by the thread holding it. */
+    unsigned int lockDepth;
 
     int numBytesInInputBuffers;
     int numBytesInOutputBuffers;
@@ -251,9 +382,15 @@ class PdContext {
     float *globalDspInputBuffers;
     float *globalDspOutputBuffers;
   
+    /** The output channels which must be cleared before each block. */
+    vector<int> clearedOutputChannels;
+  
     /** A message queue keeping track of all scheduled messages. */
     OrderedMessageQueue *messageCallbackQueue;
   
+    /** Messages sent to named receivers from any thread, which are scheduled at the start of each block. */
+    ExternalMessageQueue *externalMessageQueue;
+  
     /** The start of the current block in milliseconds. */
     double blockStartTimestamp;
     
@@ -263,34 +400,46 @@ class PdContext {
     /** The global send controller. */
     MessageSendController *sendController;
   
-    /** A global list of all [send~] objects. */
-    list<DspSend *> dspSendList;
-    
-    /** A global list of all [receive~] objects. */
-    map<string, list<DspReceive *> > dspReceiveMap;
-    
-    /** A global list of all [delwrite~] objects. */
-    list<DspDelayWrite *> delaylineList;
-    
-    /** A global list of all [delread~] and [vd~] objects. */
-    list<DelayReceiver *> delayReceiverList;
+    /** A global registry of all [send~] objects and their associated [receive~]s. */
+    NameRegistry<DspSend, DspReceive> dspSendRegistry;
     
-    /** A global list of all [throw~] objects. */
-    list<DspThrow *> throwList;
+    /** A global registry of all [delwrite~] objects and their associated [delread~]s and [vd~]s. */
+    NameRegistry<DspDelayWrite, DelayReceiver> delaylineRegistry;
     
-    /** A global list of all [catch~] objects. */
-    list<DspCatch *> catchList;
+    /** A global registry of all [catch~] objects and their associated [throw~]s. */
+    NameRegistry<DspCatch, DspThrow> dspCatchRegistry;
     
-    /** A global list of all [table] objects. */
-    list<MessageTable *> tableList;
-    
-    /** A global list of all table receivers (e.g., [tabread4~] and [tabplay~]) */
-    list<TableReceiverInterface *> tableReceiverList;
+    /** A global registry of all [table] objects and their associated table receivers (e.g., [tabread4~] and [tabplay~]). */
+    NameRegistry<MessageTable, TableReceiverInterface> tableRegistry;
   
     ObjectFactoryMap *objectFactoryMap;
   
     BufferPool *bufferPool;
   
+    DspBufferAllocator *bufferAllocator;
+  
+    DspExecutionPlan *executionPlan;
+  
+    DspParallelScheduler *parallelScheduler;
+  
+    bool fusionEnabled;
+  
+    DiskWorker *diskWorker;
+  
+    /** Output meant for the host, queued while the context is processed if polling is enabled. */
+    OutboundMessageQueue *outboundMessageQueue;
+    bool messagePollingEnabled;
+  
+    /** The number of dropped entries of the outbound queue which have been reported to the host. */
+    unsigned int numOutboundDroppedReported;
+  
+    uint32_t randomSeed;
+  
+    /** The number of random generators which have been seeded since the seed was set. */
+    uint32_t numRandomSeeds;
+  
+    MessagePool *messagePool;
+  
     /** A global map storing values for Value objects. */
     map<string,float> valueMap;
 
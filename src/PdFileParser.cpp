@@ -20,6 +20,7 @@
  *
  */
 
+#include "MessageBlock.h"
 #include "MessageFloat.h"
 #include "MessageMessageBox.h"
 #include "MessageSymbol.h"
@@ -114,14 +115,56 @@ string PdFileParser::nextLine() {
 
 #pragma mark - execute
 
+#define OBJECT_LABEL_RESOLUTION_BUFFER_LENGTH 32
+#define RESOLUTION_BUFFER_LENGTH 512
+#define INIT_MESSAGE_MAX_ELEMENTS 32
+
+void PdFileParser::configureBlockSize(PdGraph *graph) {
+  size_t savedPos = pos;
+  string savedLine = line;
+  bool savedIsDone = isDone;
+  
+  int depth = 0; // the depth of nested subpatches below the graph
+  string message;
+  while (!(message = nextMessage()).empty()) {
+    char line[message.size()+1];
+    strncpy(line, message.c_str(), sizeof(line));
+    char *hashType = strtok(line, " ");
+    char *objectType = strtok(NULL, " ;\r");
+    if (hashType == NULL || objectType == NULL) continue;
+    if (!strcmp(hashType, "#N") && !strcmp(objectType, "canvas")) {
+      depth++;
+    } else if (!strcmp(hashType, "#X") && !strcmp(objectType, "restore")) {
+      if (depth-- == 0) break; // the end of the graph has been reached
+    } else if (depth == 0 && !strcmp(hashType, "#X") && !strcmp(objectType, "obj")) {
+      strtok(NULL, " "); // skip the canvas coordinates
+      strtok(NULL, " ");
+      char *objectLabel = strtok(NULL, " ;\r");
+      if (objectLabel != NULL &&
+          (!strcmp(objectLabel, "block~") || !strcmp(objectLabel, "switch~"))) {
+        char *objectInitString = strtok(NULL, ";\r");
+        if (objectInitString != NULL) {
+          PdMessage *initMessage = PD_MESSAGE_ON_STACK(3);
+          char resBuffer[RESOLUTION_BUFFER_LENGTH];
+          initMessage->initWithSARb(3, objectInitString, graph->getArguments(),
+              resBuffer, RESOLUTION_BUFFER_LENGTH);
+          if (initMessage->isFloat(0)) MessageBlock::setBlockSizeWithMessage(graph, initMessage, 0);
+        }
+        break;
+      }
+    }
+  }
+  
+  pos = savedPos;
+  line = savedLine;
+  isDone = savedIsDone;
+}
+
 PdGraph *PdFileParser::execute(PdContext *context) {
   return execute(NULL, NULL, context, true);
 }
 
 PdGraph *PdFileParser::execute(PdMessage *initMsg, PdGraph *graph, PdContext *context, bool isSubPatch) {
-#define OBJECT_LABEL_RESOLUTION_BUFFER_LENGTH 32
-#define RESOLUTION_BUFFER_LENGTH 512
-#define INIT_MESSAGE_MAX_ELEMENTS 32
   PdMessage *initMessage = PD_MESSAGE_ON_STACK(INIT_MESSAGE_MAX_ELEMENTS);
   
   string message;
@@ -169,6 +212,7 @@ PdGraph *PdFileParser::execute(PdMessage *initMsg, PdGraph *graph, PdContext *co
         
         // the new graph is pushed onto the stack
         graph = newGraph;
+        if (graph->getParentGraph() != NULL) configureBlockSize(graph);
     } else {
         context->printErr("Unrecognised #N object type: \"%s\".", line);
       }
@@ -270,7 +314,7 @@ PdGraph *PdFileParser::execute(PdMessage *initMsg, PdGraph *graph, PdContext *co
         // set environment for loading patch
         char *objectInitString = strtok(NULL, ";"); // get the arguments to declare
         initMessage->initWithString(0.0, 2, objectInitString); // parse them
-        if (initMessage->isSymbol(0, "-path")) {
+        if (initMessage->isSymbol(0, SYMBOL_FLAG_PATH)) {
           if (initMessage->isSymbol(1)) {
             // add symbol to declare directories
             graph->addDeclarePath(initMessage->getSymbol(1));
@@ -51,6 +51,13 @@ class PdFileParser {
 
   private:
     PdGraph *execute(PdMessage *initMsg, PdGraph *graph, PdContext *context, bool isSubPatch);
+  
+    /**
+     * Looks ahead for a [block~] or [switch~] object in the graph whose contents are about to be
+     * parsed, and applies its arguments to the graph. The objects of the graph thus see the block
+     * size of the graph when they are created. The position of the parser is not changed.
+     */
+    void configureBlockSize(PdGraph *graph);
 
     /**
      * Returns the next logical message in the file, or <code>NULL</code> if the end of the file
@@ -20,7 +20,10 @@
  *
  */
 
+#include "BufferPool.h"
 #include "DeclareList.h"
+#include "DspExecutionPlan.h"
+#include "DspFusedChain.h"
 #include "DspImplicitAdd.h"
 #include "DspInlet.h"
 #include "DspOutlet.h"
@@ -53,7 +56,15 @@ PdGraph::PdGraph(PdMessage *initMessage, PdGraph *parentGraph, PdContext *contex
   // all graphs start out unattached to any context, though they exist in a context
   isAttachedToContext = false;
   switched = true; // graphs are switched on by default
+  switchable = false;
   processFunction = &processGraph;
+  overlap = 1;
+  resampleFactor = 1.0f;
+  isReblockedGraph = false;
+  numSamplesPerParentBlock = blockSizeInt;
+  numSamplesInHop = 0;
+  overlapIndex = 0;
+  blockStartIndex = 0.0;
       
   // initialise the graph arguments
   this->graphId = graphId;
@@ -70,12 +81,13 @@ PdGraph::~PdGraph() {
   graphArguments->freeMessage();
   delete declareList;
 
-  // remove all implicit +~~ objects
+  // remove all implicit +~~ objects and fused chains
   for (list<DspObject *>::iterator it = dspNodeList.begin(); it != dspNodeList.end(); ++it) {
     DspObject *dspObject = *it;
     
     if (dspObject->getGraph() != this) break;
-    if (!strcmp(dspObject->toString().c_str(), DspImplicitAdd::getObjectLabel())) {
+    if (dspObject->getObjectType() == DSP_FUSED_CHAIN ||
+        !strcmp(dspObject->toString().c_str(), DspImplicitAdd::getObjectLabel())) {
       delete dspObject;
     }
   }
@@ -115,11 +127,13 @@ void PdGraph::addObject(float canvasX, float canvasY, MessageObject *messageObje
     case MESSAGE_INLET:
     case DSP_INLET: {
       addLetObjectToLetList(messageObject, canvasX, &inletList);
+      if (isReblockedGraph) updateLetReblocking();
       break;
     }
     case MESSAGE_OUTLET:
     case DSP_OUTLET: {
       addLetObjectToLetList(messageObject, canvasX, &outletList);
+      if (isReblockedGraph) updateLetReblocking();
       break;
     }
     default: {
@@ -131,6 +145,11 @@ void PdGraph::addObject(float canvasX, float canvasY, MessageObject *messageObje
     }
   }
   
+  // a new dsp object is only processed once it has been ordered
+  if (isAttachedToContext && messageObject->doesProcessAudio()) {
+    context->getExecutionPlan()->invalidateGraph(this);
+  }
+  
   unlockContextIfAttached();
 }
 
@@ -176,8 +195,10 @@ void PdGraph::removeObject(MessageObject *object) {
       // remove the object from any special lists if it is in any of them (e.g., receive, throw~, etc.)
       unregisterObject(object);
       
-      // delete the object
+      // delete the object. The execution plan no longer refers to it once the graph is recompiled,
+      // which happens before the context is unlocked.
       delete object;
+      if (isAttachedToContext) context->getExecutionPlan()->invalidateGraph(this);
       
       break;
     } else {
@@ -364,6 +385,16 @@ char *PdGraph::resolveFullPath(const char *filename) {
   }
 }
 
+char *PdGraph::resolveWritePath(const char *filename) {
+  if (DeclareList::isFullPath(filename)) {
+    return StaticUtils::copyString(filename);
+  } else if (declareList->getIterator() != declareList->getEnd()) {
+    return StaticUtils::concatStrings(declareList->getRootPath(), filename);
+  } else {
+    return isRootGraph() ? StaticUtils::copyString(filename) : parentGraph->resolveWritePath(filename);
+  }
+}
+
 string PdGraph::findFilePath(const char *filename) {
   for (list<string>::iterator it = declareList->getIterator(); it != declareList->getEnd(); ++it) {
     string directory = *it;
@@ -421,7 +452,6 @@ void PdGraph::processGraph(DspObject *dspObject, int fromIndex, int toIndex) {
     // process all dsp objects
     // DSP processing elements are only executed if the graph is switched on
     
-    // TODO(mhroth): iterate depending on local blocksize relative to parent
     // execute all nodes which process audio
     for (list<DspObject *>::iterator it = d->dspNodeList.begin(); it != d->dspNodeList.end(); ++it) {
       DspObject *dspObject = *it;
@@ -430,6 +460,46 @@ void PdGraph::processGraph(DspObject *dspObject, int fromIndex, int toIndex) {
   }
 }
 
+void PdGraph::processReblockedGraph(DspObject *dspObject, int fromIndex, int toIndex) {
+  PdGraph *d = reinterpret_cast<PdGraph *>(dspObject);
+  
+  if (!d->switched) {
+    // a reblocked graph which is switched off outputs silence
+    for (vector<MessageObject *>::iterator it = d->outletList.begin(); it != d->outletList.end(); ++it) {
+      if ((*it)->getObjectType() == DSP_OUTLET) reinterpret_cast<DspOutlet *>(*it)->clearReblockedOutput();
+    }
+    return;
+  }
+  
+  int hopSize = d->blockSizeInt / d->overlap;
+  double parentBlockStartIndex = d->parentGraph->getBlockStartIndex() * d->resampleFactor;
+  int i = 0;
+  while (i < d->numSamplesPerParentBlock) {
+    int n = min(hopSize - d->numSamplesInHop, d->numSamplesPerParentBlock - i);
+    for (vector<MessageObject *>::iterator it = d->inletList.begin(); it != d->inletList.end(); ++it) {
+      if ((*it)->getObjectType() == DSP_INLET) reinterpret_cast<DspInlet *>(*it)->pushReblockedInput(i, n);
+    }
+    d->numSamplesInHop += n;
+    i += n;
+    
+    if (d->numSamplesInHop == hopSize) {
+      // the block ends with the last received sample. Its output is delayed such that each output
+      // sample is complete once it is read by the parent, i.e. by blockSize - min(hopSize, P) samples.
+      d->numSamplesInHop = 0;
+      d->blockStartIndex = parentBlockStartIndex + i - d->blockSizeInt;
+      d->overlapIndex = i - min(hopSize, d->numSamplesPerParentBlock);
+      for (list<DspObject *>::iterator it = d->dspNodeList.begin(); it != d->dspNodeList.end(); ++it) {
+        DspObject *dspObject = *it;
+        dspObject->processFunction(dspObject, 0, d->blockSizeInt);
+      }
+    }
+  }
+  
+  for (vector<MessageObject *>::iterator it = d->outletList.begin(); it != d->outletList.end(); ++it) {
+    if ((*it)->getObjectType() == DSP_OUTLET) reinterpret_cast<DspOutlet *>(*it)->popReblockedOutput();
+  }
+}
+
 
 #pragma mark - Add/Remove Connections (High Level)
 
@@ -447,11 +517,9 @@ void PdGraph::addConnection(MessageObject *fromObject, int outletIndex, MessageO
   toObject->addConnectionFromObjectToInlet(fromObject, outletIndex, inletIndex);
   fromObject->addConnectionToObjectFromOutlet(toObject, inletIndex, outletIndex);
   
-  // NOTE(mhroth): very heavy handed approach. Always recompute the process order when adding connections.
-  // In theory this function should check to see if a reordering is even necessary and then only make
-  // the appropriate changes. Usually a complete reevaluation shouldn't be necessary, and otherwise
-  // the use of a linked list to store the node list should make the reordering fast.
-  //  computeDeepLocalDspProcessOrder(); 
+  // the new connection may constrain the process order. The order of the attached graph is recomputed
+  // and its part of the execution plan recompiled before the context is unlocked.
+  if (isAttachedToContext) context->getExecutionPlan()->invalidateGraph(this);
   
   unlockContextIfAttached();
 }
@@ -468,14 +536,15 @@ void PdGraph::addConnection(int fromObjectIndex, int outletIndex, int toObjectIn
 }
 
 /*
- * removeConnection does not force a reordering of the dspNodeList, as lost connections do not create
- * any new constraints on the dsp object ordering that weren't there already. addConnection does
- * force a reevaluation, as the new connection may force a new constrained how how objects are ordered.
+ * Lost connections do not create any new constraints on the dsp object ordering that weren't there
+ * already. The graph is nonetheless recompiled, such that inlets which have lost their last signal
+ * connection are reassigned the zero buffer.
  */
 void PdGraph::removeConnection(MessageObject *fromObject, int outletIndex, MessageObject *toObject, int inletIndex) {
   lockContextIfAttached();
   toObject->removeConnectionFromObjectToInlet(fromObject, outletIndex, inletIndex);
   fromObject->removeConnectionToObjectFromOutlet(toObject, inletIndex, outletIndex);
+  if (isAttachedToContext) context->getExecutionPlan()->invalidateGraph(this);
   unlockContextIfAttached();
 }
 
@@ -678,10 +747,11 @@ void PdGraph::computeDeepLocalDspProcessOrder() {
     }
   }
   
-  // remove all +~~ objects
+  // remove all +~~ objects and fused chains
   for (list<DspObject *>::iterator it = dspNodeList.begin(); it != dspNodeList.end(); ++it) {
     DspObject *dspObject = *it;
-    if (!strcmp(dspObject->toString().c_str(), DspImplicitAdd::getObjectLabel())) {
+    if (dspObject->getObjectType() == DSP_FUSED_CHAIN ||
+        !strcmp(dspObject->toString().c_str(), DspImplicitAdd::getObjectLabel())) {
       delete dspObject;
     }
   }
@@ -695,6 +765,8 @@ void PdGraph::computeDeepLocalDspProcessOrder() {
     dspNodeList.splice(dspNodeList.end(), processSubList);
   }
   
+  if (context->isFusionEnabled()) DspFusedChain::fuseChains(&dspNodeList, this);
+  
   /* print out process order of local dsp objects (for debugging) */
   /*
   if (!dspNodeList.empty()) {
@@ -712,6 +784,20 @@ void PdGraph::computeDeepLocalDspProcessOrder() {
   unlockContextIfAttached();
 }
 
+void PdGraph::getDeepDspProcessOrder(vector<DspObject *> *processOrder) {
+  for (list<DspObject *>::iterator it = dspNodeList.begin(); it != dspNodeList.end(); ++it) {
+    DspObject *dspObject = *it;
+    if (dspObject->getObjectType() == OBJECT_PD) {
+      PdGraph *graph = reinterpret_cast<PdGraph *>(dspObject);
+      graph->getDeepDspProcessOrder(processOrder);
+      // a reblocked graph reads its inlets until all of its objects have been processed
+      if (graph->isReblocked()) processOrder->push_back(graph);
+    } else {
+      processOrder->push_back(dspObject);
+    }
+  }
+}
+
 #pragma mark - Print
 
 void PdGraph::printErr(const char *msg, ...) {
@@ -740,12 +826,18 @@ void PdGraph::printStd(const char *msg, ...) {
 
 double PdGraph::getBlockIndex(PdMessage *message) {
   // sampleRate is in samples/second, but we need samples/millisecond
-  return (message->getTimestamp() - context->getBlockStartTimestamp()) * 0.001 * context->getSampleRate();
+  return (message->getTimestamp() - context->getBlockStartTimestamp()) * 0.001 * getSampleRate() -
+      getBlockStartIndex();
+}
+
+double PdGraph::getBlockStartIndex() {
+  if (isReblockedGraph) return blockStartIndex;
+  return (parentGraph == NULL) ? 0.0 : parentGraph->getBlockStartIndex();
 }
 
 float PdGraph::getSampleRate() {
-  // there is no such thing as a local sample rate. Return the sample rate of the context.
-  return context->getSampleRate();
+  // the sample rate of a graph only differs from that of its parent if it is resampled
+  return ((parentGraph == NULL) ? context->getSampleRate() : parentGraph->getSampleRate()) * resampleFactor;
 }
 
 int PdGraph::getGraphId() {
@@ -796,13 +888,86 @@ bool PdGraph::doesProcessAudio() {
   return !dspNodeList.empty();
 }
 
-void PdGraph::setBlockSize(int blockSize) {
-  // only update blocksize if it is <= the parent's
-  if (blockSize <= parentGraph->getBlockSize()) {
-    // TODO(mhroth)
-    blockSizeInt = blockSize;
-    // update blockDurationMs, etc.
-    // notify all dsp objects and get them to resize their buffers accordingly
+void PdGraph::setBlockSize(int blockSize, int overlap, float resampleFactor) {
+  if (parentGraph == NULL) {
+    printErr("[block~] and [switch~] cannot reblock a top-level graph. The context's block size "
+        "of %i is used.", blockSizeInt);
+    return;
+  }
+  int parentBlockSize = parentGraph->getBlockSize();
+  if (blockSize <= 0) blockSize = parentBlockSize;
+  if (overlap <= 0) overlap = 1;
+  if (resampleFactor <= 0.0f) resampleFactor = 1.0f;
+  int numSamples = (int) (parentBlockSize * resampleFactor);
+  if (blockSize % overlap != 0 || numSamples < 1 || numSamples != parentBlockSize * resampleFactor) {
+    printErr("The block size %i, overlap %i and resampling factor %g are not compatible with the "
+        "parent block size of %i. The graph is not reblocked.", blockSize, overlap, resampleFactor,
+        parentBlockSize);
+    return;
+  }
+  if ((blockSize & (blockSize-1)) != 0 || blockSize > BUFFER_POOL_MAX_BUFFER_SIZE) {
+    printErr("The block size %i is not a power of two of at most %i. The graph is not reblocked.",
+        blockSize, BUFFER_POOL_MAX_BUFFER_SIZE);
+    return;
+  }
+  // the hops must line up with the parent's blocks, such that each hop ends within a parent block
+  int hopSize = blockSize / overlap;
+  if (hopSize % numSamples != 0 && numSamples % hopSize != 0) {
+    printErr("The hop size %i is neither a divisor nor a multiple of the parent block of %i "
+        "samples. The graph is not reblocked.", hopSize, numSamples);
+    return;
+  }
+  // the arguments of [block~] are applied when the graph is created, and again by the object
+  if (blockSize == blockSizeInt && overlap == this->overlap && resampleFactor == this->resampleFactor) return;
+  
+  // objects size their buffers, delay lines and FFT plans for the block size and sample rate of
+  // their graph when they are created, so only the overlap may change once the graph has contents
+  if ((blockSize != blockSizeInt || resampleFactor != this->resampleFactor) && hasDspContents()) {
+    printErr("The block size and resampling factor of a graph containing signal objects cannot be "
+        "changed. The graph keeps a block size of %i and a resampling factor of %g.", blockSizeInt,
+        this->resampleFactor);
+    return;
+  }
+  
+  lockContextIfAttached();
+  blockSizeInt = blockSize;
+  this->overlap = overlap;
+  this->resampleFactor = resampleFactor;
+  numSamplesPerParentBlock = numSamples;
+  numSamplesInHop = 0;
+  isReblockedGraph = (blockSize != parentBlockSize) || (overlap != 1) || (resampleFactor != 1.0f);
+  processFunction = isReblockedGraph ? &processReblockedGraph : &processGraph;
+  
+  // the signal buffers of the BufferPool must be able to hold a whole block of this graph
+  context->reserveBlockSize(blockSize);
+  updateLetReblocking();
+  if (isAttachedToContext) context->getExecutionPlan()->invalidateGraph(this);
+  unlockContextIfAttached();
+}
+
+bool PdGraph::hasDspContents() {
+  for (list<MessageObject *>::iterator it = nodeList.begin(); it != nodeList.end(); ++it) {
+    switch ((*it)->getObjectType()) {
+      case DSP_INLET:
+      case DSP_OUTLET: break; // follow the reblocking of the graph
+      default: if ((*it)->doesProcessAudio()) return true; break;
+    }
+  }
+  return false;
+}
+
+void PdGraph::updateLetReblocking() {
+  int parentBlockSize = (parentGraph == NULL) ? blockSizeInt : parentGraph->getBlockSize();
+  for (vector<MessageObject *>::iterator it = inletList.begin(); it != inletList.end(); ++it) {
+    if ((*it)->getObjectType() == DSP_INLET) {
+      reinterpret_cast<DspInlet *>(*it)->setReblocking(isReblockedGraph, blockSizeInt, resampleFactor);
+    }
+  }
+  for (vector<MessageObject *>::iterator it = outletList.begin(); it != outletList.end(); ++it) {
+    if ((*it)->getObjectType() == DSP_OUTLET) {
+      reinterpret_cast<DspOutlet *>(*it)->setReblocking(isReblockedGraph, blockSizeInt,
+          parentBlockSize, numSamplesPerParentBlock, resampleFactor);
+    }
   }
 }
 
@@ -845,3 +1010,7 @@ list<MessageObject *> PdGraph::getNodeList() {
 BufferPool *PdGraph::getBufferPool() {
   return context->getBufferPool();
 }
+
+MessagePool *PdGraph::getMessagePool() {
+  return context->getMessagePool();
+}
@@ -36,6 +36,7 @@ class DspSend;
 class DspThrow;
 class LetInterface;
 class MessageObject;
+class MessagePool;
 class MessageReceive;
 class MessageSend;
 class MessageTable;
@@ -82,6 +83,12 @@ class PdGraph : public DspObject {
 #pragma mark - Get/Set Buffers
     
     bool canSetBufferAtOutlet(unsigned int outletIndex) { return false; }
+  
+    /**
+     * A reblocked graph reads the buffers at its [inlet~]s while it is processed. They are therefore
+     * exposed as the inlets of the graph. Otherwise a graph has no dsp inlets of its own.
+     */
+    unsigned int getNumDspInlets() { return isReblockedGraph ? inletList.size() : 0; }
     void setDspBufferAtInlet(float *buffer, unsigned int inletIndex);
     void setDspBufferAtOutlet(float *buffer, unsigned int outletIndex);
     float *getDspBufferAtInlet(int inletIndex);
@@ -97,19 +104,73 @@ class PdGraph : public DspObject {
     ConnectionType getConnectionType(int outletIndex);
   
     bool doesProcessAudio();
+  
+    /** A reblocked graph is processed as a single object, which may contain any object. */
+    bool mustProcessSerially() { return true; }
     
     /** Turn the audio processing of this graph on or off. */
     void setSwitch(bool switched);
   
     /** Returns <code>true</code> if the audio processing of this graph is turned on. <code>false</code> otherwise. */
     bool isSwitchedOn();
+  
+    /** Marks this graph as one which may be switched off, i.e. which contains a [switch~]. */
+    void setSwitchable() { switchable = true; }
+  
+    /** Returns <code>true</code> if the audio processing of this graph may be turned off. */
+    bool isSwitchable() { return switchable; }
     
-    /** Set the current block size of this subgraph. */
-    void setBlockSize(int blockSize);
+    /**
+     * Set the block size of this subgraph, as with [block~] and [switch~]. The graph is processed
+     * once every <code>blockSize/overlap</code> of its own samples, each time on the last
+     * <code>blockSize</code> samples of its input. The output of successive blocks is overlapped and
+     * added. The <code>resampleFactor</code> (a power of two, e.g. 2 or 0.5) is the ratio of the
+     * sample rate of this graph to that of its parent. A graph whose block differs from that of its
+     * parent is reblocked. It is then processed as a single object which iterates over its own
+     * objects, and its [inlet~]s and [outlet~]s buffer the signals crossing it.
+     * Objects are created with the block size of their graph, so it must be set before any are added.
+     * <code>PdFileParser</code> therefore applies the arguments of [block~] and [switch~] objects
+     * when the graph is created. Once the graph contains signal objects, only the overlap can be
+     * changed, and a different block size or resampling factor is rejected with an error.
+     * The block size must be a power of two no larger than <code>BUFFER_POOL_MAX_BUFFER_SIZE</code>,
+     * and the hop must be a divisor or a multiple of the parent's block. Otherwise the graph is not
+     * reblocked.
+     */
+    void setBlockSize(int blockSize, int overlap, float resampleFactor);
     
     /** Get the current block size of this subgraph. */
     int getBlockSize();
   
+    /** Returns the number of overlapping blocks of this graph. */
+    int getOverlap() { return overlap; }
+  
+    /** Returns the ratio of the sample rate of this graph to that of its parent. */
+    float getResampleFactor() { return resampleFactor; }
+  
+    /**
+     * Returns <code>true</code> if this graph is processed with a different block, overlap or
+     * sample rate than its parent.
+     */
+    bool isReblocked() { return isReblockedGraph; }
+  
+    /**
+     * Returns the number of samples of this graph which correspond to one block of the parent. Only
+     * relevant if this graph is reblocked.
+     */
+    int getNumSamplesPerParentBlock() { return numSamplesPerParentBlock; }
+  
+    /**
+     * Returns the index at which the [outlet~]s of a reblocked graph add the current block to their
+     * overlap buffers.
+     */
+    int getOverlapIndex() { return overlapIndex; }
+  
+    /**
+     * Returns the index of the first sample of the current block of this graph, relative to the
+     * beginning of the current block of the context, in samples of this graph.
+     */
+    double getBlockStartIndex();
+  
     /** Returns <code>true</code> of this graph has no parents, code>false</code> otherwise. */
     bool isRootGraph();
   
@@ -146,6 +207,15 @@ class PdGraph : public DspObject {
     /** Computes the local tree and node processing ordering for dsp nodes, including subgraphs. */
     void computeDeepLocalDspProcessOrder();
   
+    /**
+     * Appends all <code>DspObject</code>s which are executed when this graph is processed to the
+     * given list, in the order in which they are executed. Subgraphs are expanded in place.
+     */
+    void getDeepDspProcessOrder(vector<DspObject *> *processOrder);
+  
+    /** Returns the local process order of this graph's dsp nodes. Subgraphs appear as single nodes. */
+    list<DspObject *> *getDspNodeList() { return &dspNodeList; }
+  
     /**
      * Get the process order as if this object (i.e. graph) were an atomic object. The internal
      * process order is not changed.
@@ -191,6 +261,13 @@ class PdGraph : public DspObject {
      */
     char *resolveFullPath(const char *filename);
   
+    /**
+     * Resolves the full path of a file which is to be written, and so need not exist. A relative
+     * path is taken to be relative to the directory of the graph, or of the closest parent graph
+     * which has one. The returned path SHOULD be freed by the caller.
+     */
+    char *resolveWritePath(const char *filename);
+  
     /**
      * Adds a full or partial path to the declare list. If it is a relative path, then it will be
      * resolved relative to the path of the abstraction. If this graph is a subgraph (not an
@@ -223,12 +300,26 @@ class PdGraph : public DspObject {
   
     BufferPool *getBufferPool();
   
+    MessagePool *getMessagePool();
+  
     /** Set the graph name. */
     void setName(string newName) { name = newName; }
   
   private:
     static void processGraph(DspObject *dspObject, int fromIndex, int toIndex);
   
+    /**
+     * Processes one block of the parent graph. The input is passed to the [inlet~]s in hops, and
+     * the graph is processed whenever a hop is complete.
+     */
+    static void processReblockedGraph(DspObject *dspObject, int fromIndex, int toIndex);
+  
+    /** Configures the [inlet~]s and [outlet~]s of this graph for the current block size. */
+    void updateLetReblocking();
+  
+    /** Returns true if this graph contains signal objects other than [inlet~]s and [outlet~]s. */
+    bool hasDspContents();
+  
     /** Create a new object based on its initialisation string. */
     MessageObject *newObject(char *objectType, char *objectLabel, PdMessage *initMessage, PdGraph *graph);
   
@@ -258,6 +349,23 @@ class PdGraph : public DspObject {
 
     /** True if the graph is switch on and should process audio. False otherwise. */
     bool switched;
+  
+    /** True if the graph contains a [switch~], such that it may be switched off. */
+    bool switchable;
+  
+    /** The number of overlapping blocks, and the ratio of this graph's sample rate to its parent's. */
+    int overlap;
+    float resampleFactor;
+  
+    bool isReblockedGraph;
+    int numSamplesPerParentBlock;
+  
+    /** The number of samples received since the graph was last processed, if it is reblocked. */
+    int numSamplesInHop;
+  
+    /** See <code>getOverlapIndex()</code> and <code>getBlockStartIndex()</code>. */
+    int overlapIndex;
+    double blockStartIndex;
     
     /** The parent graph. NULL if this graph is the root. */
     PdGraph *parentGraph;
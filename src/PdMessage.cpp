@@ -29,7 +29,7 @@ void PdMessage::initWithSARb(unsigned int maxElements, char *initString, PdMessa
   initWithString(0.0, maxElements, buffer);
 }
 
-void PdMessage::initWithString(double ts, unsigned int maxElements, char *initString) {
+void PdMessage::initWithString(double ts, unsigned int maxElements, char *initString, bool internSymbols) {
   timestamp = ts;
   
   char *token = strtok(initString, " ;");  
@@ -38,20 +38,22 @@ void PdMessage::initWithString(double ts, unsigned int maxElements, char *initSt
   } else {
     unsigned int i = 0;
     do {
-      parseAndSetMessageElement(i++, token);
+      parseAndSetMessageElement(i++, token, internSymbols);
     } while (((token = strtok(NULL, " ;")) != NULL) && (i < maxElements));
     
     numElements = i;
   }
 }
 
-void PdMessage::parseAndSetMessageElement(unsigned int index, char *token) {
+void PdMessage::parseAndSetMessageElement(unsigned int index, char *token, bool internSymbols) {
   if (StaticUtils::isNumeric(token)) {
     setFloat(index, atof(token)); // element is a float
   } else if (!strcmp("!", token) || !strcmp("bang", token)) {
     setBang(index); // element is a bang
-  } else {
+  } else if (internSymbols) {
     setSymbol(index, token); // element is symbolic
+  } else {
+    setUninternedSymbol(index, token);
   }
 }
 
@@ -136,15 +138,15 @@ unsigned int PdMessage::numBytes() {
 void PdMessage::resolveSymbolsToType() {
   for (int i = 0; i < numElements; i++) {
     if (isSymbol(i)) {
-      if (isSymbol(i, "symbol") || isSymbol(i, "s")) {
+      if (isSymbol(i, SYMBOL_SYMBOL) || isSymbol(i, SYMBOL_S)) {
         // do nothing, but leave the symbol as is
-      } else if (isSymbol(i, "anything") || isSymbol(i, "a")) {
+      } else if (isSymbol(i, SYMBOL_ANYTHING) || isSymbol(i, SYMBOL_A)) {
         setAnything(i);
-      } else if (isSymbol(i, "bang") || isSymbol(i, "b")) {
+      } else if (isSymbol(i, SYMBOL_BANG) || isSymbol(i, SYMBOL_B)) {
         setBang(i);
-      } else if (isSymbol(i, "float") || isSymbol(i, "f")) {
+      } else if (isSymbol(i, SYMBOL_FLOAT) || isSymbol(i, SYMBOL_F)) {
         setFloat(i, 0.0f);
-      } else if (isSymbol(i, "list") || isSymbol(i, "l")) {
+      } else if (isSymbol(i, SYMBOL_LIST) || isSymbol(i, SYMBOL_L)) {
         setList(i);
       } else {
         // if the symbol string is unknown, leave is as ANYTHING
@@ -167,7 +169,7 @@ bool PdMessage::atomIsEqualTo(unsigned int index, MessageAtom *messageAtom) {
   if (atom->type == messageAtom->type) {
     switch (atom->type) {
       case FLOAT: return (atom->constant == messageAtom->constant);
-      case SYMBOL: return !strcmp(atom->symbol, messageAtom->symbol);
+      case SYMBOL: return (atom->symbol == messageAtom->symbol);
       case BANG: return true;
       default: return false;
     }
@@ -206,12 +208,18 @@ void PdMessage::initWithTimestampAndBang(double aTimestamp) {
   setBang(0);
 }
 
-void PdMessage::initWithTimestampAndSymbol(double aTimestamp, char *symbol) {
+void PdMessage::initWithTimestampAndSymbol(double aTimestamp, const char *symbol) {
   timestamp = aTimestamp;
   numElements = 1;
   setSymbol(0, symbol);
 }
 
+void PdMessage::initWithTimestampAndAtom(double aTimestamp, MessageAtom *atom) {
+  timestamp = aTimestamp;
+  numElements = 1;
+  messageAtom = *atom;
+}
+
 
 #pragma mark -
 #pragma mark isElement
@@ -236,7 +244,7 @@ bool PdMessage::isSymbol(unsigned int index, const char *test) {
   if (index < numElements) {
     MessageAtom messageElement = (&messageAtom)[index];
     if (messageElement.type == SYMBOL) {
-      return !strcmp(messageElement.symbol, test);
+      return (messageElement.symbol == test);
     } else {
       return false;
     }
@@ -292,7 +300,12 @@ char *PdMessage::getSymbol(unsigned int index) {
   return (&messageAtom)[index].symbol;
 }
 
-void PdMessage::setSymbol(unsigned int index, char *symbol) {
+void PdMessage::setSymbol(unsigned int index, const char *symbol) {
+  (&messageAtom)[index].type = SYMBOL;
+  (&messageAtom)[index].symbol = SymbolTable::intern(symbol);
+}
+
+void PdMessage::setUninternedSymbol(unsigned int index, char *symbol) {
   (&messageAtom)[index].type = SYMBOL;
   (&messageAtom)[index].symbol = symbol;
 }
@@ -316,22 +329,16 @@ void PdMessage::setList(unsigned int index) {
 #pragma mark - copy/free
 
 PdMessage *PdMessage::copyToHeap() {
-  PdMessage *pdMessage = (PdMessage *) malloc(numBytes());
-  memcpy(pdMessage, this, numBytes()); // copy entire structure (but symbol pointers must be replaced)
-  for (int i = 0; i < numElements; i++) {
-    if (isSymbol(i)) {
-      pdMessage->setSymbol(i, StaticUtils::copyString(getSymbol(i)));
-    }
-  }
-  return pdMessage;
+  return copyTo(malloc(numBytes()));
+}
+
+PdMessage *PdMessage::copyTo(void *buffer) {
+  // symbols are interned, so the symbol pointers can be copied along with the rest of the structure
+  memcpy(buffer, this, numBytes());
+  return (PdMessage *) buffer;
 }
 
 void PdMessage::freeMessage() {
-  for (int i = 0; i < numElements; i++) {
-    if (isSymbol(i)) {
-      free(getSymbol(i));
-    }
-  }
   free(this);
 }
 
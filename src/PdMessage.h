@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "MessageElementType.h"
+#include "SymbolTable.h"
 
 #define PD_MESSAGE_ON_STACK(_x) ((PdMessage *) alloca(PdMessage::numBytes(_x)));
 
@@ -67,7 +68,13 @@ class PdMessage {
     void initWithTimestampAndNumElements(double aTimestamp, unsigned int numElem);
     void initWithTimestampAndFloat(double aTimestamp, float constant);
     void initWithTimestampAndBang(double aTimestamp);
-    void initWithTimestampAndSymbol(double aTimestamp, char *symbol);
+    void initWithTimestampAndSymbol(double aTimestamp, const char *symbol);
+  
+    /**
+     * Initialise the message with a copy of the given atom. As symbols in an existing atom are
+     * already interned, this is cheaper than <code>initWithTimestampAndSymbol()</code>.
+     */
+    void initWithTimestampAndAtom(double aTimestamp, MessageAtom *atom);
   
     /**
      * Initialise the message with a string, arguments, and a resolution buffer. The string will
@@ -82,14 +89,18 @@ class PdMessage {
      * Adds elements to the message by tokenizing the given string. If a token is numeric then it is
      * automatically resolved to a float. Otherwise the string is interpreted as a symbol. Note that
      * the <code>initString</code> is tokenized and should be provided in a buffer which may be edited. 
+     * Unless <code>internSymbols</code> is set, symbols point into the tokenized buffer (see
+     * <code>setUninternedSymbol()</code>).
      */
-    void initWithString(double timestamp, unsigned int maxElements, char *initString);
+    void initWithString(double timestamp, unsigned int maxElements, char *initString,
+        bool internSymbols = true);
   
     /** Sets the given message element to a FLOAT or SYMBOL depending on contents of string. */
-    void parseAndSetMessageElement(unsigned int index, char *initString);
+    void parseAndSetMessageElement(unsigned int index, char *initString, bool internSymbols = true);
   
     MessageAtom *getElement(unsigned int index);
   
+    /** Compares a message element to an atom. Symbols are compared by their interned pointers. */
     bool atomIsEqualTo(unsigned int index, MessageAtom *messageAtom);
   
     int getNumElements();
@@ -102,12 +113,18 @@ class PdMessage {
   
     /**
      * Returns a copy of the message to the heap. Messages usually only exist temporarily on the
-     * stack and should be copied to the heap if it should persist. Symbol pointers are copied
-     * independently to the heap.
+     * stack and should be copied to the heap if it should persist. Symbols are interned and are
+     * therefore shared with the original message.
      */
     PdMessage *copyToHeap();
   
-    /** The message memory is freed from the heap, including symbols. */
+    /**
+     * Copies the message into the given <code>buffer</code>, which must be at least
+     * <code>numBytes()</code> long. The copy must not be released with <code>freeMessage()</code>.
+     */
+    PdMessage *copyTo(void *buffer);
+  
+    /** The message memory is freed from the heap. Interned symbols are not affected. */
     void freeMessage();
     
     /**
@@ -119,6 +136,12 @@ class PdMessage {
     /** Convenience function to determine if a particular message element is a float. */
     bool isFloat(unsigned int index);
     bool isSymbol(unsigned int index);
+  
+    /**
+     * Determines if a message element is the symbol <code>test</code>, which must be interned (e.g.
+     * one of the <code>SYMBOL_</code> constants declared in SymbolTable.h). Symbols are compared by
+     * pointer only.
+     */
     bool isSymbol(unsigned int index, const char *test);
     bool isBang(unsigned int index);
     bool hasFormat(const char *format);
@@ -137,7 +160,19 @@ class PdMessage {
      * for the existence of a message element.
      */
     void setFloat(unsigned int index, float value);
-    void setSymbol(unsigned int index, char *symbol);
+  
+    /**
+     * Sets a message element to the interned copy of the given symbol. The message does not retain
+     * the given string, which may therefore be a temporary buffer.
+     */
+    void setSymbol(unsigned int index, const char *symbol);
+  
+    /**
+     * Sets a message element to the given string without interning it, such that the symbol table
+     * is not locked. The string must outlive the message, and the symbols of the message must be
+     * interned before it is sent to an object (see <code>ExternalMessageQueue</code>).
+     */
+    void setUninternedSymbol(unsigned int index, char *symbol);
     void setBang(unsigned int index);
     void setAnything(unsigned int index);
     void setList(unsigned int index);
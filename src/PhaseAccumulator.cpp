@@ -0,0 +1,292 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <math.h>
+#include "PhaseAccumulator.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#define PHASE_ACCUMULATOR_SIMD 1
+typedef __m128 v4sf;
+typedef __m128i v4si;
+#elif __ARM_NEON__
+#include <arm_neon.h>
+#define PHASE_ACCUMULATOR_SIMD 1
+typedef float32x4_t v4sf;
+typedef uint32x4_t v4si;
+#endif
+
+// 2^32 and 2^-32, the scale between a fixed-point phase and a fraction of a cycle
+#define PHASE_SCALE 4294967296.0f
+#define INVERSE_PHASE_SCALE 2.3283064365386963e-10f
+#define INVERSE_RAMP_SCALE 5.9604644775390625e-8f // 2^-24
+
+// Taylor coefficients of sin(2*pi*x), accurate to 6e-8 for |x| <= 1/4
+#define SIN_C1 6.283185307179586f
+#define SIN_C3 -41.341702240399755f
+#define SIN_C5 81.60524927607504f
+#define SIN_C7 -76.70585975306136f
+#define SIN_C9 42.058693944897634f
+#define SIN_C11 -15.094642576822984f
+
+#pragma mark - Scalar Operations
+
+// cos(2*pi*x) for |x| <= 1/2, evaluated as sin(2*pi*(1/4 - |x|))
+static inline float cosineOfCycles(float x) {
+  float y = 0.25f - fabsf(x);
+  float y2 = y * y;
+  return y * (SIN_C1 + y2 * (SIN_C3 + y2 * (SIN_C5 + y2 * (SIN_C7 + y2 * (SIN_C9 + y2 * SIN_C11)))));
+}
+
+// the signed fraction of a cycle, in [-1/2,1/2]. Large or invalid values are treated as zero.
+static inline float fraction(float x) {
+  return (fabsf(x) < 8388608.0f) ? x - rintf(x) : 0.0f;
+}
+
+static inline uint32_t phaseOfFraction(float x) {
+  return (uint32_t) (int64_t) llrintf(x * PHASE_SCALE);
+}
+
+static inline float cyclesOfPhase(uint32_t phase) {
+  return ((float) (int32_t) phase) * INVERSE_PHASE_SCALE;
+}
+
+static inline float rampOfPhase(uint32_t phase) {
+  return ((float) (phase >> 8)) * INVERSE_RAMP_SCALE;
+}
+
+#pragma mark - Vector Operations
+
+#if PHASE_ACCUMULATOR_SIMD
+#if __SSE2__
+static inline v4sf vloadu(const float *p) { return _mm_loadu_ps(p); }
+static inline void vstoreu(float *p, v4sf a) { _mm_storeu_ps(p, a); }
+static inline v4sf vset1(float f) { return _mm_set1_ps(f); }
+static inline v4sf vadd(v4sf a, v4sf b) { return _mm_add_ps(a, b); }
+static inline v4sf vsub(v4sf a, v4sf b) { return _mm_sub_ps(a, b); }
+static inline v4sf vmul(v4sf a, v4sf b) { return _mm_mul_ps(a, b); }
+static inline v4sf vabs(v4sf a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline v4si vseti(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+  return _mm_set_epi32((int) d, (int) c, (int) b, (int) a);
+}
+static inline v4si vset1i(uint32_t a) { return _mm_set1_epi32((int) a); }
+static inline v4si vaddi(v4si a, v4si b) { return _mm_add_epi32(a, b); }
+static inline v4si vsubi(v4si a, v4si b) { return _mm_sub_epi32(a, b); }
+static inline uint32_t vfirsti(v4si a) { return (uint32_t) _mm_cvtsi128_si32(a); }
+
+// the signed fraction of each cycle, as for fraction()
+static inline v4sf vfraction(v4sf x) {
+  v4sf f = _mm_sub_ps(x, _mm_cvtepi32_ps(_mm_cvtps_epi32(x)));
+  return _mm_and_ps(f, _mm_cmplt_ps(vabs(x), _mm_set1_ps(8388608.0f)));
+}
+
+// a fraction of 1/2 converts to 0x80000000, which is the correct phase modulo 2^32
+static inline v4si vphaseOfFraction(v4sf x) {
+  return _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(PHASE_SCALE)));
+}
+
+static inline v4sf vcyclesOfPhase(v4si p) {
+  return _mm_mul_ps(_mm_cvtepi32_ps(p), _mm_set1_ps(INVERSE_PHASE_SCALE));
+}
+
+static inline v4sf vrampOfPhase(v4si p) {
+  return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(p, 8)), _mm_set1_ps(INVERSE_RAMP_SCALE));
+}
+
+// the running sum of the four increments, and the total broadcast to all lanes
+static inline v4si vprefix(v4si inc, v4si *sum) {
+  v4si s = _mm_add_epi32(inc, _mm_slli_si128(inc, 4));
+  s = _mm_add_epi32(s, _mm_slli_si128(s, 8));
+  *sum = _mm_shuffle_epi32(s, _MM_SHUFFLE(3,3,3,3));
+  return s;
+}
+#elif __ARM_NEON__
+static inline v4sf vloadu(const float *p) { return vld1q_f32(p); }
+static inline void vstoreu(float *p, v4sf a) { vst1q_f32(p, a); }
+static inline v4sf vset1(float f) { return vdupq_n_f32(f); }
+static inline v4sf vadd(v4sf a, v4sf b) { return vaddq_f32(a, b); }
+static inline v4sf vsub(v4sf a, v4sf b) { return vsubq_f32(a, b); }
+static inline v4sf vmul(v4sf a, v4sf b) { return vmulq_f32(a, b); }
+static inline v4sf vabs(v4sf a) { return vabsq_f32(a); }
+static inline v4si vseti(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+  uint32_t v[4] = {a, b, c, d};
+  return vld1q_u32(v);
+}
+static inline v4si vset1i(uint32_t a) { return vdupq_n_u32(a); }
+static inline v4si vaddi(v4si a, v4si b) { return vaddq_u32(a, b); }
+static inline v4si vsubi(v4si a, v4si b) { return vsubq_u32(a, b); }
+static inline uint32_t vfirsti(v4si a) { return vgetq_lane_u32(a, 0); }
+
+// rounds to the nearest integer. ARMv7 rounds halves away from zero rather than to even.
+static inline int32x4_t vround(v4sf x) {
+  #if __aarch64__
+  return vcvtnq_s32_f32(x);
+  #else
+  uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(x), vdupq_n_u32(0x80000000));
+  v4sf half = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(vdupq_n_f32(0.5f)), sign));
+  return vcvtq_s32_f32(vaddq_f32(x, half));
+  #endif
+}
+
+static inline v4sf vfraction(v4sf x) {
+  v4sf f = vsubq_f32(x, vcvtq_f32_s32(vround(x)));
+  uint32x4_t mask = vcltq_f32(vabsq_f32(x), vdupq_n_f32(8388608.0f));
+  return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(f), mask));
+}
+
+// NEON saturates 2^31 to 0x7FFFFFFF, so a fraction of 1/2 is converted as -1/2 instead, i.e. to
+// 0x80000000 as on SSE2 and in the scalar tail
+static inline v4si vphaseOfFraction(v4sf x) {
+  v4sf y = vmulq_f32(x, vdupq_n_f32(PHASE_SCALE));
+  uint32x4_t isHalf = vcgeq_f32(y, vdupq_n_f32(2147483648.0f));
+  y = vbslq_f32(isHalf, vsubq_f32(y, vdupq_n_f32(PHASE_SCALE)), y);
+  return vreinterpretq_u32_s32(vround(y));
+}
+
+static inline v4sf vcyclesOfPhase(v4si p) {
+  return vmulq_f32(vcvtq_f32_s32(vreinterpretq_s32_u32(p)), vdupq_n_f32(INVERSE_PHASE_SCALE));
+}
+
+static inline v4sf vrampOfPhase(v4si p) {
+  return vmulq_f32(vcvtq_f32_u32(vshrq_n_u32(p, 8)), vdupq_n_f32(INVERSE_RAMP_SCALE));
+}
+
+static inline v4si vprefix(v4si inc, v4si *sum) {
+  v4si zero = vdupq_n_u32(0);
+  v4si s = vaddq_u32(inc, vextq_u32(zero, inc, 3));
+  s = vaddq_u32(s, vextq_u32(zero, s, 2));
+  *sum = vdupq_n_u32(vgetq_lane_u32(s, 3));
+  return s;
+}
+#endif
+
+static inline v4sf vcosineOfCycles(v4sf x) {
+  v4sf y = vsub(vset1(0.25f), vabs(x));
+  v4sf y2 = vmul(y, y);
+  v4sf p = vadd(vset1(SIN_C9), vmul(y2, vset1(SIN_C11)));
+  p = vadd(vset1(SIN_C7), vmul(y2, p));
+  p = vadd(vset1(SIN_C5), vmul(y2, p));
+  p = vadd(vset1(SIN_C3), vmul(y2, p));
+  p = vadd(vset1(SIN_C1), vmul(y2, p));
+  return vmul(y, p);
+}
+#endif // PHASE_ACCUMULATOR_SIMD
+
+#pragma mark - PhaseAccumulator
+
+uint32_t PhaseAccumulator::getIncrement(float frequency, float sampleRate) {
+  double x = ((double) frequency) / ((double) sampleRate);
+  if (isnan(x) || isinf(x)) return 0;
+  x -= floor(x);
+  return (uint32_t) (uint64_t) (x * 4294967296.0 + 0.5);
+}
+
+uint32_t PhaseAccumulator::getPhase(float cycles) {
+  return phaseOfFraction(fraction(cycles));
+}
+
+uint32_t PhaseAccumulator::cosine(uint32_t phase, uint32_t increment, float *output, int n) {
+  #if PHASE_ACCUMULATOR_SIMD
+  v4si p = vseti(phase, phase + increment, phase + 2*increment, phase + 3*increment);
+  v4si step = vset1i(4*increment);
+  for (; n >= 4; n -= 4, output += 4) {
+    vstoreu(output, vcosineOfCycles(vcyclesOfPhase(p)));
+    p = vaddi(p, step);
+  }
+  phase = vfirsti(p);
+  #endif
+  for (; n > 0; --n, phase += increment) {
+    *output++ = cosineOfCycles(cyclesOfPhase(phase));
+  }
+  return phase;
+}
+
+uint32_t PhaseAccumulator::cosine(uint32_t phase, float *frequency, float inverseSampleRate,
+    float *output, int n) {
+  #if PHASE_ACCUMULATOR_SIMD
+  v4si p = vset1i(phase);
+  v4sf scale = vset1(inverseSampleRate);
+  for (; n >= 4; n -= 4, frequency += 4, output += 4) {
+    v4si sum;
+    v4si increment = vphaseOfFraction(vfraction(vmul(vloadu(frequency), scale)));
+    v4si offset = vsubi(vprefix(increment, &sum), increment);
+    vstoreu(output, vcosineOfCycles(vcyclesOfPhase(vaddi(p, offset))));
+    p = vaddi(p, sum);
+  }
+  phase = vfirsti(p);
+  #endif
+  for (; n > 0; --n) {
+    // read the frequency before writing the output, as they may be the same buffer
+    uint32_t increment = phaseOfFraction(fraction(*frequency++ * inverseSampleRate));
+    *output++ = cosineOfCycles(cyclesOfPhase(phase));
+    phase += increment;
+  }
+  return phase;
+}
+
+uint32_t PhaseAccumulator::ramp(uint32_t phase, uint32_t increment, float *output, int n) {
+  #if PHASE_ACCUMULATOR_SIMD
+  v4si p = vseti(phase + increment, phase + 2*increment, phase + 3*increment, phase + 4*increment);
+  v4si step = vset1i(4*increment);
+  for (; n >= 4; n -= 4, output += 4) {
+    vstoreu(output, vrampOfPhase(p));
+    p = vaddi(p, step);
+  }
+  phase = vfirsti(p) - increment;
+  #endif
+  for (; n > 0; --n) {
+    phase += increment;
+    *output++ = rampOfPhase(phase);
+  }
+  return phase;
+}
+
+uint32_t PhaseAccumulator::ramp(uint32_t phase, float *frequency, float inverseSampleRate,
+    float *output, int n) {
+  #if PHASE_ACCUMULATOR_SIMD
+  v4si p = vset1i(phase);
+  v4sf scale = vset1(inverseSampleRate);
+  for (; n >= 4; n -= 4, frequency += 4, output += 4) {
+    v4si sum;
+    v4si offset = vprefix(vphaseOfFraction(vfraction(vmul(vloadu(frequency), scale))), &sum);
+    vstoreu(output, vrampOfPhase(vaddi(p, offset)));
+    p = vaddi(p, sum);
+  }
+  phase = vfirsti(p);
+  #endif
+  for (; n > 0; --n) {
+    phase += phaseOfFraction(fraction(*frequency++ * inverseSampleRate));
+    *output++ = rampOfPhase(phase);
+  }
+  return phase;
+}
+
+void PhaseAccumulator::cosine(float *input, float *output, int n) {
+  #if PHASE_ACCUMULATOR_SIMD
+  for (; n >= 4; n -= 4, input += 4, output += 4) {
+    vstoreu(output, vcosineOfCycles(vfraction(vloadu(input))));
+  }
+  #endif
+  for (; n > 0; --n) {
+    *output++ = cosineOfCycles(fraction(*input++));
+  }
+}
@@ -0,0 +1,71 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _PHASE_ACCUMULATOR_H_
+#define _PHASE_ACCUMULATOR_H_
+
+#include <stdint.h>
+
+/**
+ * The oscillator core shared by [osc~], [phasor~] and [cos~]. The phase of an oscillator is a
+ * 32-bit unsigned fixed-point fraction of a cycle, such that it wraps around by integer overflow
+ * and never loses precision however long the oscillator runs. Cosine is computed directly from
+ * the phase with an 11th order polynomial, so that no lookup table is needed and every sample is
+ * accurate to within float rounding.
+ *
+ * All functions process four samples at a time with SSE2 or NEON, and finish with a scalar tail
+ * which computes exactly the same values. Buffers need not be aligned, and the input buffer may be
+ * the same as the output buffer. Functions which advance the phase return the phase following the
+ * last sample.
+ */
+class PhaseAccumulator {
+
+  public:
+    /** Returns the phase increment per sample of an oscillator of the given frequency. */
+    static uint32_t getIncrement(float frequency, float sampleRate);
+
+    /** Returns the phase of the given fraction of a cycle. Only the fractional part is used. */
+    static uint32_t getPhase(float cycles);
+
+    /** Writes <code>cos(2*pi*phase)</code> to the output, advancing the phase by a constant increment. */
+    static uint32_t cosine(uint32_t phase, uint32_t increment, float *output, int n);
+
+    /**
+     * Writes <code>cos(2*pi*phase)</code> to the output, advancing the phase by the frequency of
+     * each sample multiplied by <code>1/sampleRate</code>.
+     */
+    static uint32_t cosine(uint32_t phase, float *frequency, float inverseSampleRate, float *output, int n);
+
+    /**
+     * Writes the phase, in the range <code>[0,1)</code>, to the output. As in Pd's [phasor~], the
+     * phase is advanced before each sample is written.
+     */
+    static uint32_t ramp(uint32_t phase, uint32_t increment, float *output, int n);
+
+    /** Writes the phase to the output, advancing by a per-sample frequency as for <code>cosine()</code>. */
+    static uint32_t ramp(uint32_t phase, float *frequency, float inverseSampleRate, float *output, int n);
+
+    /** Writes <code>cos(2*pi*input)</code> to the output, for an input given in cycles. */
+    static void cosine(float *input, float *output, int n);
+};
+
+#endif // _PHASE_ACCUMULATOR_H_
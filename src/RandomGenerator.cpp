@@ -0,0 +1,138 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RandomGenerator.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#elif __ARM_NEON__
+#include <arm_neon.h>
+#endif
+
+// the spacing of the seeds which are mixed into the state, the golden ratio in 32-bit fixed point
+#define SEED_INCREMENT 0x9E3779B9
+
+// the upper 24 bits of a value, as a signed fraction in [-1,1)
+#define VALUE_SCALE (1.0f / 8388608.0f)
+
+RandomGenerator::RandomGenerator(uint32_t seed) {
+  this->seed(seed);
+}
+
+uint32_t RandomGenerator::mix(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7FEB352D;
+  x ^= x >> 15;
+  x *= 0x846CA68B;
+  x ^= x >> 16;
+  return x;
+}
+
+void RandomGenerator::seed(uint32_t seed) {
+  // the state of every lane is filled from a sequence of mixed seeds (as splitmix), and must not be zero
+  for (int lane = 0; lane < 4; lane++) {
+    uint32_t isZero = 0;
+    for (int k = 0; k < 4; k++) {
+      seed += SEED_INCREMENT;
+      state[k][lane] = mix(seed);
+      isZero |= state[k][lane];
+    }
+    if (isZero == 0) state[0][lane] = SEED_INCREMENT;
+  }
+}
+
+#pragma mark - Step
+
+static inline uint32_t rotateLeft(uint32_t x, int k) {
+  return (x << k) | (x >> (32 - k));
+}
+
+// advances all four generators, returning their values
+static inline void step(uint32_t state[4][4], uint32_t *values) {
+  for (int lane = 0; lane < 4; lane++) {
+    uint32_t *s0 = &state[0][lane], *s1 = &state[1][lane], *s2 = &state[2][lane], *s3 = &state[3][lane];
+    values[lane] = *s0 + *s3;
+    uint32_t t = *s1 << 9;
+    *s2 ^= *s0;
+    *s3 ^= *s1;
+    *s1 ^= *s2;
+    *s0 ^= *s3;
+    *s2 ^= t;
+    *s3 = rotateLeft(*s3, 11);
+  }
+}
+
+#pragma mark - Fill
+
+void RandomGenerator::fill(float *output, int n) {
+  int i = 0;
+  #if __SSE2__
+  __m128i s0 = _mm_loadu_si128((__m128i *) state[0]);
+  __m128i s1 = _mm_loadu_si128((__m128i *) state[1]);
+  __m128i s2 = _mm_loadu_si128((__m128i *) state[2]);
+  __m128i s3 = _mm_loadu_si128((__m128i *) state[3]);
+  __m128 scale = _mm_set1_ps(VALUE_SCALE);
+  for (; i <= n - 4; i += 4) {
+    __m128i value = _mm_add_epi32(s0, s3);
+    __m128i t = _mm_slli_epi32(s1, 9);
+    s2 = _mm_xor_si128(s2, s0);
+    s3 = _mm_xor_si128(s3, s1);
+    s1 = _mm_xor_si128(s1, s2);
+    s0 = _mm_xor_si128(s0, s3);
+    s2 = _mm_xor_si128(s2, t);
+    s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+    _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(value, 8)), scale));
+  }
+  _mm_storeu_si128((__m128i *) state[0], s0);
+  _mm_storeu_si128((__m128i *) state[1], s1);
+  _mm_storeu_si128((__m128i *) state[2], s2);
+  _mm_storeu_si128((__m128i *) state[3], s3);
+  #elif __ARM_NEON__
+  uint32x4_t s0 = vld1q_u32(state[0]);
+  uint32x4_t s1 = vld1q_u32(state[1]);
+  uint32x4_t s2 = vld1q_u32(state[2]);
+  uint32x4_t s3 = vld1q_u32(state[3]);
+  for (; i <= n - 4; i += 4) {
+    uint32x4_t value = vaddq_u32(s0, s3);
+    uint32x4_t t = vshlq_n_u32(s1, 9);
+    s2 = veorq_u32(s2, s0);
+    s3 = veorq_u32(s3, s1);
+    s1 = veorq_u32(s1, s2);
+    s0 = veorq_u32(s0, s3);
+    s2 = veorq_u32(s2, t);
+    s3 = vsriq_n_u32(vshlq_n_u32(s3, 11), s3, 21);
+    int32x4_t upper = vshrq_n_s32(vreinterpretq_s32_u32(value), 8);
+    vst1q_f32(output + i, vmulq_n_f32(vcvtq_f32_s32(upper), VALUE_SCALE));
+  }
+  vst1q_u32(state[0], s0);
+  vst1q_u32(state[1], s1);
+  vst1q_u32(state[2], s2);
+  vst1q_u32(state[3], s3);
+  #endif
+  for (; i < n; i += 4) {
+    uint32_t v[4];
+    step(state, v);
+    for (int lane = 0; lane < 4 && i + lane < n; lane++) {
+      output[i+lane] = ((float) (((int32_t) v[lane]) >> 8)) * VALUE_SCALE;
+    }
+  }
+}
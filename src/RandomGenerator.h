@@ -0,0 +1,59 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _RANDOM_GENERATOR_H_
+#define _RANDOM_GENERATOR_H_
+
+#include <stdint.h>
+
+/**
+ * The pseudo-random number generator of [noise~]. It runs four xoshiro128+ generators side by side,
+ * such that blocks of noise are produced four samples at a time with SSE2 or NEON. The scalar path
+ * produces exactly the same values, so a given seed yields the same output on every platform.
+ *
+ * Each generator is seeded by its object from <code>PdContext::getNextRandomSeed()</code>, such that
+ * the output of a context is reproducible when its seed is set. [random] keeps the Mersenne Twister,
+ * seeded in the same way, so that the sequence following a "seed" message is unchanged.
+ */
+class RandomGenerator {
+
+  public:
+    RandomGenerator(uint32_t seed);
+
+    /** Restarts the generator from the given seed. */
+    void seed(uint32_t seed);
+
+    /**
+     * Writes uniformly distributed values in <code>[-1,1)</code> to the output. Values are produced
+     * four at a time, and any left over at the end are discarded.
+     */
+    void fill(float *output, int n);
+
+    /** Returns a well-mixed hash of the given value, for deriving seeds. */
+    static uint32_t mix(uint32_t x);
+
+  private:
+    /** The state of the four generators, such that <code>state[k][lane]</code> is word k of a lane. */
+    uint32_t state[4][4];
+};
+
+#endif // _RANDOM_GENERATOR_H_
@@ -0,0 +1,358 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <math.h>
+#include <string.h>
+#include "DspObject.h"
+#include "RealFft.h"
+
+#if __SSE__
+#include <xmmintrin.h>
+#define REAL_FFT_SIMD 1
+typedef __m128 v4sf;
+#elif __ARM_NEON__
+#include <arm_neon.h>
+#define REAL_FFT_SIMD 1
+typedef float32x4_t v4sf;
+#endif
+
+std::map<int, RealFft *> RealFft::plans;
+#ifndef EMSCRIPTEN
+pthread_mutex_t RealFft::plansLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+#pragma mark - Vector Operations
+
+#if REAL_FFT_SIMD
+#if __SSE__
+static inline v4sf vload(const float *p) { return _mm_load_ps(p); }
+static inline v4sf vloadu(const float *p) { return _mm_loadu_ps(p); }
+static inline void vstore(float *p, v4sf a) { _mm_store_ps(p, a); }
+static inline void vstoreu(float *p, v4sf a) { _mm_storeu_ps(p, a); }
+static inline v4sf vset1(float f) { return _mm_set1_ps(f); }
+static inline v4sf vadd(v4sf a, v4sf b) { return _mm_add_ps(a, b); }
+static inline v4sf vsub(v4sf a, v4sf b) { return _mm_sub_ps(a, b); }
+static inline v4sf vmul(v4sf a, v4sf b) { return _mm_mul_ps(a, b); }
+static inline v4sf vreverse(v4sf a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(0,1,2,3)); }
+
+// [a0 b0 a1 b1], [a2 b2 a3 b3]
+static inline void vinterleave(v4sf a, v4sf b, v4sf *lo, v4sf *hi) {
+  *lo = _mm_unpacklo_ps(a, b);
+  *hi = _mm_unpackhi_ps(a, b);
+}
+
+// [a0 a2 b0 b2], [a1 a3 b1 b3]
+static inline void vdeinterleave(v4sf a, v4sf b, v4sf *even, v4sf *odd) {
+  *even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0));
+  *odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1));
+}
+
+// [a0 a1 b0 b1], [a2 a3 b2 b3]
+static inline void vhalves(v4sf a, v4sf b, v4sf *lo, v4sf *hi) {
+  *lo = _mm_movelh_ps(a, b);
+  *hi = _mm_movehl_ps(b, a);
+}
+#elif __ARM_NEON__
+static inline v4sf vload(const float *p) { return vld1q_f32(p); }
+static inline v4sf vloadu(const float *p) { return vld1q_f32(p); }
+static inline void vstore(float *p, v4sf a) { vst1q_f32(p, a); }
+static inline void vstoreu(float *p, v4sf a) { vst1q_f32(p, a); }
+static inline v4sf vset1(float f) { return vdupq_n_f32(f); }
+static inline v4sf vadd(v4sf a, v4sf b) { return vaddq_f32(a, b); }
+static inline v4sf vsub(v4sf a, v4sf b) { return vsubq_f32(a, b); }
+static inline v4sf vmul(v4sf a, v4sf b) { return vmulq_f32(a, b); }
+static inline v4sf vreverse(v4sf a) {
+  v4sf r = vrev64q_f32(a);
+  return vcombine_f32(vget_high_f32(r), vget_low_f32(r));
+}
+
+static inline void vinterleave(v4sf a, v4sf b, v4sf *lo, v4sf *hi) {
+  float32x4x2_t t = vzipq_f32(a, b);
+  *lo = t.val[0];
+  *hi = t.val[1];
+}
+
+static inline void vdeinterleave(v4sf a, v4sf b, v4sf *even, v4sf *odd) {
+  float32x4x2_t t = vuzpq_f32(a, b);
+  *even = t.val[0];
+  *odd = t.val[1];
+}
+
+static inline void vhalves(v4sf a, v4sf b, v4sf *lo, v4sf *hi) {
+  *lo = vcombine_f32(vget_low_f32(a), vget_low_f32(b));
+  *hi = vcombine_f32(vget_high_f32(a), vget_high_f32(b));
+}
+#endif
+#endif // REAL_FFT_SIMD
+
+
+#pragma mark - Plans
+
+bool RealFft::isValidLength(int length) {
+  return (length >= 2) && ((length & (length - 1)) == 0);
+}
+
+RealFft *RealFft::getPlan(int length) {
+  if (!isValidLength(length)) return NULL;
+  
+  // contexts create and delete their objects on different threads
+  #ifndef EMSCRIPTEN
+  pthread_mutex_lock(&plansLock);
+  #endif
+  std::map<int, RealFft *>::iterator it = plans.find(length);
+  RealFft *plan = NULL;
+  if (it == plans.end()) {
+    plan = new RealFft(length);
+    plans[length] = plan;
+  } else {
+    plan = it->second;
+  }
+  plan->refCount++;
+  #ifndef EMSCRIPTEN
+  pthread_mutex_unlock(&plansLock);
+  #endif
+  return plan;
+}
+
+void RealFft::releasePlan(RealFft *plan) {
+  if (plan == NULL) return;
+  #ifndef EMSCRIPTEN
+  pthread_mutex_lock(&plansLock);
+  #endif
+  if (--(plan->refCount) == 0) {
+    plans.erase(plan->length);
+    delete plan;
+  }
+  #ifndef EMSCRIPTEN
+  pthread_mutex_unlock(&plansLock);
+  #endif
+}
+
+RealFft::RealFft(int length) {
+  this->length = length;
+  numComplex = length / 2;
+  refCount = 0;
+  
+  int half = numComplex / 2;
+  int numTwiddles = (half > 0) ? half : 1;
+  twiddleReal = ALLOC_ALIGNED_BUFFER(numTwiddles * sizeof(float));
+  twiddleImag = ALLOC_ALIGNED_BUFFER(numTwiddles * sizeof(float));
+  twiddleReal2 = ALLOC_ALIGNED_BUFFER(numTwiddles * sizeof(float));
+  twiddleImag2 = ALLOC_ALIGNED_BUFFER(numTwiddles * sizeof(float));
+  for (int k = 0; k < half; k++) {
+    double phase = -2.0 * M_PI * k / numComplex;
+    twiddleReal[k] = (float) cos(phase);
+    twiddleImag[k] = (float) sin(phase);
+    // the twiddle factor of element k in the second stage is that of butterfly k/2
+    double phase2 = -2.0 * M_PI * (2 * (k / 2)) / numComplex;
+    twiddleReal2[k] = (float) cos(phase2);
+    twiddleImag2[k] = (float) sin(phase2);
+  }
+  
+  untangleReal = ALLOC_ALIGNED_BUFFER(numComplex * sizeof(float));
+  untangleImag = ALLOC_ALIGNED_BUFFER(numComplex * sizeof(float));
+  for (int k = 0; k < numComplex; k++) {
+    double phase = -2.0 * M_PI * k / length;
+    untangleReal[k] = (float) cos(phase);
+    untangleImag[k] = (float) sin(phase);
+  }
+}
+
+RealFft::~RealFft() {
+  FREE_ALIGNED_BUFFER(twiddleReal);
+  FREE_ALIGNED_BUFFER(twiddleImag);
+  FREE_ALIGNED_BUFFER(twiddleReal2);
+  FREE_ALIGNED_BUFFER(twiddleImag2);
+  FREE_ALIGNED_BUFFER(untangleReal);
+  FREE_ALIGNED_BUFFER(untangleImag);
+}
+
+
+#pragma mark - Complex Transform
+
+float *RealFft::transform(float *xr, float *xi, float *yr, float *yi, float **resultImag) {
+  // Each stage computes the butterflies of x[j] and x[j+half] for all j. Element j belongs to
+  // butterfly p = j/s, and the results are written to y[j + p*s] and y[j + p*s + s].
+  int half = numComplex / 2;
+  for (int s = 1; s < numComplex; s <<= 1) {
+    int j = 0;
+    #if REAL_FFT_SIMD
+    if (s == 1 && half >= 4) {
+      for (; j < half; j += 4) {
+        v4sf ar = vload(xr+j), ai = vload(xi+j);
+        v4sf br = vload(xr+j+half), bi = vload(xi+j+half);
+        v4sf wr = vload(twiddleReal+j), wi = vload(twiddleImag+j);
+        v4sf sr = vadd(ar, br), si = vadd(ai, bi);
+        v4sf dr = vsub(ar, br), di = vsub(ai, bi);
+        v4sf tr = vsub(vmul(dr, wr), vmul(di, wi));
+        v4sf ti = vadd(vmul(dr, wi), vmul(di, wr));
+        v4sf lo, hi;
+        vinterleave(sr, tr, &lo, &hi); vstore(yr+2*j, lo); vstore(yr+2*j+4, hi);
+        vinterleave(si, ti, &lo, &hi); vstore(yi+2*j, lo); vstore(yi+2*j+4, hi);
+      }
+    } else if (s == 2 && half >= 4) {
+      for (; j < half; j += 4) {
+        v4sf ar = vload(xr+j), ai = vload(xi+j);
+        v4sf br = vload(xr+j+half), bi = vload(xi+j+half);
+        v4sf wr = vload(twiddleReal2+j), wi = vload(twiddleImag2+j);
+        v4sf sr = vadd(ar, br), si = vadd(ai, bi);
+        v4sf dr = vsub(ar, br), di = vsub(ai, bi);
+        v4sf tr = vsub(vmul(dr, wr), vmul(di, wi));
+        v4sf ti = vadd(vmul(dr, wi), vmul(di, wr));
+        v4sf lo, hi;
+        vhalves(sr, tr, &lo, &hi); vstore(yr+2*j, lo); vstore(yr+2*j+4, hi);
+        vhalves(si, ti, &lo, &hi); vstore(yi+2*j, lo); vstore(yi+2*j+4, hi);
+      }
+    } else if (s >= 4) {
+      for (int p = 0; p < half / s; p++) {
+        v4sf wr = vset1(twiddleReal[p*s]), wi = vset1(twiddleImag[p*s]);
+        float *yr0 = yr + 2*p*s, *yi0 = yi + 2*p*s;
+        for (int q = 0; q < s; q += 4, j += 4) {
+          v4sf ar = vload(xr+j), ai = vload(xi+j);
+          v4sf br = vload(xr+j+half), bi = vload(xi+j+half);
+          v4sf dr = vsub(ar, br), di = vsub(ai, bi);
+          vstore(yr0+q, vadd(ar, br));
+          vstore(yi0+q, vadd(ai, bi));
+          vstore(yr0+q+s, vsub(vmul(dr, wr), vmul(di, wi)));
+          vstore(yi0+q+s, vadd(vmul(dr, wi), vmul(di, wr)));
+        }
+      }
+    }
+    #endif // REAL_FFT_SIMD
+    for (; j < half; j++) {
+      int p = j / s;
+      int q = j - p * s;
+      float wr = twiddleReal[p*s], wi = twiddleImag[p*s];
+      float dr = xr[j] - xr[j+half], di = xi[j] - xi[j+half];
+      yr[q + 2*p*s] = xr[j] + xr[j+half];
+      yi[q + 2*p*s] = xi[j] + xi[j+half];
+      yr[q + 2*p*s + s] = dr * wr - di * wi;
+      yi[q + 2*p*s + s] = dr * wi + di * wr;
+    }
+    
+    float *t = xr; xr = yr; yr = t;
+    t = xi; xi = yi; yi = t;
+  }
+  *resultImag = xi;
+  return xr;
+}
+
+
+#pragma mark - Real Transform
+
+void RealFft::forward(float *input, float *outputReal, float *outputImag, float *work) {
+  int m = numComplex;
+  float *zr = work, *zi = work + m;
+  
+  // the even samples are the real part, the odd samples the imaginary part
+  int n = 0;
+  #if REAL_FFT_SIMD
+  for (; n + 4 <= m; n += 4) {
+    v4sf even, odd;
+    vdeinterleave(vloadu(input+2*n), vloadu(input+2*n+4), &even, &odd);
+    vstore(zr+n, even);
+    vstore(zi+n, odd);
+  }
+  #endif // REAL_FFT_SIMD
+  for (; n < m; n++) {
+    zr[n] = input[2*n];
+    zi[n] = input[2*n+1];
+  }
+  
+  zr = transform(zr, zi, work + 2*m, work + 3*m, &zi);
+  
+  // untangle the spectra of the even and odd samples, E[k] = (Z[k] + Z*[m-k])/2 and
+  // O[k] = -i(Z[k] - Z*[m-k])/2, and combine them as X[k] = E[k] + exp(-2*pi*i*k/length) O[k]
+  int k = 1;
+  #if REAL_FFT_SIMD
+  v4sf half = vset1(0.5f);
+  for (; k + 4 <= m; k += 4) {
+    v4sf ar = vloadu(zr+k), ai = vloadu(zi+k);
+    v4sf br = vreverse(vloadu(zr+m-k-3)), bi = vreverse(vloadu(zi+m-k-3));
+    v4sf er = vmul(half, vadd(ar, br)), ei = vmul(half, vsub(ai, bi));
+    v4sf or_ = vmul(half, vadd(ai, bi)), oi = vmul(half, vsub(br, ar));
+    v4sf wr = vloadu(untangleReal+k), wi = vloadu(untangleImag+k);
+    vstoreu(outputReal+k, vadd(er, vsub(vmul(wr, or_), vmul(wi, oi))));
+    vstoreu(outputImag+k, vadd(ei, vadd(vmul(wr, oi), vmul(wi, or_))));
+  }
+  #endif // REAL_FFT_SIMD
+  for (; k < m; k++) {
+    float er = 0.5f * (zr[k] + zr[m-k]), ei = 0.5f * (zi[k] - zi[m-k]);
+    float or_ = 0.5f * (zi[k] + zi[m-k]), oi = 0.5f * (zr[m-k] - zr[k]);
+    float wr = untangleReal[k], wi = untangleImag[k];
+    outputReal[k] = er + wr * or_ - wi * oi;
+    outputImag[k] = ei + wr * oi + wi * or_;
+  }
+  outputReal[0] = zr[0] + zi[0];
+  outputReal[m] = zr[0] - zi[0];
+  outputImag[0] = 0.0f;
+  
+  // the redundant bins are zero, as in Pd
+  memset(outputReal+m+1, 0, (m-1) * sizeof(float));
+  memset(outputImag+m, 0, m * sizeof(float));
+}
+
+void RealFft::inverse(float *inputReal, float *inputImag, float *output, float *work) {
+  int m = numComplex;
+  float *zr = work, *zi = work + m;
+  
+  // tangle the spectrum into that of a complex signal of half the length, Z[k] = (X[k] + X*[m-k]) +
+  // i(X[k] - X*[m-k]) exp(2*pi*i*k/length). It is conjugated such that the forward transform can be
+  // used for the inverse.
+  int k = 1;
+  #if REAL_FFT_SIMD
+  for (; k + 4 <= m; k += 4) {
+    v4sf ar = vloadu(inputReal+k), ai = vloadu(inputImag+k);
+    v4sf br = vreverse(vloadu(inputReal+m-k-3)), bi = vreverse(vloadu(inputImag+m-k-3));
+    v4sf dr = vsub(ar, br), di = vadd(ai, bi);
+    v4sf wr = vloadu(untangleReal+k), wi = vloadu(untangleImag+k);
+    vstoreu(zr+k, vsub(vadd(ar, br), vsub(vmul(di, wr), vmul(dr, wi))));
+    vstoreu(zi+k, vsub(vsub(bi, ai), vadd(vmul(dr, wr), vmul(di, wi))));
+  }
+  #endif // REAL_FFT_SIMD
+  for (; k < m; k++) {
+    float dr = inputReal[k] - inputReal[m-k], di = inputImag[k] + inputImag[m-k];
+    float wr = untangleReal[k], wi = untangleImag[k];
+    zr[k] = inputReal[k] + inputReal[m-k] - (di * wr - dr * wi);
+    zi[k] = -(inputImag[k] - inputImag[m-k] + dr * wr + di * wi);
+  }
+  zr[0] = inputReal[0] + inputReal[m];
+  zi[0] = -(inputReal[0] - inputReal[m]);
+  
+  zr = transform(zr, zi, work + 2*m, work + 3*m, &zi);
+  
+  // undo the conjugation, and interleave the even and odd samples
+  int n = 0;
+  #if REAL_FFT_SIMD
+  v4sf zero = vset1(0.0f);
+  for (; n + 4 <= m; n += 4) {
+    v4sf lo, hi;
+    vinterleave(vload(zr+n), vsub(zero, vload(zi+n)), &lo, &hi);
+    vstoreu(output+2*n, lo);
+    vstoreu(output+2*n+4, hi);
+  }
+  #endif // REAL_FFT_SIMD
+  for (; n < m; n++) {
+    output[2*n] = zr[n];
+    output[2*n+1] = -zi[n];
+  }
+}
@@ -0,0 +1,116 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _REAL_FFT_H_
+#define _REAL_FFT_H_
+
+#include <map>
+#ifndef EMSCRIPTEN
+#include <pthread.h>
+#endif
+
+/**
+ * A radix-2 fast Fourier transform of real signals, as used by [rfft~] and [rifft~]. A real signal
+ * of length N is transformed as a complex signal of length N/2, with the even samples as the real
+ * part and the odd samples as the imaginary part. The complex transform is a Stockham autosort FFT
+ * on split real and imaginary arrays, such that each butterfly stage is a pass over contiguous
+ * memory with SSE or NEON. The spectrum of the real signal is then untangled in a final pass.
+ *
+ * The spectrum is laid out as in Pd. Only the unique bins are returned: bins <code>0</code> to
+ * <code>N/2</code> of the real part and bins <code>1</code> to <code>N/2-1</code> of the imaginary
+ * part. All other values are zero. The inverse transform reads only these bins and is not
+ * normalised, such that a forward and inverse transform scale the signal by <code>N</code>.
+ *
+ * Plans contain only the precomputed twiddle factors, and are shared by all objects with the same
+ * transform length. A plan may thus be used by several threads at once, each with its own work
+ * buffer of <code>getWorkBufferLength()</code> floats.
+ */
+class RealFft {
+  
+  public:
+    /**
+     * Returns the plan for the given transform length, which must be a power of two of at least 2.
+     * <code>NULL</code> is returned for any other length. Each plan must be returned with
+     * <code>releasePlan()</code>.
+     */
+    static RealFft *getPlan(int length);
+  
+    /** Releases a plan returned by <code>getPlan()</code>. The plan is deleted when no longer used. */
+    static void releasePlan(RealFft *plan);
+  
+    /** Returns <code>true</code> if the given length is a power of two of at least 2. */
+    static bool isValidLength(int length);
+  
+    int getLength() { return length; }
+  
+    /** The number of floats in the work buffer which each caller must provide. */
+    int getWorkBufferLength() { return 2 * length; }
+  
+    /**
+     * Transforms <code>length</code> samples of the input to the unique bins of the spectrum. The
+     * work buffer must be 16-byte aligned. The input may be the same buffer as either output.
+     */
+    void forward(float *input, float *outputReal, float *outputImag, float *work);
+  
+    /**
+     * Transforms the unique bins of a spectrum to <code>length</code> samples. The work buffer must
+     * be 16-byte aligned. The output may be the same buffer as either input.
+     */
+    void inverse(float *inputReal, float *inputImag, float *output, float *work);
+  
+  private:
+    RealFft(int length);
+    ~RealFft();
+  
+    /**
+     * Computes the unnormalised complex FFT of length <code>length/2</code> from <code>(re, im)</code>
+     * to either itself or <code>(re2, im2)</code>, whichever contains the result on return.
+     */
+    float *transform(float *re, float *im, float *re2, float *im2, float **resultImag);
+  
+    int length;
+  
+    /** The number of complex values, <code>length/2</code>. */
+    int numComplex;
+  
+    /** The twiddle factors <code>exp(-2*pi*i*k/numComplex)</code> for k in <code>[0, numComplex/2)</code>. */
+    float *twiddleReal;
+    float *twiddleImag;
+  
+    /** The twiddle factors of the second stage, each repeated twice. */
+    float *twiddleReal2;
+    float *twiddleImag2;
+  
+    /** The twiddle factors <code>exp(-2*pi*i*k/length)</code> for k in <code>[0, numComplex)</code>. */
+    float *untangleReal;
+    float *untangleImag;
+  
+    int refCount;
+  
+    /** All plans in use, by their length. Shared by all contexts, and only accessed with the lock held. */
+    static std::map<int, RealFft *> plans;
+    #ifndef EMSCRIPTEN
+    static pthread_mutex_t plansLock;
+    #endif
+};
+
+#endif // _REAL_FFT_H_
@@ -0,0 +1,173 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "SymbolTable.h"
+
+/** The number of buckets of a new table. A power of two. */
+#define SYMBOL_TABLE_INITIAL_BUCKETS 1024
+
+struct SymbolTableEntry {
+  char *symbol;
+  unsigned int hash;
+  atomic<SymbolTableEntry *> next;
+};
+
+struct SymbolTableBuckets {
+  unsigned int numBuckets; // a power of two
+  atomic<SymbolTableEntry *> *buckets;
+};
+
+atomic<SymbolTableBuckets *> SymbolTable::currentBuckets(NULL);
+atomic<unsigned int> SymbolTable::numSymbols(0);
+
+#ifndef EMSCRIPTEN
+pthread_mutex_t SymbolTable::symbolLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static SymbolTableBuckets *newBuckets(unsigned int numBuckets) {
+  SymbolTableBuckets *buckets = new SymbolTableBuckets();
+  buckets->numBuckets = numBuckets;
+  buckets->buckets = new atomic<SymbolTableEntry *>[numBuckets];
+  for (unsigned int i = 0; i < numBuckets; i++) {
+    buckets->buckets[i].store(NULL, memory_order_relaxed);
+  }
+  return buckets;
+}
+
+unsigned int SymbolTable::hash(const char *symbol) {
+  // FNV-1a
+  unsigned int h = 2166136261u;
+  for (const unsigned char *c = (const unsigned char *) symbol; *c != '\0'; c++) {
+    h = (h ^ *c) * 16777619u;
+  }
+  return h;
+}
+
+char *SymbolTable::find(SymbolTableBuckets *buckets, const char *symbol, unsigned int hash) {
+  if (buckets == NULL) return NULL;
+  SymbolTableEntry *entry =
+      buckets->buckets[hash & (buckets->numBuckets-1)].load(memory_order_acquire);
+  while (entry != NULL) {
+    if (entry->hash == hash && !strcmp(entry->symbol, symbol)) return entry->symbol;
+    entry = entry->next.load(memory_order_acquire);
+  }
+  return NULL;
+}
+
+void SymbolTable::insert(SymbolTableBuckets *buckets, SymbolTableEntry *entry) {
+  atomic<SymbolTableEntry *> *bucket = &buckets->buckets[entry->hash & (buckets->numBuckets-1)];
+  entry->next.store(bucket->load(memory_order_relaxed), memory_order_relaxed);
+  bucket->store(entry, memory_order_release);
+}
+
+char *SymbolTable::find(const char *symbol) {
+  if (symbol == NULL) return NULL;
+  return find(currentBuckets.load(memory_order_acquire), symbol, hash(symbol));
+}
+
+char *SymbolTable::intern(const char *symbol) {
+  if (symbol == NULL) return NULL;
+  
+  unsigned int h = hash(symbol);
+  char *internedSymbol = find(currentBuckets.load(memory_order_acquire), symbol, h);
+  if (internedSymbol != NULL) return internedSymbol;
+  
+  #ifndef EMSCRIPTEN
+  pthread_mutex_lock(&symbolLock);
+  #endif
+  // the symbol may have been added since it was looked for
+  SymbolTableBuckets *buckets = currentBuckets.load(memory_order_relaxed);
+  internedSymbol = find(buckets, symbol, h);
+  if (internedSymbol == NULL) {
+    if (buckets == NULL || numSymbols.load(memory_order_relaxed) >= 2 * buckets->numBuckets) {
+      // the entries are copied to larger buckets, which are published once they are complete. The
+      // old buckets and entries are kept (see the class comment).
+      SymbolTableBuckets *grownBuckets = newBuckets((buckets == NULL)
+          ? SYMBOL_TABLE_INITIAL_BUCKETS : 2 * buckets->numBuckets);
+      for (unsigned int i = 0; buckets != NULL && i < buckets->numBuckets; i++) {
+        SymbolTableEntry *entry = buckets->buckets[i].load(memory_order_relaxed);
+        for (; entry != NULL; entry = entry->next.load(memory_order_relaxed)) {
+          SymbolTableEntry *copy = new SymbolTableEntry();
+          copy->symbol = entry->symbol;
+          copy->hash = entry->hash;
+          insert(grownBuckets, copy);
+        }
+      }
+      buckets = grownBuckets;
+      currentBuckets.store(buckets, memory_order_release);
+    }
+    SymbolTableEntry *entry = new SymbolTableEntry();
+    entry->symbol = strdup(symbol);
+    entry->hash = h;
+    insert(buckets, entry);
+    numSymbols.store(numSymbols.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    internedSymbol = entry->symbol;
+  }
+  #ifndef EMSCRIPTEN
+  pthread_mutex_unlock(&symbolLock);
+  #endif
+  
+  return internedSymbol;
+}
+
+unsigned int SymbolTable::size() {
+  return numSymbols.load(memory_order_relaxed);
+}
+
+const char *const SYMBOL_SET = SymbolTable::intern("set");
+const char *const SYMBOL_CLEAR = SymbolTable::intern("clear");
+const char *const SYMBOL_STOP = SymbolTable::intern("stop");
+const char *const SYMBOL_START = SymbolTable::intern("start");
+const char *const SYMBOL_OPEN = SymbolTable::intern("open");
+const char *const SYMBOL_PRINT = SymbolTable::intern("print");
+const char *const SYMBOL_FLUSH = SymbolTable::intern("flush");
+const char *const SYMBOL_SEED = SymbolTable::intern("seed");
+const char *const SYMBOL_READ = SymbolTable::intern("read");
+const char *const SYMBOL_WRITE = SymbolTable::intern("write");
+const char *const SYMBOL_NORMALIZE = SymbolTable::intern("normalize");
+const char *const SYMBOL_RESIZE = SymbolTable::intern("resize");
+const char *const SYMBOL_APPEND = SymbolTable::intern("append");
+const char *const SYMBOL_PREPEND = SymbolTable::intern("prepend");
+const char *const SYMBOL_SPLIT = SymbolTable::intern("split");
+const char *const SYMBOL_TRIM = SymbolTable::intern("trim");
+const char *const SYMBOL_LENGTH = SymbolTable::intern("length");
+const char *const SYMBOL_OBJ = SymbolTable::intern("obj");
+const char *const SYMBOL_DSP = SymbolTable::intern("dsp");
+const char *const SYMBOL_SYMBOL = SymbolTable::intern("symbol");
+const char *const SYMBOL_S = SymbolTable::intern("s");
+const char *const SYMBOL_ANYTHING = SymbolTable::intern("anything");
+const char *const SYMBOL_A = SymbolTable::intern("a");
+const char *const SYMBOL_BANG = SymbolTable::intern("bang");
+const char *const SYMBOL_B = SymbolTable::intern("b");
+const char *const SYMBOL_FLOAT = SymbolTable::intern("float");
+const char *const SYMBOL_F = SymbolTable::intern("f");
+const char *const SYMBOL_LIST = SymbolTable::intern("list");
+const char *const SYMBOL_L = SymbolTable::intern("l");
+const char *const SYMBOL_FLAG_AIFF = SymbolTable::intern("-aiff");
+const char *const SYMBOL_FLAG_BYTES = SymbolTable::intern("-bytes");
+const char *const SYMBOL_FLAG_N = SymbolTable::intern("-n");
+const char *const SYMBOL_FLAG_PATH = SymbolTable::intern("-path");
+const char *const SYMBOL_FLAG_RATE = SymbolTable::intern("-rate");
+const char *const SYMBOL_FLAG_RESIZE = SymbolTable::intern("-resize");
+const char *const SYMBOL_FLAG_WAVE = SymbolTable::intern("-wave");
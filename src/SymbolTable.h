@@ -0,0 +1,142 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _SYMBOL_TABLE_H_
+#define _SYMBOL_TABLE_H_
+
+#include <atomic>
+#ifndef EMSCRIPTEN
+#include <pthread.h>
+#endif
+using namespace std;
+
+struct SymbolTableEntry;
+struct SymbolTableBuckets;
+
+/**
+ * The <code>SymbolTable</code> interns all symbols which appear in messages. Each distinct string
+ * is stored exactly once, such that two interned symbols are equal if and only if their pointers
+ * are equal. Messages therefore never own their symbols, and copying a message only copies pointers.
+ *
+ * The table is global rather than per-context because messages may be created and inspected (via
+ * the C API) independently of any context. It is append-only: interned symbols are never freed and
+ * remain valid for the lifetime of the process. Their contents must not be modified.
+ *
+ * Symbols which are already in the table are found without taking a lock or allocating memory, so
+ * that interning the symbols of a message while the context is processed does not wait for another
+ * thread. Only adding a new symbol takes the lock.
+ *
+ * Growth policy: the table holds every distinct symbol ever interned, so its memory grows with the
+ * number of distinct strings and never shrinks. This is negligible for the symbols of patches and
+ * their messages, but a patch which generates an unbounded number of distinct symbols at runtime,
+ * e.g. [makefilename] driven by a counter, grows the table without limit. The buckets are doubled
+ * once there are more than two symbols per bucket. Replaced buckets are kept, as another thread may
+ * still be searching them, which at most doubles the memory used by the buckets.
+ */
+class SymbolTable {
+  
+  public:
+    /**
+     * Returns the interned copy of the given string, adding it to the table if it has not yet been
+     * seen. <code>NULL</code> is returned for a <code>NULL</code> string. This function is thread-safe.
+     */
+    static char *intern(const char *symbol);
+  
+    /**
+     * Returns the interned copy of the given string, or <code>NULL</code> if it has not yet been
+     * interned. This function never blocks.
+     */
+    static char *find(const char *symbol);
+  
+    /** Returns the number of distinct symbols in the table. */
+    static unsigned int size();
+  
+  private:
+    SymbolTable(); // a private constructor. No instances of this object should be made.
+    ~SymbolTable();
+  
+    static unsigned int hash(const char *symbol);
+  
+    /** Searches the given buckets for the symbol with the given hash. */
+    static char *find(SymbolTableBuckets *buckets, const char *symbol, unsigned int hash);
+  
+    /** Adds the entry to the given buckets. Called with the lock held. */
+    static void insert(SymbolTableBuckets *buckets, SymbolTableEntry *entry);
+  
+    /**
+     * The current buckets. Readers only ever see fully built buckets, and entries are only ever
+     * prepended to a chain, so a chain may always be searched while another thread adds to it.
+     * Constant-initialised, such that symbols may be interned during static initialisation.
+     */
+    static atomic<SymbolTableBuckets *> currentBuckets;
+  
+    /** The number of symbols in the table. Only changed with the lock held. */
+    static atomic<unsigned int> numSymbols;
+  
+    #ifndef EMSCRIPTEN
+    static pthread_mutex_t symbolLock;
+    #endif
+};
+
+/*
+ * The symbols which objects compare the elements of their messages against (see
+ * PdMessage::isSymbol()). They are interned during static initialisation, such that the comparison
+ * is a pointer comparison.
+ */
+extern const char *const SYMBOL_SET;
+extern const char *const SYMBOL_CLEAR;
+extern const char *const SYMBOL_STOP;
+extern const char *const SYMBOL_START;
+extern const char *const SYMBOL_OPEN;
+extern const char *const SYMBOL_PRINT;
+extern const char *const SYMBOL_FLUSH;
+extern const char *const SYMBOL_SEED;
+extern const char *const SYMBOL_READ;
+extern const char *const SYMBOL_WRITE;
+extern const char *const SYMBOL_NORMALIZE;
+extern const char *const SYMBOL_RESIZE;
+extern const char *const SYMBOL_APPEND;
+extern const char *const SYMBOL_PREPEND;
+extern const char *const SYMBOL_SPLIT;
+extern const char *const SYMBOL_TRIM;
+extern const char *const SYMBOL_LENGTH;
+extern const char *const SYMBOL_OBJ;
+extern const char *const SYMBOL_DSP;
+extern const char *const SYMBOL_SYMBOL;
+extern const char *const SYMBOL_S;
+extern const char *const SYMBOL_ANYTHING;
+extern const char *const SYMBOL_A;
+extern const char *const SYMBOL_BANG;
+extern const char *const SYMBOL_B;
+extern const char *const SYMBOL_FLOAT;
+extern const char *const SYMBOL_F;
+extern const char *const SYMBOL_LIST;
+extern const char *const SYMBOL_L;
+extern const char *const SYMBOL_FLAG_AIFF;
+extern const char *const SYMBOL_FLAG_BYTES;
+extern const char *const SYMBOL_FLAG_N;
+extern const char *const SYMBOL_FLAG_PATH;
+extern const char *const SYMBOL_FLAG_RATE;
+extern const char *const SYMBOL_FLAG_RESIZE;
+extern const char *const SYMBOL_FLAG_WAVE;
+
+#endif // _SYMBOL_TABLE_H_
@@ -24,6 +24,8 @@
 #include <Accelerate/Accelerate.h>
 #endif
 #include <string.h>
+#include "ExternalMessageQueue.h"
+#include "MessagePool.h"
 #include "MessageTable.h"
 #include "PdAbstractionDataBase.h"
 #include "PdContext.h"
@@ -283,6 +285,22 @@ void zg_context_process_s(ZGContext *context, short *inputBuffers, short *output
   #endif
 }
 
+void zg_context_set_num_dsp_threads(ZGContext *context, unsigned int numThreads) {
+  context->setNumDspThreads(numThreads);
+}
+
+void zg_context_set_fusion_enabled(ZGContext *context, int enabled) {
+  context->setFusionEnabled(enabled != 0);
+}
+
+void zg_context_set_disk_io_synchronous(ZGContext *context, int synchronous) {
+  context->setDiskIoSynchronous(synchronous != 0);
+}
+
+void zg_context_set_random_seed(ZGContext *context, unsigned int seed) {
+  context->setRandomSeed((uint32_t) seed);
+}
+
 void *zg_context_get_userinfo(PdContext *context) {
   return context->callbackUserData;
 }
@@ -320,6 +338,14 @@ void zg_context_unregister_receiver(ZGContext *context, const char *receiverName
   context->unregisterExternalReceiver(receiverName);
 }
 
+void zg_context_set_message_polling_enabled(ZGContext *context, int enabled) {
+  context->setMessagePollingEnabled(enabled != 0);
+}
+
+unsigned int zg_context_poll_messages(ZGContext *context) {
+  return context->pollMessages();
+}
+
 
 #pragma mark - Context Send Message
 
@@ -365,6 +391,21 @@ void zg_context_send_midinote(PdContext *context, int channel, int noteNumber, i
       (float) noteNumber, (float) velocity, (float) channel);
 }
 
+void zg_context_get_message_queue_stats(ZGContext *context, unsigned int *numSent,
+    unsigned int *numDropped, unsigned int *maxNumQueued) {
+  ExternalMessageQueue *queue = context->getExternalMessageQueue();
+  if (numSent != NULL) *numSent = queue->getNumPushed() + queue->getNumDropped();
+  if (numDropped != NULL) *numDropped = queue->getNumDropped();
+  if (maxNumQueued != NULL) *maxNumQueued = queue->getMaxNumQueued();
+}
+
+void zg_context_get_message_pool_stats(ZGContext *context, unsigned int *numHits,
+    unsigned int *numMisses) {
+  MessagePool *pool = context->getMessagePool();
+  if (numHits != NULL) *numHits = pool->getNumHits();
+  if (numMisses != NULL) *numMisses = pool->getNumMisses();
+}
+
 
 #pragma mark - Graph
 
@@ -445,7 +486,7 @@ ZGMessage *zg_message_new_from_string(double timetamp, const char *initString) {
 }
 
 void zg_message_delete(PdMessage *message) {
-  message->freeMessage(); // also frees any symbols on the heap
+  message->freeMessage(); // symbols are interned and are not freed
 }
 
 void zg_message_set_float(PdMessage *message, unsigned int index, float f) {
@@ -453,9 +494,7 @@ void zg_message_set_float(PdMessage *message, unsigned int index, float f) {
 }
 
 void zg_message_set_symbol(PdMessage *message, unsigned int index, const char *s) {
-  char *symbol = message->getSymbol(index);
-  free(symbol); // free it if it is not already NULL
-  message->setSymbol(index, StaticUtils::copyString((char *) s));
+  message->setSymbol(index, s); // the symbol is interned
 }
 
 void zg_message_set_bang(PdMessage *message, unsigned int index) {
@@ -182,6 +182,37 @@ typedef enum ZGConnectionType {
   /** Process the given context. Audio buffers are channel-interleaved with signed short (16-bit) samples. */
   void zg_context_process_s(ZGContext *context, short *inputBuffers, short *outputBuffers);
   
+  /**
+   * Sets the number of threads on which the context's DSP is processed, including the thread which
+   * calls zg_context_process(). Independent parts of the attached graphs are then processed
+   * concurrently on a pool of worker threads. With one thread (the default) all DSP is processed on
+   * the calling thread. The output is identical in either case.
+   */
+  void zg_context_set_num_dsp_threads(ZGContext *context, unsigned int numThreads);
+  
+  /**
+   * Enables (non-zero) or disables (zero) the fusing of chains of elementwise signal objects, such as
+   * [*~] -> [+~] -> [clip~], into single loops over each block. Fusing is enabled by default. The
+   * output is identical in either case.
+   */
+  void zg_context_set_fusion_enabled(ZGContext *context, int enabled);
+  
+  /**
+   * Sets whether disk I/O, such as reading a sound file with [soundfiler], is performed immediately
+   * while the context is processed (non-zero), or in the background (zero, the default). In the
+   * latter case the results become available at the start of a later block, without interrupting
+   * the audio. Synchronous disk I/O is useful when rendering offline.
+   */
+  void zg_context_set_disk_io_synchronous(ZGContext *context, int synchronous);
+  
+  /**
+   * Sets the seed of the random generators of [noise~] and [random] objects. Objects created
+   * afterwards are seeded from it in the order in which they are created, such that a graph which is
+   * created after the seed is set renders identically every time, on every platform. Otherwise the
+   * seed differs for each context.
+   */
+  void zg_context_set_random_seed(ZGContext *context, unsigned int seed);
+  
   
 #pragma mark - Context Send Message
   
@@ -228,12 +259,48 @@ typedef enum ZGConnectionType {
    */
   void zg_context_send_midinote(ZGContext *context, int channel, int noteNumber, int velocity, double blockIndex);
   
+  /**
+   * Messages are sent to a context without locking it, through a bounded queue which is emptied at
+   * the start of each block. Messages sent while the queue is full are dropped. This function returns
+   * the number of messages sent, the number of those which were dropped, and the largest number which
+   * have been waiting at the start of a block. Any of the pointers may be NULL.
+   */
+  void zg_context_get_message_queue_stats(ZGContext *context, unsigned int *numSent,
+      unsigned int *numDropped, unsigned int *maxNumQueued);
+  
+  /**
+   * Messages which are scheduled or queued for DSP objects are copied into a pool owned by the
+   * context. This function returns the number of copies which were served from memory already held
+   * by the pool (hits), and the number for which the pool had to allocate memory from the system
+   * (misses), e.g. because it had to grow. Any of the pointers may be NULL.
+   */
+  void zg_context_get_message_pool_stats(ZGContext *context, unsigned int *numHits,
+      unsigned int *numMisses);
+  
 
 #pragma mark - Context Un/Register External Receivers
   
   void zg_context_register_receiver(ZGContext *context, const char *receiverName);
   
   void zg_context_unregister_receiver(ZGContext *context, const char *receiverName);
+  
+  /**
+   * Enables (non-zero) or disables (zero) the polling of output from the context. Messages to
+   * registered receivers, printed lines and ZG_PD_DSP suggestions produced by zg_context_process()
+   * are then no longer passed to the callback function on the audio thread, but are queued until
+   * zg_context_poll_messages() is called, e.g. on a thread of the host. A slow callback function then
+   * no longer delays the audio thread. Output produced elsewhere, such as errors while a graph is
+   * loaded, is still passed to the callback function immediately. Polling is disabled by default.
+   */
+  void zg_context_set_message_polling_enabled(ZGContext *context, int enabled);
+  
+  /**
+   * Passes the output queued since the last call to the callback function of the context, on the
+   * calling thread and in the order in which it was produced, and returns the number of calls. If the
+   * queue has filled up in the meantime, the number of dropped messages is reported with ZG_PRINT_ERR.
+   * Only one thread may poll a context at a time.
+   */
+  unsigned int zg_context_poll_messages(ZGContext *context);
 
   
 #pragma mark - Object
@@ -320,7 +387,10 @@ typedef enum ZGConnectionType {
   
   void zg_message_set_float(ZGMessage *message, unsigned int index, float f);
   
-  /** The symbol parameter is copied into the message. Any previous symbol is freed from memory. */
+  /**
+   * The symbol parameter is interned, such that the caller retains ownership of the given string.
+   * Symbols are shared between all messages and are never freed.
+   */
   void zg_message_set_symbol(ZGMessage *message, unsigned int index, const char *s);
   
   void zg_message_set_bang(ZGMessage *message, unsigned int index);
@@ -333,6 +403,7 @@ typedef enum ZGConnectionType {
   
   float zg_message_get_float(ZGMessage *message, unsigned int index);
   
+  /** The returned symbol is interned. It remains valid after the message is deleted and must not be modified. */
   const char *zg_message_get_symbol(ZGMessage *message, unsigned int index);
   
   /** Returns a string representation of the message. The string must be freed by the caller. */
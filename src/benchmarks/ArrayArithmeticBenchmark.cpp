@@ -0,0 +1,142 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A benchmark of the kernels of ArrayArithmetic, for typical block sizes from 64 to 1024 samples.
+ * Each kernel is timed with a plain loop as compiled by the compiler, and on x86 with the SSE, AVX
+ * and AVX-512 kernels as far as they are supported by the processor. The time per call is reported
+ * for each. The output of every kernel must be identical to that of the plain loop.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ArrayArithmetic.h"
+#include "BenchmarkUtils.h"
+#include "DspObject.h"
+
+#define MIN_BLOCK_SIZE 64
+#define MAX_BLOCK_SIZE 1024
+#define NUM_SAMPLES (1 << 26) // the number of samples processed for each measurement
+#define NUM_KERNELS 9
+
+static const char *kernelNames[NUM_KERNELS] = {
+  "add", "add constant", "subtract", "subtract constant", "multiply", "multiply constant",
+  "divide", "divide constant", "fill"
+};
+
+// the plain loops are not inlined, so that they are timed as a call like the kernels
+__attribute__((noinline)) static void loop(int kernel, float *input0, float *input1,
+    float *output, int n) {
+  float constant = input1[0];
+  switch (kernel) {
+    case 0: for (int i = 0; i < n; i++) output[i] = input0[i] + input1[i]; break;
+    case 1: for (int i = 0; i < n; i++) output[i] = input0[i] + constant; break;
+    case 2: for (int i = 0; i < n; i++) output[i] = input0[i] - input1[i]; break;
+    case 3: for (int i = 0; i < n; i++) output[i] = input0[i] - constant; break;
+    case 4: for (int i = 0; i < n; i++) output[i] = input0[i] * input1[i]; break;
+    case 5: for (int i = 0; i < n; i++) output[i] = input0[i] * constant; break;
+    case 6: for (int i = 0; i < n; i++) output[i] = input0[i] / input1[i]; break;
+    case 7: for (int i = 0; i < n; i++) output[i] = input0[i] / constant; break;
+    case 8: for (int i = 0; i < n; i++) output[i] = constant; break;
+    default: break;
+  }
+}
+
+static void arrayArithmetic(int kernel, float *input0, float *input1, float *output, int n) {
+  float constant = input1[0];
+  switch (kernel) {
+    case 0: ArrayArithmetic::add(input0, input1, output, 0, n); break;
+    case 1: ArrayArithmetic::add(input0, constant, output, 0, n); break;
+    case 2: ArrayArithmetic::subtract(input0, input1, output, 0, n); break;
+    case 3: ArrayArithmetic::subtract(input0, constant, output, 0, n); break;
+    case 4: ArrayArithmetic::multiply(input0, input1, output, 0, n); break;
+    case 5: ArrayArithmetic::multiply(input0, constant, output, 0, n); break;
+    case 6: ArrayArithmetic::divide(input0, input1, output, 0, n); break;
+    case 7: ArrayArithmetic::divide(input0, constant, output, 0, n); break;
+    case 8: ArrayArithmetic::fill(output, constant, 0, n); break;
+    default: break;
+  }
+}
+
+int main(int argc, char * const argv[]) {
+  #if ARRAY_ARITHMETIC_DISPATCH
+  const char *pathNames[] = {"loop", "SSE", "AVX", "AVX-512"};
+  ArrayArithmetic::InstructionSet instructionSets[] = {
+    ArrayArithmetic::SSE, ArrayArithmetic::SSE, ArrayArithmetic::AVX, ArrayArithmetic::AVX512
+  };
+  int numPaths = 4;
+  #else
+  const char *pathNames[] = {"loop", "ArrayArithmetic"};
+  int numPaths = 2;
+  #endif
+  
+  float *input0 = ALLOC_ALIGNED_BUFFER(MAX_BLOCK_SIZE * sizeof(float));
+  float *input1 = ALLOC_ALIGNED_BUFFER(MAX_BLOCK_SIZE * sizeof(float));
+  float *expected = ALLOC_ALIGNED_BUFFER(MAX_BLOCK_SIZE * sizeof(float));
+  float *output = ALLOC_ALIGNED_BUFFER(MAX_BLOCK_SIZE * sizeof(float));
+  srand(1);
+  for (int i = 0; i < MAX_BLOCK_SIZE; i++) {
+    input0[i] = 2.0f * ((float) rand() / RAND_MAX) - 1.0f;
+    input1[i] = 0.5f + ((float) rand() / RAND_MAX);
+  }
+  
+  bool isCorrect = true;
+  printf("%-18s %6s", "kernel (ns/call)", "block");
+  for (int p = 0; p < numPaths; p++) printf(" %10s", pathNames[p]);
+  printf("\n");
+  for (int k = 0; k < NUM_KERNELS; k++) {
+    for (int n = MIN_BLOCK_SIZE; n <= MAX_BLOCK_SIZE; n <<= 1) {
+      printf("%-18s %6i", kernelNames[k], n);
+      loop(k, input0, input1, expected, n);
+      int numIterations = NUM_SAMPLES / n;
+      for (int p = 0; p < numPaths; p++) {
+        #if ARRAY_ARITHMETIC_DISPATCH
+        if (p > 0 && !ArrayArithmetic::setInstructionSet(instructionSets[p])) {
+          printf(" %10s", "-");
+          continue;
+        }
+        #endif
+        memset(output, 0, MAX_BLOCK_SIZE * sizeof(float));
+        timeval start, end;
+        gettimeofday(&start, NULL);
+        for (int i = 0; i < numIterations; i++) {
+          if (p == 0) loop(k, input0, input1, output, n);
+          else arrayArithmetic(k, input0, input1, output, n);
+        }
+        gettimeofday(&end, NULL);
+        printf(" %10.1f", 1000000.0 * elapsedMs(&start, &end) / numIterations);
+        if (memcmp(output, expected, n * sizeof(float))) isCorrect = false;
+      }
+      printf("\n");
+    }
+  }
+  printf("Kernels are correct: %s\n", isCorrect ? "YES" : "NO");
+  
+  FREE_ALIGNED_BUFFER(input0);
+  FREE_ALIGNED_BUFFER(input1);
+  FREE_ALIGNED_BUFFER(expected);
+  FREE_ALIGNED_BUFFER(output);
+  
+  return isCorrect ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _BENCHMARK_UTILS_H_
+#define _BENCHMARK_UTILS_H_
+
+/*
+ * Helpers shared by the benchmarks: timing, and setting up a context with a patch given as a
+ * netlist. Each benchmark remains a standalone executable which includes this header.
+ */
+
+#include <sys/time.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#include "ZenGarden.h"
+
+#define BENCHMARK_SAMPLE_RATE 44100.0f
+
+/** Returns the time between two calls to <code>gettimeofday()</code> in milliseconds. */
+static inline double elapsedMs(timeval *start, timeval *end) {
+  return (end->tv_sec - start->tv_sec) * 1000.0 + (end->tv_usec - start->tv_usec) / 1000.0;
+}
+
+/** Returns the time between two calls to <code>gettimeofday()</code> in microseconds. */
+static inline double elapsedUs(timeval *start, timeval *end) {
+  return (end->tv_sec - start->tv_sec) * 1000000.0 + (end->tv_usec - start->tv_usec);
+}
+
+/**
+ * The callback of a benchmark context which only prints errors. Benchmarks which listen to other
+ * callbacks pass on those which they do not handle.
+ */
+static inline void *printErrors(ZGCallbackFunction function, void *userData, void *ptr) {
+  if (function == ZG_PRINT_ERR) printf("ERROR: %s\n", (const char *) ptr);
+  return NULL;
+}
+
+/** Appends a line in <code>printf()</code> format to a netlist. */
+static inline void appendLine(std::string *netlist, const char *format, ...) {
+  char line[128];
+  va_list ap;
+  va_start(ap, format);
+  vsnprintf(line, sizeof(line), format, ap);
+  va_end(ap);
+  netlist->append(line);
+}
+
+/** Creates a context at 44.1kHz with no user data. */
+static inline ZGContext *newBenchmarkContext(int numInputChannels, int numOutputChannels,
+    int blockSize, void *(*callback)(ZGCallbackFunction, void *, void *) = printErrors) {
+  return zg_context_new(numInputChannels, numOutputChannels, blockSize, BENCHMARK_SAMPLE_RATE,
+      callback, NULL);
+}
+
+/**
+ * Creates a graph in the context from a netlist and attaches it. The benchmark exits if the
+ * netlist cannot be read, as the measurement would be meaningless.
+ */
+static inline ZGGraph *attachNetlist(ZGContext *context, const char *netlist) {
+  ZGGraph *graph = zg_context_new_graph_from_string(context, netlist);
+  if (graph == NULL) {
+    printf("ERROR: the patch of the benchmark could not be created.\n");
+    exit(1);
+  }
+  zg_graph_attach(graph);
+  return graph;
+}
+
+#endif // _BENCHMARK_UTILS_H_
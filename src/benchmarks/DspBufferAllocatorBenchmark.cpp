@@ -0,0 +1,119 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A benchmark of the liveness-based signal buffer allocation. A patch of 256 voices is created,
+ * each a chain of [osc~] -> [*~] -> [lop~] -> [hip~] summed into the left channel of [dac~]. The
+ * output of each [lop~] is also metered with an [rmstodb~] whose outlet is not connected. Every
+ * fourth voice is wrapped in a subpatch with [inlet~] and [outlet~]. The number of buffers used by the process order
+ * before and after the allocation pass is reported, along with the time taken to process the patch
+ * with the buffers in the pool and in the contiguous arena. The output of both must be identical.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "BenchmarkUtils.h"
+#include "DspBufferAllocator.h"
+#include "PdContext.h"
+#include "ZenGarden.h"
+
+#define NUM_VOICES 256
+#define BLOCK_SIZE 64
+#define NUM_BLOCKS 10000
+
+static std::string createNetlist() {
+  std::string netlist = "#N canvas 0 0 400 400 10;\n";
+  netlist.append("#X obj 0 0 dac~;\n");
+  int numObjects = 1;
+  for (int i = 0; i < NUM_VOICES; i++) {
+    int osc = numObjects;
+    appendLine(&netlist, "#X obj 0 0 osc~ %i;\n", 100 + i);
+    if (i % 4 == 0) {
+      // a voice in a subpatch
+      netlist.append("#N canvas 0 0 400 400 voice 0;\n");
+      netlist.append("#X obj 0 0 inlet~;\n");
+      netlist.append("#X obj 0 0 *~ 0.01;\n");
+      netlist.append("#X obj 0 0 lop~ 1000;\n");
+      netlist.append("#X obj 0 0 hip~ 10;\n");
+      netlist.append("#X obj 0 0 outlet~;\n");
+      netlist.append("#X obj 0 0 clip~ -1 1;\n");
+      netlist.append("#X connect 0 0 1 0;\n#X connect 1 0 2 0;\n#X connect 2 0 3 0;\n");
+      netlist.append("#X connect 3 0 4 0;\n#X connect 2 0 5 0;\n");
+      netlist.append("#X restore 0 0 pd voice;\n");
+      appendLine(&netlist, "#X connect %i 0 ", osc);
+      appendLine(&netlist, "%i 0;\n", osc + 1);
+      appendLine(&netlist, "#X connect %i 0 0 0;\n", osc + 1);
+      numObjects += 2;
+    } else {
+      netlist.append("#X obj 0 0 *~ 0.01;\n");
+      netlist.append("#X obj 0 0 lop~ 1000;\n");
+      netlist.append("#X obj 0 0 hip~ 10;\n");
+      netlist.append("#X obj 0 0 clip~ -1 1;\n");
+      for (int j = 0; j < 3; j++) {
+        appendLine(&netlist, "#X connect %i 0 ", osc + j);
+        appendLine(&netlist, "%i 0;\n", osc + j + 1);
+      }
+      appendLine(&netlist, "#X connect %i 0 ", osc + 2);
+      appendLine(&netlist, "%i 0;\n", osc + 4);
+      appendLine(&netlist, "#X connect %i 0 0 0;\n", osc + 3);
+      numObjects += 5;
+    }
+  }
+  return netlist;
+}
+
+static double run(bool isArenaEnabled, float *output) {
+  PdContext *context = newBenchmarkContext(0, 2, BLOCK_SIZE);
+  context->getBufferAllocator()->setArenaEnabled(isArenaEnabled);
+  attachNetlist(context, createNetlist().c_str());
+  printf("%s: %u buffers before allocation, %u after.\n",
+      isArenaEnabled ? "Arena" : "Pool ",
+      context->getBufferAllocator()->getNumBuffersBefore(),
+      context->getBufferAllocator()->getNumBuffersAfter());
+  
+  float input[1];
+  timeval start, end;
+  gettimeofday(&start, NULL);
+  for (int i = 0; i < NUM_BLOCKS; i++) {
+    zg_context_process(context, input, output);
+  }
+  gettimeofday(&end, NULL);
+  zg_context_delete(context);
+  return elapsedMs(&start, &end);
+}
+
+int main(int argc, char * const argv[]) {
+  float poolOutput[2*BLOCK_SIZE];
+  float arenaOutput[2*BLOCK_SIZE];
+  
+  double poolMs = run(false, poolOutput);
+  double arenaMs = run(true, arenaOutput);
+  printf("Processed %i blocks in %f milliseconds (pool) and %f milliseconds (arena).\n",
+      NUM_BLOCKS, poolMs, arenaMs);
+  
+  bool isEqual = !memcmp(poolOutput, arenaOutput, sizeof(poolOutput));
+  printf("Output is identical: %s\n", isEqual ? "YES" : "NO");
+  return isEqual ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A benchmark of parallel DSP. A patch of 64 independent voices is created, each an [osc~] followed
+ * by eight [lop~] -> [hip~] stages and a [*~]. Even voices are summed into the left channel of a
+ * [dac~], odd voices are thrown to a [catch~] which feeds the right channel. The patch is processed
+ * with one (serial), two and four threads. The time taken and the number of clusters and segments
+ * of the schedule are reported. The output must be identical in all cases.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "BenchmarkUtils.h"
+#include "DspParallelScheduler.h"
+#include "PdContext.h"
+#include "ZenGarden.h"
+
+#define NUM_VOICES 64
+#define NUM_STAGES 8
+#define BLOCK_SIZE 64
+#define NUM_BLOCKS 2000
+
+static std::string createNetlist() {
+  std::string netlist = "#N canvas 0 0 400 400 10;\n";
+  netlist.append("#X obj 0 0 dac~;\n");
+  netlist.append("#X obj 0 0 catch~ bus;\n");
+  netlist.append("#X connect 1 0 0 1;\n");
+  int numObjects = 2;
+  for (int i = 0; i < NUM_VOICES; i++) {
+    int osc = numObjects;
+    appendLine(&netlist, "#X obj 0 0 osc~ %i;\n", 100 + 10*i, 0);
+    for (int j = 0; j < NUM_STAGES; j++) {
+      netlist.append("#X obj 0 0 lop~ 5000;\n");
+      netlist.append("#X obj 0 0 hip~ 20;\n");
+    }
+    netlist.append("#X obj 0 0 *~ 0.01;\n");
+    int last = osc + 2*NUM_STAGES + 1;
+    for (int j = osc; j < last; j++) {
+      appendLine(&netlist, "#X connect %i 0 %i 0;\n", j, j + 1);
+    }
+    if (i % 2 == 0) {
+      appendLine(&netlist, "#X connect %i 0 %i 0;\n", last, 0);
+      numObjects = last + 1;
+    } else {
+      netlist.append("#X obj 0 0 throw~ bus;\n");
+      appendLine(&netlist, "#X connect %i 0 %i 0;\n", last, last + 1);
+      numObjects = last + 2;
+    }
+  }
+  return netlist;
+}
+
+static double run(unsigned int numThreads, float *output, double *checksum) {
+  PdContext *context = newBenchmarkContext(0, 2, BLOCK_SIZE);
+  attachNetlist(context, createNetlist().c_str());
+  zg_context_set_num_dsp_threads(context, numThreads);
+  if (context->getParallelScheduler() != NULL) {
+    printf("%u threads: %u clusters in %u segments.\n", numThreads,
+        context->getParallelScheduler()->getNumClusters(),
+        context->getParallelScheduler()->getNumSegments());
+  }
+  
+  float input[1];
+  *checksum = 0.0;
+  timeval start, end;
+  gettimeofday(&start, NULL);
+  for (int i = 0; i < NUM_BLOCKS; i++) {
+    zg_context_process(context, input, output);
+    for (int j = 0; j < 2*BLOCK_SIZE; j++) {
+      *checksum += output[j];
+    }
+  }
+  gettimeofday(&end, NULL);
+  zg_context_delete(context);
+  return elapsedMs(&start, &end);
+}
+
+int main(int argc, char * const argv[]) {
+  float serialOutput[2*BLOCK_SIZE];
+  double serialChecksum = 0.0;
+  double serialMs = run(1, serialOutput, &serialChecksum);
+  printf("1 thread: processed %i blocks in %f milliseconds.\n", NUM_BLOCKS, serialMs);
+  
+  bool isEqual = true;
+  unsigned int numThreads[] = {2, 4};
+  for (int i = 0; i < 2; i++) {
+    float output[2*BLOCK_SIZE];
+    double checksum = 0.0;
+    double ms = run(numThreads[i], output, &checksum);
+    printf("%u threads: processed %i blocks in %f milliseconds.\n", numThreads[i], NUM_BLOCKS, ms);
+    isEqual = isEqual && !memcmp(serialOutput, output, sizeof(output)) && (checksum == serialChecksum);
+  }
+  printf("Output is identical: %s\n", isEqual ? "YES" : "NO");
+  return isEqual ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A benchmark of messages sent to a context from other threads while it is processed. Four threads
+ * each send 20000 messages to [r foo], pausing briefly between them, while the context processes a
+ * bank of oscillators. The messages are forwarded to [s out], such that the number delivered and
+ * their order per thread may be checked. The time taken by each send is measured with the message
+ * queue, and while locking the context around the send as was previously done. The average and
+ * largest times, the number of messages dropped because the queue was full, and the largest number
+ * waiting at the start of a block are reported.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+#include "BenchmarkUtils.h"
+#include "ExternalMessageQueue.h"
+#include "PdContext.h"
+#include "ZenGarden.h"
+
+#define NUM_SENDERS 4
+#define NUM_MESSAGES 20000
+#define NUM_VOICES 64
+#define BLOCK_SIZE 64
+
+typedef struct Sender {
+  PdContext *context;
+  int index;
+  bool isLocking;
+  double totalUs;
+  double maxUs;
+  pthread_t thread;
+} Sender;
+
+static int lastIndex[NUM_SENDERS];
+static int numReceived;
+static bool isOrdered;
+
+static void *callbackFunction(ZGCallbackFunction function, void *userData, void *ptr) {
+  switch (function) {
+    case ZG_RECEIVER_MESSAGE: {
+      // called while the context is processed, so no synchronisation is needed
+      PdMessage *message = ((ZGReceiverMessagePair *) ptr)->message;
+      int sender = (int) message->getFloat(0);
+      int index = (int) message->getFloat(1);
+      if (index <= lastIndex[sender]) isOrdered = false;
+      lastIndex[sender] = index;
+      numReceived++;
+      break;
+    }
+    default: return printErrors(function, userData, ptr);
+  }
+  return NULL;
+}
+
+static void *sendMessages(void *userData) {
+  Sender *sender = (Sender *) userData;
+  timeval start, end;
+  for (int i = 0; i < NUM_MESSAGES; i++) {
+    gettimeofday(&start, NULL);
+    if (sender->isLocking) sender->context->lock();
+    zg_context_send_messageV(sender->context, "foo", 0.0, "ff", (float) sender->index, (float) i);
+    if (sender->isLocking) sender->context->unlock();
+    gettimeofday(&end, NULL);
+    double us = elapsedUs(&start, &end);
+    sender->totalUs += us;
+    if (us > sender->maxUs) sender->maxUs = us;
+    usleep(50);
+  }
+  return NULL;
+}
+
+static std::string createNetlist() {
+  std::string netlist = "#N canvas 0 0 400 400 10;\n";
+  netlist.append("#X obj 0 0 r foo;\n");
+  netlist.append("#X obj 0 0 s out;\n");
+  netlist.append("#X obj 0 0 dac~;\n");
+  netlist.append("#X connect 0 0 1 0;\n");
+  for (int i = 0; i < NUM_VOICES; i++) {
+    appendLine(&netlist, "#X obj 0 0 osc~ %i;\n", 100 + 10*i);
+    appendLine(&netlist, "#X connect %i 0 2 %i;\n", 3 + i, i % 2);
+  }
+  return netlist;
+}
+
+static bool run(bool isLocking) {
+  PdContext *context = newBenchmarkContext(0, 2, BLOCK_SIZE, callbackFunction);
+  attachNetlist(context, createNetlist().c_str());
+  zg_context_register_receiver(context, "out");
+  float *output = (float *) malloc(2 * BLOCK_SIZE * sizeof(float));
+  
+  for (int i = 0; i < NUM_SENDERS; i++) lastIndex[i] = -1;
+  numReceived = 0;
+  isOrdered = true;
+  Sender senders[NUM_SENDERS];
+  for (int i = 0; i < NUM_SENDERS; i++) {
+    senders[i].context = context;
+    senders[i].index = i;
+    senders[i].isLocking = isLocking;
+    senders[i].totalUs = 0.0;
+    senders[i].maxUs = 0.0;
+    pthread_create(&senders[i].thread, NULL, &sendMessages, &senders[i]);
+  }
+  
+  // process until every message has been received, or dropped
+  ExternalMessageQueue *queue = context->getExternalMessageQueue();
+  while (numReceived + queue->getNumDropped() < NUM_SENDERS * NUM_MESSAGES) {
+    zg_context_process(context, NULL, output);
+  }
+  
+  double totalUs = 0.0;
+  double maxUs = 0.0;
+  for (int i = 0; i < NUM_SENDERS; i++) {
+    pthread_join(senders[i].thread, NULL);
+    totalUs += senders[i].totalUs;
+    if (senders[i].maxUs > maxUs) maxUs = senders[i].maxUs;
+  }
+  unsigned int numSent = 0;
+  unsigned int numDropped = 0;
+  unsigned int maxNumQueued = 0;
+  zg_context_get_message_queue_stats(context, &numSent, &numDropped, &maxNumQueued);
+  printf("%-16s %10.2f %10.0f %10u %10u\n", isLocking ? "context locked" : "message queue",
+      totalUs / (NUM_SENDERS * NUM_MESSAGES), maxUs, numDropped, maxNumQueued);
+  bool isCorrect = isOrdered && numSent == NUM_SENDERS * NUM_MESSAGES &&
+      numReceived + numDropped == numSent;
+  
+  free(output);
+  zg_context_delete(context);
+  return isCorrect;
+}
+
+int main(int argc, char * const argv[]) {
+  printf("%-16s %10s %10s %10s %10s\n", "", "mean us", "max us", "dropped", "max queued");
+  bool isCorrect = run(true);
+  isCorrect = run(false) && isCorrect;
+  printf("Messages are delivered in order: %s\n", isCorrect ? "YES" : "NO");
+  
+  return isCorrect ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A benchmark of fused chains of elementwise objects. A patch of 64 independent voices is created,
+ * each an [osc~] followed by [*~ 0.5] -> [+~ 0.1] -> [clip~ -0.5 0.5] -> [*~] (with a [phasor~]
+ * operand) -> [-~ 0.05] -> [/~ 2] -> [wrap~] -> [*~ 0.01], summed into a [dac~]. The patch is
+ * processed with and without fusing. The time taken is reported, and the output must be identical.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "BenchmarkUtils.h"
+#include "ZenGarden.h"
+
+#define NUM_VOICES 64
+#define BLOCK_SIZE 64
+#define NUM_BLOCKS 20000
+
+static const char *chain[] = {
+  "*~ 0.5", "+~ 0.1", "clip~ -0.5 0.5", "*~", "-~ 0.05", "/~ 2", "wrap~", "*~ 0.01", NULL
+};
+
+static std::string createNetlist() {
+  std::string netlist = "#N canvas 0 0 400 400 10;\n";
+  netlist.append("#X obj 0 0 dac~;\n");
+  int numObjects = 1;
+  for (int i = 0; i < NUM_VOICES; i++) {
+    int osc = numObjects;
+    appendLine(&netlist, "#X obj 0 0 osc~ %i;\n", 100 + 10*i, 0);
+    appendLine(&netlist, "#X obj 0 0 phasor~ %i;\n", 1 + i, 0);
+    int j = osc + 2;
+    for (int k = 0; chain[k] != NULL; k++, j++) {
+      netlist.append("#X obj 0 0 ").append(chain[k]).append(";\n");
+      appendLine(&netlist, "#X connect %i 0 %i 0;\n", (k == 0) ? osc : j - 1, j);
+      if (!strcmp(chain[k], "*~")) appendLine(&netlist, "#X connect %i 0 %i 1;\n", osc + 1, j);
+    }
+    appendLine(&netlist, "#X connect %i 0 %i 0;\n", j - 1, 0);
+    numObjects = j;
+  }
+  return netlist;
+}
+
+static double run(bool isFusionEnabled, float *output, double *checksum) {
+  ZGContext *context = newBenchmarkContext(0, 2, BLOCK_SIZE);
+  zg_context_set_fusion_enabled(context, isFusionEnabled ? 1 : 0);
+  attachNetlist(context, createNetlist().c_str());
+  
+  float input[1];
+  *checksum = 0.0;
+  timeval start, end;
+  gettimeofday(&start, NULL);
+  for (int i = 0; i < NUM_BLOCKS; i++) {
+    zg_context_process(context, input, output);
+    for (int j = 0; j < 2*BLOCK_SIZE; j++) {
+      *checksum += output[j];
+    }
+  }
+  gettimeofday(&end, NULL);
+  zg_context_delete(context);
+  return elapsedMs(&start, &end);
+}
+
+int main(int argc, char * const argv[]) {
+  float separateOutput[2*BLOCK_SIZE];
+  double separateChecksum = 0.0;
+  double separateMs = run(false, separateOutput, &separateChecksum);
+  printf("separate: processed %i blocks in %f milliseconds.\n", NUM_BLOCKS, separateMs);
+  
+  float fusedOutput[2*BLOCK_SIZE];
+  double fusedChecksum = 0.0;
+  double fusedMs = run(true, fusedOutput, &fusedChecksum);
+  printf("fused: processed %i blocks in %f milliseconds.\n", NUM_BLOCKS, fusedMs);
+  
+  bool isEqual = !memcmp(separateOutput, fusedOutput, sizeof(fusedOutput)) &&
+      (separateChecksum == fusedChecksum);
+  printf("Output is identical: %s\n", isEqual ? "YES" : "NO");
+  return isEqual ? 0 : 1;
+}
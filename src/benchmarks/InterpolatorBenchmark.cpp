@@ -0,0 +1,209 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A benchmark of the 4-point interpolation shared by [tabread4~] and [vd~]. A bank of 1000 voices,
+ * each reading a table and a delay line at its own rate, is processed in blocks of 64 samples. On x86
+ * builds with runtime dispatch, this is repeated with each instruction set which the processor
+ * supports. The linear interpolation with branches which
+ * both objects previously used is timed as well. The time per voice per block is reported, and the
+ * outputs of all instruction sets are checked against a scalar reference of Pd's interpolation.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ArrayArithmetic.h"
+#include "BenchmarkUtils.h"
+#include "DspObject.h"
+#include "Interpolator.h"
+
+#define NUM_VOICES 1000
+#define BLOCK_SIZE 64
+#define NUM_BLOCKS 2000
+#define SAMPLE_RATE 44100.0f
+#define TABLE_SIZE 4096
+#define DELAY_LENGTH 4096 // the length of the delay line, as [delwrite~] would allocate it
+
+static float referenceInterpolation(float a, float b, float c, float d, float frac) {
+  float cminusb = c - b;
+  return b + frac * (cminusb - 0.1666667f * (1.0f - frac) *
+      ((d - a - 3.0f * cminusb) * frac + (d + 2.0f * a - 3.0f * b)));
+}
+
+// the former [tabread4~]
+static void linearTableRead(float *table, int length, float *index, float *output, int n) {
+  int maxIndex = length - 1;
+  for (int i = 0; i < n; i++) {
+    float xf = index[i];
+    int xi = (int) xf;
+    if (xi <= 0) {
+      output[i] = table[0];
+    } else if (xi >= maxIndex) {
+      output[i] = table[maxIndex];
+    } else {
+      float dx = xf - ((float) xi);
+      output[i] = ((table[xi+1] - table[xi]) * dx) + table[xi];
+    }
+  }
+}
+
+// the former [vd~], which relied on a guard sample at the end of the delay line
+static void linearDelayRead(float *buffer, int length, int position, float *delay, float *output, int n) {
+  float lengthFloat = (float) length;
+  float base = (float) position;
+  for (int i = 0; i < n; i++, base += 1.0f) {
+    float samples = delay[i] * (SAMPLE_RATE / 1000.0f);
+    if (samples < 0.0f) {
+      samples = 0.0f;
+    } else if (samples > lengthFloat) {
+      samples = lengthFloat;
+    }
+    float x = base - samples;
+    if (x < 0.0f) x += lengthFloat;
+    int x0 = (int) x;
+    float dx = x - ((float) x0);
+    output[i] = ((buffer[x0+1] - buffer[x0]) * dx) + buffer[x0];
+  }
+}
+
+static void report(const char *name, double tableMs, double delayMs) {
+  double scale = 1000000.0 / ((double) NUM_VOICES * NUM_BLOCKS);
+  printf("%-10s %20.1f %20.1f\n", name, tableMs * scale, delayMs * scale);
+}
+
+int main(int argc, char * const argv[]) {
+  float *table = ALLOC_ALIGNED_BUFFER(TABLE_SIZE * sizeof(float));
+  float *buffer = ALLOC_ALIGNED_BUFFER((DELAY_LENGTH+1) * sizeof(float));
+  float *indices = ALLOC_ALIGNED_BUFFER(NUM_VOICES * BLOCK_SIZE * sizeof(float));
+  float *delays = ALLOC_ALIGNED_BUFFER(NUM_VOICES * BLOCK_SIZE * sizeof(float));
+  float *output = ALLOC_ALIGNED_BUFFER(BLOCK_SIZE * sizeof(float));
+  for (int i = 0; i < TABLE_SIZE; i++) {
+    table[i] = sinf(2.0f * M_PI * ((float) i) / TABLE_SIZE);
+  }
+  for (int i = 0; i < DELAY_LENGTH; i++) {
+    buffer[i] = ((float) rand()) / RAND_MAX - 0.5f;
+  }
+  buffer[DELAY_LENGTH] = buffer[0];
+  // each voice sweeps through the table and the delay line at its own rate, partly out of range
+  for (int v = 0; v < NUM_VOICES; v++) {
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+      float phase = fmodf((v * 37.0f + i * (1.0f + v * 0.01f)) / TABLE_SIZE, 1.0f);
+      indices[v*BLOCK_SIZE+i] = phase * (TABLE_SIZE + 20) - 10.0f;
+      delays[v*BLOCK_SIZE+i] = phase * 1000.0f * (DELAY_LENGTH + 64) / SAMPLE_RATE;
+    }
+  }
+  float maxDelay = (float) (DELAY_LENGTH - BLOCK_SIZE - 2);
+  timeval start, end;
+  double tableMs, delayMs;
+  printf("%-10s %20s %20s\n", "", "tabread4~ ns/block", "vd~ ns/block");
+
+  gettimeofday(&start, NULL);
+  for (int b = 0; b < NUM_BLOCKS; b++) {
+    for (int v = 0; v < NUM_VOICES; v++) {
+      linearTableRead(table, TABLE_SIZE, indices + v*BLOCK_SIZE, output, BLOCK_SIZE);
+    }
+  }
+  gettimeofday(&end, NULL);
+  tableMs = elapsedMs(&start, &end);
+  gettimeofday(&start, NULL);
+  for (int b = 0; b < NUM_BLOCKS; b++) {
+    for (int v = 0; v < NUM_VOICES; v++) {
+      linearDelayRead(buffer, DELAY_LENGTH, (b * BLOCK_SIZE) % DELAY_LENGTH, delays + v*BLOCK_SIZE,
+          output, BLOCK_SIZE);
+    }
+  }
+  gettimeofday(&end, NULL);
+  delayMs = elapsedMs(&start, &end);
+  report("linear", tableMs, delayMs);
+
+  #if ARRAY_ARITHMETIC_DISPATCH
+  const char *pathNames[] = {"SSE", "AVX", "AVX-512"};
+  ArrayArithmetic::InstructionSet instructionSets[] = {
+    ArrayArithmetic::SSE, ArrayArithmetic::AVX, ArrayArithmetic::AVX512
+  };
+  int numPaths = 3;
+  #else
+  const char *pathNames[] = {"4-point"};
+  int numPaths = 1;
+  #endif
+  bool isCorrect = true;
+  for (int p = 0; p < numPaths; p++) {
+    #if ARRAY_ARITHMETIC_DISPATCH
+    if (!ArrayArithmetic::setInstructionSet(instructionSets[p])) continue;
+    #endif
+
+    gettimeofday(&start, NULL);
+    for (int b = 0; b < NUM_BLOCKS; b++) {
+      for (int v = 0; v < NUM_VOICES; v++) {
+        Interpolator::readClipped(table, TABLE_SIZE, indices + v*BLOCK_SIZE, 0.0f, output, BLOCK_SIZE);
+      }
+    }
+    gettimeofday(&end, NULL);
+    tableMs = elapsedMs(&start, &end);
+    for (int v = 0; v < NUM_VOICES; v++) {
+      Interpolator::readClipped(table, TABLE_SIZE, indices + v*BLOCK_SIZE, 0.0f, output, BLOCK_SIZE);
+      for (int i = 0; i < BLOCK_SIZE; i++) {
+        float f = fminf(fmaxf(indices[v*BLOCK_SIZE+i], 1.0f), (float) (TABLE_SIZE - 2));
+        int x = (int) f;
+        if (x > TABLE_SIZE - 3) x = TABLE_SIZE - 3;
+        if (output[i] != referenceInterpolation(table[x-1], table[x], table[x+1], table[x+2], f - x)) {
+          isCorrect = false;
+        }
+      }
+    }
+
+    gettimeofday(&start, NULL);
+    for (int b = 0; b < NUM_BLOCKS; b++) {
+      for (int v = 0; v < NUM_VOICES; v++) {
+        Interpolator::readDelayed(buffer, DELAY_LENGTH, (b * BLOCK_SIZE) % DELAY_LENGTH,
+            delays + v*BLOCK_SIZE, SAMPLE_RATE / 1000.0f, maxDelay, output, BLOCK_SIZE);
+      }
+    }
+    gettimeofday(&end, NULL);
+    delayMs = elapsedMs(&start, &end);
+    for (int v = 0; v < NUM_VOICES; v++) {
+      Interpolator::readDelayed(buffer, DELAY_LENGTH, 0, delays + v*BLOCK_SIZE, SAMPLE_RATE / 1000.0f,
+          maxDelay, output, BLOCK_SIZE);
+      for (int i = 0; i < BLOCK_SIZE; i++) {
+        float samples = fmaxf(fminf(delays[v*BLOCK_SIZE+i] * (SAMPLE_RATE / 1000.0f), maxDelay), 1.0f);
+        int x = i - (int) samples + DELAY_LENGTH;
+        float expected = referenceInterpolation(buffer[(x+1) % DELAY_LENGTH], buffer[x % DELAY_LENGTH],
+            buffer[(x-1) % DELAY_LENGTH], buffer[(x-2) % DELAY_LENGTH], samples - (int) samples);
+        if (output[i] != expected) isCorrect = false;
+      }
+    }
+    report(pathNames[p], tableMs, delayMs);
+  }
+
+  printf("Interpolation is correct: %s\n", isCorrect ? "YES" : "NO");
+
+  FREE_ALIGNED_BUFFER(table);
+  FREE_ALIGNED_BUFFER(buffer);
+  FREE_ALIGNED_BUFFER(indices);
+  FREE_ALIGNED_BUFFER(delays);
+  FREE_ALIGNED_BUFFER(output);
+
+  return isCorrect ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A benchmark of the random generator of [noise~] and [random]. A bank of 1000 voices of noise is
+ * processed in blocks of 64 samples, with RandomGenerator and with the Mersenne Twister which both
+ * objects previously used. The time per voice per block and the number of voices which could run in
+ * real time at 44100Hz are reported, and the mean and variance of the noise are checked against
+ * those of a uniform distribution on [-1,1).
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "BenchmarkUtils.h"
+#include "DspObject.h"
+#include "MersenneTwister.h"
+#include "RandomGenerator.h"
+
+#define NUM_VOICES 1000
+#define BLOCK_SIZE 64
+#define NUM_BLOCKS 2000
+#define SAMPLE_RATE 44100.0f
+
+static void report(const char *name, double ms) {
+  double nsPerBlock = 1000000.0 * ms / ((double) NUM_VOICES * NUM_BLOCKS);
+  double realTimeVoices = (1000.0 * BLOCK_SIZE / SAMPLE_RATE) * 1000000.0 / nsPerBlock;
+  printf("%-18s %15.1f %17.0f\n", name, nsPerBlock, realTimeVoices);
+}
+
+int main(int argc, char * const argv[]) {
+  float *output = ALLOC_ALIGNED_BUFFER(BLOCK_SIZE * sizeof(float));
+  timeval start, end;
+  printf("%-18s %15s %17s\n", "", "ns/voice/block", "real-time voices");
+
+  MTRand **twisters = new MTRand*[NUM_VOICES];
+  for (int v = 0; v < NUM_VOICES; v++) twisters[v] = new MTRand(v);
+  gettimeofday(&start, NULL);
+  for (int b = 0; b < NUM_BLOCKS; b++) {
+    for (int v = 0; v < NUM_VOICES; v++) {
+      for (int i = 0; i < BLOCK_SIZE; i++) {
+        output[i] = ((float) twisters[v]->rand(2.0)) - 1.0f;
+      }
+    }
+  }
+  gettimeofday(&end, NULL);
+  report("Mersenne Twister", elapsedMs(&start, &end));
+  for (int v = 0; v < NUM_VOICES; v++) delete twisters[v];
+  delete[] twisters;
+
+  RandomGenerator **generators = new RandomGenerator*[NUM_VOICES];
+  for (int v = 0; v < NUM_VOICES; v++) generators[v] = new RandomGenerator(v);
+  gettimeofday(&start, NULL);
+  for (int b = 0; b < NUM_BLOCKS; b++) {
+    for (int v = 0; v < NUM_VOICES; v++) {
+      generators[v]->fill(output, BLOCK_SIZE);
+    }
+  }
+  gettimeofday(&end, NULL);
+  report("RandomGenerator", elapsedMs(&start, &end));
+
+  // the statistics of the first voice, continuing after the timed blocks
+  double sum = 0.0;
+  double sumOfSquares = 0.0;
+  for (int b = 0; b < NUM_BLOCKS; b++) {
+    generators[0]->fill(output, BLOCK_SIZE);
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+      sum += output[i];
+      sumOfSquares += output[i] * output[i];
+    }
+  }
+  for (int v = 0; v < NUM_VOICES; v++) delete generators[v];
+  delete[] generators;
+
+  int numSamples = NUM_BLOCKS * BLOCK_SIZE;
+  double mean = sum / numSamples;
+  double variance = sumOfSquares / numSamples - mean * mean;
+  bool isCorrect = fabs(mean) < 0.01 && fabs(variance - 1.0/3.0) < 0.01;
+  printf("mean %.4f, variance %.4f (uniform: 0, %.4f)\n", mean, variance, 1.0/3.0);
+  printf("Noise is uniform: %s\n", isCorrect ? "YES" : "NO");
+
+  FREE_ALIGNED_BUFFER(output);
+
+  return isCorrect ? 0 : 1;
+}
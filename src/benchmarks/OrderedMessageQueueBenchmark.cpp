@@ -0,0 +1,98 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ *
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A microbenchmark of the context message scheduler. 100k messages are scheduled with
+ * pseudo-random timestamps and half of them are cancelled again (as [delay], [metro], [pipe]
+ * and [vline~] do when they are retriggered). The remainder are drained in order, checking that
+ * messages are delivered by timestamp and that messages with equal timestamps remain in FIFO order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "BenchmarkUtils.h"
+#include "MessagePool.h"
+#include "OrderedMessageQueue.h"
+
+#define NUM_MESSAGES 100000
+
+int main(int argc, char * const argv[]) {
+  MessagePool *messagePool = new MessagePool();
+  OrderedMessageQueue *queue = new OrderedMessageQueue(messagePool);
+  MessageObject *messageObject = new MessageObject(0, 1, NULL);
+  PdMessage **handles = (PdMessage **) malloc(NUM_MESSAGES * sizeof(PdMessage *));
+  PdMessage *message = PD_MESSAGE_ON_STACK(1);
+  
+  timeval start, end;
+  
+  // schedule
+  srand(1);
+  gettimeofday(&start, NULL);
+  for (int i = 0; i < NUM_MESSAGES; i++) {
+    // quantise timestamps such that many messages share the same one
+    message->initWithTimestampAndFloat((double) (rand() % 10000), (float) i);
+    handles[i] = queue->insertMessage(messageObject, 0, message);
+  }
+  gettimeofday(&end, NULL);
+  printf("Scheduled %i messages in %f milliseconds.\n", NUM_MESSAGES, elapsedMs(&start, &end));
+  
+  // cancel every other message, in a scrambled order
+  gettimeofday(&start, NULL);
+  for (int i = 0; i < NUM_MESSAGES/2; i++) {
+    int j = (int) ((i * 7919L) % (NUM_MESSAGES/2)) * 2;
+    queue->removeMessage(messageObject, 0, handles[j]);
+  }
+  gettimeofday(&end, NULL);
+  printf("Cancelled %i messages in %f milliseconds.\n", NUM_MESSAGES/2, elapsedMs(&start, &end));
+  
+  // drain, verifying the delivery order
+  bool isOrdered = true;
+  double lastTimestamp = -1.0;
+  float lastIndex = -1.0f;
+  int numDelivered = 0;
+  gettimeofday(&start, NULL);
+  while (!queue->empty()) {
+    PdMessage *nextMessage = queue->peek().second.first;
+    queue->pop();
+    if (nextMessage->getTimestamp() < lastTimestamp ||
+        (nextMessage->getTimestamp() == lastTimestamp && nextMessage->getFloat(0) < lastIndex) ||
+        ((int) nextMessage->getFloat(0)) % 2 == 0) {
+      isOrdered = false;
+    }
+    lastTimestamp = nextMessage->getTimestamp();
+    lastIndex = nextMessage->getFloat(0);
+    queue->freeMessage(nextMessage);
+    numDelivered++;
+  }
+  gettimeofday(&end, NULL);
+  printf("Delivered %i messages in %f milliseconds.\n", numDelivered, elapsedMs(&start, &end));
+  printf("Message pool: %u hits, %u misses.\n", messagePool->getNumHits(), messagePool->getNumMisses());
+  printf("Delivery order is correct: %s\n", (isOrdered && numDelivered == NUM_MESSAGES/2) ? "YES" : "NO");
+  
+  free(handles);
+  delete messageObject;
+  delete queue;
+  delete messagePool;
+  
+  return (isOrdered && numDelivered == NUM_MESSAGES/2) ? 0 : 1;
+}
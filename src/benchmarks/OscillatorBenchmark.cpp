@@ -0,0 +1,184 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A benchmark of the oscillator core shared by [osc~], [phasor~] and [cos~]. A bank of 1000 voices,
+ * each with its own frequency, is processed in blocks of 64 samples. The cosine of a constant and
+ * of a per-sample frequency, the ramp of [phasor~] and the cosine of [cos~] are timed, along with
+ * the interpolated table lookup with fmod() which [osc~] previously used. The time per voice per
+ * block, the number of voices which could run in real time at 44100Hz, and the largest error of
+ * the cosine relative to double precision are reported.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "BenchmarkUtils.h"
+#include "DspObject.h"
+#include "PhaseAccumulator.h"
+
+#define NUM_VOICES 1000
+#define BLOCK_SIZE 64
+#define NUM_BLOCKS 2000
+#define SAMPLE_RATE 44100.0f
+#define COS_TABLE_SIZE 32768
+#define MAX_ERROR 1e-5
+
+static float *cosTable;
+
+// the former [osc~], a linearly interpolated table lookup with a floating-point phase
+static float tableOscillator(float phase, float frequency, float *output, int n) {
+  float tableSizeFloat = (float) (COS_TABLE_SIZE - 1);
+  float addend = frequency * tableSizeFloat / SAMPLE_RATE;
+  for (int i = 0; i < n; i++) {
+    unsigned int lower = (unsigned int) phase;
+    float fraction = phase - lower;
+    output[i] = (1.0f - fraction) * cosTable[lower] + fraction * cosTable[lower + 1];
+    phase = fmodf(phase + addend, tableSizeFloat);
+  }
+  return phase;
+}
+
+static void report(const char *name, double ms, bool hasError, double error) {
+  double nsPerBlock = 1000000.0 * ms / ((double) NUM_VOICES * NUM_BLOCKS);
+  double realTimeVoices = (1000.0 * BLOCK_SIZE / SAMPLE_RATE) * 1000000.0 / nsPerBlock;
+  if (hasError) {
+    printf("%-28s %15.1f %17.0f %12.3g\n", name, nsPerBlock, realTimeVoices, error);
+  } else {
+    printf("%-28s %15.1f %17.0f %12s\n", name, nsPerBlock, realTimeVoices, "-");
+  }
+}
+
+int main(int argc, char * const argv[]) {
+  float *frequencies = (float *) malloc(NUM_VOICES * sizeof(float));
+  uint32_t *phases = (uint32_t *) malloc(NUM_VOICES * sizeof(uint32_t));
+  uint32_t *increments = (uint32_t *) malloc(NUM_VOICES * sizeof(uint32_t));
+  float *tablePhases = (float *) malloc(NUM_VOICES * sizeof(float));
+  float *input = ALLOC_ALIGNED_BUFFER(BLOCK_SIZE * sizeof(float));
+  float *output = ALLOC_ALIGNED_BUFFER(NUM_VOICES * BLOCK_SIZE * sizeof(float));
+  cosTable = ALLOC_ALIGNED_BUFFER(COS_TABLE_SIZE * sizeof(float));
+  for (int i = 0; i < COS_TABLE_SIZE; i++) {
+    cosTable[i] = cosf(2.0f * M_PI * ((float) i) / (COS_TABLE_SIZE - 1));
+  }
+  for (int i = 0; i < NUM_VOICES; i++) {
+    frequencies[i] = 50.0f + 10.0f * i;
+    increments[i] = PhaseAccumulator::getIncrement(frequencies[i], SAMPLE_RATE);
+  }
+  for (int i = 0; i < BLOCK_SIZE; i++) {
+    input[i] = 440.0f + i;
+  }
+  bool isCorrect = true;
+  timeval start, end;
+  printf("%-28s %15s %17s %12s\n", "", "ns/voice/block", "real-time voices", "max error");
+
+  // measure the error of the first block of every voice, against double precision
+  #define MEASURE_ERROR(_error, _expression) { \
+    _error = 0.0; \
+    for (int v = 0; v < NUM_VOICES; v++) { \
+      for (int i = 0; i < BLOCK_SIZE; i++) { \
+        _error = fmax(_error, fabs(output[v*BLOCK_SIZE+i] - (_expression))); \
+      } \
+    } \
+  }
+  double error;
+
+  for (int v = 0; v < NUM_VOICES; v++) tablePhases[v] = 0.0f;
+  gettimeofday(&start, NULL);
+  for (int b = 0; b < NUM_BLOCKS; b++) {
+    for (int v = 0; v < NUM_VOICES; v++) {
+      tablePhases[v] = tableOscillator(tablePhases[v], frequencies[v], output + v*BLOCK_SIZE,
+          BLOCK_SIZE);
+    }
+  }
+  gettimeofday(&end, NULL);
+  for (int v = 0; v < NUM_VOICES; v++) {
+    tableOscillator(0.0f, frequencies[v], output + v*BLOCK_SIZE, BLOCK_SIZE);
+  }
+  MEASURE_ERROR(error, cos(2.0 * M_PI * frequencies[v] * i / SAMPLE_RATE));
+  report("table with fmod()", elapsedMs(&start, &end), true, error);
+
+  for (int v = 0; v < NUM_VOICES; v++) phases[v] = 0;
+  gettimeofday(&start, NULL);
+  for (int b = 0; b < NUM_BLOCKS; b++) {
+    for (int v = 0; v < NUM_VOICES; v++) {
+      phases[v] = PhaseAccumulator::cosine(phases[v], increments[v], output + v*BLOCK_SIZE,
+          BLOCK_SIZE);
+    }
+  }
+  gettimeofday(&end, NULL);
+  for (int v = 0; v < NUM_VOICES; v++) {
+    PhaseAccumulator::cosine(0, increments[v], output + v*BLOCK_SIZE, BLOCK_SIZE);
+  }
+  MEASURE_ERROR(error, cos(2.0 * M_PI * frequencies[v] * i / SAMPLE_RATE));
+  report("osc~ (constant frequency)", elapsedMs(&start, &end), true, error);
+  if (error > MAX_ERROR) isCorrect = false;
+
+  for (int v = 0; v < NUM_VOICES; v++) phases[v] = 0;
+  gettimeofday(&start, NULL);
+  for (int b = 0; b < NUM_BLOCKS; b++) {
+    for (int v = 0; v < NUM_VOICES; v++) {
+      phases[v] = PhaseAccumulator::cosine(phases[v], input, 1.0f/SAMPLE_RATE,
+          output + v*BLOCK_SIZE, BLOCK_SIZE);
+    }
+  }
+  gettimeofday(&end, NULL);
+  for (int v = 0; v < NUM_VOICES; v++) {
+    PhaseAccumulator::cosine(0, input, 1.0f/SAMPLE_RATE, output + v*BLOCK_SIZE, BLOCK_SIZE);
+  }
+  // the phase of sample i is the sum of the frequencies of the preceding samples
+  MEASURE_ERROR(error, cos(2.0 * M_PI * (440.0 * i + 0.5 * i * (i - 1)) / SAMPLE_RATE));
+  report("osc~ (signal frequency)", elapsedMs(&start, &end), true, error);
+  if (error > MAX_ERROR) isCorrect = false;
+
+  for (int v = 0; v < NUM_VOICES; v++) phases[v] = 0;
+  gettimeofday(&start, NULL);
+  for (int b = 0; b < NUM_BLOCKS; b++) {
+    for (int v = 0; v < NUM_VOICES; v++) {
+      phases[v] = PhaseAccumulator::ramp(phases[v], increments[v], output + v*BLOCK_SIZE,
+          BLOCK_SIZE);
+    }
+  }
+  gettimeofday(&end, NULL);
+  report("phasor~", elapsedMs(&start, &end), false, 0.0);
+
+  gettimeofday(&start, NULL);
+  for (int b = 0; b < NUM_BLOCKS; b++) {
+    for (int v = 0; v < NUM_VOICES; v++) {
+      PhaseAccumulator::cosine(output + v*BLOCK_SIZE, output + v*BLOCK_SIZE, BLOCK_SIZE);
+    }
+  }
+  gettimeofday(&end, NULL);
+  report("cos~", elapsedMs(&start, &end), false, 0.0);
+
+  printf("Oscillators are correct: %s\n", isCorrect ? "YES" : "NO");
+
+  free(frequencies);
+  free(phases);
+  free(increments);
+  free(tablePhases);
+  FREE_ALIGNED_BUFFER(input);
+  FREE_ALIGNED_BUFFER(output);
+  FREE_ALIGNED_BUFFER(cosTable);
+
+  return isCorrect ? 0 : 1;
+}
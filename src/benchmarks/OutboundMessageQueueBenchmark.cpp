@@ -0,0 +1,153 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A benchmark of output from a context to a slow host. Each block, eight messages are sent to
+ * [r foo], which forwards them to [s out] and [print]. The callback function takes 10 microseconds for
+ * every call, as a bridge to another language might. The time taken to process each block is measured
+ * with the callback function called on the processing thread, and with the output polled from
+ * another thread. The average and largest times per block and the number of messages dropped are
+ * reported, and the order in which messages arrive at the host is checked.
+ */
+
+#include <pthread.h>
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "BenchmarkUtils.h"
+#include "ZenGarden.h"
+
+#define NUM_BLOCKS 2000
+#define NUM_MESSAGES_PER_BLOCK 8
+#define BLOCK_SIZE 64
+#define CALLBACK_US 10.0
+
+static int numReceived;
+static int numPrinted;
+static int numDropped;
+static bool isOrdered;
+static std::atomic<bool> isProcessing;
+
+static void *callbackFunction(ZGCallbackFunction function, void *userData, void *ptr) {
+  switch (function) {
+    case ZG_PRINT_STD: numPrinted++; break;
+    case ZG_PRINT_ERR: {
+      unsigned int n = 0;
+      if (sscanf((const char *) ptr, "%u messages were dropped", &n) == 1) {
+        numDropped += n;
+      } else {
+        printErrors(function, userData, ptr);
+      }
+      break;
+    }
+    case ZG_RECEIVER_MESSAGE: {
+      ZGReceiverMessagePair *pair = (ZGReceiverMessagePair *) ptr;
+      if (strcmp(pair->receiverName, "out") != 0 ||
+          (int) zg_message_get_float(pair->message, 0) < numReceived) {
+        isOrdered = false;
+      }
+      numReceived = (int) zg_message_get_float(pair->message, 0) + 1;
+      break;
+    }
+    default: break;
+  }
+  // imitate a slow host
+  timeval start, now;
+  gettimeofday(&start, NULL);
+  do {
+    gettimeofday(&now, NULL);
+  } while (elapsedUs(&start, &now) < CALLBACK_US);
+  return NULL;
+}
+
+static void *pollMessages(void *userData) {
+  ZGContext *context = (ZGContext *) userData;
+  while (isProcessing) {
+    zg_context_poll_messages(context);
+    usleep(1000);
+  }
+  zg_context_poll_messages(context);
+  return NULL;
+}
+
+static bool run(bool isPolling) {
+  const char *netlist = "#N canvas 0 0 400 400 10;\n"
+      "#X obj 0 0 r foo;\n"
+      "#X obj 0 0 s out;\n"
+      "#X obj 0 0 print;\n"
+      "#X connect 0 0 1 0;\n"
+      "#X connect 0 0 2 0;\n";
+  ZGContext *context = newBenchmarkContext(0, 2, BLOCK_SIZE, callbackFunction);
+  attachNetlist(context, netlist);
+  zg_context_register_receiver(context, "out");
+  zg_context_set_message_polling_enabled(context, isPolling ? 1 : 0);
+  float *output = (float *) malloc(2 * BLOCK_SIZE * sizeof(float));
+  
+  numReceived = 0;
+  numPrinted = 0;
+  numDropped = 0;
+  isOrdered = true;
+  isProcessing = true;
+  pthread_t thread;
+  if (isPolling) pthread_create(&thread, NULL, &pollMessages, context);
+  
+  double totalUs = 0.0;
+  double maxUs = 0.0;
+  timeval start, end;
+  for (int i = 0; i < NUM_BLOCKS; i++) {
+    for (int j = 0; j < NUM_MESSAGES_PER_BLOCK; j++) {
+      zg_context_send_messageV(context, "foo", 0.0, "f", (float) (i * NUM_MESSAGES_PER_BLOCK + j));
+    }
+    gettimeofday(&start, NULL);
+    zg_context_process(context, NULL, output);
+    gettimeofday(&end, NULL);
+    double us = elapsedUs(&start, &end);
+    totalUs += us;
+    if (us > maxUs) maxUs = us;
+    // pace the blocks as an audio device would
+    while (elapsedUs(&start, &end) < 1000000.0 * BLOCK_SIZE / 44100.0) gettimeofday(&end, NULL);
+  }
+  
+  isProcessing = false;
+  if (isPolling) pthread_join(thread, NULL);
+  printf("%-16s %10.1f %10.0f %10d\n", isPolling ? "polled" : "callback",
+      totalUs / NUM_BLOCKS, maxUs, numDropped);
+  int numMessages = NUM_BLOCKS * NUM_MESSAGES_PER_BLOCK;
+  bool isCorrect = isOrdered && numDropped == 0 && numReceived == numMessages &&
+      numPrinted == numMessages;
+  
+  free(output);
+  zg_context_delete(context);
+  return isCorrect;
+}
+
+int main(int argc, char * const argv[]) {
+  printf("%-16s %10s %10s %10s\n", "", "mean us", "max us", "dropped");
+  bool isCorrect = run(false);
+  isCorrect = run(true) && isCorrect;
+  printf("Messages are delivered in order: %s\n", isCorrect ? "YES" : "NO");
+  
+  return isCorrect ? 0 : 1;
+}
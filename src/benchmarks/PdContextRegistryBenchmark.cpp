@@ -0,0 +1,88 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A benchmark of attaching a large graph to a context. A patch with 10k named objects is created
+ * (pairs of [send~]/[receive~], [delwrite~]/[delread~], [catch~]/[throw~] and [table]/[tabread]).
+ * Half of the receivers are created before their sender and half after, such that both orders of
+ * registration are exercised. Attaching the graph registers every object with the context by name.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#include "BenchmarkUtils.h"
+#include "ZenGarden.h"
+
+#define NUM_OBJECTS 10000
+
+int main(int argc, char * const argv[]) {
+  // each group contributes 8 named objects
+  std::string netlist = "#N canvas 0 0 400 400 10;\n";
+  for (int i = 0; i < NUM_OBJECTS/8; i++) {
+    bool isReceiverFirst = (i % 2 == 0);
+    if (isReceiverFirst) appendLine(&netlist, "#X obj 0 0 receive~ s%i;\n", i);
+    appendLine(&netlist, "#X obj 0 0 send~ s%i;\n", i);
+    if (!isReceiverFirst) appendLine(&netlist, "#X obj 0 0 receive~ s%i;\n", i);
+    
+    if (isReceiverFirst) appendLine(&netlist, "#X obj 0 0 delread~ d%i 1;\n", i);
+    appendLine(&netlist, "#X obj 0 0 delwrite~ d%i 10;\n", i);
+    if (!isReceiverFirst) appendLine(&netlist, "#X obj 0 0 delread~ d%i 1;\n", i);
+    
+    if (isReceiverFirst) appendLine(&netlist, "#X obj 0 0 throw~ c%i;\n", i);
+    appendLine(&netlist, "#X obj 0 0 catch~ c%i;\n", i);
+    if (!isReceiverFirst) appendLine(&netlist, "#X obj 0 0 throw~ c%i;\n", i);
+    
+    if (isReceiverFirst) appendLine(&netlist, "#X obj 0 0 tabread t%i;\n", i);
+    appendLine(&netlist, "#X obj 0 0 table t%i 16;\n", i);
+    if (!isReceiverFirst) appendLine(&netlist, "#X obj 0 0 tabread t%i;\n", i);
+  }
+  
+  ZGContext *context = newBenchmarkContext(0, 2, 64);
+  
+  timeval start, end;
+  
+  gettimeofday(&start, NULL);
+  ZGGraph *graph = zg_context_new_graph_from_string(context, netlist.c_str());
+  gettimeofday(&end, NULL);
+  printf("Created a graph with %i named objects in %f milliseconds.\n", NUM_OBJECTS, elapsedMs(&start, &end));
+  if (graph == NULL) {
+    printf("The graph could not be created.\n");
+    zg_context_delete(context);
+    return 1;
+  }
+  
+  gettimeofday(&start, NULL);
+  zg_graph_attach(graph);
+  gettimeofday(&end, NULL);
+  printf("Attached the graph in %f milliseconds.\n", elapsedMs(&start, &end));
+  
+  gettimeofday(&start, NULL);
+  zg_graph_unattach(graph);
+  gettimeofday(&end, NULL);
+  printf("Unattached the graph in %f milliseconds.\n", elapsedMs(&start, &end));
+  
+  zg_context_delete(context);
+  
+  return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A benchmark of playing a sound file from disk with [readsf~]. A 30 second stereo file is written
+ * with libsndfile and played to the end, with synchronous disk I/O and from the stream thread, and
+ * for comparison with [tabplay~] from tables filled by [soundfiler] beforehand. Blocks are processed
+ * at the rate of an audio device. The longest and the mean time taken to process a block, the
+ * memory held for the file, and the number of frames which did not reach the output are reported.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sndfile.h>
+
+#include "BenchmarkUtils.h"
+#include "ZenGarden.h"
+
+#define SOUNDFILE_PATH "/tmp/zengarden_readsf_benchmark.wav"
+#define NUM_FRAMES (30 * 44100)
+#define BLOCK_SIZE 64
+#define BLOCK_MS (1000.0 * BLOCK_SIZE / 44100.0)
+#define MAX_BLOCKS (2 * NUM_FRAMES / BLOCK_SIZE)
+#define RING_BYTES_PER_CHANNEL 262144
+
+static inline float getSample(int channel, int frame) {
+  // never zero, such that silence can be told apart from the file
+  return ((float) (frame % 1000 + 1) / 1000.0f) * (channel == 0 ? 1.0f : -1.0f);
+}
+
+static bool isFinished;
+
+static void *callbackFunction(ZGCallbackFunction function, void *userData, void *ptr) {
+  switch (function) {
+    case ZG_RECEIVER_MESSAGE: isFinished = true; break;
+    default: return printErrors(function, userData, ptr);
+  }
+  return NULL;
+}
+
+static bool writeSoundfile() {
+  SF_INFO sfInfo;
+  sfInfo.samplerate = 44100;
+  sfInfo.channels = 2;
+  sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+  SNDFILE *sndFile = sf_open(SOUNDFILE_PATH, SFM_WRITE, &sfInfo);
+  if (sndFile == NULL) return false;
+  float frames[2 * 1024];
+  for (int i = 0; i < NUM_FRAMES; i += 1024) {
+    int n = (NUM_FRAMES - i < 1024) ? NUM_FRAMES - i : 1024;
+    for (int j = 0; j < n; j++) {
+      frames[2*j] = getSample(0, i+j);
+      frames[2*j+1] = getSample(1, i+j);
+    }
+    sf_writef_float(sndFile, frames, n);
+  }
+  sf_close(sndFile);
+  return true;
+}
+
+/** Plays the file with the given netlist, which bangs [s finished] at the end. */
+static bool run(const char *name, const char *netlist, bool isSynchronous, int numKilobytes) {
+  PdContext *context = newBenchmarkContext(0, 2, BLOCK_SIZE, callbackFunction);
+  zg_context_set_disk_io_synchronous(context, isSynchronous ? 1 : 0);
+  attachNetlist(context, netlist);
+  zg_context_register_receiver(context, "finished");
+  float *output = (float *) malloc(2 * BLOCK_SIZE * sizeof(float));
+  
+  // [tabplay~] waits for the tables to be filled, [readsf~] for the file to be opened
+  zg_context_send_message_from_string(context, "play", 0.0, "open " SOUNDFILE_PATH);
+  zg_context_process(context, NULL, output);
+  usleep(100000);
+  zg_context_send_message_from_string(context, "play", 0.0, "start");
+  
+  isFinished = false;
+  double maxMs = 0.0;
+  double totalMs = 0.0;
+  int numBlocks = 0;
+  int frameIndex = 0; // the next frame of the file expected at the output
+  int numLostFrames = 0;
+  timeval start, end;
+  while (!isFinished && numBlocks < MAX_BLOCKS) {
+    gettimeofday(&start, NULL);
+    zg_context_process(context, NULL, output);
+    gettimeofday(&end, NULL);
+    double ms = elapsedMs(&start, &end);
+    if (ms > maxMs) maxMs = ms;
+    totalMs += ms;
+    numBlocks++;
+    for (int i = 0; i < BLOCK_SIZE && frameIndex < NUM_FRAMES; i++) {
+      if (output[i] == getSample(0, frameIndex) && output[BLOCK_SIZE+i] == getSample(1, frameIndex)) {
+        frameIndex++;
+      } else if (frameIndex > 0) {
+        numLostFrames++;
+      }
+    }
+    // leave the rest of the block to other threads, as an audio device would
+    if (ms < BLOCK_MS) usleep((useconds_t) (1000.0 * (BLOCK_MS - ms)));
+  }
+  numLostFrames += NUM_FRAMES - frameIndex;
+  printf("%-24s %14.3f %14.4f %12i %12i\n", name, maxMs, totalMs / numBlocks, numKilobytes,
+      numLostFrames);
+  
+  free(output);
+  zg_context_delete(context);
+  return isFinished;
+}
+
+int main(int argc, char * const argv[]) {
+  if (!writeSoundfile()) {
+    printf("The file %s could not be written.\n", SOUNDFILE_PATH);
+    return 1;
+  }
+  
+  const char *tablesNetlist = "#N canvas 0 0 400 400 10;\n"
+      "#X obj 0 0 table left;\n"
+      "#X obj 0 0 table right;\n"
+      "#X obj 0 0 r play;\n"
+      "#X obj 0 0 route open start;\n"
+      "#X msg 0 0 read -resize \\$1 left right;\n"
+      "#X obj 0 0 soundfiler;\n"
+      "#X obj 0 0 t b b;\n"
+      "#X obj 0 0 tabplay~ left;\n"
+      "#X obj 0 0 tabplay~ right;\n"
+      "#X obj 0 0 dac~;\n"
+      "#X obj 0 0 s finished;\n"
+      "#X connect 2 0 3 0;\n"
+      "#X connect 3 0 4 0;\n"
+      "#X connect 4 0 5 0;\n"
+      "#X connect 3 1 6 0;\n"
+      "#X connect 6 0 7 0;\n"
+      "#X connect 6 1 8 0;\n"
+      "#X connect 7 0 9 0;\n"
+      "#X connect 8 0 9 1;\n"
+      "#X connect 7 1 10 0;\n";
+  char streamNetlist[1024];
+  snprintf(streamNetlist, sizeof(streamNetlist), "#N canvas 0 0 400 400 10;\n"
+      "#X obj 0 0 r play;\n"
+      "#X obj 0 0 readsf~ 2 %i;\n"
+      "#X obj 0 0 dac~;\n"
+      "#X obj 0 0 s finished;\n"
+      "#X connect 0 0 1 0;\n"
+      "#X connect 1 0 2 0;\n"
+      "#X connect 1 1 2 1;\n"
+      "#X connect 1 2 3 0;\n", RING_BYTES_PER_CHANNEL);
+  
+  printf("%-24s %14s %14s %12s %12s\n", "", "max ms/block", "mean ms/block", "KB held", "lost frames");
+  int tableKilobytes = 2 * NUM_FRAMES * sizeof(float) / 1024;
+  int ringKilobytes = 2 * RING_BYTES_PER_CHANNEL / 1024;
+  bool isCorrect = run("tabplay~", tablesNetlist, true, tableKilobytes);
+  isCorrect = run("readsf~ (synchronous)", streamNetlist, true, ringKilobytes) && isCorrect;
+  isCorrect = run("readsf~ (background)", streamNetlist, false, ringKilobytes) && isCorrect;
+  printf("Files are played to the end: %s\n", isCorrect ? "YES" : "NO");
+  
+  unlink(SOUNDFILE_PATH);
+  return isCorrect ? 0 : 1;
+}
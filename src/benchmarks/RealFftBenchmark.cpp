@@ -0,0 +1,128 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A benchmark of the real FFT used by [rfft~] and [rifft~], against a naive DFT for transform
+ * lengths from 64 to 8192. For each length, the time per transform of both is reported, along with
+ * the largest error of the FFT relative to the largest bin of the DFT (computed in double
+ * precision), and the largest error of a forward and inverse transform relative to the signal.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "BenchmarkUtils.h"
+#include "DspObject.h"
+#include "RealFft.h"
+
+#define MIN_LENGTH 64
+#define MAX_LENGTH 8192
+#define MAX_ERROR 1e-4
+
+// the unique bins of the DFT, laid out as by RealFft
+static void naiveDft(float *input, double *real, double *imag, int n) {
+  for (int k = 0; k < n; k++) {
+    real[k] = 0.0;
+    imag[k] = 0.0;
+  }
+  for (int k = 0; k <= n/2; k++) {
+    double sumReal = 0.0;
+    double sumImag = 0.0;
+    for (int j = 0; j < n; j++) {
+      double phase = -2.0 * M_PI * (double) (((long) j * k) % n) / n;
+      sumReal += input[j] * cos(phase);
+      sumImag += input[j] * sin(phase);
+    }
+    real[k] = sumReal;
+    if (k > 0 && k < n/2) imag[k] = sumImag;
+  }
+}
+
+int main(int argc, char * const argv[]) {
+  bool isCorrect = true;
+  srand(1);
+  printf("%8s %14s %14s %10s %14s %14s\n", "length", "DFT (us)", "FFT (us)", "speedup",
+      "FFT error", "inverse error");
+  for (int n = MIN_LENGTH; n <= MAX_LENGTH; n <<= 1) {
+    RealFft *fft = RealFft::getPlan(n);
+    float *input = ALLOC_ALIGNED_BUFFER(n * sizeof(float));
+    float *real = ALLOC_ALIGNED_BUFFER(n * sizeof(float));
+    float *imag = ALLOC_ALIGNED_BUFFER(n * sizeof(float));
+    float *output = ALLOC_ALIGNED_BUFFER(n * sizeof(float));
+    float *work = ALLOC_ALIGNED_BUFFER(fft->getWorkBufferLength() * sizeof(float));
+    double *dftReal = (double *) malloc(n * sizeof(double));
+    double *dftImag = (double *) malloc(n * sizeof(double));
+    for (int i = 0; i < n; i++) {
+      input[i] = 2.0f * ((float) rand() / RAND_MAX) - 1.0f;
+    }
+    
+    timeval start, end;
+    
+    // the DFT is quadratic in the length, so it is repeated fewer times for longer transforms
+    int numDftIterations = (4 * MAX_LENGTH) / n;
+    gettimeofday(&start, NULL);
+    for (int i = 0; i < numDftIterations; i++) {
+      naiveDft(input, dftReal, dftImag, n);
+    }
+    gettimeofday(&end, NULL);
+    double dftUs = 1000.0 * elapsedMs(&start, &end) / numDftIterations;
+    
+    int numFftIterations = (1 << 24) / n;
+    gettimeofday(&start, NULL);
+    for (int i = 0; i < numFftIterations; i++) {
+      fft->forward(input, real, imag, work);
+    }
+    gettimeofday(&end, NULL);
+    double fftUs = 1000.0 * elapsedMs(&start, &end) / numFftIterations;
+    
+    double maxBin = 0.0;
+    double fftError = 0.0;
+    for (int k = 0; k < n; k++) {
+      maxBin = fmax(maxBin, sqrt(dftReal[k] * dftReal[k] + dftImag[k] * dftImag[k]));
+      fftError = fmax(fftError, fmax(fabs(real[k] - dftReal[k]), fabs(imag[k] - dftImag[k])));
+    }
+    fftError /= maxBin;
+    
+    fft->inverse(real, imag, output, work);
+    double inverseError = 0.0;
+    for (int i = 0; i < n; i++) {
+      inverseError = fmax(inverseError, fabs(output[i] / n - input[i]));
+    }
+    
+    printf("%8i %14.3f %14.3f %9.1fx %14.3g %14.3g\n", n, dftUs, fftUs, dftUs / fftUs, fftError,
+        inverseError);
+    if (fftError > MAX_ERROR || inverseError > MAX_ERROR) isCorrect = false;
+    
+    free(dftReal);
+    free(dftImag);
+    FREE_ALIGNED_BUFFER(input);
+    FREE_ALIGNED_BUFFER(real);
+    FREE_ALIGNED_BUFFER(imag);
+    FREE_ALIGNED_BUFFER(output);
+    FREE_ALIGNED_BUFFER(work);
+    RealFft::releasePlan(fft);
+  }
+  printf("FFT is correct: %s\n", isCorrect ? "YES" : "NO");
+  
+  return isCorrect ? 0 : 1;
+}
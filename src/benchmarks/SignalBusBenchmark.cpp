@@ -0,0 +1,114 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+/*
+ * A benchmark of signals received by name. A patch of 256 buses is created, each an [osc~] sent
+ * with [send~] to a [receive~] -> [*~ 0.01] in the left channel of [dac~], and thrown with
+ * [throw~] to a single [catch~] in the right channel. In one patch every sender is processed before
+ * its receivers, such that they share its buffer. In the other every [receive~] is processed first,
+ * and so reads a copy which is a block late. The [catch~] is processed after its [throw~]s in both.
+ * The time taken to process each patch is reported. The left channel of the second patch must be
+ * that of the first delayed by one block.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "BenchmarkUtils.h"
+#include "ZenGarden.h"
+
+#define NUM_BUSES 256
+#define BLOCK_SIZE 64
+#define NUM_BLOCKS 10000
+#define MAX_ERROR 1e-5f
+
+// objects are processed in the order in which they are created, unless they are connected
+static std::string createNetlist(bool isSenderFirst) {
+  std::string senders;
+  for (int i = 0; i < NUM_BUSES; i++) {
+    appendLine(&senders, "#X obj 0 0 osc~ %i;\n", 100 + i, 0);
+    appendLine(&senders, "#X obj 0 0 send~ bus%i;\n", i, 0);
+    senders.append("#X obj 0 0 throw~ mix;\n");
+  }
+  std::string receivers;
+  for (int i = 0; i < NUM_BUSES; i++) {
+    appendLine(&receivers, "#X obj 0 0 receive~ bus%i;\n", i, 0);
+    receivers.append("#X obj 0 0 *~ 0.01;\n");
+  }
+  receivers.append("#X obj 0 0 catch~ mix;\n");
+  receivers.append("#X obj 0 0 dac~;\n");
+  
+  std::string netlist = "#N canvas 0 0 400 400 10;\n";
+  netlist.append(isSenderFirst ? senders + receivers : receivers + senders);
+  int firstSender = isSenderFirst ? 0 : 2*NUM_BUSES + 2;
+  int firstReceiver = isSenderFirst ? 3*NUM_BUSES : 0;
+  int dac = firstReceiver + 2*NUM_BUSES + 1;
+  for (int i = 0; i < NUM_BUSES; i++) {
+    int osc = firstSender + 3*i;
+    int receive = firstReceiver + 2*i;
+    appendLine(&netlist, "#X connect %i 0 %i 0;\n", osc, osc + 1);
+    appendLine(&netlist, "#X connect %i 0 %i 0;\n", osc, osc + 2);
+    appendLine(&netlist, "#X connect %i 0 %i 0;\n", receive, receive + 1);
+    appendLine(&netlist, "#X connect %i 0 %i 0;\n", receive + 1, dac);
+  }
+  appendLine(&netlist, "#X connect %i 0 %i 1;\n", dac - 1, dac);
+  return netlist;
+}
+
+// returns the time taken, and the output of the last two blocks
+static double run(bool isSenderFirst, float *output) {
+  ZGContext *context = newBenchmarkContext(0, 2, BLOCK_SIZE);
+  attachNetlist(context, createNetlist(isSenderFirst).c_str());
+  
+  float input[1];
+  timeval start, end;
+  gettimeofday(&start, NULL);
+  for (int i = 0; i < NUM_BLOCKS; i++) {
+    zg_context_process(context, input, output + (i & 1) * 2*BLOCK_SIZE);
+  }
+  gettimeofday(&end, NULL);
+  zg_context_delete(context);
+  return elapsedMs(&start, &end);
+}
+
+int main(int argc, char * const argv[]) {
+  float senderFirstOutput[4*BLOCK_SIZE];
+  float receiverFirstOutput[4*BLOCK_SIZE];
+  
+  double senderFirstMs = run(true, senderFirstOutput);
+  double receiverFirstMs = run(false, receiverFirstOutput);
+  printf("Processed %i blocks in %f milliseconds (shared buffers) and %f milliseconds (copies).\n",
+      NUM_BLOCKS, senderFirstMs, receiverFirstMs);
+  
+  // NUM_BLOCKS is even, so the last block is in the second half of each output. The [catch~] always
+  // follows its [throw~]s, which may however be summed in a different order.
+  bool isEqual = !memcmp(senderFirstOutput, receiverFirstOutput + 2*BLOCK_SIZE,
+      BLOCK_SIZE*sizeof(float));
+  for (int i = 0; i < BLOCK_SIZE; i++) {
+    float error = fabsf(senderFirstOutput[3*BLOCK_SIZE+i] - receiverFirstOutput[3*BLOCK_SIZE+i]);
+    if (error > MAX_ERROR) isEqual = false;
+  }
+  printf("Output is correct: %s\n", isEqual ? "YES" : "NO");
+  return isEqual ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A benchmark of reading a sound file with [soundfiler] while a context is processed. A 30 second
+ * stereo file is written with libsndfile and read into two tables, once with synchronous disk I/O
+ * and once in the background. Blocks are processed at the rate of an audio device. The longest time
+ * taken to process a block, the number of blocks until the file has been read, and whether the
+ * tables hold the contents of the file are reported.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sndfile.h>
+
+#include "BenchmarkUtils.h"
+#include "MessageTable.h"
+#include "PdContext.h"
+#include "ZenGarden.h"
+
+#define SOUNDFILE_PATH "/tmp/zengarden_soundfiler_benchmark.wav"
+#define NUM_FRAMES (30 * 44100)
+#define BLOCK_SIZE 64
+#define BLOCK_MS (1000.0 * BLOCK_SIZE / 44100.0)
+#define MAX_BLOCKS 100000
+
+static inline float getSample(int channel, int frame) {
+  return ((float) (frame % 1000) / 1000.0f) * (channel == 0 ? 1.0f : -1.0f);
+}
+
+static bool isLoaded;
+static float numFramesLoaded;
+
+static void *callbackFunction(ZGCallbackFunction function, void *userData, void *ptr) {
+  switch (function) {
+    case ZG_RECEIVER_MESSAGE: {
+      isLoaded = true;
+      numFramesLoaded = zg_message_get_float(((ZGReceiverMessagePair *) ptr)->message, 0);
+      break;
+    }
+    default: return printErrors(function, userData, ptr);
+  }
+  return NULL;
+}
+
+static bool writeSoundfile() {
+  SF_INFO sfInfo;
+  sfInfo.samplerate = 44100;
+  sfInfo.channels = 2;
+  sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+  SNDFILE *sndFile = sf_open(SOUNDFILE_PATH, SFM_WRITE, &sfInfo);
+  if (sndFile == NULL) return false;
+  float frames[2 * 1024];
+  for (int i = 0; i < NUM_FRAMES; i += 1024) {
+    int n = (NUM_FRAMES - i < 1024) ? NUM_FRAMES - i : 1024;
+    for (int j = 0; j < n; j++) {
+      frames[2*j] = getSample(0, i+j);
+      frames[2*j+1] = getSample(1, i+j);
+    }
+    sf_writef_float(sndFile, frames, n);
+  }
+  sf_close(sndFile);
+  return true;
+}
+
+static bool run(bool isSynchronous) {
+  const char *netlist = "#N canvas 0 0 400 400 10;\n"
+      "#X obj 0 0 table left;\n"
+      "#X obj 0 0 table right;\n"
+      "#X obj 0 0 r load;\n"
+      "#X obj 0 0 soundfiler;\n"
+      "#X obj 0 0 s loaded;\n"
+      "#X obj 0 0 osc~ 440;\n"
+      "#X obj 0 0 dac~;\n"
+      "#X connect 2 0 3 0;\n"
+      "#X connect 3 0 4 0;\n"
+      "#X connect 5 0 6 0;\n";
+  PdContext *context = newBenchmarkContext(0, 2, BLOCK_SIZE, callbackFunction);
+  attachNetlist(context, netlist);
+  zg_context_register_receiver(context, "loaded");
+  zg_context_set_disk_io_synchronous(context, isSynchronous ? 1 : 0);
+  float *output = (float *) malloc(2 * BLOCK_SIZE * sizeof(float));
+  
+  isLoaded = false;
+  numFramesLoaded = 0.0f;
+  zg_context_send_message_from_string(context, "load", 0.0,
+      "read -resize " SOUNDFILE_PATH " left right");
+  double maxMs = 0.0;
+  int numBlocks = 0;
+  timeval start, end;
+  while (!isLoaded && numBlocks < MAX_BLOCKS) {
+    gettimeofday(&start, NULL);
+    zg_context_process(context, NULL, output);
+    gettimeofday(&end, NULL);
+    double ms = elapsedMs(&start, &end);
+    if (ms > maxMs) maxMs = ms;
+    numBlocks++;
+    // leave the rest of the block to other threads, as an audio device would
+    if (ms < BLOCK_MS) usleep((useconds_t) (1000.0 * (BLOCK_MS - ms)));
+  }
+  
+  // check the contents of the tables
+  bool isCorrect = isLoaded && ((int) numFramesLoaded) == NUM_FRAMES;
+  for (int c = 0; c < 2 && isCorrect; c++) {
+    int bufferLength = 0;
+    float *buffer = context->getTable(c == 0 ? "left" : "right")->getBuffer(&bufferLength);
+    if (bufferLength != NUM_FRAMES) isCorrect = false;
+    for (int i = 0; i < bufferLength && isCorrect; i++) {
+      if (buffer[i] != getSample(c, i)) isCorrect = false;
+    }
+  }
+  printf("%-16s %14.3f %14i\n", isSynchronous ? "synchronous" : "background", maxMs, numBlocks);
+  
+  free(output);
+  zg_context_delete(context);
+  return isCorrect;
+}
+
+int main(int argc, char * const argv[]) {
+  if (!writeSoundfile()) {
+    printf("The file %s could not be written.\n", SOUNDFILE_PATH);
+    return 1;
+  }
+  
+  printf("%-16s %14s %14s\n", "", "max ms/block", "blocks to load");
+  bool isCorrect = run(true);
+  isCorrect = run(false) && isCorrect;
+  printf("Tables are filled correctly: %s\n", isCorrect ? "YES" : "NO");
+  
+  unlink(SOUNDFILE_PATH);
+  return isCorrect ? 0 : 1;
+}
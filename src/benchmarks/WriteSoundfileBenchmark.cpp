@@ -0,0 +1,146 @@
+/*
+ *  Copyright 2012 Reality Jockey, Ltd.
+ *                 info@rjdj.me
+ *                 http://rjdj.me/
+ * 
+ *  This file is part of ZenGarden.
+ *
+ *  ZenGarden is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ZenGarden is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ZenGarden.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A benchmark of recording to a sound file with [writesf~]. The input of a context, which counts the
+ * frames, is recorded to a 30 second stereo file with synchronous disk I/O and from the stream
+ * thread, and for comparison by the host writing the output of each block with libsndfile. Blocks
+ * are processed at the rate of an audio device. The longest and the mean time taken to process and
+ * record a block are reported, and whether the file holds every frame.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sndfile.h>
+
+#include "BenchmarkUtils.h"
+#include "ZenGarden.h"
+
+#define SOUNDFILE_PATH "/tmp/zengarden_writesf_benchmark.wav"
+#define BLOCK_SIZE 64
+#define NUM_BLOCKS (30 * 44100 / BLOCK_SIZE)
+#define NUM_FRAMES (NUM_BLOCKS * BLOCK_SIZE)
+#define BLOCK_MS (1000.0 * BLOCK_SIZE / 44100.0)
+
+static inline float getSample(int channel, int frame) {
+  return ((float) (frame % 1000) / 1000.0f) * (channel == 0 ? 1.0f : -1.0f);
+}
+
+/** Returns true if the file holds exactly the frames which were recorded. */
+static bool checkSoundfile() {
+  SF_INFO sfInfo;
+  sfInfo.format = 0;
+  SNDFILE *sndFile = sf_open(SOUNDFILE_PATH, SFM_READ, &sfInfo);
+  if (sndFile == NULL) return false;
+  bool isCorrect = (sfInfo.channels == 2 && sfInfo.frames == NUM_FRAMES);
+  float frames[2 * 1024];
+  for (int i = 0; i < NUM_FRAMES && isCorrect; i += 1024) {
+    int n = (NUM_FRAMES - i < 1024) ? NUM_FRAMES - i : 1024;
+    if (sf_readf_float(sndFile, frames, n) != n) isCorrect = false;
+    for (int j = 0; j < n && isCorrect; j++) {
+      if (frames[2*j] != getSample(0, i+j) || frames[2*j+1] != getSample(1, i+j)) isCorrect = false;
+    }
+  }
+  sf_close(sndFile);
+  return isCorrect;
+}
+
+/** Records the input of a context to the file, with [writesf~] or else by writing each output. */
+static bool run(const char *name, bool isRecordedByHost, bool isSynchronous) {
+  const char *netlist = "#N canvas 0 0 400 400 10;\n"
+      "#X obj 0 0 adc~;\n"
+      "#X obj 0 0 dac~;\n"
+      "#X obj 0 0 r record;\n"
+      "#X obj 0 0 writesf~ 2;\n"
+      "#X connect 0 0 1 0;\n"
+      "#X connect 0 1 1 1;\n"
+      "#X connect 2 0 3 0;\n"
+      "#X connect 0 0 3 0;\n"
+      "#X connect 0 1 3 1;\n";
+  PdContext *context = newBenchmarkContext(2, 2, BLOCK_SIZE);
+  zg_context_set_disk_io_synchronous(context, isSynchronous ? 1 : 0);
+  attachNetlist(context, netlist);
+  float *input = (float *) malloc(2 * BLOCK_SIZE * sizeof(float));
+  float *output = (float *) malloc(2 * BLOCK_SIZE * sizeof(float));
+  float *frames = (float *) malloc(2 * BLOCK_SIZE * sizeof(float));
+  
+  SNDFILE *sndFile = NULL;
+  if (isRecordedByHost) {
+    SF_INFO sfInfo;
+    sfInfo.samplerate = 44100;
+    sfInfo.channels = 2;
+    sfInfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+    sndFile = sf_open(SOUNDFILE_PATH, SFM_WRITE, &sfInfo);
+  } else {
+    zg_context_send_message_from_string(context, "record", 0.0, "open -bytes 4 " SOUNDFILE_PATH);
+    zg_context_send_message_from_string(context, "record", 0.0, "start");
+  }
+  
+  double maxMs = 0.0;
+  double totalMs = 0.0;
+  timeval start, end;
+  for (int i = 0; i < NUM_BLOCKS; i++) {
+    for (int j = 0; j < BLOCK_SIZE; j++) {
+      input[j] = getSample(0, i*BLOCK_SIZE + j);
+      input[BLOCK_SIZE+j] = getSample(1, i*BLOCK_SIZE + j);
+    }
+    gettimeofday(&start, NULL);
+    zg_context_process(context, input, output);
+    if (isRecordedByHost) {
+      // the host interleaves the output itself
+      for (int j = 0; j < BLOCK_SIZE; j++) {
+        frames[2*j] = output[j];
+        frames[2*j+1] = output[BLOCK_SIZE+j];
+      }
+      sf_writef_float(sndFile, frames, BLOCK_SIZE);
+    }
+    gettimeofday(&end, NULL);
+    double ms = elapsedMs(&start, &end);
+    if (ms > maxMs) maxMs = ms;
+    totalMs += ms;
+    // leave the rest of the block to other threads, as an audio device would
+    if (ms < BLOCK_MS) usleep((useconds_t) (1000.0 * (BLOCK_MS - ms)));
+  }
+  
+  // the file is closed when [writesf~] is deleted
+  if (isRecordedByHost) sf_close(sndFile);
+  zg_context_delete(context);
+  bool isCorrect = checkSoundfile();
+  printf("%-24s %14.3f %14.4f %10s\n", name, maxMs, totalMs / NUM_BLOCKS, isCorrect ? "yes" : "NO");
+  
+  free(input);
+  free(output);
+  free(frames);
+  unlink(SOUNDFILE_PATH);
+  return isCorrect;
+}
+
+int main(int argc, char * const argv[]) {
+  printf("%-24s %14s %14s %10s\n", "", "max ms/block", "mean ms/block", "complete");
+  bool isCorrect = run("host", true, false);
+  isCorrect = run("writesf~ (synchronous)", false, true) && isCorrect;
+  isCorrect = run("writesf~ (background)", false, false) && isCorrect;
+  printf("Files are recorded correctly: %s\n", isCorrect ? "YES" : "NO");
+  
+  return isCorrect ? 0 : 1;
+}
@@ -188,6 +188,17 @@ public class ZGContext {
   }
   native private void sendMessage(String receiverName, Message message, long nativePtr);
   
+  /**
+   * Sets whether files are read and written on the thread calling <code>process()</code>, such that
+   * every result is available at the logical time at which it was requested. Disk I/O is otherwise
+   * done on a background thread. Synchronous disk I/O is useful when rendering offline.
+   * @param synchronous
+   */
+  public void setDiskIoSynchronous(boolean synchronous) {
+    setDiskIoSynchronous(synchronous, contextPtr);
+  }
+  native private void setDiskIoSynchronous(boolean synchronous, long nativePtr);
+  
   @Override
   public boolean equals(Object o) {
     if (ZGContext.class.isInstance(o)) {
@@ -71,6 +71,14 @@ JNIEXPORT void JNICALL Java_me_rjdj_zengarden_ZGContext_process
 JNIEXPORT void JNICALL Java_me_rjdj_zengarden_ZGContext_sendMessage
   (JNIEnv *, jobject, jstring, jobject, jlong);
 
+/*
+ * Class:     me_rjdj_zengarden_ZGContext
+ * Method:    setDiskIoSynchronous
+ * Signature: (ZJ)V
+ */
+JNIEXPORT void JNICALL Java_me_rjdj_zengarden_ZGContext_setDiskIoSynchronous
+  (JNIEnv *, jobject, jboolean, jlong);
+
 #ifdef __cplusplus
 }
 #endif
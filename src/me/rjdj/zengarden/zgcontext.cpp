@@ -185,3 +185,8 @@ JNIEXPORT void JNICALL Java_me_rjdj_zengarden_ZGContext_process
   env->ReleasePrimitiveArrayCritical(jinputBuffer, cinputBuffer, JNI_ABORT);
   env->ReleasePrimitiveArrayCritical(joutputBuffer, coutputBuffer, JNI_ABORT);
 }
+
+JNIEXPORT void JNICALL Java_me_rjdj_zengarden_ZGContext_setDiskIoSynchronous
+    (JNIEnv *env, jobject jobj, jboolean jsynchronous, jlong nativePtr) {
+  zg_context_set_disk_io_synchronous((ZGContext *) nativePtr, (jsynchronous == JNI_TRUE) ? 1 : 0);
+}
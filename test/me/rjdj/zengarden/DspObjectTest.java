@@ -65,11 +65,63 @@ public class DspObjectTest implements ZenGardenListener {
     if (ais != null) ais.close(); // no matter what, be sure to close the audio input stream
   }
   
+  /**
+   * Test that a graph reblocked by [block~ 256] delays its signal by 256 - 64 samples.
+   */
+  @Test
+  public void testDspBlockLatency() {
+    genericDspTest("DspBlockLatency.pd");
+  }
+  
+  /**
+   * Test that the overlapping blocks of a graph with [block~ 128 4] are added to its output. The
+   * hop of 32 samples is shorter than the parent's block.
+   */
+  @Test
+  public void testDspBlockOverlap() {
+    genericDspTest("DspBlockOverlap.pd");
+  }
+  
+  /**
+   * Test that [block~ 96], which is not a power of two, is rejected. The graph keeps the block of
+   * its parent and its signal passes without delay.
+   */
+  @Test
+  public void testDspBlockNonMultiple() {
+    genericDspTest("DspBlockNonMultiple.pd");
+  }
+  
   @Test
   public void testDspCos() {
     genericDspTest("DspCos.pd");
   }
   
+  /**
+   * Test that several [dac~]s writing the same channel are summed, while a [dac~] in a graph which
+   * has been switched off by [switch~] writes nothing.
+   */
+  @Test
+  public void testDspDacAccumulate() {
+    genericDspTest("DspDacAccumulate.pd");
+  }
+  
+  /**
+   * Test that [dac~ 2 1] writes its second inlet to the first output channel. The second channel
+   * does not exist in the test context and its input is ignored.
+   */
+  @Test
+  public void testDspDacChannels() {
+    genericDspTest("DspDacChannels.pd");
+  }
+  
+  /**
+   * Test [hip~] with its cutoff frequency driven by a signal ramp.
+   */
+  @Test
+  public void testDspHipSignal() {
+    genericDspTest("DspHipSignal.pd");
+  }
+  
   @Test
   public void testDspInletOutlet() {
     genericDspTest("DspInletOutlet.pd");
@@ -80,6 +132,14 @@ public class DspObjectTest implements ZenGardenListener {
     genericDspTest("DspLine.pd");
   }
 
+  /**
+   * Test [lop~] with its cutoff frequency driven by a signal ramp.
+   */
+  @Test
+  public void testDspLopSignal() {
+    genericDspTest("DspLopSignal.pd");
+  }
+  
   @Test
   public void testDspOsc() {
     genericDspTest("DspOsc.pd");
@@ -93,11 +153,24 @@ public class DspObjectTest implements ZenGardenListener {
     genericDspTest("DspPhasorSignal.pd");
   }
 
+  /**
+   * Test that [readsf~] plays a file from the given onset, and bangs at its end. The bang reopens the
+   * file, which is played again from the start of the next block.
+   */
+  @Test
+  public void testDspReadSoundfile() {
+    genericDspTest("DspReadSoundfile.pd");
+  }
+  
   @Test
   public void testDspSampHold() {
     genericDspTest("DspSampHold.pd");
   }
   
+  /**
+   * Test that every [receive~] of a name reads the signal of its [send~], and that a [receive~]
+   * without a [send~] reads silence.
+   */
   @Test
   public void testDspSendReceive() {
     genericDspTest("DspSendReceive.pd");
@@ -108,11 +181,32 @@ public class DspObjectTest implements ZenGardenListener {
     genericDspTest("DspTableWrite.pd", 2000);
   }
   
+  /**
+   * Test that [catch~] sums the signals of all [throw~]s to its name, and outputs silence if there
+   * are none.
+   */
   @Test
   public void testDspThrowCatch() {
     genericDspTest("DspThrowCatch.pd");
   }
   
+  /**
+   * Test [vcf~] with its center frequency driven by a signal ramp.
+   */
+  @Test
+  public void testDspVcf() {
+    genericDspTest("DspVcf.pd");
+  }
+  
+  /**
+   * Test that [writesf~] records its input to a file. The file is recorded for 250ms and then played
+   * back with [readsf~].
+   */
+  @Test
+  public void testDspWriteSoundfile() {
+    genericDspTest("DspWriteSoundfile.pd");
+  }
+  
   @Test
   public void testDspWrap() {
     genericDspTest("DspWrap.pd");
@@ -138,6 +232,7 @@ public class DspObjectTest implements ZenGardenListener {
     // create and configure a context
     ZGContext context = new ZGContext(NUM_INPUT_CHANNELS, NUM_OUTPUT_CHANNELS, BLOCK_SIZE, SAMPLE_RATE);
     context.addListener(this);
+    context.setDiskIoSynchronous(true); // objects reading files produce the same output in every run
     ZGGraph graph = context.newGraph(new File(TEST_PATHNAME, testFilename));
     graph.attach();
     